@@ -1,24 +1,32 @@
 #ifndef _CREATURE_H_
 #define _CREATURE_H_
 
-#include <queue>
 #include <string>
 #include <functional>
 
+#include "EcoSystem/CreatureHandle.h"
+#include "EcoSystem/CreaturePool.h"
+#include "EcoSystem/PathArena.h"
+#include "EcoSystem/Random.h"
 #include "EcoSystem/Terrain.h"
 
 #define MAX_CREATURE_SPEED 10.f
 #define MAX_CREATURE_SIZE 10.f
 #define MAX_CREATURE_SENSE 10.f
+// what a new world's offspring traits drift by when they mutate, see EcoSystem::SetMutationEpsilon
+#define DEFAULT_MUTATION_EPSILON 0.1f
 
 namespace CS380
 {
-	extern float CREATURE_MUTATION_EPSILON;
+	class EcoSystem;
+	class CheckpointWriter;
+	class CheckpointReader;
 
 	struct EvolutionData
 	{
 		EvolutionData(float _repT= 0.9f, float _repl = 0.f, float _muta = 0.f) noexcept;
 		EvolutionData(const EvolutionData& _evo) noexcept;
+		EvolutionData& operator=(const EvolutionData&) noexcept = default;
 		float mfReplicationThresh; // threshhold to attempt to replicate
 		float mfReplicateChance; // actual birthing low value
 		float mfMutationChance; // when replicating theres mutating chance
@@ -41,11 +49,17 @@ namespace CS380
 		{
 			FLAG_INVALID = 0,
 
+			// set by Rest, the behaviour is skipped until the creature wakes
+			FLAG_RESTING = 1 << 14,
 			FLAG_DEAD = 1 << 15
 		};
 
-		Creature(const std::string& _name, unsigned short _flags, const Traits& _t, unsigned _id) noexcept;
-		~Creature(void) noexcept;
+		// species at or below a creature's level are its prey, level 0 grazes. species override it to move up
+		static constexpr unsigned TROPHIC_LEVEL = 0;
+
+		// every species also declares static constexpr const char* NAME, see Data::SpeciesNames
+		Creature(unsigned short _flags, const Traits& _t, unsigned _id) noexcept;
+		virtual ~Creature(void) noexcept;
 
 		// getters
 		unsigned short GetFlags(void) const noexcept;
@@ -53,7 +67,7 @@ namespace CS380
 		float GetSpeed(void) const noexcept;
 		float GetSense(void) const noexcept;
 		unsigned int GetColor(void) const noexcept;
-		const std::string& GetName(void) const noexcept;
+		const char* GetName(void) const noexcept;
 		std::pair<float, float> GetFatigue(void) const noexcept;
 		std::pair<float, float> GetEnergy(void) const noexcept;
 		void GetGridPosition(unsigned& _outX, unsigned& _outY) const noexcept;
@@ -61,11 +75,17 @@ namespace CS380
 		void GetHomeGridPosition(unsigned& _outX, unsigned& _outY) const noexcept;
 		bool HasPendingMovement(void) const noexcept;
 		CS380::GridPos GetPendingDestination(void) const noexcept;
-		const std::string& GetUniqueID(void) const noexcept;
+		// unique for the run and replayed with the seed, format it where it is shown
+		std::uint64_t GetUniqueID(void) const noexcept;
 		float GetMutChance(void) const noexcept;
 		float GetRepChance(void) const noexcept;
 		const EvolutionData& GetEvoData(void) const noexcept;
-		const Traits& GetTraits(void) const noexcept;
+		Traits GetTraits(void) const noexcept;
+		const CreatureHandle& GetHandle(void) const noexcept;
+		// CreatureList index, the same as the handle's
+		unsigned GetSpecies(void) const noexcept;
+		// the world whose pool the creature was constructed in
+		EcoSystem& GetWorld(void) const noexcept;
 
 		void SetFatigueBase(const std::pair<float, float>& _curMax) noexcept;
 		void SetEnergyBase(const std::pair<float, float>& _curMax) noexcept;
@@ -81,7 +101,7 @@ namespace CS380
 		// set color to be represented on grid
 		void SetColor(float _red = 1.f, float _green = 1.f, float _blue = 1.f, float _alpha = 1.f) noexcept;
 
-		// set position
+		// set position, keeps the EcoSystem's occupancy layer in step
 		void SetGridPosition(unsigned _x, unsigned _y) noexcept;
 
 		// mark curr position as new home base
@@ -94,50 +114,152 @@ namespace CS380
 		void UpdateAwake(float) noexcept;
 		void UpdateAsleep(float) noexcept;
 
-		// To move creature
-		void SetMovement(const std::vector<GridPos>& _path);
+		// live creatures [_begin, _end) of T's pool, UpdateAwake one by one with T's behaviour called directly
+		template<typename T>
+		static void UpdateAwakeRange(CreaturePoolBase& _pool, unsigned _begin, unsigned _end, float _dt) noexcept;
+		// idle drain and path timers as one pass over the hot data then the behaviours one by one. same rules as
+		// UpdateAwakeRange, but the drain is paid before anyone in the range acts. a resting creature with no step
+		// due costs only its row here
+		template<typename T>
+		static void UpdateAwakeBatched(CreaturePoolBase& _pool, unsigned _begin, unsigned _end, float _dt) noexcept;
+
+		// To move creature, plans the shortest path there. false and the current path kept when there is none
+		bool SetMovement(const GridPos& _dest, PathMode _mode = PATH_AUTO);
+		// the same path planned at the end of the tick, within the world's path budget (see EcoSystem::RequestPath).
+		// the current path is walked until it arrives, HasPendingMovement counts the request already and a later
+		// request or SetMovement takes its place. a request that finds no path just ends
+		void RequestMovement(const GridPos& _dest, PathMode _mode = PATH_AUTO);
 
 		// fun functions
 		float Eaten(Creature * _predator);
+		// while the creature phase runs in parallel this only records the meal and returns 0, Digest runs when it resolves
 		float Eat(void);
+		// what eating _v energy does to this creature, may replicate
+		float Digest(float _v);
 		void Replicate(void);
 
 		// TODO : USER-END TO IMPLEMENT
 		virtual void UpdateAwakeBehaviour(float) = 0;
 		virtual void UpdateAsleepBehaviour(float) = 0;
 
+		// everything but the hot data, which the pool saves as whole columns. species with state of their own
+		// extend both and call these first
+		virtual void SaveState(CheckpointWriter& _w) const;
+		virtual void LoadState(CheckpointReader& _r);
+
 	protected:
-		unsigned short mBitFlags;
+		void SetFlag(unsigned short _f) noexcept;
+		void ClearFlag(unsigned short _f) noexcept;
+
+		// from the behaviour, with a path pending: nothing is left to decide until the path runs out or energy drops
+		// under _energyBelow, so the behaviour is not called until one of them happens. the path is still walked
+		// and idle drain still paid every tick, energy only goes down while resting
+		void Rest(float _energyBelow) noexcept;
+
+		// this creature's own stream, behaviours draw from it instead of rand()
+		Rng mRng;
 
 	private:
-		std::string mName;
-		std::string mUniqueID;
+		std::uint64_t mnUniqueID;
 		unsigned int mnColorCode;
 		unsigned mnChartID;
-
-		// first is current, second is max
-		std::pair<float,float> mfFatigue;
-		// first is current, second is max
-		std::pair<float,float> mfEnergy;
+		// flags, energy, fatigue, traits, position and path timer live in the pool's hot data,
+		// the pool keeps mnRow current when it swaps rows around
+		friend class CreaturePoolBase;
+		// answers RequestMovement
+		friend class EcoSystem;
+		EcoSystem* mpWorld;
+		CreatureHotData* mpHot;
+		unsigned mnRow;
+		CreatureHandle mHandle;
 
 		float mfFatigueThresh;
 		float mfEnergyThresh;
 
-		Traits mTraits;
 		EvolutionData mEvoData;
 
-		// current path to move
-		std::deque<GridPos> mCurPath;
-		float mfAccPathDt;
+		// current path to move, its steps live in the world's PathArena
+		PathCursor mPath;
+		// the RequestMovement still waiting for its path, 0 for none, and the last one made
+		std::uint32_t mnPathTicket;
+		std::uint32_t mnLastTicket;
 
-		unsigned mnPosX;
-		unsigned mnPosY;
 		unsigned mnHomeX;
 		unsigned mnHomeY;
-
-		void Move(float);
+		// set by the first SetGridPosition, which places the creature in the occupancy layer
+		bool mbOnGrid;
+
+		unsigned Row(void) const noexcept { return mnRow; }
+		CreatureHotData& Hot(void) noexcept { return *mpHot; }
+		const CreatureHotData& Hot(void) const noexcept { return *mpHot; }
+
+		// takes as many path steps as the accumulated path time pays for
+		void AdvancePath(void);
+		// what the path's next step takes, for the step timer. steps are a cell long and speed is fixed for life
+		void TimeNextStep(void) noexcept;
+		// true while resting, clears the flag once the creature wakes
+		bool StillResting(void) noexcept;
+		bool IsPathTicket(std::uint32_t _ticket) const noexcept;
+		// the answer to request _ticket, _path goes back to the arena when a later request took its place
+		void DeliverPath(std::uint32_t _ticket, bool _found, PathCursor& _path) noexcept;
+		// moves the creature and its home by _dx, _dy when it changes worlds, before it is placed in the new one's
+		// occupancy. its path and any path request are the old world's and are dropped
+		void Translate(int _dx, int _dy) noexcept;
+
+		// UpdateAwake up to the behaviour
+		void TickAwake(float _dt) noexcept;
+		// the vectorized half of UpdateAwakeBatched, then what is left of it per creature
+		static void DrainBatched(CreatureHotData& _h, unsigned _begin, unsigned _end, float _dt) noexcept;
+		void SettleBatched(void) noexcept;
 	};
 
+	template<typename T>
+	inline void Creature::UpdateAwakeRange(CreaturePoolBase& _pool, unsigned _begin, unsigned _end, float _dt) noexcept
+	{
+		if (_dt <= 0.f)
+			return;
+
+		const CreatureHotData& h = _pool.GetHot();
+		for (unsigned i = _begin; i < _end; ++i)
+		{
+			if (h.mFlags[i] & Flags::FLAG_DEAD)
+				continue;
+
+			T* c = static_cast<T*>(_pool.GetLive(i));
+			c->TickAwake(_dt);
+			if (c->StillResting())
+				continue;
+			c->T::UpdateAwakeBehaviour(_dt);
+		}
+	}
+
+	template<typename T>
+	inline void Creature::UpdateAwakeBatched(CreaturePoolBase& _pool, unsigned _begin, unsigned _end, float _dt) noexcept
+	{
+		if (_dt <= 0.f)
+			return;
+
+		CreatureHotData& h = _pool.GetHot();
+		DrainBatched(h, _begin, _end, _dt);
+
+		// behaviours can replicate into this pool, so the columns are indexed fresh every time
+		for (unsigned i = _begin; i < _end; ++i)
+		{
+			if (h.mFlags[i] & Flags::FLAG_DEAD)
+				continue;
+			// no step due, no debt and still above its wake level, so nothing happens to it this tick and the
+			// creature itself is never touched
+			if ((h.mFlags[i] & Flags::FLAG_RESTING) && h.mPathDt[i] <= h.mStepDt[i] && h.mEnergy[i] > 0.f && h.mEnergy[i] >= h.mWakeEnergy[i])
+				continue;
+
+			T* c = static_cast<T*>(_pool.GetLive(i));
+			c->SettleBatched();
+			if (c->StillResting())
+				continue;
+			c->T::UpdateAwakeBehaviour(_dt);
+		}
+	}
+
 }
 
 
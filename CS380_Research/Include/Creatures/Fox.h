@@ -7,12 +7,18 @@ namespace CS380
 	class Fox : public Creature
 	{
 	public:
+		static constexpr const char* NAME = "Fox";
+		static constexpr unsigned TROPHIC_LEVEL = 1;
+
 		Fox(const Traits& _t, unsigned _id) noexcept;
 		~Fox(void) noexcept;
 
 		void UpdateAwakeBehaviour(float);
 		void UpdateAsleepBehaviour(float);
 
+		void SaveState(CheckpointWriter& _w) const override;
+		void LoadState(CheckpointReader& _r) override;
+
 
 	private:
 		bool searching;
@@ -7,12 +7,17 @@ namespace CS380
 	class Rabbit : public Creature
 	{
 	public:
+		static constexpr const char* NAME = "Rabbit";
+
 		Rabbit(const Traits& _t, unsigned _id) noexcept;
 		~Rabbit(void) noexcept;
 
 		void UpdateAwakeBehaviour(float);
 		void UpdateAsleepBehaviour(float);
 
+		void SaveState(CheckpointWriter& _w) const override;
+		void LoadState(CheckpointReader& _r) override;
+
 
 	private:
 		bool searching;
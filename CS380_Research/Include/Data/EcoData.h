@@ -9,7 +9,11 @@
 
 #define EVOLUTION_CHART_COUNT 2
 
+#include <array>
+#include <memory>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 namespace CS380
 {
@@ -18,73 +22,221 @@ namespace CS380
 		"Rabbit 1", "Fox1"
 	};
 
-	extern EvolutionData EvolutionChart[EVOLUTION_CHART_COUNT];
+	// what every new world's evolution chart starts as, each EcoSystem keeps and edits its own copy
+	extern const EvolutionData DefaultEvolutionChart[EVOLUTION_CHART_COUNT];
 
 	namespace Data
 	{
-		void MakeTools(void);
+		void MakeTools(EcoSystem& _eco);
+
+		// species index of T, its position in CreatureList
+		template<typename T, std::size_t I = 0>
+		constexpr unsigned SpeciesOf(void) noexcept
+		{
+			if constexpr (std::is_same_v<T, std::tuple_element_t<I, CreatureList>>)
+				return static_cast<unsigned>(I);
+			else
+				return SpeciesOf<T, I + 1>();
+		}
+
+		template<std::size_t ... I>
+		constexpr std::array<const char*, sizeof...(I)> MakeSpeciesNames_Impl(std::index_sequence<I...>) noexcept
+		{
+			return { { std::tuple_element_t<I, CreatureList>::NAME... } };
+		}
+
+		// T::NAME by species index
+		inline constexpr std::array<const char*, std::tuple_size_v<CreatureList>> SpeciesNames =
+			MakeSpeciesNames_Impl(std::make_index_sequence<std::tuple_size_v<CreatureList>>{});
+
+		using SpeciesMasks = std::array<unsigned, std::tuple_size_v<CreatureList>>;
+
+		template<std::size_t ... I>
+		constexpr SpeciesMasks MakePreyMasks_Impl(std::index_sequence<I...>) noexcept
+		{
+			constexpr unsigned levels[] = { std::tuple_element_t<I, CreatureList>::TROPHIC_LEVEL... };
+			SpeciesMasks masks{};
+			for (std::size_t p = 0; p < sizeof...(I); ++p)
+				for (std::size_t t = 0; t < sizeof...(I); ++t)
+					if (levels[t] <= levels[p])
+						masks[p] |= 1u << t;
+			return masks;
+		}
+
+		template<std::size_t ... I>
+		constexpr unsigned MakeGrazerMask_Impl(std::index_sequence<I...>) noexcept
+		{
+			return (0u | ... | (std::tuple_element_t<I, CreatureList>::TROPHIC_LEVEL == 0 ? (1u << I) : 0u));
+		}
+
+		// bit t of PreyMasks[p] is set when species p may eat species t, built from the TROPHIC_LEVELs
+		inline constexpr SpeciesMasks PreyMasks = MakePreyMasks_Impl(std::make_index_sequence<std::tuple_size_v<CreatureList>>{});
+		inline constexpr unsigned GrazerMask = MakeGrazerMask_Impl(std::make_index_sequence<std::tuple_size_v<CreatureList>>{});
+
+		inline constexpr bool CanEat(unsigned _predator, unsigned _target) noexcept
+		{
+			return (PreyMasks[_predator] >> _target) & 1u;
+		}
+
+		// whether the species grazes the cell it stands on
+		inline constexpr bool Grazes(unsigned _species) noexcept
+		{
+			return (GrazerMask >> _species) & 1u;
+		}
+
+		static_assert(CanEat(SpeciesOf<Fox>(), SpeciesOf<Rabbit>()) && !CanEat(SpeciesOf<Rabbit>(), SpeciesOf<Fox>()), "foxes eat rabbits, not the other way round");
+
+		template<std::size_t ... I>
+		void MakePools_Impl(EcoSystem& _eco, std::vector<std::unique_ptr<CreaturePoolBase>>& _pools, std::index_sequence<I...>)
+		{
+			(_pools.emplace_back(std::make_unique<CreaturePool<std::tuple_element_t<I, CreatureList>>>(_eco, static_cast<unsigned>(I))), ...);
+		}
+
+		// one pool per CreatureList entry, species index is the tuple index
+		inline void MakePools(EcoSystem& _eco, std::vector<std::unique_ptr<CreaturePoolBase>>& _pools)
+		{
+			MakePools_Impl(_eco, _pools, std::make_index_sequence<std::tuple_size_v<CreatureList>>{});
+		}
 
 		template<typename T, typename SFNAE = std::enable_if_t<std::is_base_of_v<Creature, T>, T>>
-		void SpawnCreature(unsigned short _x, unsigned short _y, const EvolutionData& _evo, const Traits& _trait, int _i)
+		void SpawnCreature(EcoSystem& _eco, unsigned _x, unsigned _y, const EvolutionData& _evo, const Traits& _trait, int _i)
 		{
-			EcoSystem& eco = EcoSystem::GetInst();
-			Creature *c = static_cast<Creature*>(new T{ _trait, static_cast<unsigned>(_i) });
+			CreatureHandle h;
+			Creature *c = static_cast<CreaturePool<T>&>(_eco.GetPool(static_cast<unsigned>(_i))).Create(h, _trait, static_cast<unsigned>(_i));
 			c->SetEvolutionData(_evo);
 			c->SetGridPosition(_x, _y);
 			c->MarkTerritory();
-			eco.AddCreature(c);
+			_eco.NoteSpawn();
 		}
 
 		struct SpawnVisitor
 		{
-			SpawnVisitor(unsigned short _x, unsigned short _y, const EvolutionData& _evo, const Traits& _t) noexcept
-				: mnGridX{ _x }, mnGridY{ _y }, mEvo{ _evo }, mTrait{ _t }
+			SpawnVisitor(EcoSystem& _eco, unsigned _x, unsigned _y, const EvolutionData& _evo, const Traits& _t) noexcept
+				: mEco{ _eco }, mnGridX{ _x }, mnGridY{ _y }, mEvo{ _evo }, mTrait{ _t }
 			{}
 
 			template<typename T>
-			SpawnVisitor(T _x, T _y, const EvolutionData& _evo, const Traits& _t) noexcept
-				: SpawnVisitor{ static_cast<unsigned short>(_x), static_cast<unsigned short>(_y), _evo, _t }
+			SpawnVisitor(EcoSystem& _eco, T _x, T _y, const EvolutionData& _evo, const Traits& _t) noexcept
+				: SpawnVisitor{ _eco, static_cast<unsigned>(_x), static_cast<unsigned>(_y), _evo, _t }
 			{}
 
 			template<typename T>
 			void operator()(int _i)
 			{
-				Data::SpawnCreature<T>(mnGridX, mnGridY, mEvo, mTrait, _i);
+				Data::SpawnCreature<T>(mEco, mnGridX, mnGridY, mEvo, mTrait, _i);
 			}
 
-			unsigned short mnGridX;
-			unsigned short mnGridY;
+			EcoSystem& mEco;
+			unsigned mnGridX;
+			unsigned mnGridY;
 			EvolutionData mEvo;
 			Traits mTrait;
 		};
 
-		template<size_t I>
-		struct VisitTuple_Impl
+		template<typename T, typename F>
+		void VisitSpawn_Impl(F& _func, int _i)
+		{
+			_func.template operator()<T>(_i);
+		}
+
+		template<typename F, std::size_t ... I>
+		void VisitSpawnTuple_Impl(F& _func, int _i, std::index_sequence<I...>)
+		{
+			static constexpr void (*table[])(F&, int) = { &VisitSpawn_Impl<std::tuple_element_t<I, CreatureList>, F>... };
+			if (static_cast<unsigned>(_i) < sizeof...(I))
+				table[_i](_func, _i);
+		}
+
+		// _func.operator()<T>(_i) for the CreatureList entry _i, one indexed call
+		template<typename F>
+		void VisitSpawnTuple(F _func, int _i)
 		{
-			template <typename T, typename F>
-			static void Visit(int _i, F _func)
+			VisitSpawnTuple_Impl(_func, _i, std::make_index_sequence<std::tuple_size_v<CreatureList>>{});
+		}
+
+		// traits drawn per creature, each uniformly between its min and max
+		struct TraitDistribution
+		{
+			explicit TraitDistribution(const Traits& _t) noexcept
+				: mMin{ _t }, mMax{ _t }
+			{}
+
+			TraitDistribution(const Traits& _min, const Traits& _max) noexcept
+				: mMin{ _min }, mMax{ _max }
+			{}
+
+			Traits Draw(Rng& _rng) const noexcept
 			{
-				if (_i == I - 1)
-					_func.operator()<std::tuple_element_t<I - 1, T>>(_i);
-				else
-					VisitTuple_Impl<I - 1>::template Visit<T>(_i, _func);
+				const float size = _rng.Range(mMin.mfSize, mMax.mfSize);
+				const float speed = _rng.Range(mMin.mfSpeed, mMax.mfSpeed);
+				const float sense = _rng.Range(mMin.mfSense, mMax.mfSense);
+				return Traits{ size, speed, sense };
 			}
+
+			Traits mMin;
+			Traits mMax;
 		};
 
-		template<>
-		struct VisitTuple_Impl<0>
+		// up to _count T on distinct free cells of _region, cells then traits drawn from _rng. the pool makes room for
+		// all of them once and they go in row by row, returns how many there were room for
+		template<typename T, typename SFNAE = std::enable_if_t<std::is_base_of_v<Creature, T>, T>>
+		unsigned SpawnMany(EcoSystem& _eco, unsigned _count, const SpawnRegion& _region, const TraitDistribution& _traits, Rng& _rng)
+		{
+			constexpr unsigned species = SpeciesOf<T>();
+			std::vector<GridPos> cells;
+			const unsigned n = _eco.SampleFreeCells(_count, _region, _rng, cells);
+			_eco.GetPool(species).Reserve(n);
+			const EvolutionData& evo = _eco.GetEvolutionData(species);
+			for (const GridPos& p : cells)
+				SpawnCreature<T>(_eco, static_cast<unsigned>(p.x), static_cast<unsigned>(p.y), evo, _traits.Draw(_rng), static_cast<int>(species));
+			return n;
+		}
+
+		struct SpawnManyVisitor
 		{
-			template <typename T, typename F>
-			static void Visit(int, F)
+			template<typename T>
+			void operator()(int)
 			{
+				mnSpawned = SpawnMany<T>(mEco, mnCount, mRegion, mTraits, mRng);
 			}
+
+			EcoSystem& mEco;
+			unsigned mnCount;
+			const SpawnRegion& mRegion;
+			const TraitDistribution& mTraits;
+			Rng& mRng;
+			unsigned& mnSpawned;
 		};
 
-		template<typename F>
-		void VisitSpawnTuple(F _func, int _i)
+		// SpawnMany for species _species
+		inline unsigned SpawnMany(EcoSystem& _eco, unsigned _species, unsigned _count, const SpawnRegion& _region, const TraitDistribution& _traits, Rng& _rng)
 		{
-			VisitTuple_Impl<std::tuple_size_v<CreatureList>>::Visit<CreatureList>(_i, _func);
+			unsigned n = 0;
+			VisitSpawnTuple(SpawnManyVisitor{ _eco, _count, _region, _traits, _rng, n }, static_cast<int>(_species));
+			return n;
 		}
+
+		// species _species on _fraction of the region's free cells, 0.8 on an empty map fills 80% of it
+		inline unsigned SpawnFill(EcoSystem& _eco, unsigned _species, float _fraction, const SpawnRegion& _region, const TraitDistribution& _traits, Rng& _rng)
+		{
+			const float f = _fraction < 0.f ? 0.f : _fraction > 1.f ? 1.f : _fraction;
+			const unsigned count = static_cast<unsigned>(static_cast<double>(_eco.CountFreeCells(_region)) * f + 0.5);
+			return SpawnMany(_eco, _species, count, _region, _traits, _rng);
+		}
+
+		using UpdateRangeFn = void (*)(CreaturePoolBase&, unsigned, unsigned, float) noexcept;
+		using UpdateTable = std::array<UpdateRangeFn, std::tuple_size_v<CreatureList>>;
+
+		template<std::size_t ... I>
+		constexpr UpdateTable MakeUpdateTable_Impl(bool _batched, std::index_sequence<I...>) noexcept
+		{
+			return { { (_batched ? &Creature::UpdateAwakeBatched<std::tuple_element_t<I, CreatureList>>
+				: &Creature::UpdateAwakeRange<std::tuple_element_t<I, CreatureList>>)... } };
+		}
+
+		// per species update of a pool range, each entry calls its species' behaviour without going through the vtable
+		inline constexpr UpdateTable UpdateRanges = MakeUpdateTable_Impl(false, std::make_index_sequence<std::tuple_size_v<CreatureList>>{});
+		inline constexpr UpdateTable BatchedUpdateRanges = MakeUpdateTable_Impl(true, std::make_index_sequence<std::tuple_size_v<CreatureList>>{});
 	}
 }
 
@@ -0,0 +1,153 @@
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "EcoSystem/Grid.h"
+
+// "ECOC", u32 version, then every section in the order EcoSystem::SaveCheckpoint writes them. planes are stored
+// raw with their row padding, a load is a handful of memcpys
+#define CHECKPOINT_MAGIC "ECOC"
+#define CHECKPOINT_VERSION 7u
+// where the gui saves to and loads from
+#define CHECKPOINT_DEFAULT_PATH "checkpoint.eco"
+
+namespace CS380
+{
+	// appends to one growing block, the sim only ever serializes to memory and leaves the disk to a writer thread
+	class CheckpointWriter
+	{
+	public:
+		CheckpointWriter(void) noexcept
+			: mBuffer{}
+		{}
+
+		void Bytes(const void* _p, std::size_t _n)
+		{
+			const unsigned char* b = static_cast<const unsigned char*>(_p);
+			mBuffer.insert(mBuffer.end(), b, b + _n);
+		}
+
+		template<typename T>
+		void Pod(const T& _v)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "only raw copyable values go in as they are");
+			Bytes(&_v, sizeof(T));
+		}
+
+		template<typename T>
+		void Vector(const std::vector<T>& _v)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "only raw copyable values go in as they are");
+			Pod(static_cast<std::uint64_t>(_v.size()));
+			Bytes(_v.data(), _v.size() * sizeof(T));
+		}
+
+		template<typename T>
+		void Plane(const Grid<T>& _g)
+		{
+			Pod(_g.GetWidth());
+			Pod(_g.GetHeight());
+			Bytes(_g.Data(), static_cast<std::size_t>(_g.GetStride()) * _g.GetHeight() * sizeof(T));
+		}
+
+		std::vector<unsigned char>& GetBuffer(void) noexcept { return mBuffer; }
+
+	private:
+		std::vector<unsigned char> mBuffer;
+	};
+
+	// reads back over a block in memory. a short or mismatched read sets the failed flag and every read after it
+	// returns zeros, so a loader checks once at the end instead of after every value
+	class CheckpointReader
+	{
+	public:
+		CheckpointReader(const unsigned char* _p, std::size_t _n) noexcept
+			: mpData{ _p }, mnSize{ _n }, mnPos{ 0 }, mbFailed{ false }
+		{}
+
+		bool Bytes(void* _p, std::size_t _n) noexcept
+		{
+			if (mbFailed || _n > mnSize - mnPos)
+			{
+				mbFailed = true;
+				if (_n)
+					std::memset(_p, 0, _n);
+				return false;
+			}
+			// an empty vector's data may be null
+			if (_n)
+				std::memcpy(_p, mpData + mnPos, _n);
+			mnPos += _n;
+			return true;
+		}
+
+		template<typename T>
+		void Pod(T& _out) noexcept
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "only raw copyable values come out as they are");
+			Bytes(&_out, sizeof(T));
+		}
+
+		template<typename T>
+		T Pod(void) noexcept
+		{
+			T v{};
+			Pod(v);
+			return v;
+		}
+
+		template<typename T>
+		void Vector(std::vector<T>& _out)
+		{
+			const std::uint64_t n = Pod<std::uint64_t>();
+			if (mbFailed || n > (mnSize - mnPos) / sizeof(T))
+			{
+				mbFailed = true;
+				_out.clear();
+				return;
+			}
+			_out.resize(static_cast<std::size_t>(n));
+			Bytes(_out.data(), _out.size() * sizeof(T));
+		}
+
+		// the plane has to come back the size the caller expects
+		template<typename T>
+		void Plane(Grid<T>& _g, unsigned _w, unsigned _h)
+		{
+			const unsigned w = Pod<unsigned>();
+			const unsigned h = Pod<unsigned>();
+			if (w != _w || h != _h)
+			{
+				mbFailed = true;
+				return;
+			}
+			_g.Resize(w, h);
+			Bytes(_g.Data(), static_cast<std::size_t>(_g.GetStride()) * h * sizeof(T));
+		}
+
+		void Fail(void) noexcept { mbFailed = true; }
+		bool Failed(void) const noexcept { return mbFailed; }
+		bool AtEnd(void) const noexcept { return mnPos == mnSize; }
+
+	private:
+		const unsigned char* mpData;
+		std::size_t mnSize;
+		std::size_t mnPos;
+		bool mbFailed;
+	};
+
+	// whole file in one go, false when it could not be opened or read
+	bool ReadCheckpointFile(const std::string& _path, std::vector<unsigned char>& _out);
+	bool WriteCheckpointFile(const std::string& _path, const std::vector<unsigned char>& _data) noexcept;
+}
+
+#endif
+
+
+
@@ -0,0 +1,126 @@
+#ifndef _CHUNKED_GRID_H_
+#define _CHUNKED_GRID_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// cells per side of a chunk, as a shift
+#define CHUNK_SHIFT 6
+#define CHUNK_SIZE (1u << CHUNK_SHIFT)
+#define CHUNK_MASK (CHUNK_SIZE - 1u)
+
+namespace CS380
+{
+	// world sized layer kept as CHUNK_SIZE x CHUNK_SIZE blocks that are only allocated once a cell in them is
+	// written, for layers that stay empty over most of a large world. a directory holds one pointer per chunk,
+	// so a lookup is a shift, a mask and one indirection. cells of a chunk never written read as the fill value.
+	// reads never allocate, so any number of threads may read while nobody calls Touch
+	template<typename T>
+	class ChunkedGrid
+	{
+	public:
+		ChunkedGrid(void) noexcept
+			: mDirectory{}, mFill{}, mnWidth{ 0 }, mnHeight{ 0 }, mnChunksX{ 0 }, mnChunksY{ 0 }, mnAllocated{ 0 }
+		{}
+
+		// drops every chunk
+		void Resize(unsigned _w, unsigned _h, const T& _fill = T{});
+
+		unsigned GetWidth(void) const noexcept { return mnWidth; }
+		unsigned GetHeight(void) const noexcept { return mnHeight; }
+		bool InBounds(int _x, int _y) const noexcept
+		{
+			return static_cast<unsigned>(_x) < mnWidth && static_cast<unsigned>(_y) < mnHeight;
+		}
+
+		const T& operator()(unsigned _x, unsigned _y) const noexcept
+		{
+			const Chunk* c = mDirectory[Slot(_x, _y)].get();
+			return c ? c->mCells[Cell(_x, _y)] : mFill;
+		}
+		// writable cell, allocating its chunk on first use
+		T& Touch(unsigned _x, unsigned _y);
+		// writable cell, nullptr when its chunk was never allocated
+		T* Find(unsigned _x, unsigned _y) noexcept
+		{
+			Chunk* c = mDirectory[Slot(_x, _y)].get();
+			return c ? c->mCells + Cell(_x, _y) : nullptr;
+		}
+
+		unsigned GetChunkCount(void) const noexcept { return mnChunksX * mnChunksY; }
+		unsigned GetAllocatedChunks(void) const noexcept { return mnAllocated; }
+		std::size_t GetMemoryBytes(void) const noexcept
+		{
+			return mDirectory.size() * sizeof(std::unique_ptr<Chunk>) + static_cast<std::size_t>(mnAllocated) * sizeof(Chunk);
+		}
+
+		// _func(T* cells, CHUNK_SIZE * CHUNK_SIZE of them) over every allocated chunk
+		template<typename F>
+		void ForEachChunk(F&& _func);
+
+	private:
+		struct Chunk
+		{
+			T mCells[CHUNK_SIZE * CHUNK_SIZE];
+		};
+
+		std::vector<std::unique_ptr<Chunk>> mDirectory;
+		T mFill;
+		unsigned mnWidth;
+		unsigned mnHeight;
+		unsigned mnChunksX;
+		unsigned mnChunksY;
+		unsigned mnAllocated;
+
+		std::size_t Slot(unsigned _x, unsigned _y) const noexcept
+		{
+			return static_cast<std::size_t>(_y >> CHUNK_SHIFT) * mnChunksX + (_x >> CHUNK_SHIFT);
+		}
+		static unsigned Cell(unsigned _x, unsigned _y) noexcept
+		{
+			return ((_y & CHUNK_MASK) << CHUNK_SHIFT) | (_x & CHUNK_MASK);
+		}
+	};
+
+	template<typename T>
+	inline void ChunkedGrid<T>::Resize(unsigned _w, unsigned _h, const T& _fill)
+	{
+		mnWidth = _w;
+		mnHeight = _h;
+		mnChunksX = (_w + CHUNK_SIZE - 1) >> CHUNK_SHIFT;
+		mnChunksY = (_h + CHUNK_SIZE - 1) >> CHUNK_SHIFT;
+		mFill = _fill;
+		mDirectory.clear();
+		mDirectory.resize(static_cast<std::size_t>(mnChunksX) * mnChunksY);
+		mnAllocated = 0;
+	}
+
+	template<typename T>
+	inline T& ChunkedGrid<T>::Touch(unsigned _x, unsigned _y)
+	{
+		std::unique_ptr<Chunk>& c = mDirectory[Slot(_x, _y)];
+		if (!c)
+		{
+			c = std::make_unique<Chunk>();
+			for (T& v : c->mCells)
+				v = mFill;
+			++mnAllocated;
+		}
+		return c->mCells[Cell(_x, _y)];
+	}
+
+	template<typename T>
+	template<typename F>
+	inline void ChunkedGrid<T>::ForEachChunk(F&& _func)
+	{
+		for (std::unique_ptr<Chunk>& c : mDirectory)
+			if (c)
+				_func(c->mCells, CHUNK_SIZE * CHUNK_SIZE);
+	}
+}
+
+#endif
+
+
+
@@ -0,0 +1,21 @@
+#ifndef _COLOR_H_
+#define _COLOR_H_
+
+namespace CS380
+{
+	// packs into the same 0xAABBGGRR layout as ImGui::GetColorU32, without needing an ImGui context
+	inline unsigned int PackColor(float _r, float _g, float _b, float _a = 1.f) noexcept
+	{
+		auto toByte = [](float _v) -> unsigned int
+		{
+			_v = _v < 0.f ? 0.f : _v > 1.f ? 1.f : _v;
+			return static_cast<unsigned int>(_v * 255.f + 0.5f);
+		};
+		return toByte(_r) | (toByte(_g) << 8) | (toByte(_b) << 16) | (toByte(_a) << 24);
+	}
+}
+
+#endif
+
+
+
@@ -0,0 +1,97 @@
+#ifndef _COMMAND_BUFFER_H_
+#define _COMMAND_BUFFER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "EcoSystem/CreatureHandle.h"
+
+// queued path requests a parallel serve hands the pool at once, the budget is checked between batches
+#define PATH_QUEUE_BATCH 64
+// nodes the queued searches of one tick may expand before the rest wait for the next, see EcoSystem::SetPathBudget
+#define DEFAULT_PATH_BUDGET 65536
+
+namespace CS380
+{
+	struct GridPos;
+	enum PathMode : unsigned char;
+
+	// a path mActor asked for with Creature::RequestMovement, planned from wherever it stands when the request
+	// is answered. mnTicket tells a request apart from the ones the creature made before it
+	struct PathRequest
+	{
+		CreatureHandle mActor;
+		int mnDestX;
+		int mnDestY;
+		std::uint32_t mnTicket;
+		PathMode meMode;
+	};
+
+	// energy a creature handed back to the map, the EcoSystem sums them per cell and puts them down in cell order
+	// once the creature phase is over
+	struct EnergyReturn
+	{
+		// row in the high half and column in the low, so sorting on it walks the map row by row
+		std::uint64_t mnCell;
+		float mfValue;
+	};
+
+	// a change to shared state asked for by a creature while the creature phase runs in parallel
+	struct WorldCommand
+	{
+		enum Type : unsigned char
+		{
+			// mfValue onto the fertilizer at (x, y)
+			CMD_FERTILIZE,
+			// mActor eats whatever is at (x, y), creature or grass
+			CMD_EAT,
+			// path request from (x, y) to (dest x, dest y), only feeds the flow field cache
+			CMD_PATH,
+			// mActor left (x, y) for (dest x, dest y), for the occupancy layer
+			CMD_MOVE
+		};
+
+		Type meType;
+		CreatureHandle mActor;
+		int mnX;
+		int mnY;
+		int mnDestX;
+		int mnDestY;
+		float mfValue;
+	};
+
+	// commands recorded by one slice of creatures in the order they were asked for. the EcoSystem replays the
+	// slices in creature order once every worker is done, so the world comes out the same for any thread count
+	class CommandBuffer
+	{
+	public:
+		CommandBuffer(void) noexcept;
+
+		void ReturnEnergy(const GridPos& _p, float _v);
+		void Eat(const CreatureHandle& _actor, const GridPos& _p);
+		void NotePath(const GridPos& _src, const GridPos& _dest);
+		void Move(const CreatureHandle& _actor, const GridPos& _from, const GridPos& _to);
+		void RequestPath(const PathRequest& _request);
+
+		void Clear(void) noexcept;
+		const std::vector<WorldCommand>& GetCommands(void) const noexcept;
+		// kept apart from the commands, they join the world's path queue in the same order
+		const std::vector<PathRequest>& GetPathRequests(void) const noexcept;
+		// apart too, they join the world's energy ledger
+		const std::vector<EnergyReturn>& GetReturns(void) const noexcept;
+
+		// buffer the calling thread records into, nullptr when changes apply immediately
+		static CommandBuffer* GetActive(void) noexcept;
+		static void SetActive(CommandBuffer* _buffer) noexcept;
+
+	private:
+		std::vector<WorldCommand> mCommands;
+		std::vector<PathRequest> mPathRequests;
+		std::vector<EnergyReturn> mReturns;
+	};
+}
+
+#endif
+
+
+
@@ -0,0 +1,37 @@
+#ifndef _CREATURE_HANDLE_H_
+#define _CREATURE_HANDLE_H_
+
+#define CREATURE_HANDLE_SLOT_BITS 24
+#define CREATURE_HANDLE_SLOT_MASK ((1u << CREATURE_HANDLE_SLOT_BITS) - 1)
+
+namespace CS380
+{
+	// species + pool slot + generation, 8 bytes. a handle to a creature that has since died (or whose slot was reused)
+	// resolves to nullptr instead of to whoever lives there now
+	struct CreatureHandle
+	{
+		CreatureHandle(void) noexcept
+			: mnIndex{ 0 }, mnGen{ 0 }
+		{}
+
+		CreatureHandle(unsigned _species, unsigned _slot, unsigned _gen) noexcept
+			: mnIndex{ (_species << CREATURE_HANDLE_SLOT_BITS) | (_slot & CREATURE_HANDLE_SLOT_MASK) }, mnGen{ _gen }
+		{}
+
+		unsigned GetSpecies(void) const noexcept { return mnIndex >> CREATURE_HANDLE_SLOT_BITS; }
+		unsigned GetSlot(void) const noexcept { return mnIndex & CREATURE_HANDLE_SLOT_MASK; }
+		// generation 0 is never handed out
+		bool IsValid(void) const noexcept { return mnGen != 0; }
+
+		bool operator==(const CreatureHandle& _rhs) const noexcept { return mnIndex == _rhs.mnIndex && mnGen == _rhs.mnGen; }
+		bool operator!=(const CreatureHandle& _rhs) const noexcept { return !(*this == _rhs); }
+
+		unsigned mnIndex;
+		unsigned mnGen;
+	};
+}
+
+#endif
+
+
+
@@ -0,0 +1,183 @@
+#ifndef _CREATURE_POOL_H_
+#define _CREATURE_POOL_H_
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "EcoSystem/CreatureHandle.h"
+#include "EcoSystem/PopulationStats.h"
+
+// creatures per slab, slabs are never moved or freed until the pool is so addresses stay stable
+#define CREATURE_POOL_SLAB 256
+
+namespace CS380
+{
+	class Creature;
+	class CreaturePoolBase;
+	class EcoSystem;
+	class CheckpointWriter;
+	class CheckpointReader;
+
+	// per tick creature state kept as parallel arrays, row i belongs to GetLive(i). the Creature accessors read and
+	// write through here, so batch passes over a whole species touch only the columns they need
+	struct CreatureHotData
+	{
+		std::vector<float> mEnergy;
+		std::vector<float> mEnergyMax;
+		std::vector<float> mFatigue;
+		std::vector<float> mFatigueMax;
+		std::vector<float> mSize;
+		std::vector<float> mSpeed;
+		std::vector<float> mSense;
+		// the part of every action's cost that only depends on traits, set once at birth since traits never change
+		std::vector<float> mMetabolism;
+		std::vector<float> mPathDt;
+		// what the path timer has to pass for the next step, so waiting on a step is a compare
+		std::vector<float> mStepDt;
+		// a resting creature's behaviour is woken once its energy drops under this, see Creature::Rest
+		std::vector<float> mWakeEnergy;
+		// scratch for the batched pass, idle cost the creature could not pay
+		std::vector<float> mIdleDebt;
+		// next creature standing on the same cell, the cell itself holds the first
+		std::vector<CreatureHandle> mCellNext;
+		std::vector<unsigned> mPosX;
+		std::vector<unsigned> mPosY;
+		std::vector<unsigned short> mFlags;
+
+		template<typename F>
+		void ForEachColumn(F&& _func)
+		{
+			_func(mEnergy); _func(mEnergyMax); _func(mFatigue); _func(mFatigueMax);
+			_func(mSize); _func(mSpeed); _func(mSense); _func(mMetabolism); _func(mPathDt); _func(mStepDt); _func(mWakeEnergy); _func(mIdleDebt);
+			_func(mCellNext); _func(mPosX); _func(mPosY); _func(mFlags);
+		}
+
+		template<typename F>
+		void ForEachColumn(F&& _func) const
+		{
+			const_cast<CreatureHotData*>(this)->ForEachColumn([&_func](const auto& _col) { _func(_col); });
+		}
+	};
+
+	// where the creature being constructed on this thread lives, handed out by Acquire and picked up by the Creature constructor
+	struct CreatureBinding
+	{
+		EcoSystem* mpWorld;
+		CreatureHotData* mpHot;
+		CreatureHandle mHandle;
+		unsigned mnRow;
+	};
+
+	// slab allocator for one species. everything except construction is type erased, so the
+	// EcoSystem can hold every species' pool in one list and destroy through Creature's virtual destructor
+	class CreaturePoolBase
+	{
+	public:
+		CreaturePoolBase(EcoSystem& _world, unsigned _species, std::size_t _size, std::size_t _align) noexcept;
+		virtual ~CreaturePoolBase(void) noexcept;
+
+		CreaturePoolBase(const CreaturePoolBase&) = delete;
+		CreaturePoolBase& operator=(const CreaturePoolBase&) = delete;
+
+		// nullptr for stale or foreign handles
+		Creature* Get(const CreatureHandle& _h) const noexcept;
+		void Destroy(const CreatureHandle& _h) noexcept;
+		void Clear(void) noexcept;
+		// room for _count more creatures in one go, slabs and every column. slots still go out in the order
+		// creating them one at a time would hand them out in
+		void Reserve(unsigned _count);
+
+		// live creatures packed densely, order changes when one is destroyed
+		unsigned GetLiveCount(void) const noexcept;
+		Creature* GetLive(unsigned _i) const noexcept;
+		CreatureHandle GetLiveHandle(unsigned _i) const noexcept;
+
+		unsigned GetSpecies(void) const noexcept;
+		// the world every creature of the pool lives in
+		EcoSystem& GetWorld(void) const noexcept;
+
+		CreatureHotData& GetHot(void) noexcept;
+		const CreatureHotData& GetHot(void) const noexcept;
+		// hot data row of a live slot, changes when another creature of the species is destroyed
+		unsigned GetRow(unsigned _slot) const noexcept { return mSlots[_slot].mnDense; }
+
+		// kept up as creatures are committed and destroyed, extremes lost to a death are recounted here
+		const SpeciesStats& GetStats(void) noexcept;
+
+		static CreatureBinding TakeBinding(void) noexcept;
+
+		// slot generations, free list, hot columns and every live creature's own state. Load puts the pool back
+		// slot for slot, so handles held anywhere else in the checkpoint stay valid
+		void Save(CheckpointWriter& _w) const;
+		bool Load(CheckpointReader& _r);
+		// one live creature, its hot row then its own state, for handing it over to another world. LoadRecord makes
+		// it in a free slot and counts it live but not spawned, an invalid handle when the record does not read
+		void SaveRecord(unsigned _row, CheckpointWriter& _w) const;
+		CreatureHandle LoadRecord(CheckpointReader& _r);
+
+	protected:
+		// reserves a slot and its hot data row and returns its storage, Commit once the object is constructed in it
+		void* Acquire(unsigned& _outSlot);
+		CreatureHandle Commit(unsigned _slot, Creature* _c) noexcept;
+		// an object of the pool's species in _mem for Load to fill in, its constructor arguments do not matter
+		virtual Creature* ConstructBlank(void* _mem) = 0;
+
+	private:
+		// the row of a slot Acquire or Load picked, bound for the constructor
+		void* BindSlot(unsigned _slot);
+		void AddStats(unsigned _row) noexcept;
+
+		struct Slot
+		{
+			Creature* mpCreature;
+			unsigned mnGen;
+			unsigned mnDense;
+		};
+
+		std::vector<void*> mSlabs;
+		std::vector<Slot> mSlots;
+		std::vector<unsigned> mFree;
+		std::vector<Creature*> mDense;
+		std::vector<unsigned> mDenseSlots;
+		CreatureHotData mHot;
+		SpeciesStats mStats;
+		EcoSystem* mpWorld;
+
+		std::size_t mnStride;
+		std::size_t mnAlign;
+		unsigned mnSpecies;
+	};
+
+	template<typename T>
+	class CreaturePool final : public CreaturePoolBase
+	{
+	public:
+		CreaturePool(EcoSystem& _world, unsigned _species) noexcept
+			: CreaturePoolBase{ _world, _species, sizeof(T), alignof(T) }
+		{}
+
+		template<typename ... Args>
+		T* Create(CreatureHandle& _outHandle, Args&& ... _args)
+		{
+			unsigned slot = 0;
+			T* c = new (Acquire(slot)) T{ std::forward<Args>(_args)... };
+			_outHandle = Commit(slot, c);
+			return c;
+		}
+
+	protected:
+		Creature* ConstructBlank(void* _mem) override
+		{
+			// traits named through T so this only needs Traits where a pool is instantiated
+			using TraitsType = decltype(std::declval<const T&>().GetTraits());
+			return new (_mem) T{ TraitsType{ 1.f, 1.f, 1.f }, 0u };
+		}
+	};
+}
+
+#endif
+
+
+
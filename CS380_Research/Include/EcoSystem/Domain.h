@@ -0,0 +1,91 @@
+#ifndef _DOMAIN_H_
+#define _DOMAIN_H_
+
+#include <vector>
+
+#include "EcoSystem/Checkpoint.h"
+#include "EcoSystem/EcoSystem.h"
+
+// cells around a process's own rectangle its map also holds, creatures and reach of one tick have to fit in it
+#define DOMAIN_HALO 8
+
+namespace CS380
+{
+	// one process's part of a world cut into a grid of rectangles, a rectangle per process. the process's EcoSystem
+	// holds its rectangle and a DOMAIN_HALO wide ring of the neighbours' cells around it, and after every tick
+	// Exchange sends each neighbour the edits made to its cells, the creatures that walked onto them and the
+	// current values of the cells its ring holds. no creature is in two maps at once, so across a cut creatures
+	// only meet once one has crossed, and the ring and the edits are a tick behind. processes talk over MPI when
+	// built with ECO_WITH_MPI, without it there is only ever the one process and a domain of the whole world
+	class Domain
+	{
+	public:
+		// _w by _h cells in all, cut up between every process
+		Domain(unsigned _w, unsigned _h) noexcept;
+
+		Domain(const Domain&) = delete;
+		Domain& operator=(const Domain&) = delete;
+
+		// once per process before any domain is made and after the last one went, false if it could not start
+		static bool InitProcesses(int* _argc, char*** _argv) noexcept;
+		static void FinishProcesses(void) noexcept;
+		static unsigned GetProcessRank(void) noexcept;
+		static unsigned GetProcessCount(void) noexcept;
+
+		// sizes _eco's map to this process's part and seeds it off its master seed, before Begin
+		void Attach(EcoSystem& _eco) noexcept;
+		// after the EcoSystem's Begin and before anything spawns
+		void Begin(void);
+		// this process's cut of _total creatures spread evenly over the world, the cuts add up to _total
+		unsigned Share(unsigned _total) const noexcept;
+		// after every Tick on every process
+		void Exchange(void);
+		// _n values summed over every process in place
+		void Sum(double* _v, unsigned _n) const noexcept;
+
+		// the rectangle this process owns and the one its map covers, in world cells
+		unsigned GetOwnedX(void) const noexcept { return mOwned.mnX0; }
+		unsigned GetOwnedY(void) const noexcept { return mOwned.mnY0; }
+		unsigned GetOwnedWidth(void) const noexcept { return mOwned.mnX1 - mOwned.mnX0; }
+		unsigned GetOwnedHeight(void) const noexcept { return mOwned.mnY1 - mOwned.mnY0; }
+
+	private:
+		struct Rect
+		{
+			unsigned mnX0;
+			unsigned mnY0;
+			unsigned mnX1;
+			unsigned mnY1;
+		};
+
+		Rect GetOwned(unsigned _rank) const noexcept;
+		Rect GetWindow(unsigned _rank) const noexcept;
+		unsigned OwnerOf(unsigned _x, unsigned _y) const noexcept;
+		// where _rank's message goes in mOut, the peer count for a process that is not a peer. every peer gets one
+		// each exchange even when it is empty
+		unsigned PeerIndex(unsigned _rank) const noexcept;
+		void ApplyMessage(unsigned _from, const std::vector<unsigned char>& _msg);
+
+		EcoSystem* mpEco;
+		unsigned mnWidth;
+		unsigned mnHeight;
+		unsigned mnRank;
+		unsigned mnCount;
+		// processes across and down
+		unsigned mnGridX;
+		unsigned mnGridY;
+		Rect mOwned;
+		Rect mWindow;
+		// every process whose rectangle reaches into this one's map, which is also every one whose map reaches
+		// into this one's rectangle
+		std::vector<unsigned> mPeers;
+		std::vector<CheckpointWriter> mOut;
+		std::vector<CheckpointWriter> mMigrants;
+		std::vector<unsigned> mnMigrants;
+	};
+}
+
+#endif
+
+
+
@@ -1,17 +1,49 @@
 #ifndef _ECOSYSTEM_H_
 #define _ECOSYSTEM_H_
 
+#include "CommandBuffer.h"
+#include "CreaturePool.h"
+#include "GridRenderer.h"
+#include "PathArena.h"
+#include "Profiler.h"
+#include "RingBuffer.h"
+#include "ScentField.h"
+#include "SpatialIndex.h"
+#include "SpscQueue.h"
+#include "Telemetry.h"
 #include "Terrain.h"
+#include "ThreadPool.h"
 #include "Tools/Tools.h"
+#include "TripleBuffer.h"
+#include "WorldSnapshot.h"
 
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
 #include <tuple>
 #include <stack>
+#include <thread>
 #include <vector>
 
+// every simulation tick integrates exactly this much time, regardless of frame rate
+#define FIXED_DT 0.01666666666f
+#define DEFAULT_MAX_TICKS_PER_FRAME 64
+// world size before RenderSetup / SetWorldSize pick one, and the largest side the setup lets through
+#define DEFAULT_WORLD_SIDE 64
+#define MAX_WORLD_SIDE 16384
+// creatures per job of the parallel creature phase, each job records into its own CommandBuffer
+#define CREATURE_SLICE_SIZE 256
+// gui commands in flight to the sim thread, more than that in one frame are dropped
+#define UI_COMMAND_CAPACITY 1024
+
 namespace CS380
 {
 	class Creature;
+	class Domain;
 	class Tools;
+	struct EvolutionData;
 	enum LogTypes
 	{
 		AVG_SPEED,
@@ -22,54 +54,219 @@ namespace CS380
 		LAST
 	};
 
+	// the parts of a tick, timed by every Tick
+	enum TickPhase
+	{
+		PHASE_TERRAIN,
+		PHASE_CREATURES,
+		PHASE_CLEANUP,
+		PHASE_LOGS,
+		PHASE_COUNT
+	};
+
+	// a rectangle of cells to spawn into, clipped to the map. one with no width or height is the whole map
+	struct SpawnRegion
+	{
+		unsigned mnX;
+		unsigned mnY;
+		unsigned mnWidth;
+		unsigned mnHeight;
+	};
+
+	// one world, its terrain, creatures, seed and parameters. worlds share nothing, so several can run side by
+	// side on their own threads (see Ensemble)
 	class EcoSystem final
 	{
 	public:
-		static EcoSystem& GetInst(void) noexcept;
+		EcoSystem(unsigned _w = DEFAULT_WORLD_SIDE, unsigned _h = DEFAULT_WORLD_SIDE, unsigned _s = 32) noexcept;
 		~EcoSystem(void) noexcept;
 
+		EcoSystem(const EcoSystem&) = delete;
+		EcoSystem& operator=(const EcoSystem&) = delete;
+
 		void Init(void) noexcept;
+		// frees the map textures, while the GL context is still alive
+		void Shutdown(void) noexcept;
 
 		void UpdateWindowSize(int, int) noexcept;
+		// gui frame, runs the tools and map rendering off the latest snapshot. the simulation itself runs on its
+		// own thread from Begin on, so a slow frame never holds a tick up
 		void Update(float) noexcept;
 
+		// accumulates frame time (scaled by the time step) and runs as many FIXED_DT ticks as the per frame budget allows
+		unsigned Advance(float _frameDt) noexcept;
+
+		// one simulation tick of FIXED_DT, no ImGui calls (used by the headless runner)
+		void Tick(void) noexcept;
+		unsigned long long GetTickCount(void) const noexcept;
+		// wall time spent in a phase, summed over the ticks since the last reset
+		double GetPhaseSeconds(TickPhase _phase) const noexcept;
+		void ResetPhaseTimes(void) noexcept;
+		// per tick zone timers and search counters, off until enabled (see Profiler). the gui sees its
+		// history in the snapshot, a trace capture is only driven from the sim thread or while it is stopped
+		Profiler& GetProfiler(void) noexcept;
+		const Profiler& GetProfiler(void) const noexcept;
+		// every creature's planned path, see Creature::SetMovement
+		PathArena& GetPaths(void) noexcept;
+
+		// headless set up, same values RenderSetup exposes
+		void SetWorldSize(unsigned _w, unsigned _h) noexcept;
+		void SetGrassParams(float _initialA, float _initialLo, float _initialHi, float _rateLo, float _rateHi, float _maxEnergy) noexcept;
+		void SetFertilizerParams(float _rateLo, float _rateHi, float _maxEnergy, float _deathThresh) noexcept;
+		// smooth patches in the growth rates Begin draws, see Terrain::SetRateNoise
+		void SetRateNoise(float _mix, float _scale = TERRAIN_NOISE_SCALE) noexcept;
+		// this world's master seed and entity counter, set the seed before Begin to replay a run
+		Random& GetRandom(void) noexcept;
+		const Random& GetRandom(void) const noexcept;
+		// replication parameters per chart entry and how far offspring traits mutate, starting from
+		// DefaultEvolutionChart and DEFAULT_MUTATION_EPSILON. new offspring pick changes up straight away
+		const EvolutionData& GetEvolutionData(unsigned _i) const noexcept;
+		void SetEvolutionData(unsigned _i, const EvolutionData& _evo) noexcept;
+		float GetMutationEpsilon(void) const noexcept;
+		void SetMutationEpsilon(float _eps) noexcept;
+		void Begin(void) noexcept;
+		bool IsRunning(void) const noexcept;
+		// sim thread, ticking at the time step scaled real time (or flat out when unthrottled) and publishing a
+		// snapshot whenever the gui took the last one. Stop is safe to call when it never started
+		void StartSimThread(void);
+		void StopSimThread(void) noexcept;
+		// gui thread only, the snapshot the current frame draws and the way back to the sim
+		const WorldSnapshot& GetView(void) const noexcept;
+		bool PushCommand(const UiCommand& _cmd) noexcept;
+		// 0 uses every hardware thread
+		void SetWorkerCount(unsigned _n) noexcept;
+		ThreadPool& GetThreadPool(void) noexcept;
+		// idle drain and path timers as one pass per species over the pool's hot data instead of per creature
+		void SetBatchedUpdate(bool _b) noexcept;
+		bool IsBatchedUpdate(void) const noexcept;
+		// creature phase spread over the thread pool, world changes are recorded and resolved in creature order at
+		// the end of it. the result does not depend on the thread count
+		void SetParallelUpdate(bool _b) noexcept;
+		bool IsParallelUpdate(void) const noexcept;
+		// grass and fertilizer worked out per cell when read instead of swept every tick, see Terrain::SetLazy
+		void SetLazyTerrain(bool _b) noexcept;
+		bool IsLazyTerrain(void) const noexcept;
+		// species (a bit per CreatureList index) that leave a scent behind, see ScentField. spread in the terrain
+		// phase and read by predators in place of a search for prey, none by default
+		void SetScentSpecies(unsigned _mask) noexcept;
+		unsigned GetScentSpecies(void) const noexcept;
+		bool IsScented(unsigned _species) const noexcept;
+		// ScentField::Climb on _species' scent, only for a scented species
+		GridPos ClimbScent(const GridPos& _p, unsigned _species) const noexcept;
+		const ScentField& GetScent(void) const noexcept;
+
 		// aux inits
-		void AddCreature(Creature *);
+		// spawn count and peak population, once a creature constructed in its species pool has taken its cell
+		void NoteSpawn(void) noexcept;
+		CreaturePoolBase& GetPool(unsigned _species) noexcept;
 		template<typename T, typename SFNAE = std::enable_if_t<std::is_base_of_v<Tools, T>, T>>
 		void AddTools(T* _pTool);
 
+		// occupancy, kept current on every spawn, move and death instead of rebuilt each tick. a cell can hold
+		// several creatures, GetGridVal returns the latest to arrive and the others chain off it
+		void AddOccupant(const CreatureHandle& _h, const GridPos& _p) noexcept;
+		void MoveOccupant(const CreatureHandle& _h, const GridPos& _from, const GridPos& _to) noexcept;
+		// neighbour queries over the occupancy, species masks have one bit per CreatureList index. both see the
+		// layer as it was at the start of the creature phase while it runs in parallel
+		unsigned QueryRadius(const GridPos& _p, float _radius, unsigned _speciesMask, SpatialHit* _out, unsigned _capacity) const noexcept;
+		// _pred(const Creature*) on live candidates, nearest first. in the parallel phase alive means alive when it
+		// started, and the hit's cell is where the creature stood then. _pred may only read what a creature does
+		// not change during the phase (its traits), its flags and position belong to the slice updating it
+		template<typename P>
+		SpatialHit NearestOf(const GridPos& _p, float _radius, unsigned _species, P&& _pred) const;
+
 		// aux visual aid
-		void HighlightGrid(unsigned short x, unsigned short y, unsigned int _col);
 		void HighlightGrid(unsigned x, unsigned y, unsigned int _col);
 
 		// getters
 		int GetWidth(void) const noexcept;
 		int GetHeight(void) const noexcept;
-		int GetGridVal(unsigned _x, unsigned _y) const noexcept;
+		CreatureHandle GetGridVal(unsigned _x, unsigned _y) const noexcept;
 		float GetGrassVal(unsigned _x, unsigned _y) const noexcept;
 		float GetGrassValA(unsigned _x, unsigned _y) const noexcept;
 		const Terrain& GetTerrain(void) const noexcept;
-		Creature * GetCreature(int i);
-		const std::deque<Creature *>& GetAllCreatures(void) const noexcept;
-		std::vector<GridPos> GetShortestPath(const GridPos& _src, const GridPos& _dest);
+		Creature * GetCreature(const CreatureHandle& _h) const noexcept;
+		unsigned GetCreatureCount(void) const noexcept;
+		// _func(Creature*, const CreatureHandle&) over every live creature, species by species
+		template<typename F>
+		void ForEachCreature(F&& _func) const;
+		// written into GetPaths, false when there is no path
+		bool GetShortestPath(const GridPos& _src, const GridPos& _dest, PathCursor& _out, PathMode _mode = PATH_AUTO);
+		// queues a path for _request's creature, see Creature::RequestMovement. the queue is served at the end of the
+		// creature phase in request order, on the thread pool when the phase runs in parallel, and every path
+		// goes to its creature before the tick moves on
+		void RequestPath(const PathRequest& _request);
+		// nodes the queued searches may expand in one tick, whatever is left waits for the next one. checked after
+		// every request (every PATH_QUEUE_BATCH in parallel), so a tick goes over by at most that. 0 for no limit
+		void SetPathBudget(unsigned _nodes) noexcept;
+		unsigned GetPathBudget(void) const noexcept;
+		std::size_t GetQueuedPaths(void) const noexcept;
 		GridPos GetBestGrassPos(const GridPos& _src, float _radiusLimit, float _minAlpha);
 		GridPos GetEmptyNeighbour(const GridPos& _src);
 		std::pair<float, float> GetScreenPos(const GridPos& _p) const noexcept;
+		// gui thread, the cell under the mouse when it is over the map and no window wants it, -1, -1 otherwise
+		GridPos GetHoveredCell(void) const noexcept;
 		float GetScalar(void) const noexcept;
-		const std::vector<std::deque<float>>& GetLogs(void) const noexcept;
+		const std::vector<RingBuffer<float>>& GetLogs(void) const noexcept;
+		// every log sample from here on also goes to _path, the global logs then per species count, peak and the
+		// mean, variance, min and max of speed, size and sense. only while the sim thread is not running. a
+		// blocking stream holds the tick up rather than drop samples, see TelemetryStream::Start
+		bool OpenTelemetry(const std::string& _path, bool _blocking = false);
+		void CloseTelemetry(void) noexcept;
+		// its row counts, still there after the close
+		const TelemetryStream& GetTelemetry(void) const noexcept;
+
+		// the whole run as of the last tick, copied into memory here and written out on a background thread.
+		// only between ticks, from the sim thread or while it is stopped
+		void SaveCheckpoint(const std::string& _path);
+		// waits for the last save to reach the disk, false if it did not make it
+		bool FinishCheckpoint(void) noexcept;
+		// takes the place of Begin and the spawns, with the sim thread stopped. a file that is not a checkpoint of this
+		// version leaves the world as it was, one that breaks off part way leaves it begun over empty
+		bool LoadCheckpoint(const std::string& _path);
+
+		// one part of a world cut up between processes, see Domain. only the cells of _owned are this world's own:
+		// spawns land in them, edits to the others are kept for their owner and the logs add up every part
+		void SetDomain(Domain* _domain, const SpawnRegion& _owned) noexcept;
+		// where this map sits in the whole world, for the fertilizer gradient Begin draws
+		void SetWorldFrame(unsigned _x, unsigned _y, unsigned _w, unsigned _h) noexcept;
+		bool IsOwned(unsigned _x, unsigned _y) const noexcept;
+		// grazing and fertilizer that landed outside the owned cells since the owner last took them, in order
+		std::vector<WorldCommand>& GetForeignEdits(void) noexcept;
+		// out of this world without dying or any death effects, its species and pool record go to _w
+		void Emigrate(const CreatureHandle& _h, CheckpointWriter& _w);
+		// the other end of Emigrate, the creature moves by _dx, _dy into this map. false when the record does not read
+		bool Immigrate(CheckpointReader& _r, int _dx, int _dy);
+		// a foreign edit another part made to one of the owned cells
+		void ApplyForeignEdit(const WorldCommand& _cmd) noexcept;
+		// a halo cell as its owner has it, see Terrain::SetCell
+		void OverwriteCell(unsigned _x, unsigned _y, float _grass, float _fert, float _fertLo) noexcept;
+		// the grass ratio sum of the owned cells only, the whole map's for a world of its own
+		double GetOwnedGrassRatioSum(void) const noexcept;
+
+		// _count creatures of a species with unit traits on random free cells, drawn from the world's spawn stream
+		void Populate(unsigned _species, unsigned _count) noexcept;
+		// the same on _fraction of the cells still free, from a stream of its own
+		void PopulateFill(unsigned _species, float _fraction) noexcept;
+		// free cells are kept as a bit per cell alongside the space layer, so these never walk the creatures
+		bool IsCellFree(unsigned _x, unsigned _y) const noexcept;
+		unsigned CountFreeCells(const SpawnRegion& _region) const noexcept;
+		// _count distinct free cells of _region, every choice equally likely, appended to _out in row order.
+		// returns how many, fewer than _count only when the region runs out of free cells
+		unsigned SampleFreeCells(unsigned _count, const SpawnRegion& _region, Rng& _rng, std::vector<GridPos>& _out) const;
 
 		// fun functions
 		void Nuke(void) noexcept;
+		// goes into the energy ledger and onto the fertilizer once the creature phase is over
 		void ReturnEnergyToMap(float _v, const GridPos& _p) noexcept;
 
 		// returns 0-1 if its grass, returns size prey's remainding energy, predator automatically gains energy according to return val
 		float Eat(const GridPos& _p, Creature* _predator);
 
+		// most creatures alive at once
 		unsigned mnPeakPops;
 
 	private:
-		EcoSystem(unsigned _w = 0, unsigned _h = 0, unsigned _s = 1) noexcept;
-
 		unsigned mnLogWindow;
 		unsigned mnWidth;
 		unsigned mnHeight;
@@ -78,22 +275,91 @@ namespace CS380
 		int mnWindowX;
 		int mnWindowY;
 		float mfDelta;
+		float mfTickAccumulator;
+		unsigned mnMaxTicksPerFrame;
+		unsigned long long mnTickCount;
+		double mPhaseSeconds[PHASE_COUNT];
 		float mfTitleBarSize;
 		float mfTimeStep;
 		float mfLogFreq;
 		float mfLogAccDt;
 		float mfScalar;
+		// map view, mfScalar is the fitted cell size times mfZoom, mfPan the cell at the top left corner and
+		// mfMapOrigin where cell 0, 0 lands on screen
+		float mfZoom;
+		float mfPanX;
+		float mfPanY;
+		float mfMapOriginX;
+		float mfMapOriginY;
 		bool mbEcoTool;
 		bool mbRunEco;
+		bool mbBatchedUpdate;
+		bool mbParallelUpdate;
+		bool mbUnthrottled;
+		// the front snapshot was swapped in this frame, its tile dirty bits have not been drawn yet
+		bool mbFreshView;
 
+		Random mRandom;
+		std::vector<EvolutionData> mEvolution;
+		float mfMutationEpsilon;
 
+		ThreadPool mThreadPool;
+		// timing is not world state, const paths like UpdateSlice count into it too
+		mutable Profiler mProfiler;
+		// ahead of the pools, creatures give their paths back as they go
+		PathArena mPaths;
 		Terrain mTerrain;
+		SpatialIndex mSpatial;
+		ScentField mScent;
+		// bit x of row y set while the space layer has a head on the cell, rows padded to whole words
+		std::vector<std::uint64_t> mOccupied;
+		unsigned mnOccupiedStride;
+		GridRenderer mGridRenderer;
 
-		std::deque<Creature*> mAllCreatures;
+		// one pool per CreatureList entry, indexed by species
+		std::vector<std::unique_ptr<CreaturePoolBase>> mPools;
+
+		struct CreatureSlice
+		{
+			unsigned mnPool;
+			unsigned mnBegin;
+			unsigned mnEnd;
+		};
+		std::vector<CreatureSlice> mSlices;
+		std::vector<CommandBuffer> mCommands;
+		// [species] a bit per pool slot, set for every creature alive as the parallel creature phase starts
+		std::vector<std::vector<std::uint64_t>> mSensedAlive;
+		// energy handed back this tick in creature order, empty between ticks
+		std::vector<EnergyReturn> mEnergyLedger;
+		// oldest first, what the budget left over from earlier ticks leads
+		std::vector<PathRequest> mPathQueue;
+		unsigned mnPathBudget;
+		// one batch of a parallel serve, indexed from the batch's first request. found is 1 once searched, 2 with a path
+		std::vector<PathCursor> mPathResults;
+		std::vector<unsigned> mPathNodes;
+		std::vector<unsigned char> mPathFound;
+		// source and destination of every search of a parallel serve, noted with the flow fields after it
+		std::vector<std::pair<GridPos, GridPos>> mPathNotes;
 		std::vector<Tools*> mTools;
-		std::stack<std::tuple<unsigned short, unsigned short, unsigned int>> mHighlightQueue;
+		// null and the whole map for a world of its own
+		Domain* mpDomain;
+		SpawnRegion mOwned;
+		std::vector<WorldCommand> mForeignEdits;
+		std::stack<std::tuple<unsigned, unsigned, unsigned int>> mHighlightQueue;
+
+		std::vector<RingBuffer<float>> mLogs;
+		TelemetryStream mTelemetry;
+		std::vector<float> mTelemetryRow;
+		std::future<bool> mCheckpointWrite;
 
-		std::vector<std::deque<float>> mLogs;
+		std::thread mSimThread;
+		std::atomic<bool> mbStopSim;
+		SpscQueue<UiCommand, UI_COMMAND_CAPACITY> mUiCommands;
+		TripleBuffer<WorldSnapshot> mSnapshots;
+		// publish each terrain tile last changed in
+		std::vector<unsigned> mTileChanged;
+		unsigned mnPublishCount;
+		SimSettings mUiSettings;
 
 		float mfInitialGrassA;
 		float mfInitialGrassVLo;
@@ -109,16 +375,45 @@ namespace CS380
 
 		void RenderMap(void);
 		void RenderGrid(void);
-		void RenderGridOverlay(void) noexcept;
+		void UpdateMapView(void) noexcept;
+		// refills and uploads the texels under one terrain tile
+		void RefreshMapTile(unsigned _tx, unsigned _ty);
+		unsigned int MapTexel(unsigned _bx, unsigned _by, unsigned _lod);
 		void RenderHighlights(void);
 		void RenderMenuBar(void);
 		void RenderSetup(void) noexcept;
 		void UpdateTools(void);
-		void UpdateMap(void);
-		void UpdateCreatures(float) const;
+		void RenderUI(void);
+		void RemoveOccupant(const CreatureHandle& _h, const GridPos& _p) noexcept;
+		// ConsumeGrass and AddFertilizer, noting the edit when the cell is not owned
+		float GrazeCell(const GridPos& _p, float _val) noexcept;
+		void FertilizeCell(const GridPos& _p, float _v) noexcept;
+		void RelinkOccupant(const CreatureHandle& _h, const GridPos& _from, const GridPos& _to) noexcept;
+		void LinkCell(const CreatureHandle& _h, const GridPos& _p) noexcept;
+		void UnlinkCell(const CreatureHandle& _h, const GridPos& _p) noexcept;
+		CreatureHandle& NextInCell(const CreatureHandle& _h) noexcept;
+		// every cell free, sized to the map
+		void ResetOccupancy(void);
+		// the scent spread by a tick and put down again where the scented creatures stand now
+		void UpdateScent(void) noexcept;
+		// a live handle's creature not dead as far as a NearestOf from the current thread can tell
+		bool IsSensedAlive(const CreatureHandle& _h, const Creature* _c) const noexcept;
+		void UpdateCreatures(float);
+		void UpdateSlice(CreaturePoolBase& _pool, unsigned _begin, unsigned _end, float _dt) const;
+		void ResolveCommands(const CommandBuffer& _cmd);
+		// the ledger summed per cell and put down in row order, the returns to a cell add up in the order they came
+		void SettleEnergy(void) noexcept;
+		void ServePaths(void);
 		void UpdateLogs(void) noexcept;
 		void EcoTool(void);
+		void PushSetting(UiCommand::Param _p, float _v, int _index = 0) noexcept;
 		void CleanUpDead(void);
+
+		void SimLoop(void) noexcept;
+		void ApplyCommand(const UiCommand& _cmd) noexcept;
+		void SpawnRandom(const UiCommand& _cmd) noexcept;
+		void PublishSnapshot(float _ticksPerSecond) noexcept;
+		void CaptureTile(WorldSnapshot& _s, unsigned _tx, unsigned _ty) noexcept;
 	};
 
 	template<typename T, typename SFNAE>
@@ -126,6 +421,24 @@ namespace CS380
 	{
 		mTools.push_back(static_cast<Tools*>(_pTool));
 	}
+
+	template<typename F>
+	inline void EcoSystem::ForEachCreature(F&& _func) const
+	{
+		for (const auto& pool : mPools)
+			for (unsigned i = 0; i < pool->GetLiveCount(); ++i)
+				_func(pool->GetLive(i), pool->GetLiveHandle(i));
+	}
+
+	template<typename P>
+	inline SpatialHit EcoSystem::NearestOf(const GridPos& _p, float _radius, unsigned _species, P&& _pred) const
+	{
+		return mSpatial.NearestOf(_p, _radius, _species, [this, &_pred](const CreatureHandle& _h)
+		{
+			const Creature* c = GetCreature(_h);
+			return c && IsSensedAlive(_h, c) && _pred(c);
+		});
+	}
 }
 
 #endif
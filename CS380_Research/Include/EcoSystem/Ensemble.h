@@ -0,0 +1,82 @@
+#ifndef _ENSEMBLE_H_
+#define _ENSEMBLE_H_
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Creatures/Creature.h"
+#include "EcoSystem/CommandBuffer.h"
+#include "EcoSystem/PopulationStats.h"
+
+namespace CS380
+{
+	// one world of an ensemble, its seed and everything it may differ in from the others. the set up is the
+	// headless runner's, so a member replays exactly as a headless run with the same options
+	struct EnsembleMember
+	{
+		std::uint64_t mnSeed = 0;
+		unsigned mnTicks = 10000;
+		unsigned mnWidth = 64;
+		unsigned mnHeight = 64;
+		// creatures spawned at the start per species, CreatureList order
+		std::vector<unsigned> mPopulation;
+		// then the fraction of the cells still free each species fills, CreatureList order
+		std::vector<float> mFill;
+		float mfGrassA = 0.1f;
+		float mfGrassRateLo = 0.0001f;
+		float mfGrassRateHi = 0.05f;
+		// see EcoSystem::SetRateNoise
+		float mfRateNoise = 0.f;
+		float mfMutationEpsilon = DEFAULT_MUTATION_EPSILON;
+		// takes the place of the default chart entries it covers
+		std::vector<EvolutionData> mEvolution;
+		bool mbBatched = false;
+		bool mbLazyTerrain = false;
+		// see EcoSystem::SetScentSpecies
+		unsigned mnScentMask = 0;
+		unsigned mnPathBudget = DEFAULT_PATH_BUDGET;
+	};
+
+	struct EnsembleResult
+	{
+		std::uint64_t mnSeed = 0;
+		unsigned long long mnTicks = 0;
+		unsigned mnCreatures = 0;
+		unsigned mnPeakPops = 0;
+		// grass / hi summed over the cells, the grass density log
+		double mfGrassDensity = 0.0;
+		// per species, CreatureList order
+		std::vector<SpeciesStats> mSpecies;
+		double mfSeconds = 0.0;
+	};
+
+	// runs many independent worlds at once, one world per thread at a time. each world keeps to a single worker
+	// of its own, the ensemble's threads are where the parallelism comes from
+	class Ensemble
+	{
+	public:
+		// _threads worlds at a time, 0 for every hardware thread
+		explicit Ensemble(unsigned _threads = 0) noexcept;
+
+		void Add(const EnsembleMember& _member);
+		unsigned GetSize(void) const noexcept;
+		const EnsembleMember& GetMember(unsigned _i) const noexcept;
+
+		// member index and its result, called as each world finishes. calls never overlap, the order does
+		using DoneFunc = std::function<void(unsigned, const EnsembleResult&)>;
+		// every member to its tick count, results in the order the members were added
+		std::vector<EnsembleResult> Run(const DoneFunc& _onDone = DoneFunc{});
+
+		static EnsembleResult RunMember(const EnsembleMember& _member);
+
+	private:
+		std::vector<EnsembleMember> mMembers;
+		unsigned mnThreads;
+	};
+}
+
+#endif
+
+
+
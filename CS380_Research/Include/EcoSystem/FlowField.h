@@ -0,0 +1,84 @@
+#ifndef _FLOWFIELD_H_
+#define _FLOWFIELD_H_
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// cells around the destination a field covers, creatures only path within their sense (<= MAX_CREATURE_SENSE)
+#define FLOW_FIELD_RADIUS 12
+#define FLOW_FIELD_CAPACITY 64
+// a destination gets a field once it has been asked for this many times while cached
+#define FLOW_FIELD_MIN_REQUESTS 2
+
+namespace CS380
+{
+	struct GridPos;
+	struct PathCursor;
+	class PathArena;
+	class CheckpointWriter;
+	class CheckpointReader;
+
+	// LRU cache of reverse dijkstra distance windows keyed by destination, a creature inside a window
+	// reads its next step straight off the field instead of running its own A*
+	class FlowFieldCache
+	{
+	public:
+		FlowFieldCache(void) noexcept;
+
+		// drops every field, call whenever the step costs change
+		void Reset(unsigned _w, unsigned _h) noexcept;
+
+		// counts a request for _dest, refreshes its LRU stamp and builds its field once asked for often enough
+		void NoteRequest(const GridPos& _src, const GridPos& _dest) noexcept;
+		// true and writes the path (source excluded) into _arena when a built field for _dest covers _src, never
+		// touches the cache
+		bool PeekPath(const GridPos& _src, const GridPos& _dest, PathArena& _arena, PathCursor& _out) const noexcept;
+		// NoteRequest, then true and writes the next cell towards _dest when a built field covers _src
+		bool GetNextStep(const GridPos& _src, const GridPos& _dest, GridPos& _out) noexcept;
+
+		unsigned long long GetHits(void) const noexcept;
+		unsigned long long GetMisses(void) const noexcept;
+
+		// the entries and their LRU state, built fields are rebuilt on Load instead of stored. the cache has to come
+		// back _w by _h, and an entry off the map, a second one for a destination or one whose window is not the
+		// one its destination gives fails the load
+		void Save(CheckpointWriter& _w) const;
+		bool Load(CheckpointReader& _r, unsigned _w, unsigned _h);
+
+	private:
+		struct Entry
+		{
+			unsigned mnDest;
+			unsigned mnRequests;
+			unsigned long long mnLastUse;
+			int mnX0;
+			int mnY0;
+			unsigned mnW;
+			unsigned mnH;
+			bool mbBuilt;
+		};
+
+		std::vector<Entry> mEntries;
+		std::unordered_map<unsigned, unsigned> mLookup;
+		std::vector<float> mFields;
+		std::vector<std::pair<float, unsigned>> mOpen;
+
+		unsigned mnWidth;
+		unsigned mnHeight;
+		unsigned long long mnClock;
+		unsigned long long mnHits;
+		unsigned long long mnMisses;
+
+		// returns the entry for a built field covering _src, or nullptr
+		const Entry* Find(const GridPos& _src, const GridPos& _dest) const noexcept;
+		bool Covers(const Entry& _e, const GridPos& _src) const noexcept;
+		void Build(unsigned _slot, const GridPos& _dest) noexcept;
+		bool Step(const Entry& _e, const float* _field, int& _x, int& _y) const noexcept;
+	};
+}
+
+#endif
+
+
+
@@ -0,0 +1,171 @@
+#ifndef _GRID_H_
+#define _GRID_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define GRID_ALIGNMENT 64
+
+namespace CS380
+{
+	// the 8 unit steps around a cell by direction code. the terrain's spill, the flow fields, the scent and the 3 bit
+	// steps in the PathArena all go by this one table, a path only decodes to the cells it was made of while they do
+	constexpr int NeighbourDX[8] = { -1, 0, 1, -1, 1, -1, 0, 1 };
+	constexpr int NeighbourDY[8] = { 1, 1, 1, 0, 0, -1, -1, -1 };
+
+	// allocator handing out GRID_ALIGNMENT aligned blocks so every grid row can start on a cache line
+	template<typename T, std::size_t A = GRID_ALIGNMENT>
+	struct AlignedAllocator
+	{
+		using value_type = T;
+
+		template<typename U>
+		struct rebind { using other = AlignedAllocator<U, A>; };
+
+		AlignedAllocator(void) noexcept = default;
+		template<typename U>
+		AlignedAllocator(const AlignedAllocator<U, A>&) noexcept {}
+
+		T* allocate(std::size_t _n)
+		{
+			return static_cast<T*>(::operator new(_n * sizeof(T), std::align_val_t{ A }));
+		}
+
+		void deallocate(T* _p, std::size_t) noexcept
+		{
+			::operator delete(_p, std::align_val_t{ A });
+		}
+
+		// default construction leaves a trivial cell unwritten, see Grid::Reshape
+		template<typename U>
+		void construct(U* _p) noexcept(std::is_nothrow_default_constructible_v<U>)
+		{
+			::new (static_cast<void*>(_p)) U;
+		}
+
+		template<typename U, typename... Args>
+		void construct(U* _p, Args&&... _args)
+		{
+			::new (static_cast<void*>(_p)) U(std::forward<Args>(_args)...);
+		}
+
+		template<typename U>
+		bool operator==(const AlignedAllocator<U, A>&) const noexcept { return true; }
+		template<typename U>
+		bool operator!=(const AlignedAllocator<U, A>&) const noexcept { return false; }
+	};
+
+	// non owning rectangular window into a grid, shares the grid's row stride
+	template<typename T>
+	struct GridView
+	{
+		T* mpData;
+		unsigned mnWidth;
+		unsigned mnHeight;
+		unsigned mnStride;
+
+		T& operator()(unsigned _x, unsigned _y) const noexcept { return mpData[_y * mnStride + _x]; }
+		T* Row(unsigned _y) const noexcept { return mpData + _y * mnStride; }
+	};
+
+	// single contiguous, row major 2d layer. rows are padded to a multiple of the alignment so
+	// Row(y) is always aligned, accessors do no bounds checking (use InBounds first)
+	template<typename T>
+	class Grid
+	{
+	public:
+		Grid(void) noexcept
+			: mData{}, mnWidth{ 0 }, mnHeight{ 0 }, mnStride{ 0 }
+		{}
+
+		Grid(unsigned _w, unsigned _h, const T& _v = T{})
+			: Grid{}
+		{
+			Resize(_w, _h, _v);
+		}
+
+		void Resize(unsigned _w, unsigned _h, const T& _v = T{})
+		{
+			constexpr unsigned perLine = sizeof(T) >= GRID_ALIGNMENT || GRID_ALIGNMENT % sizeof(T) ? 1u : static_cast<unsigned>(GRID_ALIGNMENT / sizeof(T));
+			mnWidth = _w;
+			mnHeight = _h;
+			mnStride = (_w + perLine - 1) / perLine * perLine;
+			mData.assign(static_cast<std::size_t>(mnStride) * mnHeight, _v);
+		}
+
+		// Resize without the fill, cells of a trivial T (and the row padding) are left as they were or unwritten.
+		// for a caller that writes every cell anyway, so a fresh plane's pages are first touched by whichever
+		// worker fills them rather than all up front on one thread
+		void Reshape(unsigned _w, unsigned _h)
+		{
+			constexpr unsigned perLine = sizeof(T) >= GRID_ALIGNMENT || GRID_ALIGNMENT % sizeof(T) ? 1u : static_cast<unsigned>(GRID_ALIGNMENT / sizeof(T));
+			mnWidth = _w;
+			mnHeight = _h;
+			mnStride = (_w + perLine - 1) / perLine * perLine;
+			mData.clear();
+			mData.resize(static_cast<std::size_t>(mnStride) * mnHeight);
+		}
+
+		void Fill(const T& _v) noexcept
+		{
+			for (auto& v : mData)
+				v = _v;
+		}
+
+		void Swap(Grid& _rhs) noexcept
+		{
+			mData.swap(_rhs.mData);
+			std::swap(mnWidth, _rhs.mnWidth);
+			std::swap(mnHeight, _rhs.mnHeight);
+			std::swap(mnStride, _rhs.mnStride);
+		}
+
+		unsigned GetWidth(void) const noexcept { return mnWidth; }
+		unsigned GetHeight(void) const noexcept { return mnHeight; }
+		unsigned GetStride(void) const noexcept { return mnStride; }
+		bool Empty(void) const noexcept { return mData.empty(); }
+
+		bool InBounds(int _x, int _y) const noexcept
+		{
+			return static_cast<unsigned>(_x) < mnWidth && static_cast<unsigned>(_y) < mnHeight;
+		}
+
+		std::size_t Index(unsigned _x, unsigned _y) const noexcept { return static_cast<std::size_t>(_y) * mnStride + _x; }
+
+		T& operator()(unsigned _x, unsigned _y) noexcept { return mData[Index(_x, _y)]; }
+		const T& operator()(unsigned _x, unsigned _y) const noexcept { return mData[Index(_x, _y)]; }
+
+		T& operator[](std::size_t _i) noexcept { return mData[_i]; }
+		const T& operator[](std::size_t _i) const noexcept { return mData[_i]; }
+
+		T* Row(unsigned _y) noexcept { return mData.data() + static_cast<std::size_t>(_y) * mnStride; }
+		const T* Row(unsigned _y) const noexcept { return mData.data() + static_cast<std::size_t>(_y) * mnStride; }
+
+		T* Data(void) noexcept { return mData.data(); }
+		const T* Data(void) const noexcept { return mData.data(); }
+
+		GridView<T> Tile(unsigned _x, unsigned _y, unsigned _w, unsigned _h) noexcept
+		{
+			return GridView<T>{ Row(_y) + _x, _w, _h, mnStride };
+		}
+
+		GridView<const T> Tile(unsigned _x, unsigned _y, unsigned _w, unsigned _h) const noexcept
+		{
+			return GridView<const T>{ Row(_y) + _x, _w, _h, mnStride };
+		}
+
+	private:
+		std::vector<T, AlignedAllocator<T>> mData;
+		unsigned mnWidth;
+		unsigned mnHeight;
+		unsigned mnStride;
+	};
+}
+
+#endif
+
+
+
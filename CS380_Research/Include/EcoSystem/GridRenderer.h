@@ -0,0 +1,86 @@
+#ifndef _GRID_RENDERER_H_
+#define _GRID_RENDERER_H_
+
+#include <vector>
+
+// grid lines are hidden when a cell is smaller than this many pixels
+#define GRID_LINE_MIN_CELL 4
+
+struct ImDrawList;
+struct ImVec2;
+
+namespace CS380
+{
+	// map drawn as one texture instead of a rectangle per cell. the owner writes texels through Row, UploadRect
+	// sends the ones it changed to the GPU and Draw queues the texture and the grid lines as two quads, the lines
+	// being a one cell tile repeated over the grid. a texel covers GetLod() x GetLod() cells once the world is
+	// zoomed out past a pixel per cell.
+	// only the gui build links the GL half, construction and destruction never touch GL
+	class GridRenderer
+	{
+	public:
+		enum View
+		{
+			VIEW_GRASS,
+			VIEW_FERTILIZER,
+			VIEW_OCCUPANCY,
+			VIEW_SPECIES,
+			VIEW_SCENT,
+			VIEW_COUNT
+		};
+
+		GridRenderer(void) noexcept
+			: mPixels{}, mnTexture{ 0 }, mnLineTexture{ 0 }, mnTexWidth{ 0 }, mnTexHeight{ 0 }, mnLineTile{ 0 },
+			mnWidth{ 0 }, mnHeight{ 0 }, mnCellsX{ 0 }, mnCellsY{ 0 }, mnLod{ 1 }, meView{ VIEW_GRASS },
+			mbGridLines{ true }, mbStale{ true }
+		{}
+
+		static const char* GetViewName(View _v) noexcept;
+		void SetView(View _v) noexcept { mbStale |= meView != _v; meView = _v; }
+		View GetView(void) const noexcept { return meView; }
+		void SetGridLines(bool _b) noexcept { mbGridLines = _b; }
+		bool HasGridLines(void) const noexcept { return mbGridLines; }
+
+		// _w x _h cells at _lod cells per texel side, anything but the current layout marks every texel stale
+		void Resize(unsigned _w, unsigned _h, unsigned _lod);
+		// texture size in texels
+		unsigned GetWidth(void) const noexcept { return mnWidth; }
+		unsigned GetHeight(void) const noexcept { return mnHeight; }
+		unsigned GetLod(void) const noexcept { return mnLod; }
+		// every texel has to be refilled, set by Resize and a view change, cleared by UploadRect of the whole texture
+		bool IsStale(void) const noexcept { return mbStale; }
+		// packed 0xAABBGGRR colours, one per texel
+		unsigned int* Row(unsigned _y) noexcept { return mPixels.data() + static_cast<std::size_t>(_y) * mnWidth; }
+
+		// texels [_x0, _x1) x [_y0, _y1)
+		void UploadRect(unsigned _x0, unsigned _y0, unsigned _x1, unsigned _y1) noexcept;
+		// _min, _max are the screen corners of the whole grid, _cell the size of one cell in pixels. the line tile
+		// is rebuilt when the whole pixel size of a cell changes
+		void Draw(ImDrawList* _pDrawList, const ImVec2& _min, const ImVec2& _max, float _cell) noexcept;
+		// needs the GL context that created the textures, so call it before that goes away
+		void Release(void) noexcept;
+
+	private:
+		std::vector<unsigned int> mPixels;
+		unsigned mnTexture;
+		unsigned mnLineTexture;
+		// size the texture storage was allocated with
+		unsigned mnTexWidth;
+		unsigned mnTexHeight;
+		// pixels per side of the line tile
+		unsigned mnLineTile;
+		unsigned mnWidth;
+		unsigned mnHeight;
+		unsigned mnCellsX;
+		unsigned mnCellsY;
+		unsigned mnLod;
+		View meView;
+		bool mbGridLines;
+		bool mbStale;
+	};
+}
+
+#endif
+
+
+
@@ -0,0 +1,42 @@
+#ifndef _MAXPYRAMID_H_
+#define _MAXPYRAMID_H_
+
+#include <vector>
+
+#include "EcoSystem/Grid.h"
+
+namespace CS380
+{
+	// mip chain of 2x2 maxima over a float layer, level 0 is the layer itself and each cell of level k
+	// bounds the 2^k x 2^k block of cells under it
+	class MaxPyramid
+	{
+	public:
+		MaxPyramid(void) noexcept;
+
+		// every level unwritten (see Grid::Reshape), fill the base and rebuild
+		void Resize(unsigned _w, unsigned _h) noexcept;
+
+		// write level 0 directly then RebuildLevels, or Set single cells
+		Grid<float>& GetBase(void) noexcept;
+		// levels _from and up
+		void RebuildLevels(unsigned _from = 1) noexcept;
+		// only the levels over base cells [_x0, _x1) x [_y0, _y1), up to and including _levels. rects aligned to
+		// 2^_levels cells share no cell of those levels, so they can rebuild side by side
+		void RebuildRect(unsigned _x0, unsigned _y0, unsigned _x1, unsigned _y1, unsigned _levels = ~0u) noexcept;
+		void Set(unsigned _x, unsigned _y, float _v) noexcept;
+
+		unsigned GetLevelCount(void) const noexcept;
+		const Grid<float>& GetLevel(unsigned _level) const noexcept;
+
+	private:
+		std::vector<Grid<float>> mLevels;
+
+		float Reduce(unsigned _level, unsigned _x, unsigned _y) const noexcept;
+	};
+}
+
+#endif
+
+
+
@@ -0,0 +1,172 @@
+#ifndef _PATH_ARENA_H_
+#define _PATH_ARENA_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "EcoSystem/Grid.h"
+
+// steps a block holds, 21 in its low word and 10 in its high one at 3 bits a step
+#define PATH_BLOCK_STEPS 31
+// blocks a worker makes at a time, and how many of those runs it may hold (16M blocks a worker)
+#define PATH_CHUNK_BLOCKS 4096
+#define PATH_MAX_CHUNKS 4096
+// a block handle is the worker that made it over its index in that worker's runs
+#define PATH_WORKER_SHIFT 24
+#define PATH_NONE 0xffffffffu
+
+namespace CS380
+{
+	struct GridPos;
+
+	// direction code of a unit step, _dx and _dy in -1..1 and not both 0. the inverse of NeighbourDX / NeighbourDY,
+	// a path's steps are stored as these codes and taken back through the table
+	constexpr unsigned PathDir(int _dx, int _dy) noexcept
+	{
+		constexpr unsigned char codes[9] = { 5, 6, 7, 3, 0, 4, 0, 1, 2 };
+		return codes[(_dy + 1) * 3 + _dx + 1];
+	}
+
+	constexpr bool PathDirMatchesNeighbours(void) noexcept
+	{
+		for (unsigned d = 0; d < 8; ++d)
+			if (PathDir(NeighbourDX[d], NeighbourDY[d]) != d)
+				return false;
+		return true;
+	}
+	static_assert(PathDirMatchesNeighbours(), "PathDir has to invert the neighbour table");
+
+	// a creature's place on a path in the arena, what it holds instead of the cells themselves. no steps left is
+	// no path, a zeroed cursor is one
+	struct PathCursor
+	{
+		// the block the next step is in and where in it
+		std::uint32_t mnBlock;
+		std::uint32_t mnStep;
+		std::uint32_t mnLeft;
+		// the cell the steps taken so far lead to, and the one the last step does
+		int mnAtX;
+		int mnAtY;
+		int mnEndX;
+		int mnEndY;
+	};
+
+	// one world's paths as chains of fixed blocks of 3 bit direction codes, a block a path's first 31 steps. every
+	// worker of the world's pool allocates from runs and a free list of its own, found by ThreadPool::GetCurrentWorker
+	// like the terrain's search scratch, so planning in the parallel creature phase never locks. a block freed on
+	// another worker than the one that made it joins the freeing worker's list, Balance evens the lists out
+	class PathArena
+	{
+	public:
+		PathArena(void) noexcept;
+
+		PathArena(const PathArena&) = delete;
+		PathArena& operator=(const PathArena&) = delete;
+
+		// a slot per worker that may plan or drop paths, between ticks. at most 1 << (32 - PATH_WORKER_SHIFT)
+		void ReserveWorkers(unsigned _n);
+
+		// blocks for a path of _steps leaving _from, for PathWriter to fill in. no steps when the arena is full
+		PathCursor Allocate(const GridPos& _from, unsigned _steps) noexcept;
+		// direction code of the cursor's next step, there has to be one
+		unsigned Peek(const PathCursor& _c) const noexcept;
+		// takes the next step, a block is freed as soon as the cursor is done with it
+		void Advance(PathCursor& _c) noexcept;
+		// frees what is left of the path, the cursor is then empty
+		void Release(PathCursor& _c) noexcept;
+		// _func(unsigned) with every direction code left on the path, in order
+		template<typename F>
+		void ForEachStep(const PathCursor& _c, F&& _func) const;
+
+		// between ticks, moves free blocks from the longest lists to the shortest
+		void Balance(void);
+		// blocks held by paths, and bytes of block runs made
+		std::size_t GetLiveBlocks(void) const noexcept;
+		std::size_t GetReservedBytes(void) const noexcept;
+
+	private:
+		friend class PathWriter;
+
+		struct Block
+		{
+			std::uint64_t mnLo;
+			std::uint32_t mnHi;
+			std::uint32_t mnNext;
+		};
+
+		// a cache line of its own so workers never share one
+		struct alignas(64) Worker
+		{
+			std::unique_ptr<std::unique_ptr<Block[]>[]> mChunks;
+			std::uint32_t mnMade;
+			std::vector<std::uint32_t> mFree;
+			long long mnLive;
+		};
+
+		std::uint32_t NewBlock(std::uint32_t _next) noexcept;
+		void FreeBlock(std::uint32_t _b) noexcept;
+		Block& At(std::uint32_t _b) noexcept;
+		const Block& At(std::uint32_t _b) const noexcept;
+		static unsigned Get(const Block& _b, unsigned _i) noexcept;
+
+		std::vector<Worker> mWorkers;
+	};
+
+	// fills a path Allocate made front to back, each Push also moves the path's end
+	class PathWriter
+	{
+	public:
+		PathWriter(PathArena& _arena, PathCursor& _path) noexcept;
+
+		void Push(unsigned _dir) noexcept;
+
+	private:
+		PathArena& mArena;
+		PathCursor& mPath;
+		std::uint32_t mnBlock;
+		unsigned mnStep;
+	};
+
+	inline PathArena::Block& PathArena::At(std::uint32_t _b) noexcept
+	{
+		const std::uint32_t i = _b & ((1u << PATH_WORKER_SHIFT) - 1);
+		return mWorkers[_b >> PATH_WORKER_SHIFT].mChunks[i / PATH_CHUNK_BLOCKS][i % PATH_CHUNK_BLOCKS];
+	}
+
+	inline const PathArena::Block& PathArena::At(std::uint32_t _b) const noexcept
+	{
+		return const_cast<PathArena*>(this)->At(_b);
+	}
+
+	inline unsigned PathArena::Get(const Block& _b, unsigned _i) noexcept
+	{
+		return static_cast<unsigned>(_i < 21 ? _b.mnLo >> (_i * 3) : _b.mnHi >> ((_i - 21) * 3)) & 7u;
+	}
+
+	inline unsigned PathArena::Peek(const PathCursor& _c) const noexcept
+	{
+		return Get(At(_c.mnBlock), _c.mnStep);
+	}
+
+	template<typename F>
+	inline void PathArena::ForEachStep(const PathCursor& _c, F&& _func) const
+	{
+		std::uint32_t b = _c.mnBlock;
+		unsigned i = _c.mnStep;
+		for (std::uint32_t left = _c.mnLeft; left; --left)
+		{
+			if (i == PATH_BLOCK_STEPS)
+			{
+				b = At(b).mnNext;
+				i = 0;
+			}
+			_func(Get(At(b), i++));
+		}
+	}
+}
+
+#endif
+
+
+
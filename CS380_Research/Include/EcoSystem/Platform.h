@@ -0,0 +1,14 @@
+#ifndef _PLATFORM_H_
+#define _PLATFORM_H_
+
+// debug trap that works on both msvc and gcc/clang builds (headless linux nodes)
+#if defined(_MSC_VER)
+#define ECO_DEBUGBREAK() __debugbreak()
+#else
+#define ECO_DEBUGBREAK() __builtin_trap()
+#endif
+
+#endif
+
+
+
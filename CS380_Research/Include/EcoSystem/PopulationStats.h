@@ -0,0 +1,71 @@
+#ifndef _POPULATION_STATS_H_
+#define _POPULATION_STATS_H_
+
+#include <algorithm>
+#include <cfloat>
+
+namespace CS380
+{
+	enum TraitStat : unsigned
+	{
+		TRAIT_SIZE,
+		TRAIT_SPEED,
+		TRAIT_SENSE,
+		TRAIT_COUNT
+	};
+
+	// sum, sum of squares and extremes of one trait over a population, O(1) per creature that comes or goes.
+	// removing the current min or max can not be undone in O(1), the owner recounts them when next read
+	struct RunningStat
+	{
+		double mfSum = 0.0;
+		double mfSumSq = 0.0;
+		float mfMin = FLT_MAX;
+		float mfMax = -FLT_MAX;
+
+		void Add(float _v) noexcept
+		{
+			mfSum += _v;
+			mfSumSq += static_cast<double>(_v) * _v;
+			mfMin = std::min(mfMin, _v);
+			mfMax = std::max(mfMax, _v);
+		}
+
+		// false when _v was one of the extremes
+		bool Remove(float _v) noexcept
+		{
+			mfSum -= _v;
+			mfSumSq -= static_cast<double>(_v) * _v;
+			return _v != mfMin && _v != mfMax;
+		}
+
+		double GetMean(unsigned _n) const noexcept
+		{
+			return _n ? mfSum / _n : 0.0;
+		}
+
+		double GetVariance(unsigned _n) const noexcept
+		{
+			if (!_n)
+				return 0.0;
+			const double mean = mfSum / _n;
+			return std::max(0.0, mfSumSq / _n - mean * mean);
+		}
+	};
+
+	// one species, kept by its CreaturePool. traits are fixed at birth so spawns and deaths are the only changes
+	struct SpeciesStats
+	{
+		unsigned mnCount = 0;
+		// most alive at once
+		unsigned mnPeak = 0;
+		unsigned long long mnSpawned = 0;
+		RunningStat mTraits[TRAIT_COUNT];
+		bool mbExtremaStale = false;
+	};
+}
+
+#endif
+
+
+
@@ -0,0 +1,196 @@
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "EcoSystem/RingBuffer.h"
+
+// scoped timers and search counters on the tick's hot paths. built in unless ECO_NO_PROFILE is defined, which
+// compiles every ECO_PROFILE_ macro out. built in but not recording, a timer costs one branch
+#if defined(ECO_NO_PROFILE)
+#define ECO_PROFILING 0
+#else
+#define ECO_PROFILING 1
+#endif
+
+// ticks of history the profiler window plots
+#define PROFILE_HISTORY 240
+// species the path counters keep apart, CreatureList has to fit
+#define PROFILE_MAX_SPECIES 8
+// trace events a worker buffers before a capture stops taking more
+#define PROFILE_TRACE_CAPACITY (1u << 20)
+
+#define ECO_PROFILE_CAT_(_a, _b) _a##_b
+#define ECO_PROFILE_CAT(_a, _b) ECO_PROFILE_CAT_(_a, _b)
+
+#if ECO_PROFILING
+// times the rest of the enclosing block as _zone, _prof may be null
+#define ECO_PROFILE_SCOPE(_prof, _zone) ::CS380::ProfileScope ECO_PROFILE_CAT(ecoProfileScope, __LINE__){ _prof, _zone }
+#define ECO_PROFILE_COUNT(_prof, _counter, _n) do { if (_prof) (_prof)->Count(_counter, _n); } while (0)
+#define ECO_PROFILE_SPECIES(_prof, _species) do { if (_prof) (_prof)->SetSpecies(_species); } while (0)
+#define ECO_PROFILE_PATH(_prof) do { if (_prof) (_prof)->CountPath(); } while (0)
+// a span timed by hand, for timers that already take their own laps
+#define ECO_PROFILE_ZONE(_prof, _zone, _start, _end) do { if ((_prof)->IsEnabled()) (_prof)->AddZone(_zone, _start, _end); } while (0)
+#define ECO_PROFILE_FRAME(_prof, _tick, _start, _end) (_prof)->EndFrame(_tick, _start, _end)
+#else
+#define ECO_PROFILE_SCOPE(_prof, _zone) ((void)0)
+#define ECO_PROFILE_COUNT(_prof, _counter, _n) ((void)0)
+#define ECO_PROFILE_SPECIES(_prof, _species) ((void)0)
+#define ECO_PROFILE_PATH(_prof) ((void)0)
+#define ECO_PROFILE_ZONE(_prof, _zone, _start, _end) ((void)0)
+#define ECO_PROFILE_FRAME(_prof, _tick, _start, _end) ((void)0)
+#endif
+
+namespace CS380
+{
+	// the first ones follow TickPhase
+	enum ProfileZone : unsigned
+	{
+		ZONE_TERRAIN,
+		ZONE_CREATURES,
+		ZONE_CLEANUP,
+		ZONE_LOGS,
+		ZONE_TICK,
+		ZONE_PUBLISH,
+		ZONE_SHORTEST_PATH,
+		ZONE_BEST_GRASS,
+		ZONE_EMPTY_NEIGHBOUR,
+		ZONE_LOWEST_GRASS,
+		ZONE_COUNT
+	};
+
+	enum ProfileCounter : unsigned
+	{
+		// A* runs, requests a flow field answered do not search
+		COUNTER_SEARCHES,
+		COUNTER_FLOW_FIELD_HITS,
+		// PATH_LONG answers, they neither search nor read a flow field
+		COUNTER_LONG_ROUTES,
+		COUNTER_NODES_EXPANDED,
+		COUNTER_HEAP_PUSHES,
+		COUNTER_SPAWNS,
+		COUNTER_DEATHS,
+		COUNTER_COUNT
+	};
+
+	// one tick, every worker's share added up
+	struct ProfileFrame
+	{
+		unsigned long long mnTick;
+		double mZoneSeconds[ZONE_COUNT];
+		unsigned mZoneCalls[ZONE_COUNT];
+		unsigned long long mCounters[COUNTER_COUNT];
+		// path requests per species
+		unsigned mPaths[PROFILE_MAX_SPECIES];
+	};
+
+	// hot path timing for one world. every worker of the world's pool writes its own slot, found by
+	// ThreadPool::GetCurrentWorker like the terrain's search scratch, and EndFrame adds the slots up into the
+	// history between ticks. a trace capture keeps every timed call too (GetLowestGrass is too fine grained and
+	// only shows in the totals) and writes them out as Chrome trace json
+	class Profiler
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		Profiler(void) noexcept;
+
+		// records nothing until enabled, safe to flip from any thread
+		void SetEnabled(bool _b) noexcept;
+		bool IsEnabled(void) const noexcept { return mbEnabled.load(std::memory_order_relaxed); }
+		// a slot per worker that may time or count, between ticks
+		void ReserveWorkers(unsigned _n);
+		// what the trace calls the path counters, _names has to outlive the profiler
+		void SetSpeciesNames(const char* const* _names, unsigned _count) noexcept;
+
+		// the calling worker's slot
+		void AddZone(ProfileZone _zone, Clock::time_point _start, Clock::time_point _end) noexcept;
+		void Count(ProfileCounter _counter, unsigned long long _n) noexcept;
+		// the species whose creatures the calling worker updates, for CountPath
+		void SetSpecies(unsigned _species) noexcept;
+		void CountPath(void) noexcept;
+
+		// closes tick _tick, timed from _start to _end, between ticks on the sim thread
+		void EndFrame(unsigned long long _tick, Clock::time_point _start, Clock::time_point _end) noexcept;
+		const RingBuffer<ProfileFrame>& GetHistory(void) const noexcept;
+		void ClearHistory(void) noexcept;
+
+		// keeps every event from here on, EndTrace writes them to _path and drops them. only between ticks
+		void BeginTrace(void);
+		bool IsTracing(void) const noexcept;
+		bool EndTrace(const std::string& _path);
+
+		static const char* GetZoneName(ProfileZone _zone) noexcept;
+		static const char* GetCounterName(ProfileCounter _counter) noexcept;
+
+	private:
+		struct TraceEvent
+		{
+			long long mnStart;
+			long long mnDuration;
+			ProfileZone meZone;
+		};
+
+		struct TraceFrame
+		{
+			long long mnEnd;
+			ProfileFrame mFrame;
+		};
+
+		// a cache line of its own so workers never share one
+		struct alignas(64) Slot
+		{
+			double mZoneSeconds[ZONE_COUNT];
+			unsigned mZoneCalls[ZONE_COUNT];
+			unsigned long long mCounters[COUNTER_COUNT];
+			unsigned mPaths[PROFILE_MAX_SPECIES];
+			unsigned mnSpecies;
+			std::vector<TraceEvent> mTrace;
+		};
+
+		Slot& GetSlot(void) noexcept;
+		long long TraceTime(Clock::time_point _t) const noexcept;
+
+		std::atomic<bool> mbEnabled;
+		bool mbTracing;
+		Clock::time_point mTraceOrigin;
+		std::vector<Slot> mSlots;
+		const char* const* mpSpeciesNames;
+		unsigned mnSpeciesCount;
+		RingBuffer<ProfileFrame> mHistory;
+		std::vector<TraceFrame> mTraceFrames;
+	};
+
+	class ProfileScope
+	{
+	public:
+		ProfileScope(Profiler* _prof, ProfileZone _zone) noexcept
+			: mpProfiler{ _prof && _prof->IsEnabled() ? _prof : nullptr }, meZone{ _zone }, mStart{}
+		{
+			if (mpProfiler)
+				mStart = Profiler::Clock::now();
+		}
+
+		~ProfileScope(void) noexcept
+		{
+			if (mpProfiler)
+				mpProfiler->AddZone(meZone, mStart, Profiler::Clock::now());
+		}
+
+		ProfileScope(const ProfileScope&) = delete;
+		ProfileScope& operator=(const ProfileScope&) = delete;
+
+	private:
+		Profiler* mpProfiler;
+		ProfileZone meZone;
+		Profiler::Clock::time_point mStart;
+	};
+}
+
+#endif
+
+
+
@@ -0,0 +1,147 @@
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace CS380
+{
+	// fixed substreams off the master seed, a run with the same seed and inputs replays exactly
+	enum RandomStream : std::uint64_t
+	{
+		STREAM_TERRAIN_INIT = 1,
+		// retired, terrain queries hash instead. kept so the later stream ids do not move
+		STREAM_TERRAIN_QUERY,
+		STREAM_TERRAIN_HASH,
+		STREAM_CREATURE,
+		STREAM_SPAWN,
+		STREAM_TOOLS,
+		STREAM_FILL
+	};
+
+	// splitmix64 step, used to expand seeds and as a stateless mixer
+	inline std::uint64_t SplitMix64(std::uint64_t& _state) noexcept
+	{
+		std::uint64_t z = (_state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	// counter based hash, same (key, counter) always gives the same bits on every thread
+	inline std::uint64_t CounterHash(std::uint64_t _key, std::uint64_t _counter) noexcept
+	{
+		std::uint64_t s = _key ^ (_counter * 0xD1B54A32D192ED03ull);
+		return SplitMix64(s);
+	}
+
+	// xoshiro256**, satisfies UniformRandomBitGenerator so it also drops into std::shuffle
+	class Rng
+	{
+	public:
+		using result_type = std::uint64_t;
+
+		explicit Rng(std::uint64_t _seed = 0) noexcept
+		{
+			Seed(_seed);
+		}
+
+		void Seed(std::uint64_t _seed) noexcept
+		{
+			mnSeed = _seed;
+			std::uint64_t s = _seed;
+			for (auto& v : mState)
+				v = SplitMix64(s);
+		}
+
+		std::uint64_t GetSeed(void) const noexcept { return mnSeed; }
+
+		// independent generator for sub task _id, does not advance this one
+		Rng Substream(std::uint64_t _id) const noexcept
+		{
+			return Rng{ CounterHash(mnSeed, _id + 1) };
+		}
+
+		static constexpr result_type min(void) noexcept { return 0; }
+		static constexpr result_type max(void) noexcept { return ~static_cast<result_type>(0); }
+
+		result_type operator()(void) noexcept
+		{
+			const std::uint64_t result = Rotl(mState[1] * 5, 7) * 9;
+			const std::uint64_t t = mState[1] << 17;
+			mState[2] ^= mState[0];
+			mState[3] ^= mState[1];
+			mState[1] ^= mState[2];
+			mState[0] ^= mState[3];
+			mState[2] ^= t;
+			mState[3] = Rotl(mState[3], 45);
+			return result;
+		}
+
+		// [0, 1)
+		float NextFloat(void) noexcept
+		{
+			return static_cast<float>((*this)() >> 40) * (1.f / 16777216.f);
+		}
+
+		// [_lo, _hi)
+		float Range(float _lo, float _hi) noexcept
+		{
+			return _lo + (_hi - _lo) * NextFloat();
+		}
+
+		// [0, _n), _n of 0 returns 0
+		unsigned Below(unsigned _n) noexcept
+		{
+			return static_cast<unsigned>(((*this)() >> 32) * _n >> 32);
+		}
+
+		// [_lo, _hi] inclusive
+		int RangeInt(int _lo, int _hi) noexcept
+		{
+			return _lo + static_cast<int>(Below(static_cast<unsigned>(_hi - _lo) + 1));
+		}
+
+	private:
+		std::uint64_t mState[4];
+		std::uint64_t mnSeed;
+
+		static std::uint64_t Rotl(std::uint64_t _x, int _k) noexcept
+		{
+			return (_x << _k) | (_x >> (64 - _k));
+		}
+	};
+
+	// the master seed and entity counter of one world, every world draws its streams from its own
+	class Random
+	{
+	public:
+		// picked from std::random_device unless set before the run starts
+		Random(void) noexcept;
+
+		void SetMasterSeed(std::uint64_t _seed) noexcept;
+		std::uint64_t GetMasterSeed(void) const noexcept;
+
+		// generator for a fixed stream, optionally split further by _sub
+		Rng Stream(RandomStream _stream, std::uint64_t _sub = 0) const noexcept;
+
+		// next per entity stream, deterministic as long as entities are spawned in the same order
+		Rng NextEntityStream(void) noexcept;
+		// the same counter as an id, EntityStream(NextEntityId()) is NextEntityStream()
+		std::uint64_t NextEntityId(void) noexcept;
+		Rng EntityStream(std::uint64_t _id) const noexcept;
+		void ResetEntityStreams(void) noexcept;
+		// where the entity counter is, for checkpoints to carry it over
+		std::uint64_t GetEntityCounter(void) const noexcept;
+		void SetEntityCounter(std::uint64_t _n) noexcept;
+
+	private:
+		std::uint64_t mnMasterSeed;
+		std::atomic<std::uint64_t> mnEntityCounter;
+	};
+}
+
+#endif
+
+
+
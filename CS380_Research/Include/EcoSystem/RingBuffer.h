@@ -0,0 +1,87 @@
+#ifndef _RING_BUFFER_H_
+#define _RING_BUFFER_H_
+
+#include <vector>
+
+namespace CS380
+{
+	// fixed capacity history in one contiguous block, a push past capacity overwrites the oldest sample. once
+	// full the oldest one sits at GetOffset, which is the layout ImGui's plots take as values_offset, so
+	// Data / GetSize / GetOffset plot it without a copy
+	template<typename T>
+	class RingBuffer
+	{
+	public:
+		RingBuffer(void) noexcept
+			: mData{}, mnCapacity{ 0 }, mnHead{ 0 }
+		{}
+
+		// full of _fill
+		void Reset(unsigned _capacity, const T& _fill = T{});
+		// keeps the newest samples that fit
+		void SetCapacity(unsigned _capacity);
+		// empty, same capacity
+		void Clear(void) noexcept { mData.clear(); mnHead = 0; }
+
+		void Push(const T& _v);
+
+		unsigned GetCapacity(void) const noexcept { return mnCapacity; }
+		unsigned GetSize(void) const noexcept { return static_cast<unsigned>(mData.size()); }
+		bool Empty(void) const noexcept { return mData.empty(); }
+		unsigned GetOffset(void) const noexcept { return mnHead; }
+		const T* Data(void) const noexcept { return mData.data(); }
+
+		// _i-th oldest
+		const T& operator[](unsigned _i) const noexcept { return mData[(mnHead + _i) % mData.size()]; }
+		const T& Back(void) const noexcept { return (*this)[GetSize() - 1]; }
+
+	private:
+		std::vector<T> mData;
+		unsigned mnCapacity;
+		// oldest sample once full, 0 until then
+		unsigned mnHead;
+	};
+
+	template<typename T>
+	inline void RingBuffer<T>::Reset(unsigned _capacity, const T& _fill)
+	{
+		mData.assign(_capacity, _fill);
+		mnCapacity = _capacity;
+		mnHead = 0;
+	}
+
+	template<typename T>
+	inline void RingBuffer<T>::SetCapacity(unsigned _capacity)
+	{
+		if (_capacity == mnCapacity)
+			return;
+
+		const unsigned keep = GetSize() < _capacity ? GetSize() : _capacity;
+		std::vector<T> data;
+		data.reserve(_capacity);
+		for (unsigned i = GetSize() - keep; i < GetSize(); ++i)
+			data.push_back((*this)[i]);
+		mData.swap(data);
+		mnCapacity = _capacity;
+		mnHead = 0;
+	}
+
+	template<typename T>
+	inline void RingBuffer<T>::Push(const T& _v)
+	{
+		if (!mnCapacity)
+			return;
+		if (mData.size() < mnCapacity)
+		{
+			mData.push_back(_v);
+			return;
+		}
+		mData[mnHead] = _v;
+		mnHead = (mnHead + 1) % mnCapacity;
+	}
+}
+
+#endif
+
+
+
@@ -0,0 +1,75 @@
+#ifndef _SCENT_FIELD_H_
+#define _SCENT_FIELD_H_
+
+#include <vector>
+
+#include "EcoSystem/Grid.h"
+#include "EcoSystem/Terrain.h"
+
+// share of a cell's scent that spreads to each of its 4 neighbours per tick, at most 0.25
+#define SCENT_DIFFUSION 0.2f
+// share of the scent that fades per tick
+#define SCENT_DECAY 0.01f
+// what one creature leaves on its cell per tick
+#define SCENT_DEPOSIT 1.f
+// scent under this is dropped to 0 so a fading trail never turns into denormals
+#define SCENT_FLOOR 1e-6f
+
+namespace CS380
+{
+	class ThreadPool;
+	class CheckpointWriter;
+	class CheckpointReader;
+
+	// a layer per tracked species of how much of it passed by lately. every creature of the species deposits on
+	// its cell, and once a tick the layer spreads to the 4 neighbours and fades, so it falls off with distance to
+	// where the creatures are and a predator finds them by going uphill one cell at a time instead of searching
+	// its sense radius. species masks have a bit per CreatureList index
+	class ScentField
+	{
+	public:
+		ScentField(void) noexcept;
+
+		void SetThreadPool(ThreadPool* _pool) noexcept;
+
+		// every layer cleared and sized to the map
+		void Reset(unsigned _w, unsigned _h) noexcept;
+		// layers of species that stop being tracked are freed, ones that start do so with no scent
+		void SetSpeciesMask(unsigned _mask) noexcept;
+		unsigned GetSpeciesMask(void) const noexcept { return mnMask; }
+		bool IsTracked(unsigned _species) const noexcept { return (mnMask >> _species) & 1u; }
+
+		// a tracked species only
+		void Deposit(unsigned _species, unsigned _x, unsigned _y) noexcept { mLayers[_species](_x, _y) += SCENT_DEPOSIT; }
+		// spreads and fades every tracked layer by one tick, rows in parallel. nothing leaks over the map's edge
+		void Update(void) noexcept;
+
+		float Get(unsigned _species, unsigned _x, unsigned _y) const noexcept { return mLayers[_species](_x, _y); }
+		// the neighbour of _p with the most of _species' scent when it has more than _p, _p when none does and
+		// -1, -1 when there is no scent on or around _p at all. a tracked species only
+		GridPos Climb(unsigned _species, const GridPos& _p) const noexcept;
+		// empty for an untracked species
+		const Grid<float>& GetLayer(unsigned _species) const noexcept { return mLayers[_species]; }
+
+		void Save(CheckpointWriter& _w) const;
+		// the layers have to come back _w by _h
+		bool Load(CheckpointReader& _r, unsigned _w, unsigned _h);
+
+	private:
+		void UpdateLayer(Grid<float>& _layer) noexcept;
+
+		ThreadPool* mpPool;
+		unsigned mnWidth;
+		unsigned mnHeight;
+		unsigned mnMask;
+		// indexed by species, empty unless tracked
+		std::vector<Grid<float>> mLayers;
+		// the spread is written here and swapped in
+		Grid<float> mNext;
+	};
+}
+
+#endif
+
+
+
@@ -0,0 +1,100 @@
+#ifndef _SPATIAL_INDEX_H_
+#define _SPATIAL_INDEX_H_
+
+#include <vector>
+
+#include "EcoSystem/CreatureHandle.h"
+#include "EcoSystem/Terrain.h"
+
+// cells per side of a spatial bucket, as a shift
+#define SPATIAL_BUCKET_SHIFT 3
+#define SPATIAL_BUCKET_SIZE (1u << SPATIAL_BUCKET_SHIFT)
+
+namespace CS380
+{
+	struct SpatialHit
+	{
+		CreatureHandle mHandle;
+		int mnX;
+		int mnY;
+		int mnDistSq;
+	};
+
+	// per species buckets of SPATIAL_BUCKET_SIZE^2 cells over the occupancy layer. kept in step with it by the
+	// EcoSystem occupant calls, so a query only visits the buckets and species it asks for
+	class SpatialIndex
+	{
+	public:
+		SpatialIndex(void) noexcept;
+
+		void Reset(unsigned _w, unsigned _h, unsigned _species) noexcept;
+
+		void Insert(const CreatureHandle& _h, const GridPos& _p) noexcept;
+		void Move(const CreatureHandle& _h, const GridPos& _from, const GridPos& _to) noexcept;
+		void Remove(const CreatureHandle& _h, const GridPos& _p) noexcept;
+
+		// creatures of the species in _speciesMask (bit per species) within _radius of _p, nearest first with ties
+		// in handle order. keeps the _capacity nearest and returns how many were written
+		unsigned QueryRadius(const GridPos& _p, float _radius, unsigned _speciesMask, SpatialHit* _out, unsigned _capacity) const noexcept;
+		// nearest creature of _species within _radius with _pred(const CreatureHandle&) true, where the index has it.
+		// the hit's handle is invalid if there is none. _pred only runs on candidates closer than the best so far
+		template<typename P>
+		SpatialHit NearestOf(const GridPos& _p, float _radius, unsigned _species, P&& _pred) const;
+
+	private:
+		struct Entry
+		{
+			CreatureHandle mHandle;
+			int mnX;
+			int mnY;
+		};
+
+		unsigned mnBucketsX;
+		unsigned mnBucketsY;
+		unsigned mnSpecies;
+		// [species][by][bx]
+		std::vector<std::vector<Entry>> mBuckets;
+		// [species][slot], position of the slot's entry inside its bucket
+		std::vector<std::vector<unsigned>> mWhere;
+
+		std::vector<Entry>& Bucket(unsigned _species, const GridPos& _p) noexcept;
+		const std::vector<Entry>& Bucket(unsigned _species, unsigned _bx, unsigned _by) const noexcept;
+		// bucket range covering the square around _p, false when it misses the world
+		bool BucketRange(const GridPos& _p, int _r, unsigned& _bx0, unsigned& _by0, unsigned& _bx1, unsigned& _by1) const noexcept;
+		static bool Closer(int _d, const CreatureHandle& _h, int _rhsD, const CreatureHandle& _rhsH) noexcept;
+	};
+
+	template<typename P>
+	inline SpatialHit SpatialIndex::NearestOf(const GridPos& _p, float _radius, unsigned _species, P&& _pred) const
+	{
+		SpatialHit best{ CreatureHandle{}, 0, 0, 0 };
+		if (_species >= mnSpecies || _radius < 0.f)
+			return best;
+
+		const int r = static_cast<int>(_radius);
+		const int r2 = static_cast<int>(_radius * _radius);
+		unsigned bx0, by0, bx1, by1;
+		if (!BucketRange(_p, r, bx0, by0, bx1, by1))
+			return best;
+
+		best.mnDistSq = r2 + 1;
+		for (unsigned by = by0; by <= by1; ++by)
+			for (unsigned bx = bx0; bx <= bx1; ++bx)
+				for (const Entry& e : Bucket(_species, bx, by))
+				{
+					const int dx = e.mnX - _p.x;
+					const int dy = e.mnY - _p.y;
+					const int d = dx * dx + dy * dy;
+					if (d > r2 || !Closer(d, e.mHandle, best.mnDistSq, best.mHandle))
+						continue;
+					if (_pred(e.mHandle))
+						best = SpatialHit{ e.mHandle, e.mnX, e.mnY, d };
+				}
+		return best;
+	}
+}
+
+#endif
+
+
+
@@ -0,0 +1,62 @@
+#ifndef _SPSC_QUEUE_H_
+#define _SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+
+namespace CS380
+{
+	// fixed ring of N - 1 usable slots between exactly one producer and one consumer thread. the producer only
+	// stores mnTail and the consumer only mnHead, so neither side ever waits on the other
+	template<typename T, unsigned N>
+	class SpscQueue
+	{
+	public:
+		SpscQueue(void) noexcept
+			: mSlots{}, mnHead{ 0 }, mnTail{ 0 }
+		{}
+
+		SpscQueue(const SpscQueue&) = delete;
+		SpscQueue& operator=(const SpscQueue&) = delete;
+
+		// producer side, false when full
+		bool Push(const T& _v) noexcept;
+		// consumer side, false when empty
+		bool Pop(T& _out) noexcept;
+
+	private:
+		std::array<T, N> mSlots;
+		alignas(64) std::atomic<unsigned> mnHead;
+		alignas(64) std::atomic<unsigned> mnTail;
+	};
+
+	template<typename T, unsigned N>
+	inline bool SpscQueue<T, N>::Push(const T& _v) noexcept
+	{
+		const unsigned tail = mnTail.load(std::memory_order_relaxed);
+		const unsigned next = (tail + 1) % N;
+		if (next == mnHead.load(std::memory_order_acquire))
+			return false;
+
+		mSlots[tail] = _v;
+		mnTail.store(next, std::memory_order_release);
+		return true;
+	}
+
+	template<typename T, unsigned N>
+	inline bool SpscQueue<T, N>::Pop(T& _out) noexcept
+	{
+		const unsigned head = mnHead.load(std::memory_order_relaxed);
+		if (head == mnTail.load(std::memory_order_acquire))
+			return false;
+
+		_out = mSlots[head];
+		mnHead.store((head + 1) % N, std::memory_order_release);
+		return true;
+	}
+}
+
+#endif
+
+
+
@@ -0,0 +1,139 @@
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// samples a block holds before it goes to the writer thread
+#define TELEMETRY_BLOCK_ROWS 256
+// full blocks waiting on the writer before new ones are dropped (or, blocking, waited on) instead of queued
+#define TELEMETRY_MAX_PENDING 64
+
+// binary layout, all little endian:
+//   "ECOT", u32 version, u32 column count, per column u16 length then the name
+//   then blocks of u32 rows, u64 tick per row, and per column rows floats
+#define TELEMETRY_MAGIC "ECOT"
+#define TELEMETRY_VERSION 1u
+
+namespace CS380
+{
+	// where the samples end up, only ever called from the writer thread
+	class TelemetrySink
+	{
+	public:
+		virtual ~TelemetrySink(void) noexcept {}
+
+		virtual bool Open(const std::vector<std::string>& _columns) noexcept = 0;
+		// _rows samples, _values row major with one value per column. false when they did not all make it
+		virtual bool Write(const unsigned long long* _ticks, const float* _values, unsigned _rows) noexcept = 0;
+		// false when what was still buffered could not be flushed
+		virtual bool Close(void) noexcept = 0;
+	};
+
+	class CsvTelemetrySink final : public TelemetrySink
+	{
+	public:
+		explicit CsvTelemetrySink(const std::string& _path) noexcept;
+		~CsvTelemetrySink(void) noexcept;
+
+		bool Open(const std::vector<std::string>& _columns) noexcept override;
+		bool Write(const unsigned long long* _ticks, const float* _values, unsigned _rows) noexcept override;
+		bool Close(void) noexcept override;
+
+	private:
+		std::string mPath;
+		std::FILE* mpFile;
+		unsigned mnColumns;
+	};
+
+	// column by column within a block, which compresses and loads far better than rows
+	class BinaryTelemetrySink final : public TelemetrySink
+	{
+	public:
+		explicit BinaryTelemetrySink(const std::string& _path) noexcept;
+		~BinaryTelemetrySink(void) noexcept;
+
+		bool Open(const std::vector<std::string>& _columns) noexcept override;
+		bool Write(const unsigned long long* _ticks, const float* _values, unsigned _rows) noexcept override;
+		bool Close(void) noexcept override;
+
+	private:
+		std::string mPath;
+		std::FILE* mpFile;
+		unsigned mnColumns;
+		std::vector<float> mColumn;
+	};
+
+	// .csv is written as text, anything else in the binary layout
+	std::unique_ptr<TelemetrySink> MakeTelemetrySink(const std::string& _path);
+
+	// the sim fills blocks of samples and hands the full ones to a writer thread, the only lock it takes is the
+	// swap of one block into the pending list so a slow disk never holds a tick up. when the writer falls too far
+	// behind whole blocks are dropped and counted instead of growing the backlog, unless the stream blocks
+	class TelemetryStream
+	{
+	public:
+		TelemetryStream(void) noexcept;
+		~TelemetryStream(void) noexcept;
+
+		TelemetryStream(const TelemetryStream&) = delete;
+		TelemetryStream& operator=(const TelemetryStream&) = delete;
+
+		// a blocking stream waits for the writer to catch up instead of dropping, for runs where a gap is never
+		// acceptable and a tick may as well wait on the disk
+		bool Start(std::unique_ptr<TelemetrySink> _sink, const std::vector<std::string>& _columns, bool _blocking = false);
+		// flushes what is buffered and waits for the writer to finish
+		void Stop(void) noexcept;
+		bool IsRunning(void) const noexcept;
+
+		// one sample, GetColumnCount values
+		void Push(unsigned long long _tick, const float* _values) noexcept;
+		unsigned GetColumnCount(void) const noexcept;
+		// rows of the current or last run, kept after Stop. dropped never reached the writer, failed did not make it
+		// to the disk, the rows of a write that came up short or all of them when the last flush failed
+		unsigned long long GetWrittenRows(void) const noexcept;
+		unsigned long long GetDroppedRows(void) const noexcept;
+		unsigned long long GetFailedRows(void) const noexcept;
+
+	private:
+		struct Block
+		{
+			std::vector<unsigned long long> mTicks;
+			std::vector<float> mValues;
+		};
+
+		void WriterLoop(void) noexcept;
+		void Submit(void) noexcept;
+		std::unique_ptr<Block> TakeFree(void) noexcept;
+
+		std::unique_ptr<TelemetrySink> mpSink;
+		std::thread mWriter;
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		// the writer took the pending blocks, a blocking Submit waits on it
+		std::condition_variable mDrained;
+		std::vector<std::unique_ptr<Block>> mPending;
+		// written blocks handed back for reuse
+		std::vector<std::unique_ptr<Block>> mFree;
+		// the one the sim is filling, only it touches this
+		std::unique_ptr<Block> mpCurrent;
+		unsigned mnColumns;
+		unsigned long long mnDropped;
+		// counted by the writer
+		std::atomic<unsigned long long> mnWritten;
+		std::atomic<unsigned long long> mnFailed;
+		bool mbBlocking;
+		bool mbStop;
+	};
+}
+
+#endif
+
+
+
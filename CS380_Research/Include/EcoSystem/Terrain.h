@@ -1,12 +1,44 @@
 #ifndef _TERRAIN_H_
 #define _TERRAIN_H_
 
+#include <cstdint>
 #include <vector>
 
+#include "EcoSystem/ChunkedGrid.h"
+#include "EcoSystem/CreatureHandle.h"
+#include "EcoSystem/FlowField.h"
+#include "EcoSystem/Grid.h"
+#include "EcoSystem/MaxPyramid.h"
+#include "EcoSystem/Random.h"
+
+// cells per side of a parallel update tile
+#define TERRAIN_TILE_SIZE 64
+// octile distance past which PATH_AUTO takes the long route instead of searching
+#define TERRAIN_LONG_PATH 64.f
+// cells between the points of the rate noise unless SetRateNoise says otherwise
+#define TERRAIN_NOISE_SCALE 32.f
+
 namespace CS380
 {
-	template<typename T>
-	using Map = std::vector<std::vector<T>>;
+	class ThreadPool;
+	class Profiler;
+	class PathArena;
+	struct PathCursor;
+	class CheckpointWriter;
+	class CheckpointReader;
+
+	// how a path request is answered. every cell is walkable at the same step costs, so the entrance graph a
+	// hierarchical search would build is every cluster joined to its neighbours at octile distance and the best
+	// route across it is the octile line itself. the long route is that line, written out without touching a node
+	enum PathMode : unsigned char
+	{
+		// A* over the cells, what sense radius trips use
+		PATH_LOCAL,
+		// the octile line, as long as the route itself and no search
+		PATH_LONG,
+		// long past TERRAIN_LONG_PATH, local below it
+		PATH_AUTO
+	};
 
 	struct GridPos
 	{
@@ -16,16 +48,50 @@ namespace CS380
 		int y;
 	};
 
+	// search state per cell, only valid while mnGen matches its scratch's current search. 20 bytes, the cell is
+	// 16 bit a side (MAX_WORLD_SIDE fits) and the way back is the direction code of the step that led here
 	struct Node
 	{
-		Node(const GridPos& _p, float _t, float _h) noexcept;
 		Node(void) noexcept;
-		bool operator<(const Node& _rhs) const noexcept;
-		GridPos pos;
+		std::uint16_t mnX;
+		std::uint16_t mnY;
 		float tcost;
-		float hcost;
 		float fcost;
-		Node* mpPrev;
+		unsigned mnGen : 29;
+		unsigned mnPrev : 3;
+		// slot in the open heap, or NODE_UNSEEN / NODE_CLOSED
+		unsigned mnHeapIdx;
+	};
+
+	// A* state for one worker so searches running side by side never share nodes. nodes are chunked, so a worker
+	// only pays for the part of the world its searches have explored rather than a node per cell
+	struct PathScratch
+	{
+		PathScratch(void) noexcept;
+
+		ChunkedGrid<Node> mNodes;
+		// open list reused across searches
+		std::vector<Node*> mOpen;
+		unsigned mnSearchGen;
+
+		void Reset(unsigned _w, unsigned _h) noexcept;
+		void BeginSearch(void) noexcept;
+		Node* TouchNode(int _x, int _y) noexcept;
+		void PushOpen(Node* _n) noexcept;
+		Node* PopOpen(void) noexcept;
+		void SiftUp(unsigned _i) noexcept;
+		void SiftDown(unsigned _i) noexcept;
+	};
+
+	// what changed in a tile since the map last redrew it
+	enum TileDirty : unsigned char
+	{
+		DIRTY_GRASS = 1 << 0,
+		DIRTY_FERTILIZER = 1 << 1,
+		DIRTY_OCCUPANCY = 1 << 2,
+		// set by the publish on every tile while there is scent, the terrain never does
+		DIRTY_SCENT = 1 << 3,
+		DIRTY_ALL = DIRTY_GRASS | DIRTY_FERTILIZER | DIRTY_OCCUPANCY
 	};
 
 	class Terrain
@@ -33,74 +99,240 @@ namespace CS380
 	public:
 		Terrain(unsigned _x = 0, unsigned _y = 0);
 		
+		// draws every layer off the world's seed, band by band over the pool. the same for any thread count
 		void Init(float _iga, float _igl, float _igh, unsigned _w, unsigned _h, float _grl, float _grh, float _gm, float _fm, float _frl, float _frh) noexcept;
+		// where the map sits in a bigger world cut up between processes (see Domain), so Init draws the fertilizer
+		// gradient over the whole world. a world of 0 by 0 is the map itself, the default
+		void SetWorldFrame(unsigned _x, unsigned _y, unsigned _w, unsigned _h) noexcept;
+		// how far Init blends the per cell growth rates towards smooth noise _scale cells across, so the map has
+		// fertile and barren patches instead of white noise. 0 (the default) is per cell rates only
+		void SetRateNoise(float _mix, float _scale = TERRAIN_NOISE_SCALE) noexcept;
 
-		const Map<int>& GetSpaceLayer(void) const noexcept;
-		Map<int>& GetSpaceLayer(void) noexcept;
+		// every layer, the occupancy heads and the awake and lazy state. Load takes the place of Init, the grass
+		// ratio pyramid and the flow fields are rebuilt from what it read
+		void Save(CheckpointWriter& _w) const;
+		bool Load(CheckpointReader& _r);
 
-		const Map<float>& GetGrassLayer(void) const noexcept;
-		Map<float>& GetGrassLayer(void) noexcept;
+		// chunked, memory follows where creatures have been instead of the size of the world
+		const ChunkedGrid<CreatureHandle>& GetSpaceLayer(void) const noexcept;
+		ChunkedGrid<CreatureHandle>& GetSpaceLayer(void) noexcept;
 
-		const Map<float>& GetFertilizerLayer(void) const noexcept;
-		Map<float>& GetFertilizerLayer(void) noexcept;
+		const Grid<float>& GetGrassLayer(void) const noexcept;
+		Grid<float>& GetGrassLayer(void) noexcept;
 
-		const Map<float>& GetGrassLayerRate(void) const noexcept;
-		Map<float>& GetGrassLayerRate(void) noexcept;
+		const Grid<float>& GetFertilizerLayer(void) const noexcept;
+		Grid<float>& GetFertilizerLayer(void) noexcept;
 
-		const Map<std::pair<float, float>>& GetGrassLayerThresh(void) const noexcept;
-		Map<std::pair<float, float>>& GetGrassLayerThresh(void) noexcept;
+		const Grid<float>& GetGrassLayerRate(void) const noexcept;
+		Grid<float>& GetGrassLayerRate(void) noexcept;
 
-		// first is normal, second is max
-		const Map<std::pair<float, float>>& GetFertilizerLayerThresh(void) const noexcept;
-		Map<std::pair<float, float>>& GetFertilizerLayerThresh(void) noexcept;
+		// low and high limits, the same for every cell of a map
+		float GetGrassThreshLo(void) const noexcept;
+		float GetGrassThreshHi(void) const noexcept;
 
+		// lo is the normal ratio and differs per cell, hi is max and does not
+		const Grid<float>& GetFertilizerThreshLo(void) const noexcept;
+		float GetFertilizerThreshHi(void) const noexcept;
+
+		// tiles are spread over the pool when one is set, the result is the same for any thread count
+		void SetThreadPool(ThreadPool* _pool) noexcept;
+		// the world's seed, Init draws the layers and the tie break key from it
+		void SetRandom(const Random* _random) noexcept;
+		// searches and the spill's neighbour picks are timed and counted into it, may be null
+		void SetProfiler(Profiler* _profiler) noexcept;
+		// where the shortest paths are written, has to be set before the first search
+		void SetPathArena(PathArena* _paths) noexcept;
 		void Update(float) noexcept;
 
+		// optional lazy mode for huge, sparsely visited worlds: Update only counts ticks and a cell works out its
+		// growth since it was last touched in closed form when something reads it. a saturated cell hands its
+		// spill to its lowest neighbour when it is next touched instead of every tick, so a lazy run follows the
+		// same rules but is not bit for bit an eager one. switching back settles every cell
+		void SetLazy(bool _b) noexcept;
+		bool IsLazy(void) const noexcept;
+		// current values, the stored layers lag behind in lazy mode. safe to call from several workers at once
+		float GetGrass(unsigned _x, unsigned _y) const noexcept;
+		float GetFertilizer(unsigned _x, unsigned _y) const noexcept;
+		float GetFertilizerRatio(unsigned _x, unsigned _y) const noexcept;
+
+		// every cell's grass and grass / hi added up. Update and ConsumeGrass keep them in step with their deltas, in
+		// lazy mode Settle does too, so they hold every cell as of its last settle. that is at most a spill interval
+		// behind on a tile that still grows and exact on one at rest
+		double GetGrassTotal(void) const noexcept;
+		double GetGrassRatioSum(void) const noexcept;
+		// the sums from scratch, for whoever writes the grass layer directly
+		void RecountGrass(void) noexcept;
+
 		float ConsumeGrass(unsigned _x, unsigned _y, float _val) noexcept;
+		// adds to a cell's fertilizer, marking and waking it
+		void AddFertilizer(unsigned _x, unsigned _y, float _v) noexcept;
+		// a cell's grass, fertilizer and fertilizer floor as some other world has them, for the halo of a Domain.
+		// keeps the sums and the grass pyramid in step and wakes the cell and its neighbours like ConsumeGrass
+		void SetCell(unsigned _x, unsigned _y, float _grass, float _fert, float _fertLo) noexcept;
+
+		// Update only computes awake cells, a cell goes to sleep once an update leaves it exactly where it was and
+		// nothing around it can move it. ConsumeGrass and AddFertilizer wake what they touch, anyone else writing
+		// the grass or fertilizer layer has to Wake the cell too
+		void Wake(unsigned _x, unsigned _y) noexcept;
+		unsigned long long GetAwakeCells(void) const noexcept;
 
 		unsigned int GetGrassColor(unsigned _x, unsigned _y) const noexcept;
 
-		// A*
-		std::vector<GridPos> GetShortestPath(const GridPos& _source, const GridPos& _dest) noexcept;
-		GridPos GetBestGrassPos(const GridPos& _source, float _mnLimit, float _minAlpha) noexcept;
+		// A*, NotePathRequest then PeekShortestPath
+		bool GetShortestPath(const GridPos& _source, const GridPos& _dest, PathCursor& _out, PathMode _mode = PATH_AUTO, unsigned* _nodes = nullptr) noexcept;
+		// same path but leaves the flow field cache alone, so several workers can call it at once. the path (source
+		// excluded) goes straight into the arena, false and _out untouched when there is none. a long route is
+		// as short as the search's but may bend elsewhere. _nodes, when given, gets the nodes the search expanded
+		bool PeekShortestPath(const GridPos& _source, const GridPos& _dest, PathCursor& _out, PathMode _mode = PATH_AUTO, unsigned* _nodes = nullptr) noexcept;
+		// the flow field bookkeeping of one path request (use counts, builds, evictions)
+		void NotePathRequest(const GridPos& _source, const GridPos& _dest) noexcept;
+		// one search scratch per worker that may call PeekShortestPath
+		void ReserveSearchWorkers(unsigned _n) noexcept;
+		// highest grass / thresh cell above _minAlpha within reach of _mnLimit, ties broken by a hash of the query
+		GridPos GetBestGrassPos(const GridPos& _source, float _mnLimit, float _minAlpha) const noexcept;
 		GridPos GetEmptyNeighbour(const GridPos& _src) noexcept;
+		// one step of the shortest path, O(1) when _dest has a cached flow field covering _src
+		GridPos GetNextStep(const GridPos& _src, const GridPos& _dest) noexcept;
+		const FlowFieldCache& GetFlowFields(void) const noexcept;
+
+		// TileDirty bits per TERRAIN_TILE_SIZE tile. Update and ConsumeGrass keep the grass and fertilizer bits, in
+		// lazy mode Settle does, whoever else writes a layer marks the cell. they add up until the next snapshot
+		// clears them
+		void MarkDirty(unsigned _x, unsigned _y, unsigned char _bits) noexcept;
+		unsigned char GetTileDirty(unsigned _tx, unsigned _ty) const noexcept;
+		void ClearDirty(void) noexcept;
+		unsigned GetTilesX(void) const noexcept;
+		unsigned GetTilesY(void) const noexcept;
+
+		// the grass colour for a grass / (hi - lo) ratio, what GetGrassColor gives a cell
+		static unsigned int GrassColor(float _ratio) noexcept;
 
 	private:
 
-		Map<int> mSpaceLayer;
-		Map<float> mGrassLayer;
-		Map<float> mFertilizerLayer;
-		Map<Node> mNodeLayer;
+		ChunkedGrid<CreatureHandle> mSpaceLayer;
+		Grid<float> mGrassLayer;
+		Grid<float> mFertilizerLayer;
 
-		Map<float> mGrassLayerRate;
-		Map<float> mFertilizerRate;
+		Grid<float> mGrassLayerRate;
+		Grid<float> mFertilizerRate;
 
-		// std pair low,high
-		Map<std::pair<float,float>> mGrassThresh;
-		// first is normal, second is max
-		Map<std::pair<float,float>> mFertilizerThresh;
+		// low, high. Init gives every cell the same limits, so they are kept once for the map
+		float mfGrassLo;
+		float mfGrassHi;
+		// normal per cell, max for the map
+		Grid<float> mFertilizerThreshLo;
+		float mfFertilizerHi;
+
+		// spill from saturated cells, written in the growth pass and gathered after it
+		Grid<float> mGrassNext;
+		Grid<signed char> mSpillDir;
+		Grid<float> mSpillAmount;
+
+		ThreadPool* mpPool;
+		const Random* mpRandom;
+		Profiler* mpProfiler;
+		PathArena* mpPaths;
+		unsigned long long mnUpdateCount;
 
 		unsigned mnWidth;
 		unsigned mnHeight;
+		// SetWorldFrame, the world's size is 0 without one
+		unsigned mnFrameX;
+		unsigned mnFrameY;
+		unsigned mnWorldWidth;
+		unsigned mnWorldHeight;
+		float mfRateNoise;
+		float mfRateNoiseScale;
+
+		// grass / (hi - lo) per cell, kept in step with mGrassLayer by Update and ConsumeGrass
+		MaxPyramid mGrassRatio;
+		// keys the stateless tie break hashes so they follow the master seed too
+		std::uint64_t mnHashSeed;
+
+		// step costs only change on Init, so fields stay valid until then
+		FlowFieldCache mFlowFields;
 
-		std::vector<Node*> GetNeighbours(const GridPos& _src, const GridPos& _dest, float _curT, Node * _prev) noexcept;
+		// indexed by ThreadPool::GetCurrentWorker
+		std::vector<PathScratch> mScratch;
+
+		// TileDirty per tile, a tile only ever writes its own entry during Update
+		std::vector<unsigned char> mTileDirty;
+		unsigned mnTilesX;
+		unsigned mnTilesY;
+
+		// a bit per cell and a word per tile row, tile after tile, so a tile only ever writes its own words.
+		// overfull sleepers sit above their grass limit where a neighbour's spill still clamps them, so the
+		// gather keeps visiting them
+		std::vector<std::uint64_t> mAwake;
+		std::vector<std::uint64_t> mOverfull;
+		// tiles whose grass moved this update, only those rebuild their part of mGrassRatio
+		std::vector<unsigned char> mTileGrassChanged;
+		// what the gather moved each tile's grass and grass / hi by, added to the totals after it
+		std::vector<double> mTileGrassDelta;
+		std::vector<double> mTileRatioDelta;
+		double mfGrassTotal;
+		double mfGrassRatioSum;
+		// sleeping cells are only at rest for the step they were computed with
+		float mfLastDt;
+
+		// lazy mode, the layers of a cell hold its values as of update mLastTick, which wraps along with
+		// mnUpdateCount. spill its neighbours handed it waits in mPendingSpill until it settles
+		bool mbLazy;
+		Grid<unsigned> mLastTick;
+		Grid<float> mPendingSpill;
+		// update a tile next settles at so its saturated cells hand on their spill, tiles where every cell is
+		// saturated next to a saturated neighbour wait until something is eaten near them
+		std::vector<unsigned long long> mTileDue;
+
+		struct LazyCell
+		{
+			float mfGrass;
+			float mfFert;
+			float mfSpill;
+		};
+		LazyCell Project(unsigned _x, unsigned _y) const noexcept;
+		// writes a cell's current values back, a no-op outside lazy mode
+		void Settle(unsigned _x, unsigned _y) noexcept;
+		void SettleAll(void) noexcept;
+		// false once every cell of the tile is at rest
+		bool SettleTile(unsigned _tx, unsigned _ty) noexcept;
+		void ScheduleAround(unsigned _x, unsigned _y) noexcept;
+
+		bool LongPath(const GridPos& _src, const GridPos& _dest, PathCursor& _out) noexcept;
+
+		struct BestGrassQuery;
+		void SearchBestGrass(unsigned _level, unsigned _bx, unsigned _by, BestGrassQuery& _q) const noexcept;
 		template<typename T>
-		void Normalize(Map<T>& _m);
-		GridPos GetLowestGrass(const GridPos& _src) noexcept;
+		void Normalize(Grid<T>& _m);
+		int GetLowestGrass(unsigned _x, unsigned _y) const noexcept;
+		std::size_t GetAwakeWord(unsigned _x, unsigned _y) const noexcept;
+		void WakeAround(unsigned _x, unsigned _y) noexcept;
+		void WakeAll(void) noexcept;
+		// false once the cell is at rest
+		bool UpdateCell(unsigned _x, unsigned _y, float _dt) noexcept;
+		void StepCell(unsigned _x, unsigned _y, float _dt, std::uint64_t& _awake, std::uint64_t& _over) noexcept;
+		void UpdateTile(unsigned _tx, unsigned _ty, float _dt) noexcept;
+		void GatherTile(unsigned _tx, unsigned _ty) noexcept;
 	};
 
 	template<typename T>
-	inline void Terrain::Normalize(Map<T>& _m)
+	inline void Terrain::Normalize(Grid<T>& _m)
 	{
-		T largest = _m[0][0];
-		for (unsigned i = 0; i < _m.size(); ++i)
-			for (unsigned j = 0; j < _m[i].size(); ++j)
-				if (_m[i][j] > largest)
-					largest = _m[i][j];
-
-		for (unsigned i = 0; i < _m.size(); ++i)
-			for (unsigned j = 0; j < _m[i].size(); ++j)
-				_m[i][j] /= largest;
+		T largest = _m(0, 0);
+		for (unsigned i = 0; i < _m.GetHeight(); ++i)
+		{
+			const T* row = _m.Row(i);
+			for (unsigned j = 0; j < _m.GetWidth(); ++j)
+				if (row[j] > largest)
+					largest = row[j];
+		}
+
+		for (unsigned i = 0; i < _m.GetHeight(); ++i)
+		{
+			T* row = _m.Row(i);
+			for (unsigned j = 0; j < _m.GetWidth(); ++j)
+				row[j] /= largest;
+		}
 	}
 
 }
@@ -0,0 +1,57 @@
+#ifndef _THREADPOOL_H_
+#define _THREADPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CS380
+{
+	// fixed set of workers for fork/join style loops, the calling thread joins in on every job
+	// so a pool of 1 runs everything inline
+	class ThreadPool
+	{
+	public:
+		explicit ThreadPool(unsigned _threads = 0) noexcept;
+		~ThreadPool(void) noexcept;
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// 0 picks hardware_concurrency
+		void Resize(unsigned _threads) noexcept;
+		unsigned GetThreadCount(void) const noexcept;
+
+		// runs _func(i, worker) for every i in [0, _count) and blocks until all are done,
+		// worker is in [0, GetThreadCount()) and is stable for the length of the call
+		void ParallelFor(unsigned _count, const std::function<void(unsigned, unsigned)>& _func) noexcept;
+
+		// worker index of the calling thread, 0 for any thread that is not one of a pool's workers
+		static unsigned GetCurrentWorker(void) noexcept;
+
+	private:
+		void WorkerLoop(unsigned _worker) noexcept;
+		void RunJob(unsigned _worker) noexcept;
+		void Stop(void) noexcept;
+
+		std::vector<std::thread> mWorkers;
+		std::mutex mMutex;
+		std::condition_variable mWake;
+		std::condition_variable mDone;
+
+		const std::function<void(unsigned, unsigned)>* mpJob;
+		unsigned mnCount;
+		std::atomic<unsigned> mnNext;
+		unsigned mnBusy;
+		unsigned long long mnGeneration;
+		bool mbStop;
+	};
+}
+
+#endif
+
+
+
@@ -7,7 +7,7 @@ namespace CS380
 	class LogTool :public Tools
 	{
 	public:
-		LogTool(bool _opened = true) noexcept;
+		LogTool(EcoSystem& _eco, bool _opened = true) noexcept;
 		~LogTool(void) noexcept;
 
 		void Render(void) noexcept;
@@ -0,0 +1,29 @@
+#ifndef _PROFILER_TOOL_H_
+#define _PROFILER_TOOL_H_
+#include "EcoSystem/Tools/Tools.h"
+
+#include <vector>
+
+namespace CS380
+{
+	// frame graphs of the profiler's per tick history and a flame graph of one tick of it
+	class ProfilerTool : public Tools
+	{
+	public:
+		ProfilerTool(EcoSystem& _eco, bool _opened = false) noexcept;
+		~ProfilerTool(void) noexcept;
+
+		void Render(void) noexcept;
+
+	private:
+		bool mbRecording;
+		// ticks back from the newest the flame graph shows
+		int mnFrameBack;
+		std::vector<float> mPlot;
+	};
+}
+
+#endif
+
+
+
@@ -8,7 +8,7 @@ namespace CS380
 	class SpawnTool : public Tools
 	{
 	public:
-		SpawnTool(bool _opened = true) noexcept;
+		SpawnTool(EcoSystem& _eco, bool _opened = true) noexcept;
 		~SpawnTool(void) noexcept;
 
 		void Render(void) noexcept;
@@ -19,6 +19,9 @@ namespace CS380
 		int mnSpawnY;
 		int mnCurrSelection;
 		int mnSpawnCount;
+		unsigned mnBatchCount;
+		// percent of the free cells the fill button takes
+		float mfFillPercent;
 		float mfCurSize;
 		float mfCurSpeed;
 		float mfCurSense;
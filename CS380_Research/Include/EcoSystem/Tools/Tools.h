@@ -5,10 +5,13 @@
 
 namespace CS380
 {
+	class EcoSystem;
+
 	class Tools
 	{
 	public:
-		Tools(std::string _name, bool _opened = true) noexcept;
+		// a tool works on the world it was made for
+		Tools(EcoSystem& _eco, std::string _name, bool _opened = true) noexcept;
 		virtual ~Tools(void) noexcept;
 
 		const std::string& GetName(void) const noexcept;
@@ -18,6 +21,7 @@ namespace CS380
 		
 	protected:
 
+		EcoSystem& mEco;
 		bool mbOpened;
 		std::string mName;
 
@@ -1,20 +1,45 @@
 #ifndef _VIEWER_TOOL_H_
 #define _VIEWER_TOOL_H_
 #include "EcoSystem/Tools/Tools.h"
+#include "EcoSystem/CreatureHandle.h"
+
+#include <vector>
 
 namespace CS380
 {
+	// creature list and cell inspector over the snapshot. only the rows in view submit widgets, and cells are
+	// picked off the map instead of listed
 	class ViewTool : public Tools
 	{
 	public:
-		ViewTool(bool _open = true) noexcept;
+		ViewTool(EcoSystem& _eco, bool _open = true) noexcept;
 		~ViewTool(void) noexcept;
 
 		void Render(void) noexcept;
 
 	private:
-
-		int mnCurrSelection;
+		void RenderFilter(void) noexcept;
+		void RenderCreatures(void) noexcept;
+		void RenderCells(void) noexcept;
+		void Refilter(void);
+
+		CreatureHandle mCurrSelection;
+
+		// snapshot indices of the creatures that pass the filter, redone every frame as the snapshot moves on
+		std::vector<unsigned> mFiltered;
+		// matched against the species name and the hex uid, case insensitive
+		char mSearch[64];
+		unsigned mnSpeciesMask;
+		// size, speed, sense
+		float mTraitMin[3];
+		float mTraitMax[3];
+		// energy over max energy
+		float mfEnergyMin;
+		float mfEnergyMax;
+
+		// hovering the map shows the cell under the mouse, clicking pins it
+		bool mbPick;
+		int mPinned[2];
 	};
 }
 
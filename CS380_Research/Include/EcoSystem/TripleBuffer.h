@@ -0,0 +1,59 @@
+#ifndef _TRIPLE_BUFFER_H_
+#define _TRIPLE_BUFFER_H_
+
+#include <atomic>
+
+namespace CS380
+{
+	// three slots between one writer and one reader. the writer fills Back and Publishes it, the reader Acquires
+	// the newest one into Front. each side owns its slot outright and they only swap an index, so neither waits
+	template<typename T>
+	class TripleBuffer
+	{
+	public:
+		TripleBuffer(void) noexcept
+			: mSlots{}, mnBack{ 0 }, mnShared{ 1 }, mnFront{ 2 }
+		{}
+
+		TripleBuffer(const TripleBuffer&) = delete;
+		TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+		// writer side
+		T& Back(void) noexcept { return mSlots[mnBack]; }
+		void Publish(void) noexcept
+		{
+			mnBack = mnShared.exchange(mnBack | FRESH, std::memory_order_acq_rel) & INDEX;
+		}
+		// the reader has picked up the last Publish. a writer that only publishes then never has one overwritten
+		// unseen, so the reader sees every snapshot
+		bool IsTaken(void) const noexcept
+		{
+			return !(mnShared.load(std::memory_order_acquire) & FRESH);
+		}
+
+		// reader side, true when a newer slot was swapped into Front
+		bool Acquire(void) noexcept
+		{
+			if (!(mnShared.load(std::memory_order_relaxed) & FRESH))
+				return false;
+			mnFront = mnShared.exchange(mnFront, std::memory_order_acq_rel) & INDEX;
+			return true;
+		}
+		const T& Front(void) const noexcept { return mSlots[mnFront]; }
+
+	private:
+		static constexpr unsigned INDEX = 3u;
+		static constexpr unsigned FRESH = 4u;
+
+		T mSlots[3];
+		unsigned mnBack;
+		// index of the slot in between, FRESH while it holds a publish the reader has not taken
+		std::atomic<unsigned> mnShared;
+		unsigned mnFront;
+	};
+}
+
+#endif
+
+
+
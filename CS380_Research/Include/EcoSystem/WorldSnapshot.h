@@ -0,0 +1,149 @@
+#ifndef _WORLD_SNAPSHOT_H_
+#define _WORLD_SNAPSHOT_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "EcoSystem/ChunkedGrid.h"
+#include "EcoSystem/CreatureHandle.h"
+#include "EcoSystem/Grid.h"
+#include "EcoSystem/Profiler.h"
+#include "EcoSystem/RingBuffer.h"
+
+namespace CS380
+{
+	struct EvolutionData;
+
+	// what the gui shows of one creature
+	struct CreatureView
+	{
+		CreatureHandle mHandle;
+		std::uint64_t mnID;
+		int mnX;
+		int mnY;
+		unsigned int mnColor;
+		float mfEnergy;
+		float mfMaxEnergy;
+		float mfSize;
+		float mfSpeed;
+		float mfSense;
+		float mfRepChance;
+		float mfMutChance;
+	};
+
+	// first creature on a cell, its colour and how many share the cell
+	struct CellOccupants
+	{
+		CreatureHandle mHead;
+		unsigned int mnColor;
+		unsigned mnCrowd;
+	};
+
+	// the world as the sim thread left it at the end of a tick, read only to the gui thread once published.
+	// planes hold the layers that change while running, the grass rate and the thresholds other than the
+	// fertilizer's lo only change in Terrain::Init and are read off the terrain
+	struct WorldSnapshot
+	{
+		unsigned long long mnTick;
+		float mfTicksPerSecond;
+		unsigned mnPeakPops;
+		unsigned mnWidth;
+		unsigned mnHeight;
+		unsigned mnTilesX;
+		unsigned mnTilesY;
+
+		Grid<float> mGrass;
+		Grid<float> mFertilizer;
+		Grid<float> mFertilizerLo;
+		// every scented species' scent added up, copied whole every publish and empty without any
+		Grid<float> mScent;
+		// chunked like the occupancy layer it copies
+		ChunkedGrid<CellOccupants> mOccupants;
+
+		// TileDirty bits of what changed since the snapshot before this one
+		std::vector<unsigned char> mTileDirty;
+		// publish each tile was last copied at, a tile is only copied into a slot again when it changed since
+		std::vector<unsigned> mTileGen;
+
+		std::vector<CreatureView> mCreatures;
+		std::vector<RingBuffer<float>> mLogs;
+		// the telemetry stream's rows so far, lost is dropped and failed together
+		bool mbTelemetry;
+		unsigned long long mnTelemetryWritten;
+		unsigned long long mnTelemetryLost;
+		// the profiler's per tick history, empty while it is not recording
+		RingBuffer<ProfileFrame> mProfile;
+	};
+
+	// change asked for by the gui, applied by the sim thread between ticks
+	struct UiCommand
+	{
+		enum Type : unsigned char
+		{
+			// a species mnIndex creature at (x, y) if the cell is still free
+			UI_SPAWN,
+			// mnCount species mnIndex creatures on random free cells, or that fraction of the free cells when mfValue is
+			// above 0. mnSeed picks the STREAM_TOOLS sub stream
+			UI_SPAWN_RANDOM,
+			// every creature gives its energy back to the map
+			UI_NUKE,
+			// the run as of this tick to CHECKPOINT_DEFAULT_PATH
+			UI_SAVE_CHECKPOINT,
+			// mfValue into meParam, for evolution chart mnIndex on the chart ones
+			UI_SET
+		};
+
+		enum Param : unsigned char
+		{
+			PARAM_TIME_STEP,
+			PARAM_MAX_TICKS,
+			PARAM_BATCHED,
+			PARAM_PARALLEL,
+			PARAM_UNTHROTTLED,
+			PARAM_LAZY_TERRAIN,
+			PARAM_LOG_WINDOW,
+			PARAM_LOG_FREQ,
+			PARAM_MUTATION_EPSILON,
+			PARAM_REPLICATION_THRESH,
+			PARAM_REPLICATE_CHANCE,
+			PARAM_MUTATION_CHANCE,
+			// profiler recording on or off, turning it on starts a fresh history
+			PARAM_PROFILE,
+			// species mnIndex leaves a scent or stops
+			PARAM_SCENT
+		};
+
+		Type meType;
+		Param meParam;
+		int mnIndex;
+		unsigned mnX;
+		unsigned mnY;
+		unsigned mnCount;
+		unsigned mnSeed;
+		float mfValue;
+		float mfSize;
+		float mfSpeed;
+		float mfSense;
+	};
+
+	// the gui's copy of the settings the sim thread owns, edits go out as UI_SET commands
+	struct SimSettings
+	{
+		float mfTimeStep;
+		float mfLogFreq;
+		float mfMutationEpsilon;
+		int mnMaxTicksPerFrame;
+		int mnLogWindow;
+		bool mbBatched;
+		bool mbParallel;
+		bool mbUnthrottled;
+		bool mbLazyTerrain;
+		unsigned mnScentMask;
+		std::vector<EvolutionData> mEvolution;
+	};
+}
+
+#endif
+
+
+
@@ -0,0 +1,333 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include "EcoSystem/EcoSystem.h"
+#include "Data/EcoData.h"
+
+// Benchmark runner, canned scenarios from a fixed seed with one json object per scenario on each line so runs
+// of two builds diff line by line. links the same simulation core as the headless runner
+//
+// usage: CS380_Bench [options]
+//   --scenario NAME           run only NAME, may be given several times (default every scenario)
+//   --list                    print the scenario names and exit
+//   --threads N               worker threads (default 1, 0 = all hardware threads)
+//   --parallel 0|1            parallel creature phase (default 0)
+//   --batched 0|1             batched creature metabolism pass (default 0)
+//   --lazy-terrain 0|1        lazy terrain (default 0)
+//   --scent 0|1               foxes follow a rabbit scent instead of searching (default 0)
+//   --ticks-scale F           scales every scenario's tick count, for quick runs (default 1)
+//   --out PATH                append the results to PATH instead of printing them
+//
+// peak rss is the process' so far, run a scenario on its own for its peak alone
+
+#define BENCH_SEED 380ull
+
+namespace
+{
+	// every allocation the process makes, read around the ticks to get allocations per tick
+	std::atomic<unsigned long long> gnAllocs{ 0 };
+	std::atomic<unsigned long long> gnAllocBytes{ 0 };
+
+	void* CountedAlloc(std::size_t _n)
+	{
+		gnAllocs.fetch_add(1, std::memory_order_relaxed);
+		gnAllocBytes.fetch_add(_n, std::memory_order_relaxed);
+		void* p = malloc(_n ? _n : 1);
+		if (!p)
+			throw std::bad_alloc{};
+		return p;
+	}
+
+	void* CountedAlignedAlloc(std::size_t _n, std::size_t _align)
+	{
+		gnAllocs.fetch_add(1, std::memory_order_relaxed);
+		gnAllocBytes.fetch_add(_n, std::memory_order_relaxed);
+#if defined(_MSC_VER)
+		void* p = _aligned_malloc(_n ? _n : 1, _align);
+#else
+		void* p = nullptr;
+		if (posix_memalign(&p, _align < sizeof(void*) ? sizeof(void*) : _align, _n ? _n : 1))
+			p = nullptr;
+#endif
+		if (!p)
+			throw std::bad_alloc{};
+		return p;
+	}
+
+	void AlignedFree(void* _p) noexcept
+	{
+#if defined(_MSC_VER)
+		_aligned_free(_p);
+#else
+		free(_p);
+#endif
+	}
+
+	unsigned long long PeakRssBytes(void)
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS pmc{};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+			return pmc.PeakWorkingSetSize;
+		return 0;
+#else
+		rusage ru{};
+		if (getrusage(RUSAGE_SELF, &ru))
+			return 0;
+#if defined(__APPLE__)
+		return static_cast<unsigned long long>(ru.ru_maxrss);
+#else
+		return static_cast<unsigned long long>(ru.ru_maxrss) * 1024ull;
+#endif
+#endif
+	}
+
+	struct Scenario
+	{
+		const char* mpName;
+		unsigned mnSide;
+		unsigned mnTicks;
+		unsigned mnRabbits;
+		unsigned mnFoxes;
+		float mfGrassA;
+		// replicate chance of the rabbit chart entry, negative keeps the default
+		float mfRabbitReplicate;
+		// rabbits on this fraction of the cells still free after the counts
+		float mfRabbitFill;
+	};
+
+	const Scenario Scenarios[] = {
+		// terrain alone, growth and the sleeping cells with nothing eating them
+		{ "empty-64", 64, 4000, 0, 0, 0.1f, -1.f, 0.f },
+		{ "empty-200", 200, 1000, 0, 0, 0.1f, -1.f, 0.f },
+		{ "empty-1000", 1000, 100, 0, 0, 0.1f, -1.f, 0.f },
+		{ "empty-4000", 4000, 10, 0, 0, 0.1f, -1.f, 0.f },
+		// spawning and pool growth, rabbits replicating far faster than the default chart lets them
+		{ "rabbit-boom", 200, 2000, 200, 0, 0.6f, 0.05f, 0.f },
+		// foxes hunting through the spatial index
+		{ "predator-prey", 200, 2000, 1000, 100, 0.3f, -1.f, 0.f },
+		// a crowd on thin grass, every rabbit keeps searching and walking paths
+		{ "dense-colony", 96, 1000, 4000, 0, 0.02f, -1.f, 0.f },
+		// seeding a big map most of the way full, spawn_seconds is the bulk spawn itself
+		{ "fill-1000", 1000, 2, 0, 0, 0.3f, -1.f, 0.8f }
+	};
+
+	struct BenchConfig
+	{
+		std::vector<std::string> mScenarios;
+		unsigned mnThreads = 1;
+		bool mbParallel = false;
+		bool mbBatched = false;
+		bool mbLazyTerrain = false;
+		bool mbScent = false;
+		float mfTicksScale = 1.f;
+		const char* mpOut = nullptr;
+		bool mbList = false;
+	};
+
+	void PrintUsage(void)
+	{
+		printf("usage: CS380_Bench [--scenario NAME]... [--list] [--threads N]\n"
+			   "                   [--parallel 0|1] [--batched 0|1] [--lazy-terrain 0|1]\n"
+			   "                   [--scent 0|1] [--ticks-scale F] [--out PATH]\n");
+	}
+
+	bool ParseArgs(int argc, char** argv, BenchConfig& _cfg)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const char* arg = argv[i];
+			if (!strcmp(arg, "--help") || !strcmp(arg, "-h"))
+				return false;
+			if (!strcmp(arg, "--list"))
+			{
+				_cfg.mbList = true;
+				continue;
+			}
+			if (i + 1 >= argc)
+			{
+				fprintf(stderr, "missing value for %s\n", arg);
+				return false;
+			}
+			const char* val = argv[++i];
+
+			if (!strcmp(arg, "--scenario"))
+				_cfg.mScenarios.push_back(val);
+			else if (!strcmp(arg, "--threads"))
+				_cfg.mnThreads = static_cast<unsigned>(atoi(val));
+			else if (!strcmp(arg, "--parallel"))
+				_cfg.mbParallel = atoi(val) != 0;
+			else if (!strcmp(arg, "--batched"))
+				_cfg.mbBatched = atoi(val) != 0;
+			else if (!strcmp(arg, "--lazy-terrain"))
+				_cfg.mbLazyTerrain = atoi(val) != 0;
+			else if (!strcmp(arg, "--scent"))
+				_cfg.mbScent = atoi(val) != 0;
+			else if (!strcmp(arg, "--ticks-scale"))
+				_cfg.mfTicksScale = static_cast<float>(atof(val));
+			else if (!strcmp(arg, "--out"))
+				_cfg.mpOut = val;
+			else
+			{
+				fprintf(stderr, "unknown option %s\n", arg);
+				return false;
+			}
+		}
+		return _cfg.mfTicksScale > 0.f;
+	}
+
+	const Scenario* FindScenario(const std::string& _name)
+	{
+		for (const Scenario& s : Scenarios)
+			if (_name == s.mpName)
+				return &s;
+		return nullptr;
+	}
+
+	void RunScenario(const Scenario& _s, const BenchConfig& _cfg, FILE* _out)
+	{
+		const unsigned ticks = std::max(1u, static_cast<unsigned>(_s.mnTicks * _cfg.mfTicksScale));
+
+		// the ticks are timed on their own, of the set up only the spawns are
+		std::unique_ptr<CS380::EcoSystem> eco = std::make_unique<CS380::EcoSystem>();
+		eco->SetWorkerCount(_cfg.mnThreads);
+		eco->SetParallelUpdate(_cfg.mbParallel);
+		eco->SetBatchedUpdate(_cfg.mbBatched);
+		eco->SetLazyTerrain(_cfg.mbLazyTerrain);
+		eco->SetScentSpecies(_cfg.mbScent ? 1u << CS380::Data::SpeciesOf<CS380::Rabbit>() : 0u);
+		eco->GetRandom().SetMasterSeed(BENCH_SEED);
+		if (_s.mfRabbitReplicate >= 0.f)
+		{
+			CS380::EvolutionData evo = eco->GetEvolutionData(CS380::Data::SpeciesOf<CS380::Rabbit>());
+			evo.mfReplicateChance = _s.mfRabbitReplicate;
+			eco->SetEvolutionData(CS380::Data::SpeciesOf<CS380::Rabbit>(), evo);
+		}
+		eco->SetWorldSize(_s.mnSide, _s.mnSide);
+		eco->SetGrassParams(_s.mfGrassA, 0.025f, 1.0f, 0.0001f, 0.05f, 300.f);
+		eco->Begin();
+		const auto spawnStart = std::chrono::steady_clock::now();
+		eco->Populate(CS380::Data::SpeciesOf<CS380::Rabbit>(), _s.mnRabbits);
+		eco->Populate(CS380::Data::SpeciesOf<CS380::Fox>(), _s.mnFoxes);
+		if (_s.mfRabbitFill > 0.f)
+			eco->PopulateFill(CS380::Data::SpeciesOf<CS380::Rabbit>(), _s.mfRabbitFill);
+		const double spawnSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - spawnStart).count();
+		eco->ResetPhaseTimes();
+
+		const unsigned long long allocs = gnAllocs.load();
+		const unsigned long long allocBytes = gnAllocBytes.load();
+		const auto start = std::chrono::steady_clock::now();
+		for (unsigned t = 0; t < ticks; ++t)
+			eco->Tick();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		const double tickAllocs = static_cast<double>(gnAllocs.load() - allocs) / ticks;
+		const double tickAllocBytes = static_cast<double>(gnAllocBytes.load() - allocBytes) / ticks;
+
+		// the end state goes in too, a build that changes the simulation shows up as well as one that changes its speed
+		fprintf(_out, "{\"scenario\":\"%s\",\"side\":%u,\"ticks\":%u,\"seed\":%llu,\"threads\":%u,\"parallel\":%d,\"batched\":%d,\"lazy_terrain\":%d,\"scent\":%d,"
+			"\"spawn_seconds\":%.6f,\"seconds\":%.6f,\"ticks_per_second\":%.2f,"
+			"\"phase_seconds\":{\"terrain\":%.6f,\"creatures\":%.6f,\"cleanup\":%.6f,\"logs\":%.6f},"
+			"\"allocs_per_tick\":%.2f,\"alloc_bytes_per_tick\":%.1f,\"peak_rss_bytes\":%llu,"
+			"\"creatures\":%u,\"peak_creatures\":%u,\"grass_ratio_sum\":%.4f}\n",
+			_s.mpName, _s.mnSide, ticks, BENCH_SEED, eco->GetThreadPool().GetThreadCount(), _cfg.mbParallel, _cfg.mbBatched, _cfg.mbLazyTerrain, _cfg.mbScent,
+			spawnSeconds, seconds, seconds > 0.0 ? ticks / seconds : 0.0,
+			eco->GetPhaseSeconds(CS380::PHASE_TERRAIN), eco->GetPhaseSeconds(CS380::PHASE_CREATURES),
+			eco->GetPhaseSeconds(CS380::PHASE_CLEANUP), eco->GetPhaseSeconds(CS380::PHASE_LOGS),
+			tickAllocs, tickAllocBytes, PeakRssBytes(),
+			eco->GetCreatureCount(), eco->mnPeakPops, eco->GetTerrain().GetGrassRatioSum());
+		fflush(_out);
+	}
+}
+
+void* operator new(std::size_t _n)
+{
+	return CountedAlloc(_n);
+}
+
+void* operator new(std::size_t _n, std::align_val_t _align)
+{
+	return CountedAlignedAlloc(_n, static_cast<std::size_t>(_align));
+}
+
+void operator delete(void* _p) noexcept
+{
+	free(_p);
+}
+
+void operator delete(void* _p, std::size_t) noexcept
+{
+	free(_p);
+}
+
+void operator delete(void* _p, std::align_val_t) noexcept
+{
+	AlignedFree(_p);
+}
+
+void operator delete(void* _p, std::size_t, std::align_val_t) noexcept
+{
+	AlignedFree(_p);
+}
+
+int main(int argc, char** argv)
+{
+	BenchConfig cfg;
+	if (!ParseArgs(argc, argv, cfg))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (cfg.mbList)
+	{
+		for (const Scenario& s : Scenarios)
+			printf("%s\n", s.mpName);
+		return 0;
+	}
+
+	std::vector<const Scenario*> run;
+	if (cfg.mScenarios.empty())
+		for (const Scenario& s : Scenarios)
+			run.push_back(&s);
+	for (const std::string& name : cfg.mScenarios)
+	{
+		const Scenario* s = FindScenario(name);
+		if (!s)
+		{
+			fprintf(stderr, "unknown scenario %s\n", name.c_str());
+			return 1;
+		}
+		run.push_back(s);
+	}
+
+	FILE* out = stdout;
+	if (cfg.mpOut && !(out = fopen(cfg.mpOut, "a")))
+	{
+		fprintf(stderr, "could not open %s\n", cfg.mpOut);
+		return 1;
+	}
+
+	for (const Scenario* s : run)
+		RunScenario(*s, cfg, out);
+
+	if (out != stdout)
+		fclose(out);
+	return 0;
+}
@@ -1,12 +1,15 @@
 #include "Creatures/Creature.h"
 #include "EcoSystem/EcoSystem.h"
 #include "Data/EcoData.h"
-#include "imgui.h"
+#include "EcoSystem/Color.h"
+#include "EcoSystem/Checkpoint.h"
+#include "EcoSystem/CommandBuffer.h"
+#include "EcoSystem/Platform.h"
 
+#include <algorithm>
 #include <functional>
 #include <utility>
-#include <random>
-#include <time.h> 
+#include <cmath>
 
 namespace
 {
@@ -26,33 +29,19 @@ namespace
 		0.5f
 	};
 
-	float GetActionCost(float size, float speed, float sense, float energy, Action e, float _modifier = 1.f)
+	// the trait term every action's cost scales, kept per creature in CreatureHotData::mMetabolism
+	float GetMetabolism(float size, float speed, float sense)
 	{
-		return (gActionCost[e]/2 * ((2*pow(size, 2) * speed * speed + sense + size) + energy) + (gActionCost[e]/2) * energy) * _modifier;
+		return 2 * size * size * speed * speed + sense + size;
 	}
 
-	std::string RandomString(int len)
+	float GetActionCost(float metabolism, float energy, Action e, float _modifier = 1.f)
 	{
-		std::srand(static_cast<unsigned int>(time(NULL)));
-		std::string str = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-		std::string newstr;
-		int pos;
-		while (newstr.size() != len) 
-		{
-			pos = ((std::rand() % (str.size() - 1)));
-			newstr += str.substr(pos, 1);
-		}
-		return newstr;
+		return (gActionCost[e] / 2 * metabolism + gActionCost[e] * energy) * _modifier;
 	}
-}
 
-namespace CS380
-{
-	extern EvolutionData EvolutionChart[EVOLUTION_CHART_COUNT];
 }
 
-float CS380::CREATURE_MUTATION_EPSILON = 0.1f;
-
 template<typename T>
 T Clamp(T min, T max, T val)
 {
@@ -75,37 +64,54 @@ CS380::Traits::Traits(const Traits& _t) noexcept
 	: Traits{ _t.mfSize, _t.mfSpeed, _t.mfSense }
 {}
 
-CS380::Creature::Creature(const std::string& _name, unsigned short _flags, const Traits& _t, unsigned _id) noexcept
-	: mBitFlags{ _flags }, mName{ _name }, mTraits{ _t }, mnColorCode{}, mfFatigueThresh{ 0.3f }, mfEnergyThresh{ 0.3f },
-	mCurPath{}, mfAccPathDt{}, mnPosX{}, mnPosY{}, mnHomeX{}, mnHomeY{}, mEvoData{}, mnChartID{ _id },
-	mfFatigue{ std::make_pair(0.f,0.f) }, mfEnergy{ std::make_pair(0.f,0.f) }, mUniqueID{ RandomString(16) }
-{
+CS380::Creature::Creature(unsigned short _flags, const Traits& _t, unsigned _id) noexcept
+	: mRng{}, mnUniqueID{ 0 }, mnColorCode{}, mnChartID{ _id }, mpWorld{ nullptr }, mpHot{ nullptr }, mnRow{ 0 }, mHandle{},
+	mfFatigueThresh{ 0.3f }, mfEnergyThresh{ 0.3f }, mEvoData{}, mPath{}, mnPathTicket{ 0 }, mnLastTicket{ 0 }, mnHomeX{}, mnHomeY{}, mbOnGrid{ false }
+{
+	const CreatureBinding b = CreaturePoolBase::TakeBinding();
+	if (!b.mpHot)
+		ECO_DEBUGBREAK(); // constructed outside of a CreaturePool?
+	mpWorld = b.mpWorld;
+	mpHot = b.mpHot;
+	mnRow = b.mnRow;
+	mHandle = b.mHandle;
+
+	mnUniqueID = mpWorld->GetRandom().NextEntityId();
+	mRng = mpWorld->GetRandom().EntityStream(mnUniqueID);
+
+	CreatureHotData& h = Hot();
+	const unsigned r = Row();
+	h.mFlags[r] = _flags;
+	h.mSize[r] = _t.mfSize;
+	h.mSpeed[r] = _t.mfSpeed;
+	h.mSense[r] = _t.mfSense;
+	h.mMetabolism[r] = ::GetMetabolism(_t.mfSize, _t.mfSpeed, _t.mfSense);
 	SetColor();
 }
 
 CS380::Creature::~Creature(void) noexcept
 {
-
+	mpWorld->GetPaths().Release(mPath);
 }
 
 unsigned short CS380::Creature::GetFlags(void) const noexcept
 {
-	return mBitFlags;
+	return Hot().mFlags[Row()];
 }
 
 float CS380::Creature::GetSize(void) const noexcept
 {
-	return mTraits.mfSize;
+	return Hot().mSize[Row()];
 }
 
 float CS380::Creature::GetSpeed(void) const noexcept
 {
-	return mTraits.mfSpeed;
+	return Hot().mSpeed[Row()];
 }
 
 float CS380::Creature::GetSense(void) const noexcept
 {
-	return mTraits.mfSense;
+	return Hot().mSense[Row()];
 }
 
 unsigned int CS380::Creature::GetColor(void) const noexcept
@@ -113,30 +119,34 @@ unsigned int CS380::Creature::GetColor(void) const noexcept
 	return mnColorCode;
 }
 
-const std::string& CS380::Creature::GetName(void) const noexcept
+const char* CS380::Creature::GetName(void) const noexcept
 {
-	return mName;
+	return Data::SpeciesNames[GetSpecies()];
 }
 
 std::pair<float,float> CS380::Creature::GetFatigue(void) const noexcept
 {
-	return mfFatigue;
+	const unsigned r = Row();
+	return std::make_pair(Hot().mFatigue[r], Hot().mFatigueMax[r]);
 }
 
 std::pair<float, float> CS380::Creature::GetEnergy(void) const noexcept
 {
-	return mfEnergy;
+	const unsigned r = Row();
+	return std::make_pair(Hot().mEnergy[r], Hot().mEnergyMax[r]);
 }
 
 void CS380::Creature::GetGridPosition(unsigned& _outX, unsigned& _outY) const noexcept
 {
-	_outX = mnPosX;
-	_outY = mnPosY;
+	const unsigned r = Row();
+	_outX = Hot().mPosX[r];
+	_outY = Hot().mPosY[r];
 }
 
 CS380::GridPos CS380::Creature::GetGridPosition(void) const noexcept
 {
-	return GridPos{ static_cast<int>(mnPosX), static_cast<int>(mnPosY) };
+	const unsigned r = Row();
+	return GridPos{ static_cast<int>(Hot().mPosX[r]), static_cast<int>(Hot().mPosY[r]) };
 }
 
 void CS380::Creature::GetHomeGridPosition(unsigned& _outX, unsigned& _outY) const noexcept
@@ -147,19 +157,19 @@ void CS380::Creature::GetHomeGridPosition(unsigned& _outX, unsigned& _outY) cons
 
 bool CS380::Creature::HasPendingMovement(void) const noexcept
 {
-	return !mCurPath.empty();
+	return mPath.mnLeft != 0 || mnPathTicket != 0;
 }
 
 CS380::GridPos CS380::Creature::GetPendingDestination(void) const noexcept
 {
-	if (mCurPath.empty())
+	if (!mPath.mnLeft)
 		return GridPos{ -1,-1 };
-	return mCurPath.back();
+	return GridPos{ mPath.mnEndX, mPath.mnEndY };
 }
 
-const std::string& CS380::Creature::GetUniqueID(void) const noexcept
+std::uint64_t CS380::Creature::GetUniqueID(void) const noexcept
 {
-	return mUniqueID;
+	return mnUniqueID;
 }
 
 float CS380::Creature::GetMutChance(void) const noexcept
@@ -177,9 +187,25 @@ const CS380::EvolutionData& CS380::Creature::GetEvoData(void) const noexcept
 	return mEvoData;
 }
 
-const CS380::Traits& CS380::Creature::GetTraits(void) const noexcept
+CS380::Traits CS380::Creature::GetTraits(void) const noexcept
+{
+	const unsigned r = Row();
+	return Traits{ Hot().mSize[r], Hot().mSpeed[r], Hot().mSense[r] };
+}
+
+const CS380::CreatureHandle& CS380::Creature::GetHandle(void) const noexcept
 {
-	return mTraits;
+	return mHandle;
+}
+
+unsigned CS380::Creature::GetSpecies(void) const noexcept
+{
+	return mHandle.GetSpecies();
+}
+
+CS380::EcoSystem& CS380::Creature::GetWorld(void) const noexcept
+{
+	return *mpWorld;
 }
 
 void CS380::Creature::SetFatigueThreshold(float _zeroToOne) noexcept
@@ -194,43 +220,69 @@ void CS380::Creature::SetEnergyThreshold(float _zeroToOne) noexcept
 
 void CS380::Creature::SetFatigueBase(const std::pair<float, float>& _minMax) noexcept
 {
-	mfFatigue = _minMax;
+	const unsigned r = Row();
+	Hot().mFatigue[r] = _minMax.first;
+	Hot().mFatigueMax[r] = _minMax.second;
 }
 
 void CS380::Creature::SetEnergyBase(const std::pair<float, float>& _minMax) noexcept
 {
-	mfEnergy = _minMax;
+	const unsigned r = Row();
+	Hot().mEnergy[r] = _minMax.first;
+	Hot().mEnergyMax[r] = _minMax.second;
 }
 
 float CS380::Creature::ConsumeFatigue(float _f) noexcept
 {
-	mfFatigue.first = Clamp(0.f, mfFatigue.second, mfFatigue.first - _f);
-	return mfFatigue.first;
+	CreatureHotData& h = Hot();
+	const unsigned r = Row();
+	h.mFatigue[r] = Clamp(0.f, h.mFatigueMax[r], h.mFatigue[r] - _f);
+	return h.mFatigue[r];
 }
 
 float CS380::Creature::ConsumeEnergy(float _f) noexcept
 {
-	if (_f > mfEnergy.first)
-		EcoSystem::GetInst().ReturnEnergyToMap(_f - mfEnergy.first, GetGridPosition());
-	mfEnergy.first = Clamp(0.f, mfEnergy.second, mfEnergy.first - _f);
-	return mfEnergy.first;
+	CreatureHotData& h = Hot();
+	const unsigned r = Row();
+	if (_f > h.mEnergy[r])
+		GetWorld().ReturnEnergyToMap(_f - h.mEnergy[r], GetGridPosition());
+	h.mEnergy[r] = Clamp(0.f, h.mEnergyMax[r], h.mEnergy[r] - _f);
+	return h.mEnergy[r];
 }
 
 void CS380::Creature::SetColor(float _red, float _green, float _blue, float _alpha ) noexcept
 {
-	mnColorCode = ImGui::GetColorU32({ _red, _green, _blue, _alpha });
+	mnColorCode = PackColor(_red, _green, _blue, _alpha);
 }
 
 void CS380::Creature::SetGridPosition(unsigned _x, unsigned _y) noexcept
 {
-	mnPosX = _x;
-	mnPosY = _y;
+	CreatureHotData& h = Hot();
+	const unsigned r = Row();
+	const GridPos to{ static_cast<int>(_x), static_cast<int>(_y) };
+	if (!mbOnGrid)
+		GetWorld().AddOccupant(mHandle, to);
+	else if (h.mPosX[r] != _x || h.mPosY[r] != _y)
+		GetWorld().MoveOccupant(mHandle, GetGridPosition(), to);
+	mbOnGrid = true;
+
+	h.mPosX[r] = _x;
+	h.mPosY[r] = _y;
 }
 
 void CS380::Creature::MarkTerritory(void) noexcept
 {
-	mnHomeX = mnPosX;
-	mnHomeY = mnPosY;
+	GetGridPosition(mnHomeX, mnHomeY);
+}
+
+void CS380::Creature::SetFlag(unsigned short _f) noexcept
+{
+	Hot().mFlags[Row()] |= _f;
+}
+
+void CS380::Creature::ClearFlag(unsigned short _f) noexcept
+{
+	Hot().mFlags[Row()] &= static_cast<unsigned short>(~_f);
 }
 
 void CS380::Creature::SetEvolutionData(const EvolutionData& _dat) noexcept
@@ -238,85 +290,174 @@ void CS380::Creature::SetEvolutionData(const EvolutionData& _dat) noexcept
 	mEvoData = _dat;
 }
 
-void CS380::Creature::SetMovement(const std::vector<GridPos>& _path)
+bool CS380::Creature::SetMovement(const GridPos& _dest, PathMode _mode)
 {
-	mCurPath.clear();
-	for (const auto &p : _path)
-		mCurPath.push_back(p);
-	mfAccPathDt = 0.f;
+	PathCursor path{};
+	if (!GetWorld().GetShortestPath(GetGridPosition(), _dest, path, _mode))
+		return false;
+	GetWorld().GetPaths().Release(mPath);
+	mPath = path;
+	mnPathTicket = 0;
+	Hot().mPathDt[Row()] = 0.f;
+	if (mPath.mnLeft)
+		TimeNextStep();
+	return true;
 }
 
-void CS380::Creature::Move(float _dt)
+void CS380::Creature::RequestMovement(const GridPos& _dest, PathMode _mode)
 {
-	mfAccPathDt += _dt;
-
-	int euc = (mCurPath.front().x - static_cast<int>(mnPosX)) * (mCurPath.front().x - static_cast<int>(mnPosX)) +
-			  (mCurPath.front().y - static_cast<int>(mnPosY)) * (mCurPath.front().y - static_cast<int>(mnPosY));
+	if (!++mnLastTicket)
+		++mnLastTicket;
+	mnPathTicket = mnLastTicket;
+	GetWorld().RequestPath(PathRequest{ mHandle, _dest.x, _dest.y, mnPathTicket, _mode });
+}
 
-	float tReq = sqrt(static_cast<float>(euc)) / (mTraits.mfSpeed);
+bool CS380::Creature::IsPathTicket(std::uint32_t _ticket) const noexcept
+{
+	return mnPathTicket == _ticket;
+}
 
-	while (mfAccPathDt > tReq)
+void CS380::Creature::DeliverPath(std::uint32_t _ticket, bool _found, PathCursor& _path) noexcept
+{
+	PathArena& paths = GetWorld().GetPaths();
+	if (mnPathTicket != _ticket)
+	{
+		paths.Release(_path);
+		return;
+	}
+	mnPathTicket = 0;
+	if (!_found)
+		return;
+	paths.Release(mPath);
+	mPath = _path;
+	Hot().mPathDt[Row()] = 0.f;
+	if (mPath.mnLeft)
+		TimeNextStep();
+}
+
+void CS380::Creature::Translate(int _dx, int _dy) noexcept
+{
+	CreatureHotData& h = Hot();
+	const unsigned r = Row();
+	h.mPosX[r] = static_cast<unsigned>(static_cast<int>(h.mPosX[r]) + _dx);
+	h.mPosY[r] = static_cast<unsigned>(static_cast<int>(h.mPosY[r]) + _dy);
+	// a home off the new map is kept at its edge
+	mnHomeX = static_cast<unsigned>(std::clamp(static_cast<int>(mnHomeX) + _dx, 0, GetWorld().GetWidth() - 1));
+	mnHomeY = static_cast<unsigned>(std::clamp(static_cast<int>(mnHomeY) + _dy, 0, GetWorld().GetHeight() - 1));
+	GetWorld().GetPaths().Release(mPath);
+	mPath.mnAtX = mPath.mnEndX = static_cast<int>(h.mPosX[r]);
+	mPath.mnAtY = mPath.mnEndY = static_cast<int>(h.mPosY[r]);
+	mnPathTicket = 0;
+	h.mPathDt[r] = 0.f;
+	// resting waits on a path it no longer has
+	h.mFlags[r] &= static_cast<unsigned short>(~Flags::FLAG_RESTING);
+}
+
+void CS380::Creature::AdvancePath(void)
+{
+	CreatureHotData& h = Hot();
+	const unsigned r = Row();
+	PathArena& paths = GetWorld().GetPaths();
+
+	while (h.mPathDt[r] > h.mStepDt[r])
 	{
-		mfAccPathDt -= tReq;
-		SetGridPosition(mCurPath.front().x, mCurPath.front().y);
-		ConsumeEnergy(::GetActionCost(mTraits.mfSize, mTraits.mfSpeed, mTraits.mfSense, mfEnergy.first, ::Action::MOVE));
-		mCurPath.pop_front();
-		if (mCurPath.empty())
+		h.mPathDt[r] -= h.mStepDt[r];
+		const unsigned d = paths.Peek(mPath);
+		SetGridPosition(mPath.mnAtX + NeighbourDX[d], mPath.mnAtY + NeighbourDY[d]);
+		ConsumeEnergy(::GetActionCost(h.mMetabolism[r], h.mEnergy[r], ::Action::MOVE));
+		paths.Advance(mPath);
+		if (!mPath.mnLeft)
 			break;
-
-		euc = (mCurPath.front().x - static_cast<int>(mnPosX)) * (mCurPath.front().x - static_cast<int>(mnPosX)) +
-			  (mCurPath.front().y - static_cast<int>(mnPosY)) * (mCurPath.front().y - static_cast<int>(mnPosY));
-		tReq = sqrt(static_cast<float>(euc)) / (mTraits.mfSpeed);
+		TimeNextStep();
 	}
 }
 
+void CS380::Creature::TimeNextStep(void) noexcept
+{
+	const unsigned d = GetWorld().GetPaths().Peek(mPath);
+	const int dx = NeighbourDX[d];
+	const int dy = NeighbourDY[d];
+	Hot().mStepDt[Row()] = sqrt(static_cast<float>(dx * dx + dy * dy)) / Hot().mSpeed[Row()];
+}
+
+void CS380::Creature::Rest(float _energyBelow) noexcept
+{
+	if (!mPath.mnLeft)
+		return;
+	SetFlag(Flags::FLAG_RESTING);
+	Hot().mWakeEnergy[Row()] = _energyBelow;
+}
+
+bool CS380::Creature::StillResting(void) noexcept
+{
+	CreatureHotData& h = Hot();
+	const unsigned r = Row();
+	if (!(h.mFlags[r] & Flags::FLAG_RESTING))
+		return false;
+	if (mPath.mnLeft && h.mEnergy[r] > 0.f && h.mEnergy[r] >= h.mWakeEnergy[r])
+		return true;
+	h.mFlags[r] &= static_cast<unsigned short>(~Flags::FLAG_RESTING);
+	return false;
+}
+
 float CS380::Creature::Eaten(Creature *)
 {
-	mBitFlags |= FLAG_DEAD;
-	float e = mfEnergy.first;
-	mfEnergy.first = 0;
-	mfEnergy.second = 0;
+	CreatureHotData& h = Hot();
+	const unsigned r = Row();
+	h.mFlags[r] |= FLAG_DEAD;
+	float e = h.mEnergy[r];
+	h.mEnergy[r] = 0;
+	h.mEnergyMax[r] = 0;
 	return e;
 }
 
 float CS380::Creature::Eat(void)
 {
-	float v = EcoSystem::GetInst().Eat(GetGridPosition(), this);
-	if(mfEnergy.first + v > mfEnergy.second)
-		EcoSystem::GetInst().ReturnEnergyToMap(mfEnergy.first + v - mfEnergy.second, GetGridPosition());
-	mfEnergy.first = Clamp(mfEnergy.first, mfEnergy.second, mfEnergy.first + v);
-	if (mfEnergy.first / mfEnergy.second >= mEvoData.mfReplicationThresh)
+	if (CommandBuffer* cmd = CommandBuffer::GetActive())
+	{
+		cmd->Eat(mHandle, GetGridPosition());
+		return 0.f;
+	}
+	return Digest(GetWorld().Eat(GetGridPosition(), this));
+}
+
+float CS380::Creature::Digest(float _v)
+{
+	// Replicate below may grow the pool's columns, so nothing is held across it
+	auto e = GetEnergy();
+	if(e.first + _v > e.second)
+		GetWorld().ReturnEnergyToMap(e.first + _v - e.second, GetGridPosition());
+	e.first = Clamp(e.first, e.second, e.first + _v);
+	Hot().mEnergy[Row()] = e.first;
+	if (e.first / e.second >= mEvoData.mfReplicationThresh)
 		Replicate();
 
-	return v;
+	return _v;
 }
 
 void CS380::Creature::Replicate(void)
 {
-	std::random_device rd;
-	std::mt19937 mt(rd());
-	std::uniform_real_distribution<float> dist(0.f, 1.f);
-	std::uniform_real_distribution<float> distMutV(-CREATURE_MUTATION_EPSILON, CREATURE_MUTATION_EPSILON);
-
-	if (dist(mt) <= mEvoData.mfReplicateChance)
+	if (mRng.NextFloat() <= mEvoData.mfReplicateChance)
 	{
-		GridPos p = EcoSystem::GetInst().GetEmptyNeighbour(GetGridPosition());
+		GridPos p = GetWorld().GetEmptyNeighbour(GetGridPosition());
 		if (p.x < 0 || p.y < 0) return;
 
-		float sze = mTraits.mfSize;
-		float spd = mTraits.mfSpeed;
-		float sen = mTraits.mfSense;
+		const Traits t = GetTraits();
+		float sze = t.mfSize;
+		float spd = t.mfSpeed;
+		float sen = t.mfSense;
 
-		if (dist(mt) <= mEvoData.mfMutationChance)
+		if (mRng.NextFloat() <= mEvoData.mfMutationChance)
 		{
-			sze = Clamp(0.01f, 100.f, sze + distMutV(mt));
-			spd = Clamp(0.01f, 100.f, spd + distMutV(mt));
-			spd = Clamp(0.01f, 100.f, spd + distMutV(mt));
-			sen = Clamp(0.01f, 100.f, sen + distMutV(mt));
+			const float eps = GetWorld().GetMutationEpsilon();
+			sze = Clamp(0.01f, 100.f, sze + mRng.Range(-eps, eps));
+			spd = Clamp(0.01f, 100.f, spd + mRng.Range(-eps, eps));
+			spd = Clamp(0.01f, 100.f, spd + mRng.Range(-eps, eps));
+			sen = Clamp(0.01f, 100.f, sen + mRng.Range(-eps, eps));
 		}							
 
-		ConsumeEnergy(::GetActionCost(mTraits.mfSize, mTraits.mfSpeed, mTraits.mfSense, mfEnergy.first, ::Action::REPLICATE));
-		Data::VisitSpawnTuple(Data::SpawnVisitor{ p.x, p.y, EvolutionChart[mnChartID],
+		ConsumeEnergy(::GetActionCost(Hot().mMetabolism[Row()], GetEnergy().first, ::Action::REPLICATE));
+		Data::VisitSpawnTuple(Data::SpawnVisitor{ GetWorld(), p.x, p.y, GetWorld().GetEvolutionData(mnChartID),
 						      Traits{ sze, spd, sen } }, mnChartID);
 	}
 }
@@ -326,20 +467,107 @@ void CS380::Creature::UpdateAwake(float _dt) noexcept
 	if (_dt <= 0.f)
 		return;
 
-	ConsumeEnergy(::GetActionCost(mTraits.mfSize, mTraits.mfSpeed, mTraits.mfSense, mfEnergy.first, ::Action::IDLE, _dt));
-	if (mfEnergy.first <= 0.f)
-		mBitFlags |= Flags::FLAG_DEAD;
+	TickAwake(_dt);
+	this->UpdateAwakeBehaviour(_dt);
+}
 
-	if (!mCurPath.empty())
-		Move(_dt);
+void CS380::Creature::TickAwake(float _dt) noexcept
+{
+	if (ConsumeEnergy(::GetActionCost(Hot().mMetabolism[Row()], GetEnergy().first, ::Action::IDLE, _dt)) <= 0.f)
+		SetFlag(Flags::FLAG_DEAD);
 
-	this->UpdateAwakeBehaviour(_dt);
+	if (mPath.mnLeft)
+	{
+		Hot().mPathDt[Row()] += _dt;
+		AdvancePath();
+	}
 }
 
-void CS380::Creature::UpdateAsleep(float _dt) noexcept
+void CS380::Creature::DrainBatched(CreatureHotData& _h, unsigned _begin, unsigned _end, float _dt) noexcept
 {
-	this->UpdateAsleepBehaviour(_dt);
+	// straight float loop so it vectorizes. the path timer runs for everyone, SetMovement resets it anyway
+	float* energy = _h.mEnergy.data();
+	float* debt = _h.mIdleDebt.data();
+	float* pathDt = _h.mPathDt.data();
+	const float* metabolism = _h.mMetabolism.data();
+	const float base = gActionCost[::Action::IDLE] / 2 * _dt;
+	const float rate = gActionCost[::Action::IDLE] * _dt;
+	for (unsigned i = _begin; i < _end; ++i)
+	{
+		const float left = energy[i] - (base * metabolism[i] + rate * energy[i]);
+		debt[i] = left < 0.f ? -left : 0.f;
+		energy[i] = left > 0.f ? left : 0.f;
+		pathDt[i] += _dt;
+	}
 }
 
+void CS380::Creature::SettleBatched(void) noexcept
+{
+	CreatureHotData& h = Hot();
+	const unsigned row = Row();
+	if (h.mIdleDebt[row] > 0.f)
+		GetWorld().ReturnEnergyToMap(h.mIdleDebt[row], GetGridPosition());
+	if (h.mEnergy[row] <= 0.f)
+		h.mFlags[row] |= Flags::FLAG_DEAD;
+
+	if (mPath.mnLeft)
+		AdvancePath();
+}
 
+void CS380::Creature::UpdateAsleep(float _dt) noexcept
+{
+	this->UpdateAsleepBehaviour(_dt);
+}
 
+void CS380::Creature::SaveState(CheckpointWriter& _w) const
+{
+	_w.Pod(mRng);
+	_w.Pod(mnUniqueID);
+	_w.Pod(mnColorCode);
+	_w.Pod(mnChartID);
+	_w.Pod(mfFatigueThresh);
+	_w.Pod(mfEnergyThresh);
+	_w.Pod(mEvoData.mfReplicationThresh);
+	_w.Pod(mEvoData.mfReplicateChance);
+	_w.Pod(mEvoData.mfMutationChance);
+	_w.Pod(mnHomeX);
+	_w.Pod(mnHomeY);
+	_w.Pod(mbOnGrid);
+	_w.Pod(mnPathTicket);
+	_w.Pod(mnLastTicket);
+	// the cell the steps left leave from, then a direction code a step
+	std::vector<std::uint8_t> steps;
+	steps.reserve(mPath.mnLeft);
+	mpWorld->GetPaths().ForEachStep(mPath, [&steps](unsigned _d) { steps.push_back(static_cast<std::uint8_t>(_d)); });
+	_w.Pod(mPath.mnAtX);
+	_w.Pod(mPath.mnAtY);
+	_w.Vector(steps);
+}
+
+void CS380::Creature::LoadState(CheckpointReader& _r)
+{
+	_r.Pod(mRng);
+	_r.Pod(mnUniqueID);
+	_r.Pod(mnColorCode);
+	_r.Pod(mnChartID);
+	_r.Pod(mfFatigueThresh);
+	_r.Pod(mfEnergyThresh);
+	_r.Pod(mEvoData.mfReplicationThresh);
+	_r.Pod(mEvoData.mfReplicateChance);
+	_r.Pod(mEvoData.mfMutationChance);
+	_r.Pod(mnHomeX);
+	_r.Pod(mnHomeY);
+	_r.Pod(mbOnGrid);
+	_r.Pod(mnPathTicket);
+	_r.Pod(mnLastTicket);
+	const int x = _r.Pod<int>();
+	const int y = _r.Pod<int>();
+	std::vector<std::uint8_t> steps;
+	_r.Vector(steps);
+	PathArena& paths = mpWorld->GetPaths();
+	paths.Release(mPath);
+	mPath = paths.Allocate(GridPos{ x, y }, static_cast<unsigned>(steps.size()));
+	PathWriter w{ paths, mPath };
+	for (std::uint32_t i = 0; i < mPath.mnLeft; ++i)
+		w.Push(steps[i] & 7u);
+}
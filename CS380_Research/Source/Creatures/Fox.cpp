@@ -1,12 +1,14 @@
 #include "Creatures/Fox.h"
 #include "EcoSystem/EcoSystem.h"
+#include "EcoSystem/Checkpoint.h"
 #include "Creatures/Rabbit.h"
-#include "imgui.h"
+#include "Data/EcoData.h"
+#include <algorithm>
 #include <cmath>
 
 CS380::Fox::Fox(const Traits& _t, unsigned _id) noexcept
-	: Creature{ "Fox", FLAG_INVALID, _t, _id },
-	searching{ false }
+	: Creature{ FLAG_INVALID, _t, _id },
+	searching{ false }, isHungry{ false }, preyFound{ false }, predFound{ false }
 {
 	// color
 	float totalT = _t.mfSense + _t.mfSize + _t.mfSpeed;
@@ -28,7 +30,7 @@ CS380::Fox::~Fox(void) noexcept
 void CS380::Fox::UpdateAwakeBehaviour(float)
 {
 	//if (GetFlags() & FLAG_TIRED)
-	//	mBitFlags |= FLAG_ASLEEP;
+	//	SetFlag(FLAG_ASLEEP);
 
 	if (GetEnergy().first < 0.1f * GetEnergy().second)
 	{
@@ -41,8 +43,6 @@ void CS380::Fox::UpdateAwakeBehaviour(float)
 
 	if (!searching)
 	{
-		int xDirection[8] = { -1, -1, -1, 0, 0, 1, 1, 1 };
-		int yDirection[8] = { 1, -1, 0, -1, 1, 0, 1, -1 };
 		searching = true;
 		unsigned x = 0;
 		unsigned y = 0;
@@ -50,44 +50,65 @@ void CS380::Fox::UpdateAwakeBehaviour(float)
 
 		if(static_cast<int>(GetSense()) >= 1)
 		{
-			for (int rad = 1; rad <= static_cast<int>(GetSense()); rad++)
+			EcoSystem& eco = GetWorld();
+			const GridPos pos{ static_cast<int>(x), static_cast<int>(y) };
+			const float size = GetSize();
+			// NearestOf only offers live creatures, and only their traits may be read here
+			auto edible = [&](const Creature* _c) { return size / _c->GetSize() >= 1.2f; };
+			const unsigned rabbit = Data::SpeciesOf<Rabbit>();
+
+			// a rabbit trail leads the way a cell per decision, only at the top of it is there a search and that
+			// one only of the cells around. the scent does not tell a big rabbit from a small one
+			SpatialHit prey{};
+			if (eco.IsScented(rabbit))
 			{
-				if (preyFound) break;
+				const GridPos up = eco.ClimbScent(pos, rabbit);
+				if (up.x >= 0 && !(up == pos))
+				{
+					RequestMovement(up, PATH_LONG);
+					preyFound = true;
+				}
+				else
+					prey = eco.NearestOf(pos, 1.5f, rabbit, edible);
+			}
+			else
+				prey = eco.NearestOf(pos, GetSense(), rabbit, edible);
 
-				for (int i = 0; i < 8; ++i)
+			if (prey.mHandle.IsValid())
+			{
+				RequestMovement(GridPos{ prey.mnX, prey.mnY });
+				preyFound = true;
+			}
+			else if (!preyFound)
+			{
+				// any fox we are not 1.2x bigger than could eat us, run directly away from the nearest
+				const SpatialHit threat = eco.NearestOf(pos, GetSense(), Data::SpeciesOf<Fox>(), [&](const Creature* _c)
+				{
+					return _c != this && size / _c->GetSize() < 1.2f;
+				});
+				if (threat.mHandle.IsValid())
 				{
-					CS380::GridPos nPrey{ static_cast<int>(x) + xDirection[i] * rad, static_cast<int>(y) + yDirection[i] * rad };
-					int index = CS380::EcoSystem::GetInst().GetGridVal(static_cast<unsigned>(nPrey.x), static_cast<unsigned>(nPrey.y));
-					if (index != -1)
+					const int dx = pos.x - threat.mnX;
+					const int dy = pos.y - threat.mnY;
+					const int reach = std::max(std::abs(dx), std::abs(dy));
+					if (reach > 0)
 					{
-						Creature* target = CS380::EcoSystem::GetInst().GetCreature(index);
-						if (target && dynamic_cast<Rabbit*>(target))
+						const int sense = static_cast<int>(GetSense());
+						const GridPos away{
+							std::clamp(pos.x + dx * sense / reach, 0, eco.GetWidth() - 1),
+							std::clamp(pos.y + dy * sense / reach, 0, eco.GetHeight() - 1) };
+						// every other cell of the map can be reached, so the request will find its path
+						if (!(away == pos))
 						{
-							if (GetSize() / target->GetSize() >= 1.2f)
-							{
-								auto path = EcoSystem::GetInst().GetShortestPath({ static_cast<int>(x), static_cast<int>(y) }, nPrey);
-								if (!path.empty())
-								{
-									SetMovement(path);
-								}
-								preyFound = true;
-								break;
-							}
-						}
-						if (target != this && dynamic_cast<Fox*>(target))
-						{
-							if (GetSize() / target->GetSize() < 1.2f) //run away
-							{
-								
-							}
-
+							RequestMovement(away);
+							predFound = true;
 						}
 					}
 				}
 			}
 		}
 		
-		if (!preyFound)
+		if (!preyFound && !predFound)
 		{
 			if (!isHungry)
 			{
@@ -108,8 +129,8 @@ void CS380::Fox::UpdateAwakeBehaviour(float)
 				//		continue;
 				//	}
 				//	newPos = GridPos{ static_cast<int>(x) + xDirection[randX], static_cast<int>(y) + yDirection[randY] };
-				//	if (static_cast<unsigned>(newPos.x) >= static_cast<unsigned>(EcoSystem::GetInst().GetWidth()) ||
-				//		static_cast<unsigned>(newPos.y) >= static_cast<unsigned>(EcoSystem::GetInst().GetHeight()))
+				//	if (static_cast<unsigned>(newPos.x) >= static_cast<unsigned>(GetWorld().GetWidth()) ||
+				//		static_cast<unsigned>(newPos.y) >= static_cast<unsigned>(GetWorld().GetHeight()))
 				//	{
 				//		continue;
 				//	}
@@ -117,18 +138,16 @@ void CS380::Fox::UpdateAwakeBehaviour(float)
 				//	break;
 				//}
 
-				//auto path = EcoSystem::GetInst().GetShortestPath({ static_cast<int>(x), static_cast<int>(y) }, newPos);
+				//auto path = GetWorld().GetShortestPath({ static_cast<int>(x), static_cast<int>(y) }, newPos);
 				//if (!path.empty())
 				//	SetMovement(path);
 			}
 			else
 			{
-				auto pos = EcoSystem::GetInst().GetBestGrassPos({ static_cast<int>(x), static_cast<int>(y) }, GetSense(), 0.3f);
+				auto pos = GetWorld().GetBestGrassPos({ static_cast<int>(x), static_cast<int>(y) }, GetSense(), 0.3f);
 				if (pos.x != -1 && GetEnergy().first < (GetEnergy().second * GetEvoData().mfReplicationThresh))
 				{
-					auto path = EcoSystem::GetInst().GetShortestPath({ static_cast<int>(x), static_cast<int>(y) }, pos);
-					if (!path.empty())
-						SetMovement(path);
+					RequestMovement(pos);
 				}
 			}
 		}
@@ -151,7 +170,7 @@ void CS380::Fox::UpdateAwakeBehaviour(float)
 		}
 		else
 		{
-			if (EcoSystem::GetInst().GetGrassValA(GetGridPosition().x, GetGridPosition().y) > 0.2f && isHungry)
+			if (GetWorld().GetGrassValA(GetGridPosition().x, GetGridPosition().y) > 0.2f && isHungry)
 			{
 				Eat();
 			}
@@ -166,18 +185,41 @@ void CS380::Fox::UpdateAwakeBehaviour(float)
 			{
 				preyFound = false;
 			}
+			predFound = false;
 		}
 		
 	}
+
+	// walking somewhere and not hungry, every branch above is a no op until it arrives or hunger sets in
+	if (searching && !isHungry && HasPendingMovement())
+		Rest(0.1f * GetEnergy().second);
 }
 
 void CS380::Fox::UpdateAsleepBehaviour(float)
 {
 	/*std::pair<float, float> e = GetEnergy();
 	if (e.first / e.second > 0.9f)
-		mBitFlags &= ~FLAG_ASLEEP;
+		ClearFlag(FLAG_ASLEEP);
 
 	unsigned x, y;
 	GetGridPosition(x, y);
-	EcoSystem::GetInst().HighlightGrid(static_cast<unsigned short>(x), static_cast<unsigned short>(y), ImGui::GetColorU32(ImVec4{ 0.f,0.f,0.f,1.f }));*/
-}
\ No newline at end of file
+	GetWorld().HighlightGrid(x, y, ImGui::GetColorU32(ImVec4{ 0.f,0.f,0.f,1.f }));*/
+}
+
+void CS380::Fox::SaveState(CheckpointWriter& _w) const
+{
+	Creature::SaveState(_w);
+	_w.Pod(searching);
+	_w.Pod(isHungry);
+	_w.Pod(preyFound);
+	_w.Pod(predFound);
+}
+
+void CS380::Fox::LoadState(CheckpointReader& _r)
+{
+	Creature::LoadState(_r);
+	_r.Pod(searching);
+	_r.Pod(isHungry);
+	_r.Pod(preyFound);
+	_r.Pod(predFound);
+}
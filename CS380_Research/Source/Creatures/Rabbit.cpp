@@ -1,10 +1,10 @@
 #include "Creatures/Rabbit.h"
 #include "EcoSystem/EcoSystem.h"
-#include "imgui.h"
+#include "EcoSystem/Checkpoint.h"
 
 CS380::Rabbit::Rabbit(const Traits& _t, unsigned _id) noexcept
-	: Creature{ "Rabbit", FLAG_INVALID, _t, _id },
-	searching{ false }
+	: Creature{ FLAG_INVALID, _t, _id },
+	searching{ false }, predFound{ false }
 {
 	// color
 	float totalT = _t.mfSense + _t.mfSize + _t.mfSpeed;
@@ -26,7 +26,7 @@ CS380::Rabbit::~Rabbit(void) noexcept
 void CS380::Rabbit::UpdateAwakeBehaviour(float)
 {
 	//if (GetFlags() & FLAG_TIRED)
-	//	mBitFlags |= FLAG_ASLEEP;
+	//	SetFlag(FLAG_ASLEEP);
 	unsigned x = 0;
 	unsigned y = 0;
 	GetGridPosition(x, y);
@@ -36,12 +36,10 @@ void CS380::Rabbit::UpdateAwakeBehaviour(float)
 	if (!searching)
 	{
 		searching = true;
-		auto pos = EcoSystem::GetInst().GetBestGrassPos({ static_cast<int>(x), static_cast<int>(y) }, GetSense(), 0.3f);
+		auto pos = GetWorld().GetBestGrassPos({ static_cast<int>(x), static_cast<int>(y) }, GetSense(), 0.3f);
 		if (pos.x != -1 && GetEnergy().first < (GetEnergy().second * GetEvoData().mfReplicationThresh))
 		{
-			auto path = EcoSystem::GetInst().GetShortestPath({ static_cast<int>(x), static_cast<int>(y) }, pos);
-			if (!path.empty())
-				SetMovement(path);
+			RequestMovement(pos);
 		}
 		else
 		{
@@ -54,24 +52,22 @@ void CS380::Rabbit::UpdateAwakeBehaviour(float)
 			{
 				int prevX = randX;
 				int prevY = randY;
-				randX = rand() % 8;
-				randY = rand() % 8;
+				randX = static_cast<int>(mRng.Below(8));
+				randY = static_cast<int>(mRng.Below(8));
 				if (prevX == randX || prevY == randY)
 				{
 					continue;
 				}
 				newPos = GridPos{ static_cast<int>(x) + xDirection[randX], static_cast<int>(y) + yDirection[randY] };
-				if (static_cast<unsigned>(newPos.x) >= static_cast<unsigned>(EcoSystem::GetInst().GetWidth()) ||
-					static_cast<unsigned>(newPos.y) >= static_cast<unsigned>(EcoSystem::GetInst().GetHeight()))
+				if (static_cast<unsigned>(newPos.x) >= static_cast<unsigned>(GetWorld().GetWidth()) ||
+					static_cast<unsigned>(newPos.y) >= static_cast<unsigned>(GetWorld().GetHeight()))
 				{
 					continue;
 				}
 				valid = true;
 			}
 
-			auto path = EcoSystem::GetInst().GetShortestPath({ static_cast<int>(x), static_cast<int>(y) }, newPos);
-			if (!path.empty())
-				SetMovement(path);
+			RequestMovement(newPos);
 		}
 	}
 	else
@@ -81,7 +77,7 @@ void CS380::Rabbit::UpdateAwakeBehaviour(float)
 			searching = false;
 		}
 	
-		if (EcoSystem::GetInst().GetGrassValA(GetGridPosition().x, GetGridPosition().y) > 0.1f)
+		if (GetWorld().GetGrassValA(GetGridPosition().x, GetGridPosition().y) > 0.1f)
 		{
 			Eat();
 		}
@@ -94,10 +90,16 @@ void CS380::Rabbit::UpdateAsleepBehaviour(float)
 {
 }
 
+void CS380::Rabbit::SaveState(CheckpointWriter& _w) const
+{
+	Creature::SaveState(_w);
+	_w.Pod(searching);
+	_w.Pod(predFound);
+}
 
-
-
-
-
-
-
+void CS380::Rabbit::LoadState(CheckpointReader& _r)
+{
+	Creature::LoadState(_r);
+	_r.Pod(searching);
+	_r.Pod(predFound);
+}
@@ -0,0 +1,15 @@
+
+#include "Data/EcoData.h"
+#include "EcoSystem/EcoSystem.h"
+#include "EcoSystem/Tools/SpawnTool.h"
+#include "EcoSystem/Tools/ViewerTool.h"
+#include "EcoSystem/Tools/LogTool.h"
+#include "EcoSystem/Tools/ProfilerTool.h"
+
+void CS380::Data::MakeTools(EcoSystem& _eco)
+{
+	_eco.AddTools(new SpawnTool{ _eco });
+	_eco.AddTools(new ViewTool{ _eco });
+	_eco.AddTools(new LogTool{ _eco });
+	_eco.AddTools(new ProfilerTool{ _eco });
+}
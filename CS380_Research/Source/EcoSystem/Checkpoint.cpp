@@ -0,0 +1,43 @@
+#include "EcoSystem/Checkpoint.h"
+
+#include <cstdio>
+
+bool CS380::ReadCheckpointFile(const std::string& _path, std::vector<unsigned char>& _out)
+{
+	std::FILE* f = std::fopen(_path.c_str(), "rb");
+	if (!f)
+		return false;
+
+	std::fseek(f, 0, SEEK_END);
+	const long size = std::ftell(f);
+	std::fseek(f, 0, SEEK_SET);
+	if (size < 0)
+	{
+		std::fclose(f);
+		return false;
+	}
+
+	_out.resize(static_cast<std::size_t>(size));
+	const bool ok = std::fread(_out.data(), 1, _out.size(), f) == _out.size();
+	std::fclose(f);
+	return ok;
+}
+
+bool CS380::WriteCheckpointFile(const std::string& _path, const std::vector<unsigned char>& _data) noexcept
+{
+	// written next to the target and moved over it, a crash mid write never leaves half a checkpoint behind
+	const std::string tmp = _path + ".tmp";
+	std::FILE* f = std::fopen(tmp.c_str(), "wb");
+	if (!f)
+		return false;
+
+	bool ok = std::fwrite(_data.data(), 1, _data.size(), f) == _data.size();
+	ok = std::fclose(f) == 0 && ok;
+	if (!ok)
+	{
+		std::remove(tmp.c_str());
+		return false;
+	}
+	std::remove(_path.c_str());
+	return std::rename(tmp.c_str(), _path.c_str()) == 0;
+}
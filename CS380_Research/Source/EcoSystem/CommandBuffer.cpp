@@ -0,0 +1,69 @@
+#include "EcoSystem/CommandBuffer.h"
+#include "EcoSystem/Terrain.h"
+
+namespace
+{
+	thread_local CS380::CommandBuffer* gActive = nullptr;
+}
+
+CS380::CommandBuffer::CommandBuffer(void) noexcept
+	: mCommands{}, mPathRequests{}, mReturns{}
+{
+}
+
+void CS380::CommandBuffer::ReturnEnergy(const GridPos& _p, float _v)
+{
+	mReturns.push_back(EnergyReturn{ static_cast<std::uint64_t>(_p.y) << 32 | static_cast<std::uint32_t>(_p.x), _v });
+}
+
+void CS380::CommandBuffer::Eat(const CreatureHandle& _actor, const GridPos& _p)
+{
+	mCommands.push_back(WorldCommand{ WorldCommand::CMD_EAT, _actor, _p.x, _p.y, 0, 0, 0.f });
+}
+
+void CS380::CommandBuffer::NotePath(const GridPos& _src, const GridPos& _dest)
+{
+	mCommands.push_back(WorldCommand{ WorldCommand::CMD_PATH, CreatureHandle{}, _src.x, _src.y, _dest.x, _dest.y, 0.f });
+}
+
+void CS380::CommandBuffer::Move(const CreatureHandle& _actor, const GridPos& _from, const GridPos& _to)
+{
+	mCommands.push_back(WorldCommand{ WorldCommand::CMD_MOVE, _actor, _from.x, _from.y, _to.x, _to.y, 0.f });
+}
+
+void CS380::CommandBuffer::RequestPath(const PathRequest& _request)
+{
+	mPathRequests.push_back(_request);
+}
+
+void CS380::CommandBuffer::Clear(void) noexcept
+{
+	mCommands.clear();
+	mPathRequests.clear();
+	mReturns.clear();
+}
+
+const std::vector<CS380::WorldCommand>& CS380::CommandBuffer::GetCommands(void) const noexcept
+{
+	return mCommands;
+}
+
+const std::vector<CS380::PathRequest>& CS380::CommandBuffer::GetPathRequests(void) const noexcept
+{
+	return mPathRequests;
+}
+
+const std::vector<CS380::EnergyReturn>& CS380::CommandBuffer::GetReturns(void) const noexcept
+{
+	return mReturns;
+}
+
+CS380::CommandBuffer* CS380::CommandBuffer::GetActive(void) noexcept
+{
+	return gActive;
+}
+
+void CS380::CommandBuffer::SetActive(CommandBuffer* _buffer) noexcept
+{
+	gActive = _buffer;
+}
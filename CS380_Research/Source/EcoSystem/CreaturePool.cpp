@@ -0,0 +1,335 @@
+#include "EcoSystem/CreaturePool.h"
+#include "Creatures/Creature.h"
+#include "EcoSystem/Checkpoint.h"
+
+#include <algorithm>
+#include <cfloat>
+
+namespace
+{
+	thread_local CS380::CreatureBinding gBinding{ nullptr, nullptr, CS380::CreatureHandle{}, 0 };
+}
+
+CS380::CreaturePoolBase::CreaturePoolBase(EcoSystem& _world, unsigned _species, std::size_t _size, std::size_t _align) noexcept
+	: mSlabs{}, mSlots{}, mFree{}, mDense{}, mDenseSlots{}, mHot{}, mStats{}, mpWorld{ &_world },
+	mnStride{ (_size + _align - 1) / _align * _align }, mnAlign{ _align }, mnSpecies{ _species }
+{
+}
+
+CS380::CreaturePoolBase::~CreaturePoolBase(void) noexcept
+{
+	Clear();
+	for (auto& s : mSlabs)
+		::operator delete(s, std::align_val_t{ mnAlign });
+}
+
+CS380::Creature* CS380::CreaturePoolBase::Get(const CreatureHandle& _h) const noexcept
+{
+	if (!_h.IsValid() || _h.GetSpecies() != mnSpecies || _h.GetSlot() >= mSlots.size())
+		return nullptr;
+	const Slot& s = mSlots[_h.GetSlot()];
+	return s.mnGen == _h.mnGen ? s.mpCreature : nullptr;
+}
+
+void CS380::CreaturePoolBase::Destroy(const CreatureHandle& _h) noexcept
+{
+	Creature* c = Get(_h);
+	if (!c)
+		return;
+
+	const unsigned slot = _h.GetSlot();
+	Slot& s = mSlots[slot];
+	c->~Creature();
+
+	const unsigned row = s.mnDense;
+	const float traits[TRAIT_COUNT] = { mHot.mSize[row], mHot.mSpeed[row], mHot.mSense[row] };
+	for (unsigned i = 0; i < TRAIT_COUNT; ++i)
+		if (!mStats.mTraits[i].Remove(traits[i]))
+			mStats.mbExtremaStale = true;
+	// an empty species starts from exact zeros again instead of the rounding left over
+	if (--mStats.mnCount == 0)
+		for (auto& t : mStats.mTraits)
+			t = RunningStat{};
+
+	// swap and pop the dense list, the moved creature keeps its slot so its handle is untouched
+	const unsigned dense = s.mnDense;
+	mDense[dense] = mDense.back();
+	mDenseSlots[dense] = mDenseSlots.back();
+	mSlots[mDenseSlots[dense]].mnDense = dense;
+	mDense.pop_back();
+	mDenseSlots.pop_back();
+	mHot.ForEachColumn([dense](auto& _col)
+	{
+		_col[dense] = _col.back();
+		_col.pop_back();
+	});
+	if (dense < mDense.size())
+		mDense[dense]->mnRow = dense;
+
+	s.mpCreature = nullptr;
+	if (++s.mnGen == 0)
+		s.mnGen = 1;
+	mFree.push_back(slot);
+}
+
+void CS380::CreaturePoolBase::Clear(void) noexcept
+{
+	while (!mDense.empty())
+		Destroy(GetLiveHandle(static_cast<unsigned>(mDense.size()) - 1));
+}
+
+unsigned CS380::CreaturePoolBase::GetLiveCount(void) const noexcept
+{
+	return static_cast<unsigned>(mDense.size());
+}
+
+CS380::Creature* CS380::CreaturePoolBase::GetLive(unsigned _i) const noexcept
+{
+	return mDense[_i];
+}
+
+CS380::CreatureHandle CS380::CreaturePoolBase::GetLiveHandle(unsigned _i) const noexcept
+{
+	const unsigned slot = mDenseSlots[_i];
+	return CreatureHandle{ mnSpecies, slot, mSlots[slot].mnGen };
+}
+
+unsigned CS380::CreaturePoolBase::GetSpecies(void) const noexcept
+{
+	return mnSpecies;
+}
+
+CS380::EcoSystem& CS380::CreaturePoolBase::GetWorld(void) const noexcept
+{
+	return *mpWorld;
+}
+
+CS380::CreatureHotData& CS380::CreaturePoolBase::GetHot(void) noexcept
+{
+	return mHot;
+}
+
+const CS380::CreatureHotData& CS380::CreaturePoolBase::GetHot(void) const noexcept
+{
+	return mHot;
+}
+
+const CS380::SpeciesStats& CS380::CreaturePoolBase::GetStats(void) noexcept
+{
+	if (mStats.mbExtremaStale)
+	{
+		for (auto& t : mStats.mTraits)
+		{
+			t.mfMin = FLT_MAX;
+			t.mfMax = -FLT_MAX;
+		}
+		const std::vector<float>* cols[TRAIT_COUNT] = { &mHot.mSize, &mHot.mSpeed, &mHot.mSense };
+		for (unsigned i = 0; i < TRAIT_COUNT; ++i)
+		{
+			RunningStat& t = mStats.mTraits[i];
+			for (float v : *cols[i])
+			{
+				t.mfMin = std::min(t.mfMin, v);
+				t.mfMax = std::max(t.mfMax, v);
+			}
+		}
+		mStats.mbExtremaStale = false;
+	}
+	return mStats;
+}
+
+CS380::CreatureBinding CS380::CreaturePoolBase::TakeBinding(void) noexcept
+{
+	CreatureBinding b = gBinding;
+	gBinding = CreatureBinding{ nullptr, nullptr, CreatureHandle{}, 0 };
+	return b;
+}
+
+void* CS380::CreaturePoolBase::Acquire(unsigned& _outSlot)
+{
+	if (mFree.empty())
+	{
+		// new slab, free list filled back to front so low slots go out first
+		const unsigned base = static_cast<unsigned>(mSlots.size());
+		mSlabs.push_back(::operator new(mnStride * CREATURE_POOL_SLAB, std::align_val_t{ mnAlign }));
+		mSlots.resize(base + CREATURE_POOL_SLAB, Slot{ nullptr, 1, 0 });
+		for (unsigned i = CREATURE_POOL_SLAB; i > 0; --i)
+			mFree.push_back(base + i - 1);
+	}
+
+	_outSlot = mFree.back();
+	mFree.pop_back();
+	return BindSlot(_outSlot);
+}
+
+void CS380::CreaturePoolBase::Reserve(unsigned _count)
+{
+	if (_count > mFree.size())
+	{
+		// the new slabs' slots queue up behind the ones already free, each slab back to front like Acquire's
+		const unsigned slabs = static_cast<unsigned>((_count - mFree.size() + CREATURE_POOL_SLAB - 1) / CREATURE_POOL_SLAB);
+		const unsigned base = static_cast<unsigned>(mSlots.size());
+		std::vector<unsigned> free;
+		free.reserve(slabs * CREATURE_POOL_SLAB + mFree.size());
+		for (unsigned i = slabs * CREATURE_POOL_SLAB; i > 0; --i)
+			free.push_back(base + i - 1);
+		free.insert(free.end(), mFree.begin(), mFree.end());
+		for (unsigned i = 0; i < slabs; ++i)
+			mSlabs.push_back(::operator new(mnStride * CREATURE_POOL_SLAB, std::align_val_t{ mnAlign }));
+		mSlots.resize(base + slabs * CREATURE_POOL_SLAB, Slot{ nullptr, 1, 0 });
+		mFree = std::move(free);
+	}
+
+	const std::size_t rows = mDense.size() + _count;
+	mDense.reserve(rows);
+	mDenseSlots.reserve(rows);
+	mHot.ForEachColumn([rows](auto& _col) { _col.reserve(rows); });
+}
+
+void* CS380::CreaturePoolBase::BindSlot(unsigned _slot)
+{
+	// the row goes live now so the constructor can fill it, the dense entry is patched in Commit
+	Slot& s = mSlots[_slot];
+	s.mnDense = static_cast<unsigned>(mDense.size());
+	mDense.push_back(nullptr);
+	mDenseSlots.push_back(_slot);
+	mHot.ForEachColumn([](auto& _col) { _col.emplace_back(); });
+	gBinding = CreatureBinding{ mpWorld, &mHot, CreatureHandle{ mnSpecies, _slot, s.mnGen }, s.mnDense };
+
+	return static_cast<unsigned char*>(mSlabs[_slot / CREATURE_POOL_SLAB]) + (_slot % CREATURE_POOL_SLAB) * mnStride;
+}
+
+CS380::CreatureHandle CS380::CreaturePoolBase::Commit(unsigned _slot, Creature* _c) noexcept
+{
+	Slot& s = mSlots[_slot];
+	s.mpCreature = _c;
+	mDense[s.mnDense] = _c;
+
+	// the constructor has filled in the traits by now
+	AddStats(s.mnDense);
+	++mStats.mnSpawned;
+	return CreatureHandle{ mnSpecies, _slot, s.mnGen };
+}
+
+void CS380::CreaturePoolBase::AddStats(unsigned _row) noexcept
+{
+	mStats.mTraits[TRAIT_SIZE].Add(mHot.mSize[_row]);
+	mStats.mTraits[TRAIT_SPEED].Add(mHot.mSpeed[_row]);
+	mStats.mTraits[TRAIT_SENSE].Add(mHot.mSense[_row]);
+	mStats.mnPeak = std::max(mStats.mnPeak, ++mStats.mnCount);
+}
+
+void CS380::CreaturePoolBase::Save(CheckpointWriter& _w) const
+{
+	std::vector<unsigned> gens(mSlots.size());
+	for (std::size_t i = 0; i < mSlots.size(); ++i)
+		gens[i] = mSlots[i].mnGen;
+	_w.Vector(gens);
+	_w.Vector(mDenseSlots);
+	_w.Vector(mFree);
+	_w.Pod(mStats.mnPeak);
+	_w.Pod(mStats.mnSpawned);
+
+	mHot.ForEachColumn([&_w](const auto& _col) { _w.Vector(_col); });
+	for (const Creature* c : mDense)
+		c->SaveState(_w);
+}
+
+void CS380::CreaturePoolBase::SaveRecord(unsigned _row, CheckpointWriter& _w) const
+{
+	mHot.ForEachColumn([&_w, _row](const auto& _col) { _w.Pod(_col[_row]); });
+	mDense[_row]->SaveState(_w);
+}
+
+CS380::CreatureHandle CS380::CreaturePoolBase::LoadRecord(CheckpointReader& _r)
+{
+	unsigned slot = 0;
+	Creature* c = ConstructBlank(Acquire(slot));
+	const unsigned row = mSlots[slot].mnDense;
+	mHot.ForEachColumn([&_r, row](auto& _col) { _r.Pod(_col[row]); });
+	c->LoadState(_r);
+
+	const CreatureHandle h = Commit(slot, c);
+	--mStats.mnSpawned;
+	if (_r.Failed())
+	{
+		Destroy(h);
+		return CreatureHandle{};
+	}
+	return h;
+}
+
+bool CS380::CreaturePoolBase::Load(CheckpointReader& _r)
+{
+	Clear();
+
+	std::vector<unsigned> gens;
+	std::vector<unsigned> dense;
+	std::vector<unsigned> free;
+	_r.Vector(gens);
+	_r.Vector(dense);
+	_r.Vector(free);
+	const unsigned peak = _r.Pod<unsigned>();
+	const unsigned long long spawned = _r.Pod<unsigned long long>();
+	if (_r.Failed() || gens.size() % CREATURE_POOL_SLAB || dense.size() + free.size() != gens.size())
+		return false;
+
+	// every slot is either live or free, exactly once
+	std::vector<unsigned char> seen(gens.size(), 0);
+	for (const std::vector<unsigned>* list : { &dense, &free })
+		for (unsigned slot : *list)
+			if (slot >= gens.size() || seen[slot]++ || !gens[slot])
+				return false;
+
+	// slabs line up with slots, extra ones are empty after the Clear
+	const std::size_t slabs = gens.size() / CREATURE_POOL_SLAB;
+	while (mSlabs.size() > slabs)
+	{
+		::operator delete(mSlabs.back(), std::align_val_t{ mnAlign });
+		mSlabs.pop_back();
+	}
+	while (mSlabs.size() < slabs)
+		mSlabs.push_back(::operator new(mnStride * CREATURE_POOL_SLAB, std::align_val_t{ mnAlign }));
+
+	mSlots.assign(gens.size(), Slot{ nullptr, 1, 0 });
+	for (std::size_t i = 0; i < gens.size(); ++i)
+		mSlots[i].mnGen = gens[i];
+	mFree = std::move(free);
+	mDense.clear();
+	mDenseSlots.clear();
+	mHot.ForEachColumn([](auto& _col) { _col.clear(); });
+
+	// creatures go back into their own slots in dense order, so every row ends up where it was
+	for (unsigned slot : dense)
+	{
+		Creature* c = ConstructBlank(BindSlot(slot));
+		Slot& s = mSlots[slot];
+		s.mpCreature = c;
+		mDense[s.mnDense] = c;
+	}
+
+	const std::size_t live = dense.size();
+	mHot.ForEachColumn([&_r, live](auto& _col)
+	{
+		_r.Vector(_col);
+		if (_col.size() != live)
+			_r.Fail();
+	});
+	if (_r.Failed())
+	{
+		// the columns no longer match the creatures, drop the lot
+		mHot.ForEachColumn([live](auto& _col) { _col.resize(live); });
+		Clear();
+		return false;
+	}
+
+	for (Creature* c : mDense)
+		c->LoadState(_r);
+
+	mStats = SpeciesStats{};
+	for (unsigned i = 0; i < live; ++i)
+		AddStats(i);
+	mStats.mnPeak = std::max(mStats.mnPeak, peak);
+	mStats.mnSpawned = spawned;
+	return !_r.Failed();
+}
@@ -0,0 +1,336 @@
+#include "EcoSystem/Domain.h"
+#include "Creatures/Creature.h"
+#include "Data/EcoData.h"
+
+#include <algorithm>
+
+#if defined(ECO_WITH_MPI)
+#include <mpi.h>
+#endif
+
+namespace
+{
+	// every exchange message, MPI keeps two from the same process in the order they were sent
+	constexpr int DomainTag = 380;
+
+	struct DomainEdit
+	{
+		unsigned meType;
+		int mnX;
+		int mnY;
+		float mfValue;
+	};
+}
+
+CS380::Domain::Domain(unsigned _w, unsigned _h) noexcept
+	: mpEco{ nullptr }, mnWidth{ _w }, mnHeight{ _h }, mnRank{ GetProcessRank() }, mnCount{ GetProcessCount() },
+	mnGridX{ 1 }, mnGridY{ 1 }, mOwned{}, mWindow{}, mPeers{}, mOut{}, mMigrants{}, mnMigrants{}
+{
+	// the grid with the least cut length, as square rectangles as the count allows
+	double best = -1.0;
+	for (unsigned px = 1; px <= mnCount; ++px)
+	{
+		if (mnCount % px)
+			continue;
+		const unsigned py = mnCount / px;
+		if (px > mnWidth || py > mnHeight)
+			continue;
+		const double cut = static_cast<double>(mnWidth) / px + static_cast<double>(mnHeight) / py;
+		if (best < 0.0 || cut < best)
+		{
+			best = cut;
+			mnGridX = px;
+			mnGridY = py;
+		}
+	}
+
+	mOwned = GetOwned(mnRank);
+	mWindow = GetWindow(mnRank);
+	for (unsigned r = 0; r < mnCount; ++r)
+	{
+		if (r == mnRank)
+			continue;
+		const Rect o = GetOwned(r);
+		if (o.mnX0 < mWindow.mnX1 && mWindow.mnX0 < o.mnX1 && o.mnY0 < mWindow.mnY1 && mWindow.mnY0 < o.mnY1)
+			mPeers.push_back(r);
+	}
+	mOut.resize(mPeers.size());
+	mMigrants.resize(mPeers.size());
+	mnMigrants.assign(mPeers.size(), 0);
+}
+
+bool CS380::Domain::InitProcesses(int* _argc, char*** _argv) noexcept
+{
+#if defined(ECO_WITH_MPI)
+	int started = 0;
+	MPI_Initialized(&started);
+	return started || MPI_Init(_argc, _argv) == MPI_SUCCESS;
+#else
+	(void)_argc;
+	(void)_argv;
+	return true;
+#endif
+}
+
+void CS380::Domain::FinishProcesses(void) noexcept
+{
+#if defined(ECO_WITH_MPI)
+	int done = 0;
+	MPI_Finalized(&done);
+	if (!done)
+		MPI_Finalize();
+#endif
+}
+
+unsigned CS380::Domain::GetProcessRank(void) noexcept
+{
+#if defined(ECO_WITH_MPI)
+	int started = 0;
+	MPI_Initialized(&started);
+	int rank = 0;
+	if (started)
+		MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	return static_cast<unsigned>(rank);
+#else
+	return 0;
+#endif
+}
+
+unsigned CS380::Domain::GetProcessCount(void) noexcept
+{
+#if defined(ECO_WITH_MPI)
+	int started = 0;
+	MPI_Initialized(&started);
+	int count = 1;
+	if (started)
+		MPI_Comm_size(MPI_COMM_WORLD, &count);
+	return static_cast<unsigned>(count);
+#else
+	return 1;
+#endif
+}
+
+CS380::Domain::Rect CS380::Domain::GetOwned(unsigned _rank) const noexcept
+{
+	const unsigned long long cx = _rank % mnGridX;
+	const unsigned long long cy = _rank / mnGridX;
+	return Rect{
+		static_cast<unsigned>(mnWidth * cx / mnGridX), static_cast<unsigned>(mnHeight * cy / mnGridY),
+		static_cast<unsigned>(mnWidth * (cx + 1) / mnGridX), static_cast<unsigned>(mnHeight * (cy + 1) / mnGridY) };
+}
+
+CS380::Domain::Rect CS380::Domain::GetWindow(unsigned _rank) const noexcept
+{
+	const Rect o = GetOwned(_rank);
+	return Rect{
+		o.mnX0 > DOMAIN_HALO ? o.mnX0 - DOMAIN_HALO : 0, o.mnY0 > DOMAIN_HALO ? o.mnY0 - DOMAIN_HALO : 0,
+		std::min(o.mnX1 + DOMAIN_HALO, mnWidth), std::min(o.mnY1 + DOMAIN_HALO, mnHeight) };
+}
+
+unsigned CS380::Domain::OwnerOf(unsigned _x, unsigned _y) const noexcept
+{
+	// the even split is right to within a cell, the rectangles' own edges settle it
+	unsigned cx = std::min(static_cast<unsigned>(static_cast<unsigned long long>(_x) * mnGridX / mnWidth), mnGridX - 1);
+	while (cx > 0 && GetOwned(cx).mnX0 > _x)
+		--cx;
+	while (cx + 1 < mnGridX && GetOwned(cx + 1).mnX0 <= _x)
+		++cx;
+	unsigned cy = std::min(static_cast<unsigned>(static_cast<unsigned long long>(_y) * mnGridY / mnHeight), mnGridY - 1);
+	while (cy > 0 && GetOwned(cy * mnGridX).mnY0 > _y)
+		--cy;
+	while (cy + 1 < mnGridY && GetOwned((cy + 1) * mnGridX).mnY0 <= _y)
+		++cy;
+	return cy * mnGridX + cx;
+}
+
+unsigned CS380::Domain::PeerIndex(unsigned _rank) const noexcept
+{
+	const auto it = std::lower_bound(mPeers.begin(), mPeers.end(), _rank);
+	return it != mPeers.end() && *it == _rank ? static_cast<unsigned>(it - mPeers.begin()) : static_cast<unsigned>(mPeers.size());
+}
+
+void CS380::Domain::Attach(EcoSystem& _eco) noexcept
+{
+	mpEco = &_eco;
+	_eco.SetWorldSize(mWindow.mnX1 - mWindow.mnX0, mWindow.mnY1 - mWindow.mnY0);
+	_eco.SetWorldFrame(mWindow.mnX0, mWindow.mnY0, mnWidth, mnHeight);
+	_eco.SetDomain(this, SpawnRegion{ mOwned.mnX0 - mWindow.mnX0, mOwned.mnY0 - mWindow.mnY0,
+		mOwned.mnX1 - mOwned.mnX0, mOwned.mnY1 - mOwned.mnY0 });
+
+	// process 0 keeps the seed, so one process replays a world of its own
+	Random& random = _eco.GetRandom();
+	if (mnRank)
+		random.SetMasterSeed(CounterHash(random.GetMasterSeed(), mnRank));
+}
+
+void CS380::Domain::Begin(void)
+{
+	// ids stay unique across the processes as creatures move between them
+	if (mnRank)
+		mpEco->GetRandom().SetEntityCounter(static_cast<std::uint64_t>(mnRank) << 40);
+	// every process drew its own halo, the owners' take its place
+	Exchange();
+}
+
+unsigned CS380::Domain::Share(unsigned _total) const noexcept
+{
+	auto before = [this](unsigned _rank)
+	{
+		unsigned long long cells = 0;
+		for (unsigned r = 0; r < _rank; ++r)
+		{
+			const Rect o = GetOwned(r);
+			cells += static_cast<unsigned long long>(o.mnX1 - o.mnX0) * (o.mnY1 - o.mnY0);
+		}
+		return cells;
+	};
+	const unsigned long long all = static_cast<unsigned long long>(mnWidth) * mnHeight;
+	if (!all)
+		return 0;
+	return static_cast<unsigned>(_total * before(mnRank + 1) / all - _total * before(mnRank) / all);
+}
+
+void CS380::Domain::Sum(double* _v, unsigned _n) const noexcept
+{
+#if defined(ECO_WITH_MPI)
+	if (mnCount > 1)
+		MPI_Allreduce(MPI_IN_PLACE, _v, static_cast<int>(_n), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+#else
+	(void)_v;
+	(void)_n;
+#endif
+}
+
+void CS380::Domain::Exchange(void)
+{
+	EcoSystem& eco = *mpEco;
+	std::vector<WorldCommand>& edits = eco.GetForeignEdits();
+	if (mPeers.empty())
+	{
+		edits.clear();
+		return;
+	}
+
+	for (unsigned i = 0; i < mPeers.size(); ++i)
+	{
+		mOut[i].GetBuffer().clear();
+		mMigrants[i].GetBuffer().clear();
+		mnMigrants[i] = 0;
+	}
+
+	// edits first, in the order they were made, then whoever stands on a cell it does not own
+	std::vector<std::vector<DomainEdit>> out(mPeers.size());
+	for (const WorldCommand& c : edits)
+	{
+		const unsigned gx = mWindow.mnX0 + static_cast<unsigned>(c.mnX);
+		const unsigned gy = mWindow.mnY0 + static_cast<unsigned>(c.mnY);
+		const unsigned p = PeerIndex(OwnerOf(gx, gy));
+		if (p < mPeers.size())
+			out[p].push_back(DomainEdit{ static_cast<unsigned>(c.meType), static_cast<int>(gx), static_cast<int>(gy), c.mfValue });
+	}
+	edits.clear();
+
+	for (unsigned s = 0; s < Data::SpeciesNames.size(); ++s)
+	{
+		CreaturePoolBase& pool = eco.GetPool(s);
+		for (unsigned i = 0; i < pool.GetLiveCount();)
+		{
+			const GridPos pos = pool.GetLive(i)->GetGridPosition();
+			if (eco.IsOwned(pos.x, pos.y))
+			{
+				++i;
+				continue;
+			}
+			// the last live creature is swapped into i, so i is looked at again
+			const unsigned p = PeerIndex(OwnerOf(mWindow.mnX0 + pos.x, mWindow.mnY0 + pos.y));
+			if (p >= mPeers.size())
+			{
+				++i;
+				continue;
+			}
+			++mnMigrants[p];
+			eco.Emigrate(pool.GetLiveHandle(i), mMigrants[p]);
+		}
+	}
+
+	// then the owned cells the peer's map holds, in row order
+	const Terrain& terrain = eco.GetTerrain();
+	for (unsigned i = 0; i < mPeers.size(); ++i)
+	{
+		CheckpointWriter& w = mOut[i];
+		w.Vector(out[i]);
+		w.Pod(mnMigrants[i]);
+		std::vector<unsigned char>& migrants = mMigrants[i].GetBuffer();
+		w.Bytes(migrants.data(), migrants.size());
+
+		const Rect win = GetWindow(mPeers[i]);
+		const unsigned x0 = std::max(win.mnX0, mOwned.mnX0), x1 = std::min(win.mnX1, mOwned.mnX1);
+		const unsigned y0 = std::max(win.mnY0, mOwned.mnY0), y1 = std::min(win.mnY1, mOwned.mnY1);
+		for (unsigned y = y0; y < y1; ++y)
+		{
+			for (unsigned x = x0; x < x1; ++x)
+			{
+				const unsigned lx = x - mWindow.mnX0;
+				const unsigned ly = y - mWindow.mnY0;
+				const float cell[3] = { terrain.GetGrass(lx, ly), terrain.GetFertilizer(lx, ly), terrain.GetFertilizerRatio(lx, ly) };
+				w.Bytes(cell, sizeof(cell));
+			}
+		}
+	}
+
+#if defined(ECO_WITH_MPI)
+	std::vector<MPI_Request> sends(mPeers.size());
+	for (unsigned i = 0; i < mPeers.size(); ++i)
+	{
+		const std::vector<unsigned char>& b = mOut[i].GetBuffer();
+		MPI_Isend(b.data(), static_cast<int>(b.size()), MPI_BYTE, static_cast<int>(mPeers[i]), DomainTag, MPI_COMM_WORLD, &sends[i]);
+	}
+
+	// peers in rank order, so what lands here does not depend on who was quickest
+	std::vector<unsigned char> in;
+	for (unsigned i = 0; i < mPeers.size(); ++i)
+	{
+		MPI_Status status;
+		MPI_Probe(static_cast<int>(mPeers[i]), DomainTag, MPI_COMM_WORLD, &status);
+		int n = 0;
+		MPI_Get_count(&status, MPI_BYTE, &n);
+		in.resize(static_cast<std::size_t>(n));
+		MPI_Recv(in.data(), n, MPI_BYTE, static_cast<int>(mPeers[i]), DomainTag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+		ApplyMessage(mPeers[i], in);
+	}
+	MPI_Waitall(static_cast<int>(sends.size()), sends.data(), MPI_STATUSES_IGNORE);
+#endif
+}
+
+void CS380::Domain::ApplyMessage(unsigned _from, const std::vector<unsigned char>& _msg)
+{
+	EcoSystem& eco = *mpEco;
+	CheckpointReader r{ _msg.data(), _msg.size() };
+
+	std::vector<DomainEdit> edits;
+	r.Vector(edits);
+	for (const DomainEdit& e : edits)
+		eco.ApplyForeignEdit(WorldCommand{ static_cast<WorldCommand::Type>(e.meType), CreatureHandle{},
+			e.mnX - static_cast<int>(mWindow.mnX0), e.mnY - static_cast<int>(mWindow.mnY0), 0, 0, e.mfValue });
+
+	const Rect from = GetWindow(_from);
+	const int dx = static_cast<int>(from.mnX0) - static_cast<int>(mWindow.mnX0);
+	const int dy = static_cast<int>(from.mnY0) - static_cast<int>(mWindow.mnY0);
+	const unsigned migrants = r.Pod<unsigned>();
+	for (unsigned i = 0; i < migrants && !r.Failed(); ++i)
+		eco.Immigrate(r, dx, dy);
+
+	const Rect o = GetOwned(_from);
+	const unsigned x0 = std::max(o.mnX0, mWindow.mnX0), x1 = std::min(o.mnX1, mWindow.mnX1);
+	const unsigned y0 = std::max(o.mnY0, mWindow.mnY0), y1 = std::min(o.mnY1, mWindow.mnY1);
+	for (unsigned y = y0; y < y1 && !r.Failed(); ++y)
+	{
+		for (unsigned x = x0; x < x1; ++x)
+		{
+			float cell[3];
+			if (!r.Bytes(cell, sizeof(cell)))
+				break;
+			eco.OverwriteCell(x - mWindow.mnX0, y - mWindow.mnY0, cell[0], cell[1], cell[2]);
+		}
+	}
+}
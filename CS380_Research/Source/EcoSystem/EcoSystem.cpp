@@ -1,36 +1,77 @@
 #include "EcoSystem/EcoSystem.h"
 #include "Data/EcoData.h"
+#include "EcoSystem/Domain.h"
 
-#include <GLFW/glfw3.h>
-#include <algorithm>
+#include "EcoSystem/Platform.h"
 
-#include "imgui.h"
-#include "imgui_internal.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 
-#define FIXED_DT 0.01666666666f
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
-namespace CS380
+namespace
 {
-	extern EvolutionData EvolutionChart[EVOLUTION_CHART_COUNT];
-	extern float CREATURE_MUTATION_EPSILON;
-}
+	inline unsigned PopCount(std::uint64_t _v) noexcept
+	{
+#if defined(_MSC_VER)
+		return static_cast<unsigned>(__popcnt64(_v));
+#else
+		return static_cast<unsigned>(__builtin_popcountll(_v));
+#endif
+	}
 
-template<typename T>
-T min(T l, T r)
-{
-	return l < r ? l : r;
-}
+	// index of the lowest set bit, _v is never 0
+	inline unsigned LowestBit(std::uint64_t _v) noexcept
+	{
+#if defined(_MSC_VER)
+		unsigned long i = 0;
+		_BitScanForward64(&i, _v);
+		return static_cast<unsigned>(i);
+#else
+		return static_cast<unsigned>(__builtin_ctzll(_v));
+#endif
+	}
 
-CS380::EcoSystem& CS380::EcoSystem::GetInst(void) noexcept
-{
-	static CS380::EcoSystem eco{ 64, 64, 32 };
-	return eco;
+	// the bits of occupancy word _w that fall in columns [_x0, _x1)
+	inline std::uint64_t WordMask(unsigned _w, unsigned _x0, unsigned _x1) noexcept
+	{
+		const unsigned lo = std::max(_x0, _w * 64) - _w * 64;
+		const unsigned hi = std::min(_x1, _w * 64 + 64) - _w * 64;
+		const std::uint64_t upper = hi == 64 ? ~std::uint64_t{ 0 } : (std::uint64_t{ 1 } << hi) - 1;
+		return upper & ~((std::uint64_t{ 1 } << lo) - 1);
+	}
+
+	void ClipRegion(const CS380::SpawnRegion& _r, unsigned _w, unsigned _h, unsigned& _x0, unsigned& _y0, unsigned& _x1, unsigned& _y1) noexcept
+	{
+		if (!_r.mnWidth || !_r.mnHeight)
+		{
+			_x0 = _y0 = 0;
+			_x1 = _w;
+			_y1 = _h;
+			return;
+		}
+		_x0 = std::min(_r.mnX, _w);
+		_y0 = std::min(_r.mnY, _h);
+		_x1 = _x0 + std::min(_r.mnWidth, _w - _x0);
+		_y1 = _y0 + std::min(_r.mnHeight, _h - _y0);
+	}
 }
 
+static_assert(static_cast<unsigned>(CS380::ZONE_LOGS) == static_cast<unsigned>(CS380::PHASE_LOGS), "tick phases lead the profile zones");
+static_assert(std::tuple_size_v<CS380::CreatureList> <= PROFILE_MAX_SPECIES, "the profiler counts paths for every species");
+
 CS380::EcoSystem::EcoSystem(unsigned _w, unsigned _h, unsigned _s) noexcept
-	: mnLogWindow{ 20 }, mnWidth{ _w }, mnHeight{ _h }, mnScale{ _s }, mnWindowX{ 0 }, mnWindowY{ 0 }, mfDelta{ 0.016f },
-	mfTimeStep{ 1.f }, mbEcoTool{ true }, mbRunEco{ false }, mfTitleBarSize{ 0.f }, mTerrain{ mnWidth, mnHeight },
-	mAllCreatures{}, mTools{}, mHighlightQueue{}, mLogs{}, mfScalar{}, mfLogFreq{ 1.f }, mfLogAccDt{ 0.f }, mnPeakPops{ 0 },
+	: mnPeakPops{ 0 }, mnLogWindow{ 20 }, mnWidth{ _w }, mnHeight{ _h }, mnScale{ _s }, mnWindowX{ 0 }, mnWindowY{ 0 }, mfDelta{ FIXED_DT },
+	mfTickAccumulator{ 0.f }, mnMaxTicksPerFrame{ DEFAULT_MAX_TICKS_PER_FRAME }, mnTickCount{ 0 }, mPhaseSeconds{},
+	mfTitleBarSize{ 0.f }, mfTimeStep{ 1.f }, mfLogFreq{ 1.f }, mfLogAccDt{ 0.f }, mfScalar{}, mfZoom{ 1.f }, mfPanX{ 0.f }, mfPanY{ 0.f }, mfMapOriginX{ 0.f }, mfMapOriginY{ 0.f },
+	mbEcoTool{ true }, mbRunEco{ false }, mbBatchedUpdate{ false }, mbParallelUpdate{ false }, mbUnthrottled{ false }, mbFreshView{ false },
+	mRandom{}, mEvolution{ DefaultEvolutionChart, DefaultEvolutionChart + EVOLUTION_CHART_COUNT }, mfMutationEpsilon{ DEFAULT_MUTATION_EPSILON }, mThreadPool{}, mProfiler{}, mPaths{}, mTerrain{ mnWidth, mnHeight }, mSpatial{}, mScent{}, mOccupied{}, mnOccupiedStride{ 0 }, mGridRenderer{},
+	mPools{}, mSlices{}, mCommands{}, mSensedAlive{}, mEnergyLedger{}, mPathQueue{}, mnPathBudget{ DEFAULT_PATH_BUDGET }, mPathResults{}, mPathNodes{}, mPathFound{}, mPathNotes{}, mTools{}, mpDomain{ nullptr }, mOwned{}, mForeignEdits{}, mHighlightQueue{}, mLogs{}, mTelemetry{}, mTelemetryRow{}, mCheckpointWrite{},
+	mSimThread{}, mbStopSim{ false }, mUiCommands{}, mSnapshots{}, mTileChanged{}, mnPublishCount{ 0 }, mUiSettings{},
 	mfInitialGrassA{ 0.1f },
 	mfInitialGrassVLo{ 0.025f },
 	mfInitialGrassVHi{ 1.0f },
@@ -44,18 +85,24 @@ CS380::EcoSystem::EcoSystem(unsigned _w, unsigned _h, unsigned _s) noexcept
 {
 	mLogs.resize(LogTypes::LAST);
 	for (auto& l : mLogs)
-		l.resize(mnLogWindow, 0.f);
-}
-
-void CS380::EcoSystem::Init(void) noexcept
-{
-	Data::MakeTools();
+		l.Reset(mnLogWindow, 0.f);
+	mTerrain.SetThreadPool(&mThreadPool);
+	mTerrain.SetRandom(&mRandom);
+	mTerrain.SetProfiler(&mProfiler);
+	mTerrain.SetPathArena(&mPaths);
+	mScent.SetThreadPool(&mThreadPool);
+	mProfiler.ReserveWorkers(mThreadPool.GetThreadCount());
+	mPaths.ReserveWorkers(mThreadPool.GetThreadCount());
+	mProfiler.SetSpeciesNames(Data::SpeciesNames.data(), static_cast<unsigned>(Data::SpeciesNames.size()));
+	Data::MakePools(*this, mPools);
+	ResetOccupancy();
 }
 
 CS380::EcoSystem::~EcoSystem(void) noexcept
 {
-	for (auto& c : mAllCreatures)
-		delete c;
+	StopSimThread();
+	mTelemetry.Stop();
+	FinishCheckpoint();
 	for (auto& t : mTools)
 		delete t;
 }
@@ -66,241 +113,605 @@ void CS380::EcoSystem::UpdateWindowSize(int _x, int _y) noexcept
 	mnWindowY = _y;
 }
 
-void CS380::EcoSystem::Update(float _dt) noexcept
+unsigned CS380::EcoSystem::Advance(float _frameDt) noexcept
 {
-	mfDelta = (_dt * mfTimeStep);
+	mfTickAccumulator += _frameDt * mfTimeStep;
 
-	if (mbRunEco)
+	unsigned ticks = 0;
+	while (mfTickAccumulator >= FIXED_DT && ticks < mnMaxTicksPerFrame)
 	{
-		// pre
-		mTerrain.Update(mfDelta);
-		UpdateCreatures(mfDelta);
-
+		Tick();
+		mfTickAccumulator -= FIXED_DT;
+		++ticks;
+	}
 
-		// post
-		CleanUpDead();
-		UpdateMap();
+	// over budget, drop the whole ticks still owed instead of spiralling further behind. a part tick left over
+	// after the budget paid what was owed carries on like any other frame's
+	if (mfTickAccumulator >= FIXED_DT)
+		mfTickAccumulator = std::fmod(mfTickAccumulator, FIXED_DT);
 
-		if (mbEcoTool)
-			EcoTool();
-		UpdateTools();
+	return ticks;
+}
 
-		mfLogAccDt += mfDelta;
-		if (mfLogAccDt > 1.f / mfLogFreq)
-			UpdateLogs();
+void CS380::EcoSystem::Tick(void) noexcept
+{
+	mfDelta = FIXED_DT;
+	++mnTickCount;
 
-		RenderMap();
-	}
-	else
+	const auto start = std::chrono::steady_clock::now();
+	auto last = start;
+	auto lap = [this, &last](TickPhase _phase)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		mPhaseSeconds[_phase] += std::chrono::duration<double>(now - last).count();
+		ECO_PROFILE_ZONE(&mProfiler, static_cast<ProfileZone>(_phase), last, now);
+		last = now;
+	};
+
+	// pre
+	mTerrain.Update(mfDelta);
+	UpdateScent();
+	lap(PHASE_TERRAIN);
+	UpdateCreatures(mfDelta);
+	SettleEnergy();
+	ServePaths();
+	lap(PHASE_CREATURES);
+
+	// post
+	CleanUpDead();
+	mPaths.Balance();
+	lap(PHASE_CLEANUP);
+
+	mfLogAccDt += mfDelta;
+	if (mfLogAccDt > 1.f / mfLogFreq)
 	{
-		RenderSetup();
+		UpdateLogs();
+		lap(PHASE_LOGS);
 	}
+	ECO_PROFILE_FRAME(&mProfiler, mnTickCount, start, std::chrono::steady_clock::now());
+}
+
+double CS380::EcoSystem::GetPhaseSeconds(TickPhase _phase) const noexcept
+{
+	return mPhaseSeconds[_phase];
+}
+
+void CS380::EcoSystem::ResetPhaseTimes(void) noexcept
+{
+	for (double& s : mPhaseSeconds)
+		s = 0.0;
 }
 
-void CS380::EcoSystem::AddCreature(CS380::Creature* _c)
+CS380::PathArena& CS380::EcoSystem::GetPaths(void) noexcept
 {
-	mAllCreatures.push_back(_c);
-	mnPeakPops++;
+	return mPaths;
 }
 
-void CS380::EcoSystem::RenderMap(void)
+CS380::Profiler& CS380::EcoSystem::GetProfiler(void) noexcept
 {
-	ImGui::SetNextWindowPos(ImVec2{ 0.f,0.f }, ImGuiCond_Always);
-	ImGui::SetNextWindowSize(ImVec2{ mnWindowX, mnWindowY }, ImGuiCond_Always);
-	ImGui::Begin("Simulation Space", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse | 
-		ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoTitleBar );
+	return mProfiler;
+}
 
-	RenderMenuBar();
-	RenderGrid();
-	RenderGridOverlay();
-	RenderHighlights();
+const CS380::Profiler& CS380::EcoSystem::GetProfiler(void) const noexcept
+{
+	return mProfiler;
+}
 
-	ImGui::End();
+void CS380::EcoSystem::SetWorldSize(unsigned _w, unsigned _h) noexcept
+{
+	mnWidth = _w;
+	mnHeight = _h;
 }
 
-void CS380::EcoSystem::RenderGrid(void)
+void CS380::EcoSystem::SetGrassParams(float _initialA, float _initialLo, float _initialHi, float _rateLo, float _rateHi, float _maxEnergy) noexcept
 {
-	ImRect bounds{ ImVec2{ 6.f, mfTitleBarSize + 6.f }, ImVec2{ static_cast<float>(mnWindowX) - 6.f, static_cast<float>(mnWindowY) - 6.f} };
+	mfInitialGrassA = _initialA;
+	mfInitialGrassVLo = _initialLo;
+	mfInitialGrassVHi = _initialHi;
+	mfGRateLo = _rateLo;
+	mfGRateHi = _rateHi;
+	mfGrassMaxEnergy = _maxEnergy;
+}
 
-	ImVec2 space{ bounds.Max.x - bounds.Min.x, bounds.Max.y - bounds.Min.y };
-	space.x /= static_cast<float>(mnWidth);
-	space.y /= static_cast<float>(mnHeight);
-	mfScalar = min(min(space.x, space.y), static_cast<float>(mnScale));
-	ImVec2 box{ bounds.Min.x + static_cast<float>(mfScalar), bounds.Min.y + static_cast<float>(mfScalar) };
+void CS380::EcoSystem::SetFertilizerParams(float _rateLo, float _rateHi, float _maxEnergy, float _deathThresh) noexcept
+{
+	mfFRateLo = _rateLo;
+	mfFRateHi = _rateHi;
+	mfFertilizerMaxEnergy = _maxEnergy;
+	mfDeathThresh = _deathThresh;
+}
 
-	ImDrawList *pDrawList = ImGui::GetWindowDrawList();
-	for (unsigned y = 0; y < mnHeight; ++y)
-	{
-		for (unsigned x = 0; x < mnWidth; ++x)
-		{
-			ImVec2 min{ bounds.Min.x + (x * mfScalar), bounds.Min.y + (y * mfScalar) };
-			ImVec2 max{ box.x + (x * mfScalar), box.y + (y * mfScalar) };
+void CS380::EcoSystem::SetRateNoise(float _mix, float _scale) noexcept
+{
+	mTerrain.SetRateNoise(_mix, _scale);
+}
 
-			// has creature on it
-			if (mTerrain.GetSpaceLayer()[y][x] != -1)
-			{
-				pDrawList->AddRectFilled(min, max, mAllCreatures[mTerrain.GetSpaceLayer()[y][x]]->GetColor());
-			}
-			// no creature on it
-			else
-			{
-				pDrawList->AddRectFilled(min, max, mTerrain.GetGrassColor(x,y));
-			}
-		}
-	}
+CS380::Random& CS380::EcoSystem::GetRandom(void) noexcept
+{
+	return mRandom;
+}
+
+const CS380::Random& CS380::EcoSystem::GetRandom(void) const noexcept
+{
+	return mRandom;
+}
+
+const CS380::EvolutionData& CS380::EcoSystem::GetEvolutionData(unsigned _i) const noexcept
+{
+	return mEvolution[_i];
+}
+
+void CS380::EcoSystem::SetEvolutionData(unsigned _i, const EvolutionData& _evo) noexcept
+{
+	if (_i < mEvolution.size())
+		mEvolution[_i] = _evo;
+}
+
+float CS380::EcoSystem::GetMutationEpsilon(void) const noexcept
+{
+	return mfMutationEpsilon;
+}
+
+void CS380::EcoSystem::SetMutationEpsilon(float _eps) noexcept
+{
+	mfMutationEpsilon = _eps;
+}
+
+void CS380::EcoSystem::Begin(void) noexcept
+{
+	mRandom.ResetEntityStreams();
+	mTerrain.Init(mfInitialGrassA, mfInitialGrassVLo, mfInitialGrassVHi, mnWidth, mnHeight, mfGRateLo, mfGRateHi, mfGrassMaxEnergy, mfFertilizerMaxEnergy, mfFRateLo, mfFRateHi);
+	mSpatial.Reset(mnWidth, mnHeight, static_cast<unsigned>(mPools.size()));
+	mScent.Reset(mnWidth, mnHeight);
+	ResetOccupancy();
+	mbRunEco = true;
+}
+
+unsigned long long CS380::EcoSystem::GetTickCount(void) const noexcept
+{
+	return mnTickCount;
+}
+
+bool CS380::EcoSystem::IsRunning(void) const noexcept
+{
+	return mbRunEco;
+}
+
+void CS380::EcoSystem::SetWorkerCount(unsigned _n) noexcept
+{
+	mThreadPool.Resize(_n);
+	mProfiler.ReserveWorkers(mThreadPool.GetThreadCount());
+	mPaths.ReserveWorkers(mThreadPool.GetThreadCount());
+}
+
+CS380::ThreadPool& CS380::EcoSystem::GetThreadPool(void) noexcept
+{
+	return mThreadPool;
+}
+
+void CS380::EcoSystem::SetBatchedUpdate(bool _b) noexcept
+{
+	mbBatchedUpdate = _b;
+}
+
+bool CS380::EcoSystem::IsBatchedUpdate(void) const noexcept
+{
+	return mbBatchedUpdate;
+}
+
+void CS380::EcoSystem::SetParallelUpdate(bool _b) noexcept
+{
+	mbParallelUpdate = _b;
+}
+
+void CS380::EcoSystem::SetLazyTerrain(bool _b) noexcept
+{
+	mTerrain.SetLazy(_b);
+}
+
+bool CS380::EcoSystem::IsLazyTerrain(void) const noexcept
+{
+	return mTerrain.IsLazy();
+}
+
+void CS380::EcoSystem::SetScentSpecies(unsigned _mask) noexcept
+{
+	mScent.SetSpeciesMask(_mask & ((1u << mPools.size()) - 1));
+}
+
+unsigned CS380::EcoSystem::GetScentSpecies(void) const noexcept
+{
+	return mScent.GetSpeciesMask();
 }
 
-void CS380::EcoSystem::RenderGridOverlay(void) noexcept
+bool CS380::EcoSystem::IsScented(unsigned _species) const noexcept
 {
-	ImRect bounds{ ImVec2{ 6.f, mfTitleBarSize + 6.f }, ImVec2{ static_cast<float>(mnWindowX) - 6.f, static_cast<float>(mnWindowY) - 6.f} };
-	ImVec2 box{ bounds.Min.x + static_cast<float>(mfScalar), bounds.Min.y + static_cast<float>(mfScalar) };
+	return mScent.IsTracked(_species);
+}
+
+CS380::GridPos CS380::EcoSystem::ClimbScent(const GridPos& _p, unsigned _species) const noexcept
+{
+	return mScent.Climb(_species, _p);
+}
 
-	ImDrawList *pDrawList = ImGui::GetWindowDrawList();
-	for (unsigned y = 0; y < mnHeight; ++y)
+const CS380::ScentField& CS380::EcoSystem::GetScent(void) const noexcept
+{
+	return mScent;
+}
+
+void CS380::EcoSystem::UpdateScent(void) noexcept
+{
+	if (!mScent.GetSpeciesMask())
+		return;
+	// spread first so the freshest scent is where the creatures are now, in pool order like everything else
+	mScent.Update();
+	for (unsigned s = 0; s < mPools.size(); ++s)
 	{
-		for (unsigned x = 0; x < mnWidth; ++x)
-		{
-			ImVec2 min{ bounds.Min.x + (x * mfScalar), bounds.Min.y + (y * mfScalar) };
-			ImVec2 max{ box.x + (x * mfScalar), box.y + (y * mfScalar) };
-			pDrawList->AddRect(min, max, ImGui::GetColorU32(ImVec4{0.5f,0.5f,0.5f, 0.1f}));
-		}
+		if (!mScent.IsTracked(s))
+			continue;
+		const CreatureHotData& hot = mPools[s]->GetHot();
+		for (unsigned i = 0; i < mPools[s]->GetLiveCount(); ++i)
+			if (!(hot.mFlags[i] & CS380::Creature::FLAG_DEAD))
+				mScent.Deposit(s, hot.mPosX[i], hot.mPosY[i]);
 	}
 }
 
-void CS380::EcoSystem::RenderHighlights(void)
+bool CS380::EcoSystem::IsParallelUpdate(void) const noexcept
 {
-	ImRect bounds{ ImVec2{ 6.f, mfTitleBarSize + 6.f }, ImVec2{ static_cast<float>(mnWindowX) - 6.f, static_cast<float>(mnWindowY) - 6.f} };
-	ImVec2 box{ bounds.Min.x + static_cast<float>(mfScalar), bounds.Min.y + static_cast<float>(mfScalar) };
-	ImDrawList *pDrawList = ImGui::GetWindowDrawList();
-	while (!mHighlightQueue.empty())
-	{
-		std::tuple<unsigned, unsigned, unsigned int> h = mHighlightQueue.top();
-		mHighlightQueue.pop();
+	return mbParallelUpdate;
+}
 
-		ImVec2 min{ bounds.Min.x + (std::get<0>(h) * mfScalar), bounds.Min.y + (std::get<1>(h) * mfScalar) };
-		ImVec2 max{ box.x + (std::get<0>(h) * mfScalar), box.y + (std::get<1>(h) * mfScalar) };
-		pDrawList->AddRect(min, max, std::get<2>(h), 0.f, 15, 3.f);
-	}
+void CS380::EcoSystem::NoteSpawn(void) noexcept
+{
+	ECO_PROFILE_COUNT(&mProfiler, COUNTER_SPAWNS, 1);
+	mnPeakPops = std::max(mnPeakPops, GetCreatureCount());
 }
 
-void CS380::EcoSystem::RenderMenuBar(void)
+CS380::CreaturePoolBase& CS380::EcoSystem::GetPool(unsigned _species) noexcept
 {
-	ImGui::BeginMainMenuBar();
-	mfTitleBarSize = ImGui::GetWindowSize().y;
-	if (ImGui::BeginMenu("Windows"))
-	{
-		ImGui::PushID(99);
-		ImGui::Selectable("EcoSystem", &mbEcoTool);
-		ImGui::PopID();
+	return *mPools[_species];
+}
 
-		for (unsigned i = 0; i < mTools.size(); ++i)
-		{
-			ImGui::PushID(static_cast<int>(i));
-			ImGui::Selectable(mTools[i]->GetName().c_str(), mTools[i]->GetOpened());
-			ImGui::PopID();
-		}
-		ImGui::EndMenu();
+void CS380::EcoSystem::AddOccupant(const CreatureHandle& _h, const GridPos& _p) noexcept
+{
+	LinkCell(_h, _p);
+	mSpatial.Insert(_h, _p);
+}
+
+void CS380::EcoSystem::MoveOccupant(const CreatureHandle& _h, const GridPos& _from, const GridPos& _to) noexcept
+{
+	// workers only read the layer, the move lands when the commands resolve
+	if (CommandBuffer* cmd = CommandBuffer::GetActive())
+	{
+		cmd->Move(_h, _from, _to);
+		return;
 	}
-	ImGui::EndMainMenuBar();
+	RelinkOccupant(_h, _from, _to);
 }
 
-void CS380::EcoSystem::EcoTool(void)
+unsigned CS380::EcoSystem::QueryRadius(const GridPos& _p, float _radius, unsigned _speciesMask, SpatialHit* _out, unsigned _capacity) const noexcept
 {
-	int v = static_cast<int>(mnLogWindow);
-	ImGui::Begin("EcoSystem", &mbEcoTool);
-	ImGui::DragFloat("Time step", &mfTimeStep, 0.1f, 0.f, 100.f);
+	return mSpatial.QueryRadius(_p, _radius, _speciesMask, _out, _capacity);
+}
 
-	if (ImGui::CollapsingHeader("Evolution Models"))
+void CS380::EcoSystem::RemoveOccupant(const CreatureHandle& _h, const GridPos& _p) noexcept
+{
+	UnlinkCell(_h, _p);
+	mSpatial.Remove(_h, _p);
+}
+
+void CS380::EcoSystem::RelinkOccupant(const CreatureHandle& _h, const GridPos& _from, const GridPos& _to) noexcept
+{
+	UnlinkCell(_h, _from);
+	LinkCell(_h, _to);
+	mSpatial.Move(_h, _from, _to);
+}
+
+void CS380::EcoSystem::LinkCell(const CreatureHandle& _h, const GridPos& _p) noexcept
+{
+	CreatureHandle& head = mTerrain.GetSpaceLayer().Touch(_p.x, _p.y);
+	NextInCell(_h) = head;
+	head = _h;
+	mOccupied[_p.y * mnOccupiedStride + _p.x / 64] |= std::uint64_t{ 1 } << (_p.x % 64);
+	mTerrain.MarkDirty(_p.x, _p.y, DIRTY_OCCUPANCY);
+}
+
+void CS380::EcoSystem::UnlinkCell(const CreatureHandle& _h, const GridPos& _p) noexcept
+{
+	CreatureHandle* link = &mTerrain.GetSpaceLayer().Touch(_p.x, _p.y);
+	while (link->IsValid() && *link != _h)
+		link = &NextInCell(*link);
+	if (link->IsValid())
+		*link = NextInCell(_h);
+	if (!mTerrain.GetSpaceLayer()(_p.x, _p.y).IsValid())
+		mOccupied[_p.y * mnOccupiedStride + _p.x / 64] &= ~(std::uint64_t{ 1 } << (_p.x % 64));
+	mTerrain.MarkDirty(_p.x, _p.y, DIRTY_OCCUPANCY);
+}
+
+CS380::CreatureHandle& CS380::EcoSystem::NextInCell(const CreatureHandle& _h) noexcept
+{
+	CreaturePoolBase& pool = *mPools[_h.GetSpecies()];
+	return pool.GetHot().mCellNext[pool.GetRow(_h.GetSlot())];
+}
+
+void CS380::EcoSystem::ResetOccupancy(void)
+{
+	mnOccupiedStride = (mnWidth + 63) / 64;
+	mOccupied.assign(static_cast<std::size_t>(mnOccupiedStride) * mnHeight, 0);
+}
+
+bool CS380::EcoSystem::IsCellFree(unsigned _x, unsigned _y) const noexcept
+{
+	return _x < mnWidth && _y < mnHeight && !((mOccupied[_y * mnOccupiedStride + _x / 64] >> (_x % 64)) & 1u);
+}
+
+unsigned CS380::EcoSystem::CountFreeCells(const SpawnRegion& _region) const noexcept
+{
+	unsigned x0, y0, x1, y1;
+	ClipRegion(_region, mnWidth, mnHeight, x0, y0, x1, y1);
+	unsigned free = 0;
+	for (unsigned y = y0; y < y1; ++y)
+		for (unsigned w = x0 / 64; w * 64 < x1; ++w)
+			free += PopCount(~mOccupied[y * mnOccupiedStride + w] & WordMask(w, x0, x1));
+	return free;
+}
+
+unsigned CS380::EcoSystem::SampleFreeCells(unsigned _count, const SpawnRegion& _region, Rng& _rng, std::vector<GridPos>& _out) const
+{
+	unsigned x0, y0, x1, y1;
+	ClipRegion(_region, mnWidth, mnHeight, x0, y0, x1, y1);
+	const unsigned free = CountFreeCells(_region);
+	const unsigned n = std::min(_count, free);
+	if (!n)
+		return 0;
+
+	const std::size_t first = _out.size();
+	_out.reserve(first + n);
+	const unsigned long long cells = static_cast<unsigned long long>(x1 - x0) * (y1 - y0);
+	if (n <= free / 4 && free * 2ull >= cells)
 	{
-		ImGui::DragFloat("Mutation Epsilon: %f", &CREATURE_MUTATION_EPSILON, 0.01f, 0.001f, 0.999f);
-		for (int i = 0; i < EVOLUTION_CHART_COUNT; ++i)
+		// few picks on a mostly empty region: draws land on a free cell at least half the time, duplicates are
+		// dropped and drawn again. every free cell is as likely as any other, so the set stays uniform
+		unsigned have = 0;
+		while (have < n)
 		{
-			ImGui::PushID(i);
-			if (ImGui::CollapsingHeader(Spawnables[i]))
+			for (unsigned i = have; i < n; ++i)
 			{
-				ImGui::DragFloat("Replication Thresh: %f", &EvolutionChart[i].mfReplicationThresh, 0.01f, 0.001f, 0.999f);
-				ImGui::DragFloat("Replication Chance: %f", &EvolutionChart[i].mfReplicateChance, 0.01f, 0.001f, 0.999f);
-				ImGui::DragFloat("Mutation Chance: %f", &EvolutionChart[i].mfMutationChance, 0.01f, 0.001f, 0.999f);
+				unsigned x, y;
+				do
+				{
+					x = x0 + _rng.Below(x1 - x0);
+					y = y0 + _rng.Below(y1 - y0);
+				} while (!IsCellFree(x, y));
+				_out.push_back(GridPos{ static_cast<int>(x), static_cast<int>(y) });
 			}
-			ImGui::PopID();
+			const auto begin = _out.begin() + first;
+			std::sort(begin, _out.end(), [](const GridPos& _a, const GridPos& _b) { return _a.y != _b.y ? _a.y < _b.y : _a.x < _b.x; });
+			_out.erase(std::unique(begin, _out.end(), [](const GridPos& _a, const GridPos& _b) { return _a.x == _b.x && _a.y == _b.y; }), _out.end());
+			have = static_cast<unsigned>(_out.size() - first);
 		}
+		return n;
 	}
 
-	ImGui::DragInt("Log Window", &v, 1.f, 20, 100);
-	ImGui::DragFloat("Log Freq.", &mfLogFreq, 0.1f, 1.f, 100.f);
-	mnLogWindow = static_cast<unsigned>(v);
-	if (ImGui::Button("Nuke", ImVec2{100.f,20.f}))
-		Nuke();
-	ImGui::End();
+	// otherwise one pass over the free cells taking each with probability needed / left (selection sampling),
+	// no retries however full the region is and the cells come out in row order
+	unsigned need = n;
+	unsigned left = free;
+	for (unsigned y = y0; y < y1 && need; ++y)
+	{
+		for (unsigned w = x0 / 64; w * 64 < x1 && need; ++w)
+		{
+			for (std::uint64_t bits = ~mOccupied[y * mnOccupiedStride + w] & WordMask(w, x0, x1); bits && need; bits &= bits - 1, --left)
+			{
+				if (need == left || _rng.Below(left) < need)
+				{
+					_out.push_back(GridPos{ static_cast<int>(w * 64 + LowestBit(bits)), static_cast<int>(y) });
+					--need;
+				}
+			}
+		}
+	}
+	return n;
 }
 
-void CS380::EcoSystem::UpdateMap(void)
+bool CS380::EcoSystem::IsSensedAlive(const CreatureHandle& _h, const Creature* _c) const noexcept
 {
-	unsigned x, y;
-	for (auto& row : mTerrain.GetSpaceLayer())
-		for (auto& col : row)
-			col = -1;
+	if (!CommandBuffer::GetActive())
+		return !(_c->GetFlags() & Creature::FLAG_DEAD);
+	const std::vector<std::uint64_t>& alive = mSensedAlive[_h.GetSpecies()];
+	const unsigned slot = _h.GetSlot();
+	return slot / 64 < alive.size() && (alive[slot / 64] >> (slot % 64)) & 1u;
+}
 
-	for (int i = 0; i < static_cast<int>(mAllCreatures.size()); ++i)
+void CS380::EcoSystem::UpdateCreatures(float _dt)
+{
+	// creatures born during the pass are appended, they start next tick
+	if (!mbParallelUpdate)
+	{
+		for (const auto& pool : mPools)
+			UpdateSlice(*pool, 0, pool->GetLiveCount(), _dt);
+		return;
+	}
+
+	// slices never straddle species, nothing is born or destroyed until the commands resolve
+	mSlices.clear();
+	for (unsigned p = 0; p < mPools.size(); ++p)
 	{
-		mAllCreatures[i]->GetGridPosition(x, y);
-		mTerrain.GetSpaceLayer()[y][x] = i;
+		const unsigned count = mPools[p]->GetLiveCount();
+		for (unsigned b = 0; b < count; b += CREATURE_SLICE_SIZE)
+			mSlices.push_back(CreatureSlice{ p, b, std::min(b + CREATURE_SLICE_SIZE, count) });
+	}
+	if (mCommands.size() < mSlices.size())
+		mCommands.resize(mSlices.size());
+
+	// the slices write their own creatures' flags and positions as they go, the queries into the others read this
+	// and the spatial index, both left alone until the commands resolve
+	mSensedAlive.resize(mPools.size());
+	for (unsigned p = 0; p < mPools.size(); ++p)
+	{
+		const CreaturePoolBase& pool = *mPools[p];
+		const CreatureHotData& h = pool.GetHot();
+		std::vector<std::uint64_t>& alive = mSensedAlive[p];
+		alive.clear();
+		for (unsigned i = 0; i < pool.GetLiveCount(); ++i)
+		{
+			if (h.mFlags[i] & Creature::FLAG_DEAD)
+				continue;
+			const unsigned slot = pool.GetLiveHandle(i).GetSlot();
+			if (slot / 64 >= alive.size())
+				alive.resize(slot / 64 + 1, 0);
+			alive[slot / 64] |= std::uint64_t{ 1 } << (slot % 64);
+		}
 	}
+	mTerrain.ReserveSearchWorkers(mThreadPool.GetThreadCount());
+	mPaths.ReserveWorkers(mThreadPool.GetThreadCount());
+
+	mThreadPool.ParallelFor(static_cast<unsigned>(mSlices.size()), [this, _dt](unsigned _i, unsigned)
+	{
+		const CreatureSlice& s = mSlices[_i];
+		mCommands[_i].Clear();
+		CommandBuffer::SetActive(&mCommands[_i]);
+		UpdateSlice(*mPools[s.mnPool], s.mnBegin, s.mnEnd, _dt);
+		CommandBuffer::SetActive(nullptr);
+	});
+
+	for (unsigned i = 0; i < mSlices.size(); ++i)
+		ResolveCommands(mCommands[i]);
 }
 
-void CS380::EcoSystem::UpdateTools(void)
+void CS380::EcoSystem::ServePaths(void)
 {
-	for (unsigned i = 0; i < mTools.size(); ++i)
+	// the search only reads the cells' fixed step costs and, while serving in parallel, a flow field cache nobody
+	// writes until the batch is in, so answering late changes nothing but where the creature plans from
+	std::size_t served = 0;
+	unsigned long long nodes = 0;
+	auto withinBudget = [this, &nodes] { return !mnPathBudget || nodes < mnPathBudget; };
+
+	if (!mbParallelUpdate)
 	{
-		ImGui::PushID(static_cast<int>(i));
-		if (*mTools[i]->GetOpened())
-			mTools[i]->Render();
-		ImGui::PopID();
+		for (; served < mPathQueue.size() && withinBudget(); ++served)
+		{
+			const PathRequest& q = mPathQueue[served];
+			Creature* c = GetCreature(q.mActor);
+			if (!c || !c->IsPathTicket(q.mnTicket))
+				continue;
+			ECO_PROFILE_SCOPE(&mProfiler, ZONE_SHORTEST_PATH);
+			PathCursor path{};
+			unsigned n = 0;
+			const bool found = mTerrain.GetShortestPath(c->GetGridPosition(), GridPos{ q.mnDestX, q.mnDestY }, path, q.meMode, &n);
+			nodes += n;
+			c->DeliverPath(q.mnTicket, found, path);
+		}
 	}
+	else
+	{
+		mTerrain.ReserveSearchWorkers(mThreadPool.GetThreadCount());
+		mPaths.ReserveWorkers(mThreadPool.GetThreadCount());
+		mPathNotes.clear();
+		while (served < mPathQueue.size() && withinBudget())
+		{
+			const std::size_t begin = served;
+			const unsigned count = static_cast<unsigned>(std::min<std::size_t>(PATH_QUEUE_BATCH, mPathQueue.size() - begin));
+			mPathResults.assign(count, PathCursor{});
+			mPathNodes.assign(count, 0u);
+			mPathFound.assign(count, 0u);
+			mThreadPool.ParallelFor(count, [this, begin](unsigned _i, unsigned)
+			{
+				const PathRequest& q = mPathQueue[begin + _i];
+				Creature* c = GetCreature(q.mActor);
+				if (!c || !c->IsPathTicket(q.mnTicket))
+					return;
+				ECO_PROFILE_SCOPE(&mProfiler, ZONE_SHORTEST_PATH);
+				mPathFound[_i] = 1u | (mTerrain.PeekShortestPath(c->GetGridPosition(), GridPos{ q.mnDestX, q.mnDestY }, mPathResults[_i], q.meMode, &mPathNodes[_i]) ? 2u : 0u);
+			});
+			for (unsigned i = 0; i < count; ++i)
+			{
+				if (!mPathFound[i])
+					continue;
+				const PathRequest& q = mPathQueue[begin + i];
+				Creature* c = GetCreature(q.mActor);
+				mPathNotes.emplace_back(c->GetGridPosition(), GridPos{ q.mnDestX, q.mnDestY });
+				c->DeliverPath(q.mnTicket, (mPathFound[i] & 2u) != 0, mPathResults[i]);
+				nodes += mPathNodes[i];
+			}
+			served += count;
+		}
+		// the cache hears about the requests once every batch has read it, as it does for the creature phase
+		for (const auto& n : mPathNotes)
+			mTerrain.NotePathRequest(n.first, n.second);
+	}
+	mPathQueue.erase(mPathQueue.begin(), mPathQueue.begin() + served);
 }
 
-void CS380::EcoSystem::UpdateCreatures(float _dt) const
+void CS380::EcoSystem::UpdateSlice(CreaturePoolBase& _pool, unsigned _begin, unsigned _end, float _dt) const
 {
-	for (auto& c : mAllCreatures)
-	{
-		if (c->GetFlags() & CS380::Creature::FLAG_DEAD)
-			continue;
+	// a slice never mixes species, so one table lookup picks the loop for the whole range
+	const Data::UpdateTable& table = mbBatchedUpdate ? Data::BatchedUpdateRanges : Data::UpdateRanges;
+	ECO_PROFILE_SPECIES(&mProfiler, _pool.GetSpecies());
+	table[_pool.GetSpecies()](_pool, _begin, _end, _dt);
+}
 
-		c->UpdateAwake(_dt);
+void CS380::EcoSystem::ResolveCommands(const CommandBuffer& _cmd)
+{
+	mEnergyLedger.insert(mEnergyLedger.end(), _cmd.GetReturns().begin(), _cmd.GetReturns().end());
+	for (const WorldCommand& c : _cmd.GetCommands())
+	{
+		switch (c.meType)
+		{
+		case WorldCommand::CMD_FERTILIZE:
+			FertilizeCell(GridPos{ c.mnX, c.mnY }, c.mfValue);
+			break;
+		case WorldCommand::CMD_PATH:
+			mTerrain.NotePathRequest(GridPos{ c.mnX, c.mnY }, GridPos{ c.mnDestX, c.mnDestY });
+			break;
+		case WorldCommand::CMD_MOVE:
+			// dead or not, the layer has to follow where the creature is
+			RelinkOccupant(c.mActor, GridPos{ c.mnX, c.mnY }, GridPos{ c.mnDestX, c.mnDestY });
+			break;
+		case WorldCommand::CMD_EAT:
+		{
+			// first in creature order gets the meal: prey eaten earlier in the resolve is gone for later attackers,
+			// and a creature that died before its own meal resolves does not eat
+			Creature* actor = GetCreature(c.mActor);
+			if (actor && !(actor->GetFlags() & CS380::Creature::FLAG_DEAD))
+				actor->Digest(Eat(GridPos{ c.mnX, c.mnY }, actor));
+			break;
+		}
+		}
 	}
+	mPathQueue.insert(mPathQueue.end(), _cmd.GetPathRequests().begin(), _cmd.GetPathRequests().end());
 }
 
 void CS380::EcoSystem::CleanUpDead(void)
 {
-	for (unsigned i = 0; i < mAllCreatures.size(); ++i)
+	for (auto& pool : mPools)
 	{
-		if (mAllCreatures[i]->GetFlags() & CS380::Creature::FLAG_DEAD)
+		const CreatureHotData& hot = pool->GetHot();
+		for (unsigned i = 0; i < pool->GetLiveCount();)
 		{
-			auto p = mAllCreatures[i]->GetGridPosition();
+			if (!(hot.mFlags[i] & CS380::Creature::FLAG_DEAD))
+			{
+				++i;
+				continue;
+			}
 
-			// check if he died with somebody else on it or naturally 
-			if (mTerrain.GetSpaceLayer()[p.y][p.x] == static_cast<int>(i))
-				mTerrain.GetSpaceLayer()[p.y][p.x] = -1;
+			Creature* c = pool->GetLive(i);
+			auto p = c->GetGridPosition();
+			const CreatureHandle h = pool->GetLiveHandle(i);
 
-			mTerrain.GetFertilizerLayer()[p.y][p.x] += mAllCreatures[i]->GetEnergy().second * mfDeathThresh;
+			RemoveOccupant(h, p);
+			FertilizeCell(p, c->GetEnergy().second * mfDeathThresh);
 
-			std::swap(mAllCreatures[i], mAllCreatures.back());
-			Creature *c = mAllCreatures.back();
-			mAllCreatures.pop_back();
-			delete c;
-			--i;
+			// the last live creature is swapped into i, so i is looked at again
+			pool->Destroy(h);
+			ECO_PROFILE_COUNT(&mProfiler, COUNTER_DEATHS, 1);
 		}
 	}
 }
 
-void CS380::EcoSystem::HighlightGrid(unsigned short x, unsigned short y, unsigned int _col)
-{
-	mHighlightQueue.push(std::make_tuple(x, y, _col));
-}
-
 void CS380::EcoSystem::HighlightGrid(unsigned x, unsigned y, unsigned int _col)
 {
-	mHighlightQueue.push(std::make_tuple(static_cast<unsigned short>(x), static_cast<unsigned short>(y), _col));
+	mHighlightQueue.push(std::make_tuple(x, y, _col));
 }
 
 int CS380::EcoSystem::GetWidth(void) const noexcept
@@ -313,32 +724,28 @@ int CS380::EcoSystem::GetHeight(void) const noexcept
 	return mnHeight;
 }
 
-int CS380::EcoSystem::GetGridVal(unsigned _x, unsigned _y) const noexcept
+CS380::CreatureHandle CS380::EcoSystem::GetGridVal(unsigned _x, unsigned _y) const noexcept
 {
 	if (_x >= mnWidth || _y >= mnHeight)
-		return -1;
-
+		return CreatureHandle{};
 
-	auto v = mTerrain.GetSpaceLayer()[_y][_x];
-	if (v>= 0 && v >= mAllCreatures.size())
-		__debugbreak(); // out of range? layer not updated? execution order?
-	return v;
+	return mTerrain.GetSpaceLayer()(_x, _y);
 }
 
 float CS380::EcoSystem::GetGrassVal(unsigned _x, unsigned _y) const noexcept
 {
-	if (_x > mnWidth || _y > mnHeight)
+	if (_x >= mnWidth || _y >= mnHeight)
 		return 0.f;
 
-	return mTerrain.GetGrassLayer()[_y][_x];
+	return mTerrain.GetGrass(_x, _y);
 }
 
 float CS380::EcoSystem::GetGrassValA(unsigned _x, unsigned _y) const noexcept
 {
-	if (_x > mnWidth || _y > mnHeight)
+	if (_x >= mnWidth || _y >= mnHeight)
 		return 0.f;
 
-	return mTerrain.GetGrassLayer()[_y][_x] / mTerrain.GetGrassLayerThresh()[_y][_x].second;
+	return mTerrain.GetGrass(_x, _y) / mTerrain.GetGrassThreshHi();
 }
 
 const CS380::Terrain& CS380::EcoSystem::GetTerrain(void) const noexcept
@@ -346,26 +753,48 @@ const CS380::Terrain& CS380::EcoSystem::GetTerrain(void) const noexcept
 	return mTerrain;
 }
 
-CS380::Creature * CS380::EcoSystem::GetCreature(int i)
+CS380::Creature * CS380::EcoSystem::GetCreature(const CreatureHandle& _h) const noexcept
 {
-	if (i < 0 || i >= mAllCreatures.size())
+	if (!_h.IsValid() || _h.GetSpecies() >= mPools.size())
 		return nullptr;
 
-	return mAllCreatures[i];
+	return mPools[_h.GetSpecies()]->Get(_h);
 }
 
-const std::deque<CS380::Creature *>& CS380::EcoSystem::GetAllCreatures(void) const noexcept
+unsigned CS380::EcoSystem::GetCreatureCount(void) const noexcept
 {
-	return mAllCreatures;
+	unsigned n = 0;
+	for (const auto& pool : mPools)
+		n += pool->GetLiveCount();
+	return n;
+}
+
+void CS380::EcoSystem::Populate(unsigned _species, unsigned _count) noexcept
+{
+	if (_species >= mEvolution.size())
+		return;
+
+	Rng rng = mRandom.Stream(STREAM_SPAWN, _species);
+	Data::SpawnMany(*this, _species, _count, mOwned, Data::TraitDistribution{ Traits{ 1.f, 1.f, 1.f } }, rng);
+}
+
+void CS380::EcoSystem::PopulateFill(unsigned _species, float _fraction) noexcept
+{
+	if (_species >= mEvolution.size())
+		return;
+
+	Rng rng = mRandom.Stream(STREAM_FILL, _species);
+	Data::SpawnFill(*this, _species, _fraction, mOwned, Data::TraitDistribution{ Traits{ 1.f, 1.f, 1.f } }, rng);
 }
 
 void CS380::EcoSystem::Nuke(void) noexcept
 {
-	for (auto& c : mAllCreatures)
+	ForEachCreature([this](Creature* c, const CreatureHandle&)
 	{
 		ReturnEnergyToMap(c->ConsumeEnergy(c->GetEnergy().second), c->GetGridPosition());
 		//c->ConsumeFatigue(FLT_MAX);
-	}
+	});
+	SettleEnergy();
 }
 
 float CS380::EcoSystem::Eat(const GridPos& _p, Creature* _predator)
@@ -374,70 +803,87 @@ float CS380::EcoSystem::Eat(const GridPos& _p, Creature* _predator)
 	_predator->GetGridPosition(x,y);
 
 	if (sqrt((_p.x - static_cast<int>(x)) * (_p.x - static_cast<int>(x)) + (_p.y - static_cast<int>(y)) * (_p.y - static_cast<int>(y))) > 1.5f)
-		__debugbreak(); // attempting to eat from further than 1 unit away??
+		ECO_DEBUGBREAK(); // attempting to eat from further than 1 unit away??
+
+	// first live creature on the cell other than the predator
+	Creature* target = nullptr;
+	for (CreatureHandle h = mTerrain.GetSpaceLayer()(_p.x, _p.y); h.IsValid() && !target; h = NextInCell(h))
+	{
+		Creature* c = GetCreature(h);
+		if (c != _predator && !(c->GetFlags() & CS380::Creature::FLAG_DEAD))
+			target = c;
+	}
 
-	auto i = mTerrain.GetSpaceLayer()[_p.y][_p.x];
 	// got other creature, means eating it ?
-	if (i >= 0 && i < mAllCreatures.size())
+	if (target)
 	{
-		if (mAllCreatures[i] == _predator)
-		{
-			if (dynamic_cast<Fox*>(_predator))
-			{
-				return 0;
-			}
-			// eating yourself? assume eat grass you're on
-			return mTerrain.ConsumeGrass(_p.x, _p.y, 1.f);
-		}
-		if (const auto fox = dynamic_cast<Fox*>(mAllCreatures[i]))
+		// cant eat up the food chain, graze instead
+		if (!Data::CanEat(_predator->GetSpecies(), target->GetSpecies()))
 		{
-			// rabbit cant eat foxes
-			if (fox && dynamic_cast<Rabbit*>(_predator))
-			{
-				return mTerrain.ConsumeGrass(_p.x, _p.y, 1.f);
-			}
-			
+			return GrazeCell(_p, 1.f);
 		}
-		if (mAllCreatures[i]->GetSize() < 1.2f * _predator->GetSize())
+		if (target->GetSize() < 1.2f * _predator->GetSize())
 		{
-			return mAllCreatures[i]->Eaten(_predator);
+			return target->Eaten(_predator);
 		}
 	}
-	else
-		mTerrain.GetSpaceLayer()[_p.y][_p.x] = -1;
+	// alone on it? assume eat grass you're on
+	else if (!Data::Grazes(_predator->GetSpecies()))
+	{
+		return 0;
+	}
 
 	// no creature, means eating grass?
-	return mTerrain.ConsumeGrass(_p.x, _p.y, 1.f);
+	return GrazeCell(_p, 1.f);
 }
 
-std::vector<CS380::GridPos> CS380::EcoSystem::GetShortestPath(const GridPos& _src, const GridPos& _dest)
+void CS380::EcoSystem::RequestPath(const PathRequest& _request)
 {
-	return mTerrain.GetShortestPath(_src, _dest);
+	ECO_PROFILE_PATH(&mProfiler);
+	if (CommandBuffer* cmd = CommandBuffer::GetActive())
+		cmd->RequestPath(_request);
+	else
+		mPathQueue.push_back(_request);
 }
 
-CS380::GridPos CS380::EcoSystem::GetBestGrassPos(const GridPos& _src, float _radiusLimit, float _minAlpha)
+void CS380::EcoSystem::SetPathBudget(unsigned _nodes) noexcept
 {
-	return mTerrain.GetBestGrassPos(_src, _radiusLimit, _minAlpha);
+	mnPathBudget = _nodes;
 }
 
-CS380::GridPos CS380::EcoSystem::GetEmptyNeighbour(const GridPos& _src)
+unsigned CS380::EcoSystem::GetPathBudget(void) const noexcept
 {
-	return mTerrain.GetEmptyNeighbour(_src);
+	return mnPathBudget;
 }
 
-std::pair<float, float> CS380::EcoSystem::GetScreenPos(const GridPos& _p) const noexcept
+std::size_t CS380::EcoSystem::GetQueuedPaths(void) const noexcept
 {
-	ImRect bounds{ ImVec2{ 6.f, mfTitleBarSize + 6.f }, ImVec2{ static_cast<float>(mnWindowX) - 6.f, static_cast<float>(mnWindowY) - 6.f} };
+	return mPathQueue.size();
+}
 
-	ImVec2 space{ bounds.Max.x - bounds.Min.x, bounds.Max.y - bounds.Min.y };
-	space.x /= static_cast<float>(mnWidth);
-	space.y /= static_cast<float>(mnHeight);
-	float scale = min(min(space.x, space.y), static_cast<float>(mnScale));
-	ImVec2 box{ bounds.Min.x + static_cast<float>(scale), bounds.Min.y + static_cast<float>(scale) };
+bool CS380::EcoSystem::GetShortestPath(const GridPos& _src, const GridPos& _dest, PathCursor& _out, PathMode _mode)
+{
+	ECO_PROFILE_SCOPE(&mProfiler, ZONE_SHORTEST_PATH);
+	ECO_PROFILE_PATH(&mProfiler);
+	// the flow field cache is only read while workers run, requests catch up with it when the commands resolve
+	if (CommandBuffer* cmd = CommandBuffer::GetActive())
+	{
+		cmd->NotePath(_src, _dest);
+		return mTerrain.PeekShortestPath(_src, _dest, _out, _mode);
+	}
+	return mTerrain.GetShortestPath(_src, _dest, _out, _mode);
+}
 
-	ImVec2 min{ bounds.Min.x + (_p.x * scale), bounds.Min.y + (_p.y * scale) };
-	ImVec2 max{ box.x + (_p.x * scale), box.y + (_p.y * scale) };
-	return std::make_pair((min.x + max.x) / 2, (min.y + max.y) / 2);
+CS380::GridPos CS380::EcoSystem::GetBestGrassPos(const GridPos& _src, float _radiusLimit, float _minAlpha)
+{
+	ECO_PROFILE_SCOPE(&mProfiler, ZONE_BEST_GRASS);
+	return mTerrain.GetBestGrassPos(_src, _radiusLimit, _minAlpha);
+}
+
+CS380::GridPos CS380::EcoSystem::GetEmptyNeighbour(const GridPos& _src)
+{
+	ECO_PROFILE_SCOPE(&mProfiler, ZONE_EMPTY_NEIGHBOUR);
+	return mTerrain.GetEmptyNeighbour(_src);
 }
 
 float CS380::EcoSystem::GetScalar(void) const noexcept
@@ -445,103 +891,122 @@ float CS380::EcoSystem::GetScalar(void) const noexcept
 	return mfScalar;
 }
 
-const std::vector<std::deque<float>>& CS380::EcoSystem::GetLogs(void) const noexcept
+const std::vector<CS380::RingBuffer<float>>& CS380::EcoSystem::GetLogs(void) const noexcept
 {
 	return mLogs;
 }
 
 void CS380::EcoSystem::ReturnEnergyToMap(float _v, const GridPos& _p) noexcept
 {
-	mTerrain.GetFertilizerLayer()[_p.y][_p.x] += _v;
+	if (CommandBuffer* cmd = CommandBuffer::GetActive())
+	{
+		cmd->ReturnEnergy(_p, _v);
+		return;
+	}
+	mEnergyLedger.push_back(EnergyReturn{ static_cast<std::uint64_t>(_p.y) << 32 | static_cast<std::uint32_t>(_p.x), _v });
 }
 
-void CS380::EcoSystem::UpdateLogs(void) noexcept
+void CS380::EcoSystem::SettleEnergy(void) noexcept
 {
-	mfLogAccDt = 0.f;
-	float v[LogTypes::LAST] = { 0.f, 0.f, 0.f, 0.f, 0.f };
-	for (const auto& c : mAllCreatures)
+	// stable so a cell's returns keep their creature order and the sums come out the same on any thread count
+	std::stable_sort(mEnergyLedger.begin(), mEnergyLedger.end(), [](const EnergyReturn& _a, const EnergyReturn& _b) { return _a.mnCell < _b.mnCell; });
+	for (std::size_t i = 0; i < mEnergyLedger.size();)
 	{
-		v[0] += c->GetSpeed();
-		v[1] += c->GetSize();
-		v[2] += c->GetSense();
+		const std::uint64_t cell = mEnergyLedger[i].mnCell;
+		float v = 0.f;
+		for (; i < mEnergyLedger.size() && mEnergyLedger[i].mnCell == cell; ++i)
+			v += mEnergyLedger[i].mfValue;
+		FertilizeCell(GridPos{ static_cast<int>(cell & 0xFFFFFFFFu), static_cast<int>(cell >> 32) }, v);
 	}
+	mEnergyLedger.clear();
+}
 
-	v[3] = static_cast<float>(mAllCreatures.size());
-	const auto& g = mTerrain.GetGrassLayer();
-	const auto& l = mTerrain.GetGrassLayerThresh();
-	for (unsigned y = 0; y < g.size(); ++y)
-		for (unsigned x = 0; x < g[y].size(); ++x)
-			v[4] += (g[y][x] / l[y][x].second);
+void CS380::EcoSystem::UpdateLogs(void) noexcept
+{
+	// everything here is kept up as creatures come and go and grass moves, a sample is O(species)
+	mfLogAccDt = 0.f;
+	float* row = mTelemetry.IsRunning() ? mTelemetryRow.data() + LogTypes::LAST : nullptr;
 
-	for (int i = 0; i <= LogTypes::AVG_SENSE; ++i)
+	double sums[TRAIT_COUNT] = { 0.0, 0.0, 0.0 };
+	unsigned count = 0;
+	for (const auto& pool : mPools)
 	{
-		if (mLogs[i].size() == mnLogWindow)
-			mLogs[i].pop_front();
+		const SpeciesStats& st = pool->GetStats();
+		count += st.mnCount;
+		for (unsigned i = 0; i < TRAIT_COUNT; ++i)
+			sums[i] += st.mTraits[i].mfSum;
 
-		if (mAllCreatures.size())
-			mLogs[i].push_back(v[i] / static_cast<float>(mAllCreatures.size()));
-		else
-			mLogs[i].push_back(0.f);
+		if (row)
+		{
+			*row++ = static_cast<float>(st.mnCount);
+			*row++ = static_cast<float>(st.mnPeak);
+			for (const RunningStat& t : { st.mTraits[TRAIT_SPEED], st.mTraits[TRAIT_SIZE], st.mTraits[TRAIT_SENSE] })
+			{
+				*row++ = static_cast<float>(t.GetMean(st.mnCount));
+				*row++ = static_cast<float>(t.GetVariance(st.mnCount));
+				*row++ = st.mnCount ? t.mfMin : 0.f;
+				*row++ = st.mnCount ? t.mfMax : 0.f;
+			}
+		}
 	}
 
-	for (int i = LogTypes::CREATURES_COUNTER; i < LogTypes::LAST; ++i)
+	// a part of a bigger world logs the whole of it, every part sums the same sample
+	double grass = mpDomain ? GetOwnedGrassRatioSum() : mTerrain.GetGrassRatioSum();
+	if (mpDomain)
 	{
-		if (mLogs[i].size() == mnLogWindow)
-			mLogs[i].pop_front();
-		mLogs[i].push_back(v[i]);
+		double parts[TRAIT_COUNT + 2] = { sums[0], sums[1], sums[2], static_cast<double>(count), grass };
+		mpDomain->Sum(parts, TRAIT_COUNT + 2);
+		std::copy(parts, parts + TRAIT_COUNT, sums);
+		count = static_cast<unsigned>(parts[TRAIT_COUNT]);
+		grass = parts[TRAIT_COUNT + 1];
 	}
-}
-
-void CS380::EcoSystem::RenderSetup(void) noexcept
-{
-	ImGui::Begin("Set up Simulation");
 
-	int w = static_cast<int>(mnWidth);
-	int h = static_cast<int>(mnHeight);
+	const double n = count ? static_cast<double>(count) : 1.0;
+	const float v[LogTypes::LAST] = {
+		static_cast<float>(sums[TRAIT_SPEED] / n),
+		static_cast<float>(sums[TRAIT_SIZE] / n),
+		static_cast<float>(sums[TRAIT_SENSE] / n),
+		static_cast<float>(count),
+		static_cast<float>(grass)
+	};
 
-	if (ImGui::DragInt("Width", &w, 1.f, 10, 200))
-	{
-		w = w < 10 ? 10 : w > 200 ? 200 : w;
-		mnWidth = static_cast<unsigned>(w);
-	}
-	if (ImGui::DragInt("Height", &h, 1.f, 10, 200))
+	for (int i = 0; i < LogTypes::LAST; ++i)
 	{
-		h = h < 10 ? 10 : h > 200 ? 200 : h;
-		mnHeight = static_cast<unsigned>(h);
+		// the window is a gui setting, the history in it is kept across a resize
+		mLogs[i].SetCapacity(mnLogWindow);
+		mLogs[i].Push(v[i]);
 	}
 
-	ImGui::DragFloat("Random Grass A", &mfInitialGrassA, 0.1f, 0.f, 1.f);
-	if (ImGui::DragFloat("Grass V Lo", &mfInitialGrassVLo, 0.1f, 0.f, mfInitialGrassVHi))
-		mfInitialGrassVHi = mfInitialGrassVHi < mfInitialGrassVLo ? mfInitialGrassVLo : mfInitialGrassVHi;
-	if (ImGui::DragFloat("Grass V Hi", &mfInitialGrassVHi, 0.1f, mfInitialGrassVLo, 1.f))
-		mfInitialGrassVHi = mfInitialGrassVHi < mfInitialGrassVLo ? mfInitialGrassVLo : mfInitialGrassVHi;
-
-	if (ImGui::DragFloat("Grass G Lo", &mfGRateLo, 0.001f, 0.f, mfGRateHi))
-		mfGRateHi = mfGRateHi < mfGRateLo ? mfGRateLo : mfGRateHi;
-	if (ImGui::DragFloat("Grass G Hi", &mfGRateHi, 0.001f, mfGRateLo, 0.1f))
-		mfGRateHi = mfGRateHi < mfGRateLo ? mfGRateLo : mfGRateHi;
-
-	ImGui::DragFloat("Grass Max E", &mfGrassMaxEnergy, 0.1f, 0.f, 10000.f);
-	if (ImGui::DragFloat("Fert G Lo", &mfFRateLo, 0.001f, 0.f, mfFRateHi))
-		mfFRateHi = mfFRateHi < mfFRateLo ? mfFRateLo : mfFRateHi;
-	if (ImGui::DragFloat("Fert G Hi", &mfFRateHi, 0.001f, mfFRateLo, 0.01f))
-		mfFRateHi = mfFRateHi < mfFRateLo ? mfFRateLo : mfFRateHi;
-	ImGui::DragFloat("Fert Max E", &mfFertilizerMaxEnergy, 0.1f, 0.f, 10000.f);
-	ImGui::DragFloat("Death Threshhold", &mfDeathThresh, 0.1f, 0.01f, 1.);
-	if (ImGui::Button("Begin!", ImVec2{ 120.f, 30.f }))
+	if (row)
 	{
-		mTerrain.Init(mfInitialGrassA, mfInitialGrassVLo, mfInitialGrassVHi, mnWidth, mnHeight, mfGRateLo, mfGRateHi, mfGrassMaxEnergy, mfFertilizerMaxEnergy, mfFRateLo, mfFRateHi);
-		mbRunEco = true;
+		std::copy(v, v + LogTypes::LAST, mTelemetryRow.begin());
+		mTelemetry.Push(mnTickCount, mTelemetryRow.data());
 	}
-
-	ImGui::End();
 }
 
+bool CS380::EcoSystem::OpenTelemetry(const std::string& _path, bool _blocking)
+{
+	static constexpr const char* LogNames[LogTypes::LAST] = { "avg_speed", "avg_size", "avg_sense", "creatures", "grass" };
+	static constexpr const char* SpeciesColumns[] = { "count", "peak",
+		"speed", "speed_var", "speed_min", "speed_max",
+		"size", "size_var", "size_min", "size_max",
+		"sense", "sense_var", "sense_min", "sense_max" };
 
+	std::vector<std::string> columns{ LogNames, LogNames + LogTypes::LAST };
+	for (const auto& pool : mPools)
+		for (const char* c : SpeciesColumns)
+			columns.push_back(std::string{ Data::SpeciesNames[pool->GetSpecies()] } + "_" + c);
 
+	mTelemetryRow.assign(columns.size(), 0.f);
+	return mTelemetry.Start(MakeTelemetrySink(_path), columns, _blocking);
+}
 
+void CS380::EcoSystem::CloseTelemetry(void) noexcept
+{
+	mTelemetry.Stop();
+}
 
-
-
-
-
+const CS380::TelemetryStream& CS380::EcoSystem::GetTelemetry(void) const noexcept
+{
+	return mTelemetry;
+}
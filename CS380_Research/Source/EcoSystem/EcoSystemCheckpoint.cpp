@@ -0,0 +1,182 @@
+#include "EcoSystem/EcoSystem.h"
+#include "EcoSystem/Checkpoint.h"
+#include "Data/EcoData.h"
+
+// checkpoints of the EcoSystem, everything a tick reads goes in. caches that only depend on what is saved (the
+// spatial index, the free cell bits, the grass pyramid, flow fields) are rebuilt on load, so a loaded run carries on bit for bit
+
+void CS380::EcoSystem::SaveCheckpoint(const std::string& _path)
+{
+	CheckpointWriter w;
+	w.Bytes(CHECKPOINT_MAGIC, 4);
+	w.Pod(CHECKPOINT_VERSION);
+
+	w.Pod(mRandom.GetMasterSeed());
+	w.Pod(mRandom.GetEntityCounter());
+	w.Pod(mnTickCount);
+	w.Pod(mnPeakPops);
+	w.Pod(mfLogAccDt);
+	w.Pod(mnLogWindow);
+	w.Pod(mfLogFreq);
+
+	w.Pod(mfMutationEpsilon);
+	w.Pod(static_cast<unsigned>(EVOLUTION_CHART_COUNT));
+	for (const EvolutionData& e : mEvolution)
+	{
+		w.Pod(e.mfReplicationThresh);
+		w.Pod(e.mfReplicateChance);
+		w.Pod(e.mfMutationChance);
+	}
+
+	// oldest sample first
+	for (const auto& l : mLogs)
+	{
+		w.Pod(l.GetCapacity());
+		w.Pod(l.GetSize());
+		for (unsigned i = 0; i < l.GetSize(); ++i)
+			w.Pod(l[i]);
+	}
+
+	mTerrain.Save(w);
+	mScent.Save(w);
+	w.Pod(static_cast<unsigned>(mPools.size()));
+	for (const auto& pool : mPools)
+		pool->Save(w);
+	// what the path budget left for the next tick, handles stay valid as the pools keep their slots
+	w.Vector(mPathQueue);
+
+	// the copy is done, the sim goes on while the writer takes it to disk
+	FinishCheckpoint();
+	mCheckpointWrite = std::async(std::launch::async, [path = _path, data = std::move(w.GetBuffer())]
+	{
+		return WriteCheckpointFile(path, data);
+	});
+}
+
+bool CS380::EcoSystem::FinishCheckpoint(void) noexcept
+{
+	if (!mCheckpointWrite.valid())
+		return true;
+	return mCheckpointWrite.get();
+}
+
+bool CS380::EcoSystem::LoadCheckpoint(const std::string& _path)
+{
+	std::vector<unsigned char> data;
+	if (!ReadCheckpointFile(_path, data))
+		return false;
+
+	CheckpointReader r{ data.data(), data.size() };
+	char magic[4];
+	r.Bytes(magic, 4);
+	if (r.Failed() || std::memcmp(magic, CHECKPOINT_MAGIC, 4) || r.Pod<unsigned>() != CHECKPOINT_VERSION)
+		return false;
+
+	// the header, chart and logs are read aside and only taken once the rest made it
+	const std::uint64_t seed = r.Pod<std::uint64_t>();
+	const std::uint64_t entities = r.Pod<std::uint64_t>();
+	const unsigned long long ticks = r.Pod<unsigned long long>();
+	const unsigned peak = r.Pod<unsigned>();
+	const float logAccDt = r.Pod<float>();
+	const unsigned logWindow = r.Pod<unsigned>();
+	const float logFreq = r.Pod<float>();
+
+	const float mutationEpsilon = r.Pod<float>();
+	if (r.Pod<unsigned>() != EVOLUTION_CHART_COUNT)
+		return false;
+	std::vector<EvolutionData> evolution{ mEvolution };
+	for (EvolutionData& e : evolution)
+	{
+		r.Pod(e.mfReplicationThresh);
+		r.Pod(e.mfReplicateChance);
+		r.Pod(e.mfMutationChance);
+	}
+
+	std::vector<RingBuffer<float>> logs{ mLogs };
+	for (auto& l : logs)
+	{
+		const unsigned capacity = r.Pod<unsigned>();
+		const unsigned size = r.Pod<unsigned>();
+		if (r.Failed() || size > capacity)
+			return false;
+		l.SetCapacity(capacity);
+		l.Clear();
+		for (unsigned i = 0; i < size; ++i)
+			l.Push(r.Pod<float>());
+	}
+	if (r.Failed())
+		return false;
+
+	// from here on the world is overwritten as the file is read, one that breaks off is begun over empty at the
+	// size it had and with its own settings, nothing of the file in it
+	const unsigned width = mnWidth;
+	const unsigned height = mnHeight;
+	const bool lazy = mTerrain.IsLazy();
+	const unsigned scentMask = mScent.GetSpeciesMask();
+	auto abandon = [this, width, height, lazy, scentMask]
+	{
+		for (auto& pool : mPools)
+			pool->Clear();
+		mPathQueue.clear();
+		mnWidth = width;
+		mnHeight = height;
+		mScent.SetSpeciesMask(scentMask);
+		Begin();
+		if (mTerrain.IsLazy() != lazy)
+			mTerrain.SetLazy(lazy);
+		return false;
+	};
+
+	if (!mTerrain.Load(r))
+		return abandon();
+	mnWidth = mTerrain.GetGrassLayer().GetWidth();
+	mnHeight = mTerrain.GetGrassLayer().GetHeight();
+	if (!mScent.Load(r, mnWidth, mnHeight))
+		return abandon();
+
+	if (r.Pod<unsigned>() != mPools.size())
+		return abandon();
+	for (auto& pool : mPools)
+		if (!pool->Load(r))
+			return abandon();
+	r.Vector(mPathQueue);
+	if (r.Failed() || !r.AtEnd())
+		return abandon();
+	// the caches below are rebuilt off the positions, every creature has to stand on the map
+	for (const auto& pool : mPools)
+	{
+		const CreatureHotData& h = pool->GetHot();
+		for (unsigned i = 0; i < pool->GetLiveCount(); ++i)
+			if (h.mPosX[i] >= mnWidth || h.mPosY[i] >= mnHeight)
+				return abandon();
+	}
+
+	mnTickCount = ticks;
+	mnPeakPops = peak;
+	mfLogAccDt = logAccDt;
+	mnLogWindow = logWindow;
+	mfLogFreq = logFreq;
+	mfMutationEpsilon = mutationEpsilon;
+	mEvolution = std::move(evolution);
+	mLogs = std::move(logs);
+
+	// blank creatures drew ids while the pools filled, the counter goes back to where the run had it
+	mRandom.SetMasterSeed(seed);
+	mRandom.SetEntityCounter(entities);
+
+	mSpatial.Reset(mnWidth, mnHeight, static_cast<unsigned>(mPools.size()));
+	ResetOccupancy();
+	for (const auto& pool : mPools)
+	{
+		const CreatureHotData& h = pool->GetHot();
+		for (unsigned i = 0; i < pool->GetLiveCount(); ++i)
+		{
+			mSpatial.Insert(pool->GetLiveHandle(i), GridPos{ static_cast<int>(h.mPosX[i]), static_cast<int>(h.mPosY[i]) });
+			mOccupied[h.mPosY[i] * mnOccupiedStride + h.mPosX[i] / 64] |= std::uint64_t{ 1 } << (h.mPosX[i] % 64);
+		}
+	}
+
+	mfTickAccumulator = 0.f;
+	mbRunEco = true;
+	return true;
+}
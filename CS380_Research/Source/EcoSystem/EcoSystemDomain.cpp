@@ -0,0 +1,123 @@
+#include "EcoSystem/EcoSystem.h"
+#include "EcoSystem/Checkpoint.h"
+#include "EcoSystem/Domain.h"
+#include "Creatures/Creature.h"
+
+#include <algorithm>
+
+// the EcoSystem's side of a Domain: what it owns, the edits it makes to cells it does not, and creatures moving
+// from one part of the world to another. a world without a domain owns every cell and never notes an edit
+
+void CS380::EcoSystem::SetDomain(Domain* _domain, const SpawnRegion& _owned) noexcept
+{
+	mpDomain = _domain;
+	mOwned = _owned;
+	mForeignEdits.clear();
+}
+
+void CS380::EcoSystem::SetWorldFrame(unsigned _x, unsigned _y, unsigned _w, unsigned _h) noexcept
+{
+	mTerrain.SetWorldFrame(_x, _y, _w, _h);
+}
+
+bool CS380::EcoSystem::IsOwned(unsigned _x, unsigned _y) const noexcept
+{
+	if (!mOwned.mnWidth || !mOwned.mnHeight)
+		return true;
+	return _x - mOwned.mnX < mOwned.mnWidth && _y - mOwned.mnY < mOwned.mnHeight;
+}
+
+std::vector<CS380::WorldCommand>& CS380::EcoSystem::GetForeignEdits(void) noexcept
+{
+	return mForeignEdits;
+}
+
+float CS380::EcoSystem::GrazeCell(const GridPos& _p, float _val) noexcept
+{
+	const float v = mTerrain.ConsumeGrass(_p.x, _p.y, _val);
+	// the owner takes off what was eaten here, not what was asked for
+	if (v > 0.f && !IsOwned(_p.x, _p.y))
+		mForeignEdits.push_back(WorldCommand{ WorldCommand::CMD_EAT, CreatureHandle{}, _p.x, _p.y, 0, 0, v });
+	return v;
+}
+
+void CS380::EcoSystem::FertilizeCell(const GridPos& _p, float _v) noexcept
+{
+	mTerrain.AddFertilizer(_p.x, _p.y, _v);
+	if (!IsOwned(_p.x, _p.y))
+		mForeignEdits.push_back(WorldCommand{ WorldCommand::CMD_FERTILIZE, CreatureHandle{}, _p.x, _p.y, 0, 0, _v });
+}
+
+void CS380::EcoSystem::ApplyForeignEdit(const WorldCommand& _cmd) noexcept
+{
+	if (_cmd.mnX < 0 || _cmd.mnY < 0 || !IsOwned(_cmd.mnX, _cmd.mnY))
+		return;
+	if (_cmd.meType == WorldCommand::CMD_EAT)
+	{
+		const float range = mTerrain.GetGrassThreshHi() - mTerrain.GetGrassThreshLo();
+		if (range > 0.f)
+			mTerrain.ConsumeGrass(_cmd.mnX, _cmd.mnY, _cmd.mfValue / range);
+	}
+	else if (_cmd.meType == WorldCommand::CMD_FERTILIZE)
+		mTerrain.AddFertilizer(_cmd.mnX, _cmd.mnY, _cmd.mfValue);
+}
+
+void CS380::EcoSystem::OverwriteCell(unsigned _x, unsigned _y, float _grass, float _fert, float _fertLo) noexcept
+{
+	mTerrain.SetCell(_x, _y, _grass, _fert, _fertLo);
+}
+
+double CS380::EcoSystem::GetOwnedGrassRatioSum(void) const noexcept
+{
+	// the halo is a thin ring, taking it off the whole map's sum is cheaper than adding up the owned cells
+	double sum = mTerrain.GetGrassRatioSum();
+	if (!mOwned.mnWidth || !mOwned.mnHeight)
+		return sum;
+	const double hi = mTerrain.GetGrassThreshHi();
+	for (unsigned y = 0; y < mnHeight; ++y)
+	{
+		const bool rowOwned = y - mOwned.mnY < mOwned.mnHeight;
+		for (unsigned x = 0; x < mnWidth; ++x)
+		{
+			if (rowOwned && x == mOwned.mnX)
+			{
+				x = mOwned.mnX + mOwned.mnWidth - 1;
+				continue;
+			}
+			sum -= mTerrain.GetGrass(x, y) / hi;
+		}
+	}
+	return sum;
+}
+
+void CS380::EcoSystem::Emigrate(const CreatureHandle& _h, CheckpointWriter& _w)
+{
+	Creature* c = GetCreature(_h);
+	if (!c)
+		return;
+
+	CreaturePoolBase& pool = *mPools[_h.GetSpecies()];
+	_w.Pod(_h.GetSpecies());
+	pool.SaveRecord(pool.GetRow(_h.GetSlot()), _w);
+	RemoveOccupant(_h, c->GetGridPosition());
+	pool.Destroy(_h);
+}
+
+bool CS380::EcoSystem::Immigrate(CheckpointReader& _r, int _dx, int _dy)
+{
+	const unsigned species = _r.Pod<unsigned>();
+	if (_r.Failed() || species >= mPools.size())
+	{
+		_r.Fail();
+		return false;
+	}
+
+	const CreatureHandle h = mPools[species]->LoadRecord(_r);
+	Creature* c = GetCreature(h);
+	if (!c)
+		return false;
+	c->Translate(_dx, _dy);
+	AddOccupant(h, c->GetGridPosition());
+	mnPeakPops = std::max(mnPeakPops, GetCreatureCount());
+	return true;
+}
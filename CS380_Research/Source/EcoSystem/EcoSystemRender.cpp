@@ -0,0 +1,473 @@
+#include "EcoSystem/EcoSystem.h"
+#include "Data/EcoData.h"
+#include "EcoSystem/Checkpoint.h"
+#include "EcoSystem/Color.h"
+
+#include "imgui.h"
+#include "imgui_internal.h"
+
+#include <cmath>
+
+// ImGui side of the EcoSystem, kept out of EcoSystem.cpp so the headless build links without ImGui/GLFW
+
+// largest a cell gets when zoomed in, in pixels
+#define MAP_MAX_CELL 64.f
+// zoom factor per mouse wheel notch
+#define MAP_ZOOM_STEP 1.2f
+
+template<typename T>
+T min(T l, T r)
+{
+	return l < r ? l : r;
+}
+
+void CS380::EcoSystem::Init(void) noexcept
+{
+	Data::MakeTools(*this);
+}
+
+void CS380::EcoSystem::Shutdown(void) noexcept
+{
+	StopSimThread();
+	mGridRenderer.Release();
+}
+
+void CS380::EcoSystem::Update(float) noexcept
+{
+	if (mbRunEco)
+	{
+		mbFreshView = mSnapshots.Acquire();
+		RenderUI();
+	}
+	else
+	{
+		RenderSetup();
+	}
+}
+
+void CS380::EcoSystem::RenderUI(void)
+{
+	if (mbEcoTool)
+		EcoTool();
+	UpdateTools();
+
+	RenderMap();
+}
+
+void CS380::EcoSystem::RenderMap(void)
+{
+	ImGui::SetNextWindowPos(ImVec2{ 0.f,0.f }, ImGuiCond_Always);
+	ImGui::SetNextWindowSize(ImVec2{ mnWindowX, mnWindowY }, ImGuiCond_Always);
+	ImGui::Begin("Simulation Space", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse | 
+		ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoBringToFrontOnFocus | ImGuiWindowFlags_NoInputs | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoTitleBar );
+
+	RenderMenuBar();
+	RenderGrid();
+	RenderHighlights();
+
+	ImGui::End();
+}
+
+void CS380::EcoSystem::RenderGrid(void)
+{
+	UpdateMapView();
+
+	// zoomed out past a pixel per cell, each texel covers a power of two block
+	unsigned lod = 1;
+	while (mfScalar * static_cast<float>(lod) < 1.f && lod < TERRAIN_TILE_SIZE * 64u)
+		lod *= 2;
+	mGridRenderer.Resize(mnWidth, mnHeight, lod);
+
+	// only the tiles whose data this view shows changed in the new snapshot are refilled. the gui takes every
+	// snapshot the sim publishes, so the dirty bits never skip one
+	unsigned char mask = DIRTY_OCCUPANCY;
+	if (mGridRenderer.GetView() == GridRenderer::VIEW_GRASS)
+		mask |= DIRTY_GRASS;
+	else if (mGridRenderer.GetView() == GridRenderer::VIEW_FERTILIZER)
+		mask = DIRTY_FERTILIZER;
+	else if (mGridRenderer.GetView() == GridRenderer::VIEW_SCENT)
+		mask = DIRTY_SCENT;
+
+	const WorldSnapshot& view = GetView();
+	const bool all = mGridRenderer.IsStale();
+	if (all || mbFreshView)
+		for (unsigned ty = 0; ty < view.mnTilesY; ++ty)
+			for (unsigned tx = 0; tx < view.mnTilesX; ++tx)
+				if (all || (view.mTileDirty[ty * view.mnTilesX + tx] & mask))
+					RefreshMapTile(tx, ty);
+	if (all)
+		mGridRenderer.UploadRect(0, 0, mGridRenderer.GetWidth(), mGridRenderer.GetHeight());
+	mbFreshView = false;
+
+	ImRect bounds{ ImVec2{ 6.f, mfTitleBarSize + 6.f }, ImVec2{ static_cast<float>(mnWindowX) - 6.f, static_cast<float>(mnWindowY) - 6.f} };
+	ImDrawList* pDrawList = ImGui::GetWindowDrawList();
+	pDrawList->PushClipRect(bounds.Min, bounds.Max, true);
+	mGridRenderer.Draw(pDrawList, ImVec2{ mfMapOriginX, mfMapOriginY },
+		ImVec2{ mfMapOriginX + mnWidth * mfScalar, mfMapOriginY + mnHeight * mfScalar }, mfScalar);
+	pDrawList->PopClipRect();
+}
+
+void CS380::EcoSystem::UpdateMapView(void) noexcept
+{
+	ImRect bounds{ ImVec2{ 6.f, mfTitleBarSize + 6.f }, ImVec2{ static_cast<float>(mnWindowX) - 6.f, static_cast<float>(mnWindowY) - 6.f} };
+
+	ImVec2 space{ bounds.Max.x - bounds.Min.x, bounds.Max.y - bounds.Min.y };
+	space.x /= static_cast<float>(mnWidth);
+	space.y /= static_cast<float>(mnHeight);
+	const float fit = min(min(space.x, space.y), static_cast<float>(mnScale));
+	const float maxZoom = fit < MAP_MAX_CELL ? MAP_MAX_CELL / fit : 1.f;
+	mfScalar = fit * mfZoom;
+
+	// wheel zooms about the cursor, right or middle drag pans. the map window takes no inputs, so anything
+	// the other windows do not want is over the map
+	ImGuiIO& io = ImGui::GetIO();
+	if (!io.WantCaptureMouse && bounds.Contains(io.MousePos))
+	{
+		if (io.MouseWheel != 0.f)
+		{
+			const float cx = mfPanX + (io.MousePos.x - bounds.Min.x) / mfScalar;
+			const float cy = mfPanY + (io.MousePos.y - bounds.Min.y) / mfScalar;
+			mfZoom = ImClamp(mfZoom * ImPow(MAP_ZOOM_STEP, io.MouseWheel), 1.f, maxZoom);
+			mfScalar = fit * mfZoom;
+			mfPanX = cx - (io.MousePos.x - bounds.Min.x) / mfScalar;
+			mfPanY = cy - (io.MousePos.y - bounds.Min.y) / mfScalar;
+		}
+		if (ImGui::IsMouseDragging(1) || ImGui::IsMouseDragging(2))
+		{
+			mfPanX -= io.MouseDelta.x / mfScalar;
+			mfPanY -= io.MouseDelta.y / mfScalar;
+		}
+	}
+
+	// keep the world on screen, a world smaller than the view stays in the top left as before
+	const float visX = (bounds.Max.x - bounds.Min.x) / mfScalar;
+	const float visY = (bounds.Max.y - bounds.Min.y) / mfScalar;
+	mfPanX = ImClamp(mfPanX, 0.f, ImMax(0.f, static_cast<float>(mnWidth) - visX));
+	mfPanY = ImClamp(mfPanY, 0.f, ImMax(0.f, static_cast<float>(mnHeight) - visY));
+	mfMapOriginX = bounds.Min.x - mfPanX * mfScalar;
+	mfMapOriginY = bounds.Min.y - mfPanY * mfScalar;
+}
+
+void CS380::EcoSystem::RefreshMapTile(unsigned _tx, unsigned _ty)
+{
+	const unsigned lod = mGridRenderer.GetLod();
+	const unsigned bx0 = _tx * TERRAIN_TILE_SIZE / lod;
+	const unsigned by0 = _ty * TERRAIN_TILE_SIZE / lod;
+	const unsigned bx1 = min((((_tx + 1) * TERRAIN_TILE_SIZE) + lod - 1) / lod, mGridRenderer.GetWidth());
+	const unsigned by1 = min((((_ty + 1) * TERRAIN_TILE_SIZE) + lod - 1) / lod, mGridRenderer.GetHeight());
+
+	for (unsigned by = by0; by < by1; ++by)
+	{
+		unsigned int* row = mGridRenderer.Row(by);
+		for (unsigned bx = bx0; bx < bx1; ++bx)
+			row[bx] = MapTexel(bx, by, lod);
+	}
+	if (!mGridRenderer.IsStale())
+		mGridRenderer.UploadRect(bx0, by0, bx1, by1);
+}
+
+unsigned int CS380::EcoSystem::MapTexel(unsigned _bx, unsigned _by, unsigned _lod)
+{
+	static const unsigned int palette[] = {
+		PackColor(0.95f, 0.95f, 0.95f), PackColor(1.f, 0.45f, 0.f), PackColor(0.2f, 0.6f, 1.f), PackColor(0.9f, 0.2f, 0.8f)
+	};
+	constexpr unsigned species = static_cast<unsigned>(std::tuple_size_v<CreatureList>);
+
+	const unsigned x0 = _bx * _lod;
+	const unsigned y0 = _by * _lod;
+	const unsigned x1 = min(x0 + _lod, mnWidth);
+	const unsigned y1 = min(y0 + _lod, mnHeight);
+	const WorldSnapshot& view = GetView();
+
+	// block aggregates, mean for the layers, max for the crowding and the most common species
+	float layer = 0.f;
+	unsigned crowd = 0;
+	unsigned counts[species] = {};
+	unsigned int colours[species] = {};
+	for (unsigned y = y0; y < y1; ++y)
+	{
+		for (unsigned x = x0; x < x1; ++x)
+		{
+			// the thresholds only change in Terrain::Init, the sim thread never writes them while running
+			if (mGridRenderer.GetView() == GridRenderer::VIEW_GRASS)
+				layer += view.mGrass(x, y) / (mTerrain.GetGrassThreshHi() - mTerrain.GetGrassThreshLo());
+			else if (mGridRenderer.GetView() == GridRenderer::VIEW_FERTILIZER)
+			{
+				const float hi = mTerrain.GetFertilizerThreshHi();
+				layer += hi > 0.f ? view.mFertilizer(x, y) / hi : 0.f;
+				continue;
+			}
+			else if (mGridRenderer.GetView() == GridRenderer::VIEW_SCENT)
+			{
+				// unbounded, squashed into 0-1 per cell
+				const float v = view.mScent.Empty() ? 0.f : view.mScent(x, y);
+				layer += v / (1.f + v);
+				continue;
+			}
+
+			// the snapshot keeps the head of each cell, the cell counts for its species as often as it is shared
+			const CellOccupants& o = view.mOccupants(x, y);
+			const unsigned n = o.mnCrowd;
+			if (o.mHead.IsValid() && n)
+			{
+				if (!counts[o.mHead.GetSpecies()])
+					colours[o.mHead.GetSpecies()] = o.mnColor;
+				counts[o.mHead.GetSpecies()] += n;
+			}
+			crowd = n > crowd ? n : crowd;
+		}
+	}
+	layer /= static_cast<float>((x1 - x0) * (y1 - y0));
+
+	unsigned dominant = species;
+	for (unsigned i = 0; i < species; ++i)
+		if (counts[i] && (dominant == species || counts[i] > counts[dominant]))
+			dominant = i;
+
+	switch (mGridRenderer.GetView())
+	{
+	case GridRenderer::VIEW_GRASS:
+		// creature colours over the grass, as the map always looked. a cell shows whoever arrived last
+		if (_lod == 1)
+			return view.mOccupants(x0, y0).mHead.IsValid() ? view.mOccupants(x0, y0).mnColor : Terrain::GrassColor(layer);
+		return dominant < species ? colours[dominant] : Terrain::GrassColor(layer);
+	case GridRenderer::VIEW_FERTILIZER:
+		return PackColor(0.05f + 0.75f * layer, 0.03f + 0.42f * layer, 0.1f * layer);
+	case GridRenderer::VIEW_OCCUPANCY:
+		// black when empty, yellow to red for one to four or more on the busiest cell
+		return crowd ? PackColor(1.f, 1.f - static_cast<float>(min(crowd, 4u) - 1) / 3.f, 0.f) : PackColor(0.f, 0.f, 0.f);
+	case GridRenderer::VIEW_SPECIES:
+		return dominant < species ? palette[dominant % (sizeof(palette) / sizeof(*palette))] : PackColor(0.1f, 0.1f, 0.1f);
+	case GridRenderer::VIEW_SCENT:
+		return PackColor(0.05f + 0.9f * layer, 0.05f + 0.35f * layer, 0.15f + 0.1f * layer);
+	default:
+		return 0u;
+	}
+}
+
+void CS380::EcoSystem::RenderHighlights(void)
+{
+	ImRect bounds{ ImVec2{ 6.f, mfTitleBarSize + 6.f }, ImVec2{ static_cast<float>(mnWindowX) - 6.f, static_cast<float>(mnWindowY) - 6.f} };
+	ImDrawList *pDrawList = ImGui::GetWindowDrawList();
+	pDrawList->PushClipRect(bounds.Min, bounds.Max, true);
+	while (!mHighlightQueue.empty())
+	{
+		std::tuple<unsigned, unsigned, unsigned int> h = mHighlightQueue.top();
+		mHighlightQueue.pop();
+
+		ImVec2 min{ mfMapOriginX + (std::get<0>(h) * mfScalar), mfMapOriginY + (std::get<1>(h) * mfScalar) };
+		ImVec2 max{ min.x + mfScalar, min.y + mfScalar };
+		pDrawList->AddRect(min, max, std::get<2>(h), 0.f, 15, 3.f);
+	}
+	pDrawList->PopClipRect();
+}
+
+void CS380::EcoSystem::RenderMenuBar(void)
+{
+	ImGui::BeginMainMenuBar();
+	mfTitleBarSize = ImGui::GetWindowSize().y;
+	if (ImGui::BeginMenu("Windows"))
+	{
+		ImGui::PushID(99);
+		ImGui::Selectable("EcoSystem", &mbEcoTool);
+		ImGui::PopID();
+
+		for (unsigned i = 0; i < mTools.size(); ++i)
+		{
+			ImGui::PushID(static_cast<int>(i));
+			ImGui::Selectable(mTools[i]->GetName().c_str(), mTools[i]->GetOpened());
+			ImGui::PopID();
+		}
+		ImGui::EndMenu();
+	}
+	if (ImGui::BeginMenu("View"))
+	{
+		for (int i = 0; i < GridRenderer::VIEW_COUNT; ++i)
+		{
+			const GridRenderer::View v = static_cast<GridRenderer::View>(i);
+			if (ImGui::MenuItem(GridRenderer::GetViewName(v), nullptr, mGridRenderer.GetView() == v))
+				mGridRenderer.SetView(v);
+		}
+		ImGui::Separator();
+		bool lines = mGridRenderer.HasGridLines();
+		if (ImGui::MenuItem("Grid lines", nullptr, &lines))
+			mGridRenderer.SetGridLines(lines);
+		if (ImGui::MenuItem("Reset zoom"))
+		{
+			mfZoom = 1.f;
+			mfPanX = mfPanY = 0.f;
+		}
+		ImGui::EndMenu();
+	}
+	ImGui::EndMainMenuBar();
+}
+
+void CS380::EcoSystem::EcoTool(void)
+{
+	// edits land on the gui's copy straight away and reach the sim thread through the command queue
+	SimSettings& set = mUiSettings;
+	const WorldSnapshot& view = GetView();
+	ImGui::Begin("EcoSystem", &mbEcoTool);
+	if (ImGui::DragFloat("Time step", &set.mfTimeStep, 0.1f, 0.f, 100.f))
+		PushSetting(UiCommand::PARAM_TIME_STEP, set.mfTimeStep);
+	if (ImGui::DragInt("Max ticks / frame", &set.mnMaxTicksPerFrame, 1.f, 1, 1000))
+	{
+		set.mnMaxTicksPerFrame = set.mnMaxTicksPerFrame < 1 ? 1 : set.mnMaxTicksPerFrame;
+		PushSetting(UiCommand::PARAM_MAX_TICKS, static_cast<float>(set.mnMaxTicksPerFrame));
+	}
+	if (ImGui::Checkbox("Unthrottled", &set.mbUnthrottled))
+		PushSetting(UiCommand::PARAM_UNTHROTTLED, set.mbUnthrottled ? 1.f : 0.f);
+	ImGui::Text("Tick %llu, %.0f ticks / s", view.mnTick, view.mfTicksPerSecond);
+	if (ImGui::Checkbox("Batched metabolism", &set.mbBatched))
+		PushSetting(UiCommand::PARAM_BATCHED, set.mbBatched ? 1.f : 0.f);
+	if (ImGui::Checkbox("Parallel creatures", &set.mbParallel))
+		PushSetting(UiCommand::PARAM_PARALLEL, set.mbParallel ? 1.f : 0.f);
+	if (ImGui::Checkbox("Lazy terrain", &set.mbLazyTerrain))
+		PushSetting(UiCommand::PARAM_LAZY_TERRAIN, set.mbLazyTerrain ? 1.f : 0.f);
+	ImGui::Text("Scent");
+	for (unsigned sp = 0; sp < Data::SpeciesNames.size(); ++sp)
+	{
+		ImGui::SameLine();
+		ImGui::PushID(static_cast<int>(sp));
+		bool on = (set.mnScentMask >> sp) & 1u;
+		if (ImGui::Checkbox(Data::SpeciesNames[sp], &on))
+		{
+			set.mnScentMask = on ? set.mnScentMask | (1u << sp) : set.mnScentMask & ~(1u << sp);
+			PushSetting(UiCommand::PARAM_SCENT, on ? 1.f : 0.f, static_cast<int>(sp));
+		}
+		ImGui::PopID();
+	}
+
+	if (ImGui::CollapsingHeader("Evolution Models"))
+	{
+		if (ImGui::DragFloat("Mutation Epsilon: %f", &set.mfMutationEpsilon, 0.01f, 0.001f, 0.999f))
+			PushSetting(UiCommand::PARAM_MUTATION_EPSILON, set.mfMutationEpsilon);
+		for (int i = 0; i < EVOLUTION_CHART_COUNT; ++i)
+		{
+			ImGui::PushID(i);
+			if (ImGui::CollapsingHeader(Spawnables[i]))
+			{
+				EvolutionData& evo = set.mEvolution[i];
+				if (ImGui::DragFloat("Replication Thresh: %f", &evo.mfReplicationThresh, 0.01f, 0.001f, 0.999f))
+					PushSetting(UiCommand::PARAM_REPLICATION_THRESH, evo.mfReplicationThresh, i);
+				if (ImGui::DragFloat("Replication Chance: %f", &evo.mfReplicateChance, 0.01f, 0.001f, 0.999f))
+					PushSetting(UiCommand::PARAM_REPLICATE_CHANCE, evo.mfReplicateChance, i);
+				if (ImGui::DragFloat("Mutation Chance: %f", &evo.mfMutationChance, 0.01f, 0.001f, 0.999f))
+					PushSetting(UiCommand::PARAM_MUTATION_CHANCE, evo.mfMutationChance, i);
+			}
+			ImGui::PopID();
+		}
+	}
+
+	if (ImGui::DragInt("Log Window", &set.mnLogWindow, 1.f, 20, 100))
+		PushSetting(UiCommand::PARAM_LOG_WINDOW, static_cast<float>(set.mnLogWindow));
+	if (ImGui::DragFloat("Log Freq.", &set.mfLogFreq, 0.1f, 1.f, 100.f))
+		PushSetting(UiCommand::PARAM_LOG_FREQ, set.mfLogFreq);
+	if (ImGui::Button("Nuke", ImVec2{100.f,20.f}))
+	{
+		UiCommand cmd{};
+		cmd.meType = UiCommand::UI_NUKE;
+		PushCommand(cmd);
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Save Checkpoint", ImVec2{ 120.f, 20.f }))
+	{
+		UiCommand cmd{};
+		cmd.meType = UiCommand::UI_SAVE_CHECKPOINT;
+		PushCommand(cmd);
+	}
+	ImGui::End();
+}
+
+void CS380::EcoSystem::PushSetting(UiCommand::Param _p, float _v, int _index) noexcept
+{
+	UiCommand cmd{};
+	cmd.meType = UiCommand::UI_SET;
+	cmd.meParam = _p;
+	cmd.mnIndex = _index;
+	cmd.mfValue = _v;
+	PushCommand(cmd);
+}
+
+void CS380::EcoSystem::UpdateTools(void)
+{
+	for (unsigned i = 0; i < mTools.size(); ++i)
+	{
+		ImGui::PushID(static_cast<int>(i));
+		if (*mTools[i]->GetOpened())
+			mTools[i]->Render();
+		ImGui::PopID();
+	}
+}
+
+std::pair<float, float> CS380::EcoSystem::GetScreenPos(const GridPos& _p) const noexcept
+{
+	// centre of the cell under the current pan and zoom
+	return std::make_pair(mfMapOriginX + (_p.x + 0.5f) * mfScalar, mfMapOriginY + (_p.y + 0.5f) * mfScalar);
+}
+
+CS380::GridPos CS380::EcoSystem::GetHoveredCell(void) const noexcept
+{
+	const ImGuiIO& io = ImGui::GetIO();
+	const ImRect bounds{ ImVec2{ 6.f, mfTitleBarSize + 6.f }, ImVec2{ static_cast<float>(mnWindowX) - 6.f, static_cast<float>(mnWindowY) - 6.f} };
+	if (io.WantCaptureMouse || !bounds.Contains(io.MousePos) || mfScalar <= 0.f)
+		return GridPos{ -1, -1 };
+
+	const int x = static_cast<int>(std::floor((io.MousePos.x - mfMapOriginX) / mfScalar));
+	const int y = static_cast<int>(std::floor((io.MousePos.y - mfMapOriginY) / mfScalar));
+	if (static_cast<unsigned>(x) >= mnWidth || static_cast<unsigned>(y) >= mnHeight)
+		return GridPos{ -1, -1 };
+	return GridPos{ x, y };
+}
+
+void CS380::EcoSystem::RenderSetup(void) noexcept
+{
+	ImGui::Begin("Set up Simulation");
+
+	int w = static_cast<int>(mnWidth);
+	int h = static_cast<int>(mnHeight);
+
+	if (ImGui::DragInt("Width", &w, 1.f, 10, MAX_WORLD_SIDE))
+	{
+		w = w < 10 ? 10 : w > MAX_WORLD_SIDE ? MAX_WORLD_SIDE : w;
+		mnWidth = static_cast<unsigned>(w);
+	}
+	if (ImGui::DragInt("Height", &h, 1.f, 10, MAX_WORLD_SIDE))
+	{
+		h = h < 10 ? 10 : h > MAX_WORLD_SIDE ? MAX_WORLD_SIDE : h;
+		mnHeight = static_cast<unsigned>(h);
+	}
+
+	ImGui::DragFloat("Random Grass A", &mfInitialGrassA, 0.1f, 0.f, 1.f);
+	if (ImGui::DragFloat("Grass V Lo", &mfInitialGrassVLo, 0.1f, 0.f, mfInitialGrassVHi))
+		mfInitialGrassVHi = mfInitialGrassVHi < mfInitialGrassVLo ? mfInitialGrassVLo : mfInitialGrassVHi;
+	if (ImGui::DragFloat("Grass V Hi", &mfInitialGrassVHi, 0.1f, mfInitialGrassVLo, 1.f))
+		mfInitialGrassVHi = mfInitialGrassVHi < mfInitialGrassVLo ? mfInitialGrassVLo : mfInitialGrassVHi;
+
+	if (ImGui::DragFloat("Grass G Lo", &mfGRateLo, 0.001f, 0.f, mfGRateHi))
+		mfGRateHi = mfGRateHi < mfGRateLo ? mfGRateLo : mfGRateHi;
+	if (ImGui::DragFloat("Grass G Hi", &mfGRateHi, 0.001f, mfGRateLo, 0.1f))
+		mfGRateHi = mfGRateHi < mfGRateLo ? mfGRateLo : mfGRateHi;
+
+	ImGui::DragFloat("Grass Max E", &mfGrassMaxEnergy, 0.1f, 0.f, 10000.f);
+	if (ImGui::DragFloat("Fert G Lo", &mfFRateLo, 0.001f, 0.f, mfFRateHi))
+		mfFRateHi = mfFRateHi < mfFRateLo ? mfFRateLo : mfFRateHi;
+	if (ImGui::DragFloat("Fert G Hi", &mfFRateHi, 0.001f, mfFRateLo, 0.01f))
+		mfFRateHi = mfFRateHi < mfFRateLo ? mfFRateLo : mfFRateHi;
+	ImGui::DragFloat("Fert Max E", &mfFertilizerMaxEnergy, 0.1f, 0.f, 10000.f);
+	ImGui::DragFloat("Death Threshhold", &mfDeathThresh, 0.1f, 0.01f, 1.);
+
+	unsigned long long seed = mRandom.GetMasterSeed();
+	if (ImGui::InputScalar("Seed", ImGuiDataType_U64, &seed))
+		mRandom.SetMasterSeed(seed);
+	if (ImGui::Button("Begin!", ImVec2{ 120.f, 30.f }))
+	{
+		Begin();
+		StartSimThread();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Load Checkpoint", ImVec2{ 120.f, 30.f }) && LoadCheckpoint(CHECKPOINT_DEFAULT_PATH))
+		StartSimThread();
+
+	ImGui::End();
+}
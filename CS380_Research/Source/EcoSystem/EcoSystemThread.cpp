@@ -0,0 +1,323 @@
+#include "EcoSystem/EcoSystem.h"
+#include "EcoSystem/Checkpoint.h"
+#include "Data/EcoData.h"
+
+#include <algorithm>
+#include <chrono>
+
+// sim thread side of the EcoSystem, the loop, the gui commands it drains and the snapshots it publishes
+
+// seconds between ticks per second samples
+#define SIM_RATE_WINDOW 0.5f
+
+void CS380::EcoSystem::StartSimThread(void)
+{
+	if (mSimThread.joinable())
+		return;
+
+	// nothing else writes these once the thread runs, the gui edits this copy and sends the changes over
+	mUiSettings.mfTimeStep = mfTimeStep;
+	mUiSettings.mfLogFreq = mfLogFreq;
+	mUiSettings.mfMutationEpsilon = mfMutationEpsilon;
+	mUiSettings.mnMaxTicksPerFrame = static_cast<int>(mnMaxTicksPerFrame);
+	mUiSettings.mnLogWindow = static_cast<int>(mnLogWindow);
+	mUiSettings.mbBatched = mbBatchedUpdate;
+	mUiSettings.mbParallel = mbParallelUpdate;
+	mUiSettings.mbUnthrottled = mbUnthrottled;
+	mUiSettings.mbLazyTerrain = mTerrain.IsLazy();
+	mUiSettings.mnScentMask = mScent.GetSpeciesMask();
+	mUiSettings.mEvolution = mEvolution;
+
+	// every tile goes into the first snapshot, published here so the gui has one before the thread ever runs
+	mTileChanged.assign(static_cast<std::size_t>(mTerrain.GetTilesX()) * mTerrain.GetTilesY(), 1u);
+	mnPublishCount = 0;
+	PublishSnapshot(0.f);
+
+	mbStopSim.store(false, std::memory_order_relaxed);
+	mSimThread = std::thread{ &EcoSystem::SimLoop, this };
+}
+
+void CS380::EcoSystem::StopSimThread(void) noexcept
+{
+	if (!mSimThread.joinable())
+		return;
+
+	mbStopSim.store(true, std::memory_order_release);
+	mSimThread.join();
+}
+
+const CS380::WorldSnapshot& CS380::EcoSystem::GetView(void) const noexcept
+{
+	return mSnapshots.Front();
+}
+
+bool CS380::EcoSystem::PushCommand(const UiCommand& _cmd) noexcept
+{
+	return mUiCommands.Push(_cmd);
+}
+
+void CS380::EcoSystem::SimLoop(void) noexcept
+{
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point last = Clock::now();
+	Clock::time_point rateStart = last;
+	unsigned long long rateTicks = mnTickCount;
+	float rate = 0.f;
+	bool changed = false;
+
+	while (!mbStopSim.load(std::memory_order_acquire))
+	{
+		UiCommand cmd{};
+		while (mUiCommands.Pop(cmd))
+		{
+			ApplyCommand(cmd);
+			changed = true;
+		}
+
+		const Clock::time_point now = Clock::now();
+		const float dt = std::chrono::duration<float>(now - last).count();
+		last = now;
+
+		unsigned ticks = 0;
+		if (mbUnthrottled)
+		{
+			Tick();
+			ticks = 1;
+		}
+		else
+			ticks = Advance(dt);
+		changed |= ticks > 0;
+
+		const float window = std::chrono::duration<float>(now - rateStart).count();
+		if (window >= SIM_RATE_WINDOW)
+		{
+			rate = static_cast<float>(mnTickCount - rateTicks) / window;
+			rateStart = now;
+			rateTicks = mnTickCount;
+		}
+
+		// a tick that finishes while the gui still holds the last snapshot goes out with the next one
+		if (changed && mSnapshots.IsTaken())
+		{
+			PublishSnapshot(rate);
+			changed = false;
+		}
+
+		if (!ticks)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+void CS380::EcoSystem::ApplyCommand(const UiCommand& _cmd) noexcept
+{
+	const bool chart = static_cast<unsigned>(_cmd.mnIndex) < EVOLUTION_CHART_COUNT;
+	switch (_cmd.meType)
+	{
+	case UiCommand::UI_SPAWN:
+		if (chart && _cmd.mnX < mnWidth && _cmd.mnY < mnHeight && !GetGridVal(_cmd.mnX, _cmd.mnY).IsValid())
+			Data::VisitSpawnTuple(Data::SpawnVisitor{ *this, _cmd.mnX, _cmd.mnY, mEvolution[_cmd.mnIndex],
+				Traits{ _cmd.mfSize, _cmd.mfSpeed, _cmd.mfSense } }, _cmd.mnIndex);
+		break;
+	case UiCommand::UI_SPAWN_RANDOM:
+		if (chart)
+			SpawnRandom(_cmd);
+		break;
+	case UiCommand::UI_NUKE:
+		Nuke();
+		break;
+	case UiCommand::UI_SAVE_CHECKPOINT:
+		SaveCheckpoint(CHECKPOINT_DEFAULT_PATH);
+		break;
+	case UiCommand::UI_SET:
+		switch (_cmd.meParam)
+		{
+		case UiCommand::PARAM_TIME_STEP:
+			mfTimeStep = _cmd.mfValue;
+			break;
+		case UiCommand::PARAM_MAX_TICKS:
+			mnMaxTicksPerFrame = _cmd.mfValue < 1.f ? 1u : static_cast<unsigned>(_cmd.mfValue);
+			break;
+		case UiCommand::PARAM_BATCHED:
+			mbBatchedUpdate = _cmd.mfValue != 0.f;
+			break;
+		case UiCommand::PARAM_PARALLEL:
+			mbParallelUpdate = _cmd.mfValue != 0.f;
+			break;
+		case UiCommand::PARAM_UNTHROTTLED:
+			mbUnthrottled = _cmd.mfValue != 0.f;
+			mfTickAccumulator = 0.f;
+			break;
+		case UiCommand::PARAM_LAZY_TERRAIN:
+			mTerrain.SetLazy(_cmd.mfValue != 0.f);
+			break;
+		case UiCommand::PARAM_LOG_WINDOW:
+			mnLogWindow = static_cast<unsigned>(_cmd.mfValue);
+			break;
+		case UiCommand::PARAM_LOG_FREQ:
+			mfLogFreq = _cmd.mfValue;
+			break;
+		case UiCommand::PARAM_MUTATION_EPSILON:
+			mfMutationEpsilon = _cmd.mfValue;
+			break;
+		case UiCommand::PARAM_REPLICATION_THRESH:
+			if (chart)
+				mEvolution[_cmd.mnIndex].mfReplicationThresh = _cmd.mfValue;
+			break;
+		case UiCommand::PARAM_REPLICATE_CHANCE:
+			if (chart)
+				mEvolution[_cmd.mnIndex].mfReplicateChance = _cmd.mfValue;
+			break;
+		case UiCommand::PARAM_MUTATION_CHANCE:
+			if (chart)
+				mEvolution[_cmd.mnIndex].mfMutationChance = _cmd.mfValue;
+			break;
+		case UiCommand::PARAM_PROFILE:
+			if (_cmd.mfValue != 0.f && !mProfiler.IsEnabled())
+				mProfiler.ClearHistory();
+			mProfiler.SetEnabled(_cmd.mfValue != 0.f);
+			break;
+		case UiCommand::PARAM_SCENT:
+			if (static_cast<unsigned>(_cmd.mnIndex) < mPools.size())
+			{
+				const unsigned bit = 1u << _cmd.mnIndex;
+				SetScentSpecies(_cmd.mfValue != 0.f ? mScent.GetSpeciesMask() | bit : mScent.GetSpeciesMask() & ~bit);
+			}
+			break;
+		}
+		break;
+	}
+}
+
+void CS380::EcoSystem::SpawnRandom(const UiCommand& _cmd) noexcept
+{
+	Rng rng = mRandom.Stream(STREAM_TOOLS, _cmd.mnSeed);
+	const Data::TraitDistribution traits{ Traits{ _cmd.mfSize, _cmd.mfSpeed, _cmd.mfSense } };
+	if (_cmd.mfValue > 0.f)
+		Data::SpawnFill(*this, static_cast<unsigned>(_cmd.mnIndex), _cmd.mfValue, SpawnRegion{}, traits, rng);
+	else
+		Data::SpawnMany(*this, static_cast<unsigned>(_cmd.mnIndex), _cmd.mnCount, SpawnRegion{}, traits, rng);
+}
+
+void CS380::EcoSystem::PublishSnapshot(float _ticksPerSecond) noexcept
+{
+	ECO_PROFILE_SCOPE(&mProfiler, ZONE_PUBLISH);
+	WorldSnapshot& s = mSnapshots.Back();
+	const unsigned tilesX = mTerrain.GetTilesX();
+	const unsigned tilesY = mTerrain.GetTilesY();
+	if (s.mGrass.GetWidth() != mnWidth || s.mGrass.GetHeight() != mnHeight)
+	{
+		s.mGrass.Resize(mnWidth, mnHeight, 0.f);
+		s.mFertilizer.Resize(mnWidth, mnHeight, 0.f);
+		s.mFertilizerLo.Resize(mnWidth, mnHeight, 0.f);
+		s.mOccupants.Resize(mnWidth, mnHeight, CellOccupants{ CreatureHandle{}, 0u, 0u });
+		s.mTileGen.assign(static_cast<std::size_t>(tilesX) * tilesY, 0u);
+	}
+
+	// a slot comes back two publishes stale, only the tiles that changed since it was last filled are copied
+	++mnPublishCount;
+	s.mTileDirty.assign(static_cast<std::size_t>(tilesX) * tilesY, 0);
+	for (unsigned ty = 0; ty < tilesY; ++ty)
+	{
+		for (unsigned tx = 0; tx < tilesX; ++tx)
+		{
+			const std::size_t i = static_cast<std::size_t>(ty) * tilesX + tx;
+			if (const unsigned char bits = mTerrain.GetTileDirty(tx, ty))
+			{
+				mTileChanged[i] = mnPublishCount;
+				s.mTileDirty[i] = bits;
+			}
+			if (s.mTileGen[i] < mTileChanged[i])
+			{
+				CaptureTile(s, tx, ty);
+				s.mTileGen[i] = mTileChanged[i];
+			}
+		}
+	}
+	mTerrain.ClearDirty();
+
+	// the scent spreads over the whole map every tick, there is no tile of it that stays put
+	if (mScent.GetSpeciesMask())
+	{
+		if (s.mScent.GetWidth() != mnWidth || s.mScent.GetHeight() != mnHeight)
+			s.mScent.Resize(mnWidth, mnHeight);
+		s.mScent.Fill(0.f);
+		for (unsigned sp = 0; sp < mPools.size(); ++sp)
+		{
+			if (!mScent.IsTracked(sp))
+				continue;
+			const Grid<float>& layer = mScent.GetLayer(sp);
+			for (unsigned y = 0; y < mnHeight; ++y)
+			{
+				const float* from = layer.Row(y);
+				float* to = s.mScent.Row(y);
+				for (unsigned x = 0; x < mnWidth; ++x)
+					to[x] += from[x];
+			}
+		}
+		for (unsigned char& bits : s.mTileDirty)
+			bits |= DIRTY_SCENT;
+	}
+	else if (!s.mScent.Empty())
+	{
+		Grid<float>{}.Swap(s.mScent);
+		for (unsigned char& bits : s.mTileDirty)
+			bits |= DIRTY_SCENT;
+	}
+
+	s.mnTick = mnTickCount;
+	s.mfTicksPerSecond = _ticksPerSecond;
+	s.mnPeakPops = mnPeakPops;
+	s.mnWidth = mnWidth;
+	s.mnHeight = mnHeight;
+	s.mnTilesX = tilesX;
+	s.mnTilesY = tilesY;
+
+	s.mCreatures.clear();
+	ForEachCreature([&s](Creature* _c, const CreatureHandle& _h)
+	{
+		const GridPos p = _c->GetGridPosition();
+		const std::pair<float, float> e = _c->GetEnergy();
+		s.mCreatures.push_back(CreatureView{ _h, _c->GetUniqueID(), p.x, p.y, _c->GetColor(), e.first, e.second,
+			_c->GetSize(), _c->GetSpeed(), _c->GetSense(), _c->GetRepChance(), _c->GetMutChance() });
+	});
+	s.mLogs = mLogs;
+	s.mbTelemetry = mTelemetry.IsRunning();
+	s.mnTelemetryWritten = mTelemetry.GetWrittenRows();
+	s.mnTelemetryLost = mTelemetry.GetDroppedRows() + mTelemetry.GetFailedRows();
+	if (mProfiler.IsEnabled())
+		s.mProfile = mProfiler.GetHistory();
+	else
+		s.mProfile.Clear();
+
+	mSnapshots.Publish();
+}
+
+void CS380::EcoSystem::CaptureTile(WorldSnapshot& _s, unsigned _tx, unsigned _ty) noexcept
+{
+	const unsigned x0 = _tx * TERRAIN_TILE_SIZE;
+	const unsigned y0 = _ty * TERRAIN_TILE_SIZE;
+	const unsigned x1 = std::min(x0 + TERRAIN_TILE_SIZE, mnWidth);
+	const unsigned y1 = std::min(y0 + TERRAIN_TILE_SIZE, mnHeight);
+	const ChunkedGrid<CreatureHandle>& space = mTerrain.GetSpaceLayer();
+
+	for (unsigned y = y0; y < y1; ++y)
+	{
+		for (unsigned x = x0; x < x1; ++x)
+		{
+			_s.mGrass(x, y) = mTerrain.GetGrass(x, y);
+			_s.mFertilizer(x, y) = mTerrain.GetFertilizer(x, y);
+			_s.mFertilizerLo(x, y) = mTerrain.GetFertilizerRatio(x, y);
+
+			// an empty cell in a chunk the snapshot never needed stays unallocated
+			const CreatureHandle head = space(x, y);
+			CellOccupants* o = head.IsValid() ? &_s.mOccupants.Touch(x, y) : _s.mOccupants.Find(x, y);
+			if (!o)
+				continue;
+			const Creature* c = GetCreature(head);
+			unsigned n = 0;
+			for (CreatureHandle h = head; h.IsValid(); h = NextInCell(h))
+				++n;
+			*o = CellOccupants{ head, c ? c->GetColor() : 0u, n };
+		}
+	}
+}
@@ -0,0 +1,105 @@
+#include "EcoSystem/Ensemble.h"
+#include "EcoSystem/EcoSystem.h"
+#include "Data/EcoData.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+CS380::Ensemble::Ensemble(unsigned _threads) noexcept
+	: mMembers{}, mnThreads{ _threads }
+{
+	if (!mnThreads)
+		mnThreads = std::thread::hardware_concurrency();
+	if (!mnThreads)
+		mnThreads = 1;
+}
+
+void CS380::Ensemble::Add(const EnsembleMember& _member)
+{
+	mMembers.push_back(_member);
+}
+
+unsigned CS380::Ensemble::GetSize(void) const noexcept
+{
+	return static_cast<unsigned>(mMembers.size());
+}
+
+const CS380::EnsembleMember& CS380::Ensemble::GetMember(unsigned _i) const noexcept
+{
+	return mMembers[_i];
+}
+
+std::vector<CS380::EnsembleResult> CS380::Ensemble::Run(const DoneFunc& _onDone)
+{
+	std::vector<EnsembleResult> results(mMembers.size());
+	std::atomic<unsigned> next{ 0 };
+	std::mutex doneMutex;
+
+	auto runner = [&]
+	{
+		for (unsigned i = next.fetch_add(1); i < mMembers.size(); i = next.fetch_add(1))
+		{
+			results[i] = RunMember(mMembers[i]);
+			if (_onDone)
+			{
+				std::lock_guard<std::mutex> lock{ doneMutex };
+				_onDone(i, results[i]);
+			}
+		}
+	};
+
+	// plain threads rather than a ThreadPool, a world's terrain finds its search scratch by
+	// ThreadPool::GetCurrentWorker and has to see 0 outside of its own pool
+	const unsigned threads = std::min(mnThreads, static_cast<unsigned>(mMembers.size()));
+	std::vector<std::thread> workers;
+	for (unsigned i = 1; i < threads; ++i)
+		workers.emplace_back(runner);
+	runner();
+	for (auto& t : workers)
+		t.join();
+
+	return results;
+}
+
+CS380::EnsembleResult CS380::Ensemble::RunMember(const EnsembleMember& _member)
+{
+	// on the heap, a world is too big for a worker's stack to be comfortable with
+	std::unique_ptr<EcoSystem> eco = std::make_unique<EcoSystem>();
+	eco->SetWorkerCount(1);
+	eco->GetRandom().SetMasterSeed(_member.mnSeed);
+	eco->SetBatchedUpdate(_member.mbBatched);
+	eco->SetLazyTerrain(_member.mbLazyTerrain);
+	eco->SetScentSpecies(_member.mnScentMask);
+	eco->SetPathBudget(_member.mnPathBudget);
+	eco->SetWorldSize(_member.mnWidth, _member.mnHeight);
+	eco->SetRateNoise(_member.mfRateNoise);
+	eco->SetGrassParams(_member.mfGrassA, 0.025f, 1.0f, _member.mfGrassRateLo, _member.mfGrassRateHi, 300.f);
+	eco->SetMutationEpsilon(_member.mfMutationEpsilon);
+	for (unsigned i = 0; i < _member.mEvolution.size(); ++i)
+		eco->SetEvolutionData(i, _member.mEvolution[i]);
+	eco->Begin();
+	for (unsigned s = 0; s < _member.mPopulation.size(); ++s)
+		eco->Populate(s, _member.mPopulation[s]);
+	for (unsigned s = 0; s < _member.mFill.size(); ++s)
+		if (_member.mFill[s] > 0.f)
+			eco->PopulateFill(s, _member.mFill[s]);
+
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned t = 0; t < _member.mnTicks; ++t)
+		eco->Tick();
+
+	EnsembleResult r;
+	r.mfSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	r.mnSeed = _member.mnSeed;
+	r.mnTicks = eco->GetTickCount();
+	r.mnCreatures = eco->GetCreatureCount();
+	r.mnPeakPops = eco->mnPeakPops;
+	r.mfGrassDensity = eco->GetTerrain().GetGrassRatioSum();
+	for (unsigned s = 0; s < std::tuple_size_v<CreatureList>; ++s)
+		r.mSpecies.push_back(eco->GetPool(s).GetStats());
+	return r;
+}
@@ -0,0 +1,278 @@
+#include "EcoSystem/FlowField.h"
+#include "EcoSystem/Checkpoint.h"
+#include "EcoSystem/PathArena.h"
+#include "EcoSystem/Terrain.h"
+
+#include <algorithm>
+#include <limits>
+
+#define FLOW_FIELD_SIDE (2 * FLOW_FIELD_RADIUS + 1)
+#define SQRT_2 1.41421356237f
+
+namespace
+{
+	struct OpenGreater
+	{
+		bool operator()(const std::pair<float, unsigned>& _a, const std::pair<float, unsigned>& _b) const noexcept
+		{
+			return _a.first > _b.first;
+		}
+	};
+}
+
+CS380::FlowFieldCache::FlowFieldCache(void) noexcept
+	: mEntries{}, mLookup{}, mFields{}, mOpen{}, mnWidth{ 0 }, mnHeight{ 0 }, mnClock{ 0 }, mnHits{ 0 }, mnMisses{ 0 }
+{
+}
+
+void CS380::FlowFieldCache::Reset(unsigned _w, unsigned _h) noexcept
+{
+	mnWidth = _w;
+	mnHeight = _h;
+	mEntries.clear();
+	mLookup.clear();
+	mFields.resize(static_cast<std::size_t>(FLOW_FIELD_CAPACITY) * FLOW_FIELD_SIDE * FLOW_FIELD_SIDE);
+	mOpen.reserve(FLOW_FIELD_SIDE * FLOW_FIELD_SIDE);
+	mnClock = mnHits = mnMisses = 0;
+}
+
+bool CS380::FlowFieldCache::PeekPath(const GridPos& _src, const GridPos& _dest, PathArena& _arena, PathCursor& _out) const noexcept
+{
+	const Entry* e = Find(_src, _dest);
+	if (!e)
+		return false;
+
+	// walked once to size the path and once more to write it, the field steps the same way both times
+	const float* field = mFields.data() + static_cast<std::size_t>(e - mEntries.data()) * FLOW_FIELD_SIDE * FLOW_FIELD_SIDE;
+	int x = _src.x;
+	int y = _src.y;
+	unsigned steps = 0;
+	for (; x != _dest.x || y != _dest.y; ++steps)
+		if (!Step(*e, field, x, y))
+			return false;
+
+	PathCursor path = _arena.Allocate(_src, steps);
+	if (!path.mnLeft)
+		return false;
+	PathWriter w{ _arena, path };
+	x = _src.x;
+	y = _src.y;
+	while (x != _dest.x || y != _dest.y)
+	{
+		const int px = x;
+		const int py = y;
+		Step(*e, field, x, y);
+		w.Push(PathDir(x - px, y - py));
+	}
+	_out = path;
+	return true;
+}
+
+bool CS380::FlowFieldCache::GetNextStep(const GridPos& _src, const GridPos& _dest, GridPos& _out) noexcept
+{
+	NoteRequest(_src, _dest);
+	const Entry* e = Find(_src, _dest);
+	if (!e || _src == _dest)
+		return false;
+
+	const float* field = mFields.data() + static_cast<std::size_t>(e - mEntries.data()) * FLOW_FIELD_SIDE * FLOW_FIELD_SIDE;
+	int x = _src.x;
+	int y = _src.y;
+	if (!Step(*e, field, x, y))
+		return false;
+	_out = GridPos{ x, y };
+	return true;
+}
+
+unsigned long long CS380::FlowFieldCache::GetHits(void) const noexcept
+{
+	return mnHits;
+}
+
+unsigned long long CS380::FlowFieldCache::GetMisses(void) const noexcept
+{
+	return mnMisses;
+}
+
+void CS380::FlowFieldCache::Save(CheckpointWriter& _w) const
+{
+	_w.Pod(mnWidth);
+	_w.Pod(mnHeight);
+	_w.Pod(mnClock);
+	_w.Pod(mnHits);
+	_w.Pod(mnMisses);
+	_w.Vector(mEntries);
+}
+
+bool CS380::FlowFieldCache::Load(CheckpointReader& _r, unsigned _w, unsigned _h)
+{
+	Reset(_w, _h);
+	if (_r.Pod<unsigned>() != _w || _r.Pod<unsigned>() != _h)
+		_r.Fail();
+	_r.Pod(mnClock);
+	_r.Pod(mnHits);
+	_r.Pod(mnMisses);
+	_r.Vector(mEntries);
+	if (_r.Failed() || mEntries.size() > FLOW_FIELD_CAPACITY)
+	{
+		_r.Fail();
+		Reset(_w, _h);
+		return false;
+	}
+
+	// a field only depends on its destination, so a rebuild gives back exactly what was there. the window it
+	// works out has to be the one saved, an entry not built yet has none
+	const std::uint64_t cells = static_cast<std::uint64_t>(mnWidth) * mnHeight;
+	for (unsigned i = 0; i < mEntries.size(); ++i)
+	{
+		const Entry saved = mEntries[i];
+		bool ok = saved.mnDest < cells && mLookup.emplace(saved.mnDest, i).second;
+		if (ok && saved.mbBuilt)
+		{
+			Build(i, GridPos{ static_cast<int>(saved.mnDest % mnWidth), static_cast<int>(saved.mnDest / mnWidth) });
+			const Entry& e = mEntries[i];
+			ok = e.mnX0 == saved.mnX0 && e.mnY0 == saved.mnY0 && e.mnW == saved.mnW && e.mnH == saved.mnH;
+		}
+		else if (ok)
+			ok = !saved.mnX0 && !saved.mnY0 && !saved.mnW && !saved.mnH;
+		if (!ok)
+		{
+			_r.Fail();
+			Reset(_w, _h);
+			return false;
+		}
+	}
+	return true;
+}
+
+void CS380::FlowFieldCache::NoteRequest(const GridPos& _src, const GridPos& _dest) noexcept
+{
+	if (mFields.empty() || static_cast<unsigned>(_dest.x) >= mnWidth || static_cast<unsigned>(_dest.y) >= mnHeight)
+		return;
+
+	const unsigned key = static_cast<unsigned>(_dest.y) * mnWidth + static_cast<unsigned>(_dest.x);
+	auto it = mLookup.find(key);
+	unsigned slot = 0;
+	if (it == mLookup.end())
+	{
+		if (mEntries.size() < FLOW_FIELD_CAPACITY)
+		{
+			slot = static_cast<unsigned>(mEntries.size());
+			mEntries.push_back(Entry{});
+		}
+		else
+		{
+			// evict the least recently asked for destination
+			for (unsigned i = 1; i < mEntries.size(); ++i)
+				if (mEntries[i].mnLastUse < mEntries[slot].mnLastUse)
+					slot = i;
+			mLookup.erase(mEntries[slot].mnDest);
+		}
+		mEntries[slot] = Entry{ key, 0, 0, 0, 0, 0, 0, false };
+		mLookup.emplace(key, slot);
+	}
+	else
+		slot = it->second;
+
+	Entry& e = mEntries[slot];
+	e.mnLastUse = ++mnClock;
+	if (!e.mbBuilt && ++e.mnRequests >= FLOW_FIELD_MIN_REQUESTS)
+		Build(slot, _dest);
+
+	if (Covers(e, _src))
+		++mnHits;
+	else
+		++mnMisses;
+}
+
+const CS380::FlowFieldCache::Entry* CS380::FlowFieldCache::Find(const GridPos& _src, const GridPos& _dest) const noexcept
+{
+	if (mFields.empty() || static_cast<unsigned>(_dest.x) >= mnWidth || static_cast<unsigned>(_dest.y) >= mnHeight)
+		return nullptr;
+
+	auto it = mLookup.find(static_cast<unsigned>(_dest.y) * mnWidth + static_cast<unsigned>(_dest.x));
+	if (it == mLookup.end())
+		return nullptr;
+
+	const Entry& e = mEntries[it->second];
+	return Covers(e, _src) ? &e : nullptr;
+}
+
+bool CS380::FlowFieldCache::Covers(const Entry& _e, const GridPos& _src) const noexcept
+{
+	return _e.mbBuilt && _src.x >= _e.mnX0 && _src.y >= _e.mnY0 &&
+		static_cast<unsigned>(_src.x - _e.mnX0) < _e.mnW && static_cast<unsigned>(_src.y - _e.mnY0) < _e.mnH;
+}
+
+void CS380::FlowFieldCache::Build(unsigned _slot, const GridPos& _dest) noexcept
+{
+	Entry& e = mEntries[_slot];
+	e.mnX0 = std::max(0, _dest.x - FLOW_FIELD_RADIUS);
+	e.mnY0 = std::max(0, _dest.y - FLOW_FIELD_RADIUS);
+	e.mnW = static_cast<unsigned>(std::min(static_cast<int>(mnWidth), _dest.x + FLOW_FIELD_RADIUS + 1) - e.mnX0);
+	e.mnH = static_cast<unsigned>(std::min(static_cast<int>(mnHeight), _dest.y + FLOW_FIELD_RADIUS + 1) - e.mnY0);
+
+	float* field = mFields.data() + static_cast<std::size_t>(_slot) * FLOW_FIELD_SIDE * FLOW_FIELD_SIDE;
+	std::fill(field, field + FLOW_FIELD_SIDE * FLOW_FIELD_SIDE, std::numeric_limits<float>::infinity());
+
+	// reverse dijkstra from the destination with the same step costs as Terrain::GetShortestPath
+	const unsigned start = static_cast<unsigned>(_dest.y - e.mnY0) * FLOW_FIELD_SIDE + static_cast<unsigned>(_dest.x - e.mnX0);
+	field[start] = 0.f;
+	mOpen.clear();
+	mOpen.emplace_back(0.f, start);
+	while (!mOpen.empty())
+	{
+		std::pop_heap(mOpen.begin(), mOpen.end(), OpenGreater{});
+		auto cur = mOpen.back();
+		mOpen.pop_back();
+		if (cur.first > field[cur.second])
+			continue;
+
+		const int cx = static_cast<int>(cur.second % FLOW_FIELD_SIDE);
+		const int cy = static_cast<int>(cur.second / FLOW_FIELD_SIDE);
+		for (int d = 0; d < 8; ++d)
+		{
+			const int nx = cx + NeighbourDX[d];
+			const int ny = cy + NeighbourDY[d];
+			if (static_cast<unsigned>(nx) >= e.mnW || static_cast<unsigned>(ny) >= e.mnH)
+				continue;
+			const unsigned n = static_cast<unsigned>(ny) * FLOW_FIELD_SIDE + static_cast<unsigned>(nx);
+			const float t = cur.first + ((NeighbourDX[d] && NeighbourDY[d]) ? SQRT_2 : 1.f);
+			if (t >= field[n])
+				continue;
+			field[n] = t;
+			mOpen.emplace_back(t, n);
+			std::push_heap(mOpen.begin(), mOpen.end(), OpenGreater{});
+		}
+	}
+	e.mbBuilt = true;
+}
+
+bool CS380::FlowFieldCache::Step(const Entry& _e, const float* _field, int& _x, int& _y) const noexcept
+{
+	const int lx = _x - _e.mnX0;
+	const int ly = _y - _e.mnY0;
+	// the neighbour on a shortest route is the one whose distance plus step cost is lowest
+	const float here = _field[ly * FLOW_FIELD_SIDE + lx];
+	float best = std::numeric_limits<float>::infinity();
+	int bestD = -1;
+	for (int d = 0; d < 8; ++d)
+	{
+		const int nx = lx + NeighbourDX[d];
+		const int ny = ly + NeighbourDY[d];
+		if (static_cast<unsigned>(nx) >= _e.mnW || static_cast<unsigned>(ny) >= _e.mnH)
+			continue;
+		const float v = _field[ny * FLOW_FIELD_SIDE + nx];
+		const float c = v + ((NeighbourDX[d] && NeighbourDY[d]) ? SQRT_2 : 1.f);
+		if (v < here && c < best)
+		{
+			best = c;
+			bestD = d;
+		}
+	}
+	if (bestD < 0)
+		return false;
+	_x += NeighbourDX[bestD];
+	_y += NeighbourDY[bestD];
+	return true;
+}
@@ -0,0 +1,125 @@
+#include "EcoSystem/GridRenderer.h"
+#include "EcoSystem/Color.h"
+
+#include "imgui.h"
+
+#include <GL/gl3w.h>
+
+#include <stdint.h>
+
+namespace
+{
+	GLuint MakeTexture(GLint _filter, GLint _wrap) noexcept
+	{
+		GLuint tex = 0;
+		glGenTextures(1, &tex);
+		glBindTexture(GL_TEXTURE_2D, tex);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _wrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _wrap);
+		return tex;
+	}
+
+	ImTextureID ToTextureID(unsigned _tex) noexcept
+	{
+		return reinterpret_cast<ImTextureID>(static_cast<intptr_t>(_tex));
+	}
+}
+
+const char* CS380::GridRenderer::GetViewName(View _v) noexcept
+{
+	static const char* names[VIEW_COUNT] = { "Grass", "Fertilizer", "Occupancy", "Species", "Scent" };
+	return _v < VIEW_COUNT ? names[_v] : "";
+}
+
+void CS380::GridRenderer::Resize(unsigned _w, unsigned _h, unsigned _lod)
+{
+	_lod = _lod ? _lod : 1;
+	if (_w == mnCellsX && _h == mnCellsY && _lod == mnLod && !mPixels.empty())
+		return;
+
+	mnCellsX = _w;
+	mnCellsY = _h;
+	mnLod = _lod;
+	mnWidth = (_w + _lod - 1) / _lod;
+	mnHeight = (_h + _lod - 1) / _lod;
+	mPixels.assign(static_cast<std::size_t>(mnWidth) * mnHeight, 0u);
+	mbStale = true;
+}
+
+void CS380::GridRenderer::UploadRect(unsigned _x0, unsigned _y0, unsigned _x1, unsigned _y1) noexcept
+{
+	if (!mnWidth || !mnHeight || _x0 >= _x1 || _y0 >= _y1)
+		return;
+
+	GLint last = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &last);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	if (!mnTexture)
+		mnTexture = MakeTexture(GL_NEAREST, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, mnTexture);
+	if (mnTexWidth != mnWidth || mnTexHeight != mnHeight)
+	{
+		// new storage takes the whole buffer, the owner refills everything after a resize anyway
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(mnWidth), static_cast<GLsizei>(mnHeight), 0, GL_RGBA, GL_UNSIGNED_BYTE, mPixels.data());
+		mnTexWidth = mnWidth;
+		mnTexHeight = mnHeight;
+	}
+	else
+	{
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(mnWidth));
+		glTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(_x0), static_cast<GLint>(_y0),
+			static_cast<GLsizei>(_x1 - _x0), static_cast<GLsizei>(_y1 - _y0), GL_RGBA, GL_UNSIGNED_BYTE, Row(_y0) + _x0);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+
+	if (_x0 == 0 && _y0 == 0 && _x1 >= mnWidth && _y1 >= mnHeight)
+		mbStale = false;
+	glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(last));
+}
+
+void CS380::GridRenderer::Draw(ImDrawList* _pDrawList, const ImVec2& _min, const ImVec2& _max, float _cell) noexcept
+{
+	if (!mnTexture)
+		return;
+
+	_pDrawList->AddImage(ToTextureID(mnTexture), _min, _max);
+	if (!mbGridLines || _cell < static_cast<float>(GRID_LINE_MIN_CELL))
+		return;
+
+	// one cell's worth of line, its top and left edges a texel wide so they stay about a pixel on screen
+	const unsigned tileSize = static_cast<unsigned>(_cell + 0.5f);
+	if (tileSize != mnLineTile)
+	{
+		GLint last = 0;
+		glGetIntegerv(GL_TEXTURE_BINDING_2D, &last);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+		std::vector<unsigned int> tile(static_cast<std::size_t>(tileSize) * tileSize, 0u);
+		for (unsigned i = 0; i < tileSize; ++i)
+			tile[i] = tile[static_cast<std::size_t>(i) * tileSize] = PackColor(0.5f, 0.5f, 0.5f, 0.1f);
+		if (!mnLineTexture)
+			mnLineTexture = MakeTexture(GL_NEAREST, GL_REPEAT);
+		glBindTexture(GL_TEXTURE_2D, mnLineTexture);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(tileSize), static_cast<GLsizei>(tileSize), 0, GL_RGBA, GL_UNSIGNED_BYTE, tile.data());
+		mnLineTile = tileSize;
+
+		glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(last));
+	}
+
+	_pDrawList->AddImage(ToTextureID(mnLineTexture), _min, _max, ImVec2{ 0.f, 0.f },
+		ImVec2{ static_cast<float>(mnCellsX), static_cast<float>(mnCellsY) });
+}
+
+void CS380::GridRenderer::Release(void) noexcept
+{
+	if (mnTexture)
+		glDeleteTextures(1, &mnTexture);
+	if (mnLineTexture)
+		glDeleteTextures(1, &mnLineTexture);
+	mnTexture = mnLineTexture = 0;
+	mnTexWidth = mnTexHeight = mnLineTile = 0;
+	mbStale = true;
+}
@@ -0,0 +1,102 @@
+#include "EcoSystem/MaxPyramid.h"
+
+#include <limits>
+
+CS380::MaxPyramid::MaxPyramid(void) noexcept
+	: mLevels{}
+{
+}
+
+void CS380::MaxPyramid::Resize(unsigned _w, unsigned _h) noexcept
+{
+	mLevels.clear();
+	mLevels.emplace_back();
+	mLevels.back().Reshape(_w, _h);
+	while (_w > 1 || _h > 1)
+	{
+		_w = (_w + 1) / 2;
+		_h = (_h + 1) / 2;
+		mLevels.emplace_back();
+		mLevels.back().Reshape(_w, _h);
+	}
+}
+
+CS380::Grid<float>& CS380::MaxPyramid::GetBase(void) noexcept
+{
+	return mLevels.front();
+}
+
+void CS380::MaxPyramid::RebuildLevels(unsigned _from) noexcept
+{
+	for (unsigned l = _from; l < mLevels.size(); ++l)
+	{
+		Grid<float>& lvl = mLevels[l];
+		for (unsigned y = 0; y < lvl.GetHeight(); ++y)
+		{
+			float* row = lvl.Row(y);
+			for (unsigned x = 0; x < lvl.GetWidth(); ++x)
+				row[x] = Reduce(l, x, y);
+		}
+	}
+}
+
+void CS380::MaxPyramid::RebuildRect(unsigned _x0, unsigned _y0, unsigned _x1, unsigned _y1, unsigned _levels) noexcept
+{
+	if (_x0 >= _x1 || _y0 >= _y1)
+		return;
+
+	// inclusive bounds, halved each level
+	unsigned x1 = _x1 - 1;
+	unsigned y1 = _y1 - 1;
+	for (unsigned l = 1; l < mLevels.size() && l <= _levels; ++l)
+	{
+		_x0 >>= 1;
+		_y0 >>= 1;
+		x1 >>= 1;
+		y1 >>= 1;
+		Grid<float>& lvl = mLevels[l];
+		for (unsigned y = _y0; y <= y1; ++y)
+		{
+			float* row = lvl.Row(y);
+			for (unsigned x = _x0; x <= x1; ++x)
+				row[x] = Reduce(l, x, y);
+		}
+	}
+}
+
+void CS380::MaxPyramid::Set(unsigned _x, unsigned _y, float _v) noexcept
+{
+	mLevels.front()(_x, _y) = _v;
+	for (unsigned l = 1; l < mLevels.size(); ++l)
+	{
+		_x >>= 1;
+		_y >>= 1;
+		float v = Reduce(l, _x, _y);
+		// nothing above changes once a level stays the same
+		if (mLevels[l](_x, _y) == v)
+			break;
+		mLevels[l](_x, _y) = v;
+	}
+}
+
+unsigned CS380::MaxPyramid::GetLevelCount(void) const noexcept
+{
+	return static_cast<unsigned>(mLevels.size());
+}
+
+const CS380::Grid<float>& CS380::MaxPyramid::GetLevel(unsigned _level) const noexcept
+{
+	return mLevels[_level];
+}
+
+float CS380::MaxPyramid::Reduce(unsigned _level, unsigned _x, unsigned _y) const noexcept
+{
+	const Grid<float>& below = mLevels[_level - 1];
+	const unsigned x0 = _x * 2;
+	const unsigned y0 = _y * 2;
+	float v = -std::numeric_limits<float>::infinity();
+	for (unsigned j = y0; j < y0 + 2 && j < below.GetHeight(); ++j)
+		for (unsigned i = x0; i < x0 + 2 && i < below.GetWidth(); ++i)
+			v = below(i, j) > v ? below(i, j) : v;
+	return v;
+}
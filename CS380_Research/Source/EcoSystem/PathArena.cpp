@@ -0,0 +1,186 @@
+#include "EcoSystem/PathArena.h"
+#include "EcoSystem/Terrain.h"
+#include "EcoSystem/ThreadPool.h"
+
+#include <algorithm>
+
+CS380::PathArena::PathArena(void) noexcept
+	: mWorkers{}
+{
+	ReserveWorkers(1);
+}
+
+void CS380::PathArena::ReserveWorkers(unsigned _n)
+{
+	_n = std::min(_n, 1u << (32 - PATH_WORKER_SHIFT));
+	while (mWorkers.size() < _n)
+	{
+		// the run table is made once, so reading blocks never races a worker making a run
+		mWorkers.emplace_back();
+		Worker& w = mWorkers.back();
+		w.mChunks = std::make_unique<std::unique_ptr<Block[]>[]>(PATH_MAX_CHUNKS);
+		w.mnMade = 0;
+		w.mnLive = 0;
+	}
+}
+
+CS380::PathCursor CS380::PathArena::Allocate(const GridPos& _from, unsigned _steps) noexcept
+{
+	PathCursor c{ PATH_NONE, 0, 0, _from.x, _from.y, _from.x, _from.y };
+	if (!_steps)
+		return c;
+
+	// back to front, so every block is made with its next link already known
+	std::uint32_t first = PATH_NONE;
+	for (unsigned n = (_steps + PATH_BLOCK_STEPS - 1) / PATH_BLOCK_STEPS; n > 0; --n)
+	{
+		const std::uint32_t b = NewBlock(first);
+		if (b == PATH_NONE)
+		{
+			for (std::uint32_t f = first; f != PATH_NONE; )
+			{
+				const std::uint32_t next = At(f).mnNext;
+				FreeBlock(f);
+				f = next;
+			}
+			return c;
+		}
+		first = b;
+	}
+	c.mnBlock = first;
+	c.mnLeft = _steps;
+	return c;
+}
+
+void CS380::PathArena::Advance(PathCursor& _c) noexcept
+{
+	const unsigned d = Peek(_c);
+	_c.mnAtX += NeighbourDX[d];
+	_c.mnAtY += NeighbourDY[d];
+	if (!--_c.mnLeft)
+	{
+		FreeBlock(_c.mnBlock);
+		_c.mnBlock = PATH_NONE;
+		_c.mnStep = 0;
+	}
+	else if (++_c.mnStep == PATH_BLOCK_STEPS)
+	{
+		const std::uint32_t next = At(_c.mnBlock).mnNext;
+		FreeBlock(_c.mnBlock);
+		_c.mnBlock = next;
+		_c.mnStep = 0;
+	}
+}
+
+void CS380::PathArena::Release(PathCursor& _c) noexcept
+{
+	if (!_c.mnLeft)
+		return;
+	for (std::uint32_t b = _c.mnBlock; b != PATH_NONE; )
+	{
+		const std::uint32_t next = At(b).mnNext;
+		FreeBlock(b);
+		b = next;
+	}
+	_c.mnBlock = PATH_NONE;
+	_c.mnStep = 0;
+	_c.mnLeft = 0;
+	_c.mnEndX = _c.mnAtX;
+	_c.mnEndY = _c.mnAtY;
+}
+
+void CS380::PathArena::Balance(void)
+{
+	if (mWorkers.size() < 2)
+		return;
+
+	std::size_t total = 0;
+	for (const Worker& w : mWorkers)
+		total += w.mFree.size();
+	const std::size_t share = total / mWorkers.size();
+
+	// only the surplus moves, what the last tick put out of balance
+	std::size_t to = 0;
+	for (Worker& from : mWorkers)
+	{
+		while (from.mFree.size() > share + 1)
+		{
+			while (to < mWorkers.size() && mWorkers[to].mFree.size() >= share)
+				++to;
+			if (to == mWorkers.size())
+				return;
+			Worker& dst = mWorkers[to];
+			const std::size_t n = std::min(from.mFree.size() - share, share - dst.mFree.size());
+			dst.mFree.insert(dst.mFree.end(), from.mFree.end() - n, from.mFree.end());
+			from.mFree.resize(from.mFree.size() - n);
+		}
+	}
+}
+
+std::size_t CS380::PathArena::GetLiveBlocks(void) const noexcept
+{
+	long long live = 0;
+	for (const Worker& w : mWorkers)
+		live += w.mnLive;
+	return static_cast<std::size_t>(std::max(live, 0ll));
+}
+
+std::size_t CS380::PathArena::GetReservedBytes(void) const noexcept
+{
+	std::size_t chunks = 0;
+	for (const Worker& w : mWorkers)
+		chunks += (w.mnMade + PATH_CHUNK_BLOCKS - 1) / PATH_CHUNK_BLOCKS;
+	return chunks * PATH_CHUNK_BLOCKS * sizeof(Block);
+}
+
+std::uint32_t CS380::PathArena::NewBlock(std::uint32_t _next) noexcept
+{
+	const unsigned worker = ThreadPool::GetCurrentWorker();
+	Worker& w = mWorkers[worker];
+	std::uint32_t b;
+	if (!w.mFree.empty())
+	{
+		b = w.mFree.back();
+		w.mFree.pop_back();
+	}
+	else
+	{
+		if (w.mnMade == static_cast<std::uint32_t>(PATH_CHUNK_BLOCKS) * PATH_MAX_CHUNKS)
+			return PATH_NONE;
+		if (w.mnMade % PATH_CHUNK_BLOCKS == 0)
+			w.mChunks[w.mnMade / PATH_CHUNK_BLOCKS] = std::make_unique<Block[]>(PATH_CHUNK_BLOCKS);
+		b = static_cast<std::uint32_t>(worker) << PATH_WORKER_SHIFT | w.mnMade++;
+	}
+	++w.mnLive;
+	At(b) = Block{ 0, 0, _next };
+	return b;
+}
+
+void CS380::PathArena::FreeBlock(std::uint32_t _b) noexcept
+{
+	Worker& w = mWorkers[ThreadPool::GetCurrentWorker()];
+	w.mFree.push_back(_b);
+	--w.mnLive;
+}
+
+CS380::PathWriter::PathWriter(PathArena& _arena, PathCursor& _path) noexcept
+	: mArena{ _arena }, mPath{ _path }, mnBlock{ _path.mnBlock }, mnStep{ _path.mnStep }
+{
+}
+
+void CS380::PathWriter::Push(unsigned _dir) noexcept
+{
+	if (mnStep == PATH_BLOCK_STEPS)
+	{
+		mnBlock = mArena.At(mnBlock).mnNext;
+		mnStep = 0;
+	}
+	PathArena::Block& b = mArena.At(mnBlock);
+	if (mnStep < 21)
+		b.mnLo |= static_cast<std::uint64_t>(_dir) << (mnStep * 3);
+	else
+		b.mnHi |= static_cast<std::uint32_t>(_dir) << ((mnStep - 21) * 3);
+	++mnStep;
+	mPath.mnEndX += NeighbourDX[_dir];
+	mPath.mnEndY += NeighbourDY[_dir];
+}
@@ -0,0 +1,217 @@
+#include "EcoSystem/Profiler.h"
+#include "EcoSystem/ThreadPool.h"
+
+#include <cstdio>
+
+namespace
+{
+	const char* const ZoneNames[CS380::ZONE_COUNT] = {
+		"Terrain", "Creatures", "CleanUp", "Logs", "Tick", "Publish",
+		"GetShortestPath", "GetBestGrassPos", "GetEmptyNeighbour", "GetLowestGrass"
+	};
+
+	const char* const CounterNames[CS380::COUNTER_COUNT] = {
+		"searches", "flow_field_hits", "long_routes", "nodes_expanded", "heap_pushes", "spawns", "deaths"
+	};
+
+	double Micros(long long _ns) noexcept
+	{
+		return static_cast<double>(_ns) / 1000.0;
+	}
+}
+
+CS380::Profiler::Profiler(void) noexcept
+	: mbEnabled{ false }, mbTracing{ false }, mTraceOrigin{}, mSlots(1), mpSpeciesNames{ nullptr }, mnSpeciesCount{ 0 }, mHistory{}, mTraceFrames{}
+{
+	mHistory.Reset(PROFILE_HISTORY);
+	ClearHistory();
+}
+
+void CS380::Profiler::SetEnabled(bool _b) noexcept
+{
+	mbEnabled.store(_b, std::memory_order_relaxed);
+}
+
+void CS380::Profiler::ReserveWorkers(unsigned _n)
+{
+	if (mSlots.size() < _n)
+		mSlots.resize(_n);
+}
+
+void CS380::Profiler::SetSpeciesNames(const char* const* _names, unsigned _count) noexcept
+{
+	mpSpeciesNames = _names;
+	mnSpeciesCount = _count < PROFILE_MAX_SPECIES ? _count : PROFILE_MAX_SPECIES;
+}
+
+CS380::Profiler::Slot& CS380::Profiler::GetSlot(void) noexcept
+{
+	return mSlots[ThreadPool::GetCurrentWorker()];
+}
+
+long long CS380::Profiler::TraceTime(Clock::time_point _t) const noexcept
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(_t - mTraceOrigin).count();
+}
+
+void CS380::Profiler::AddZone(ProfileZone _zone, Clock::time_point _start, Clock::time_point _end) noexcept
+{
+	Slot& s = GetSlot();
+	s.mZoneSeconds[_zone] += std::chrono::duration<double>(_end - _start).count();
+	++s.mZoneCalls[_zone];
+
+	if (mbTracing && _zone != ZONE_LOWEST_GRASS && s.mTrace.size() < PROFILE_TRACE_CAPACITY)
+	{
+		const long long start = TraceTime(_start);
+		s.mTrace.push_back(TraceEvent{ start, TraceTime(_end) - start, _zone });
+	}
+}
+
+void CS380::Profiler::Count(ProfileCounter _counter, unsigned long long _n) noexcept
+{
+	if (IsEnabled())
+		GetSlot().mCounters[_counter] += _n;
+}
+
+void CS380::Profiler::SetSpecies(unsigned _species) noexcept
+{
+	if (IsEnabled())
+		GetSlot().mnSpecies = _species < PROFILE_MAX_SPECIES ? _species : PROFILE_MAX_SPECIES - 1;
+}
+
+void CS380::Profiler::CountPath(void) noexcept
+{
+	if (IsEnabled())
+	{
+		Slot& s = GetSlot();
+		++s.mPaths[s.mnSpecies];
+	}
+}
+
+void CS380::Profiler::EndFrame(unsigned long long _tick, Clock::time_point _start, Clock::time_point _end) noexcept
+{
+	if (!IsEnabled())
+		return;
+
+	AddZone(ZONE_TICK, _start, _end);
+
+	ProfileFrame f{};
+	f.mnTick = _tick;
+	for (Slot& s : mSlots)
+	{
+		for (unsigned i = 0; i < ZONE_COUNT; ++i)
+		{
+			f.mZoneSeconds[i] += s.mZoneSeconds[i];
+			f.mZoneCalls[i] += s.mZoneCalls[i];
+			s.mZoneSeconds[i] = 0.0;
+			s.mZoneCalls[i] = 0;
+		}
+		for (unsigned i = 0; i < COUNTER_COUNT; ++i)
+		{
+			f.mCounters[i] += s.mCounters[i];
+			s.mCounters[i] = 0;
+		}
+		for (unsigned i = 0; i < PROFILE_MAX_SPECIES; ++i)
+		{
+			f.mPaths[i] += s.mPaths[i];
+			s.mPaths[i] = 0;
+		}
+	}
+	mHistory.Push(f);
+	if (mbTracing)
+		mTraceFrames.push_back(TraceFrame{ TraceTime(_end), f });
+}
+
+const CS380::RingBuffer<CS380::ProfileFrame>& CS380::Profiler::GetHistory(void) const noexcept
+{
+	return mHistory;
+}
+
+void CS380::Profiler::ClearHistory(void) noexcept
+{
+	mHistory.Clear();
+	for (Slot& s : mSlots)
+	{
+		for (unsigned i = 0; i < ZONE_COUNT; ++i)
+		{
+			s.mZoneSeconds[i] = 0.0;
+			s.mZoneCalls[i] = 0;
+		}
+		for (unsigned i = 0; i < COUNTER_COUNT; ++i)
+			s.mCounters[i] = 0;
+		for (unsigned i = 0; i < PROFILE_MAX_SPECIES; ++i)
+			s.mPaths[i] = 0;
+		s.mnSpecies = 0;
+	}
+}
+
+void CS380::Profiler::BeginTrace(void)
+{
+	mTraceOrigin = Clock::now();
+	mTraceFrames.clear();
+	for (Slot& s : mSlots)
+	{
+		s.mTrace.clear();
+		s.mTrace.reserve(PROFILE_TRACE_CAPACITY / 16);
+	}
+	mbTracing = true;
+}
+
+bool CS380::Profiler::IsTracing(void) const noexcept
+{
+	return mbTracing;
+}
+
+bool CS380::Profiler::EndTrace(const std::string& _path)
+{
+	if (!mbTracing)
+		return false;
+	mbTracing = false;
+
+	bool ok = false;
+	if (std::FILE* f = std::fopen(_path.c_str(), "w"))
+	{
+		// complete events per worker, one counter track per counter and one for the paths per species
+		std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+		std::fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"EcoSystem\"}}");
+		for (unsigned w = 0; w < mSlots.size(); ++w)
+		{
+			std::fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"worker %u\"}}", w, w);
+			for (const TraceEvent& e : mSlots[w].mTrace)
+				std::fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"eco\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					ZoneNames[e.meZone], w, Micros(e.mnStart), Micros(e.mnDuration));
+		}
+		for (const TraceFrame& t : mTraceFrames)
+		{
+			for (unsigned i = 0; i < COUNTER_COUNT; ++i)
+				std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"args\":{\"value\":%llu}}",
+					CounterNames[i], Micros(t.mnEnd), t.mFrame.mCounters[i]);
+			std::fprintf(f, ",\n{\"name\":\"paths\",\"ph\":\"C\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"args\":{", Micros(t.mnEnd));
+			for (unsigned i = 0; i < mnSpeciesCount; ++i)
+				std::fprintf(f, "%s\"%s\":%u", i ? "," : "", mpSpeciesNames[i], t.mFrame.mPaths[i]);
+			std::fprintf(f, "}}");
+		}
+		std::fprintf(f, "\n]}\n");
+		ok = !std::ferror(f);
+		ok = std::fclose(f) == 0 && ok;
+	}
+
+	mTraceFrames.clear();
+	mTraceFrames.shrink_to_fit();
+	for (Slot& s : mSlots)
+	{
+		s.mTrace.clear();
+		s.mTrace.shrink_to_fit();
+	}
+	return ok;
+}
+
+const char* CS380::Profiler::GetZoneName(ProfileZone _zone) noexcept
+{
+	return _zone < ZONE_COUNT ? ZoneNames[_zone] : "";
+}
+
+const char* CS380::Profiler::GetCounterName(ProfileCounter _counter) noexcept
+{
+	return _counter < COUNTER_COUNT ? CounterNames[_counter] : "";
+}
@@ -0,0 +1,56 @@
+#include "EcoSystem/Random.h"
+
+#include <random>
+
+CS380::Random::Random(void) noexcept
+	: mnMasterSeed{ 0 }, mnEntityCounter{ 0 }
+{
+	std::random_device rd;
+	mnMasterSeed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+}
+
+void CS380::Random::SetMasterSeed(std::uint64_t _seed) noexcept
+{
+	mnMasterSeed = _seed;
+	mnEntityCounter = 0;
+}
+
+std::uint64_t CS380::Random::GetMasterSeed(void) const noexcept
+{
+	return mnMasterSeed;
+}
+
+CS380::Rng CS380::Random::Stream(RandomStream _stream, std::uint64_t _sub) const noexcept
+{
+	return Rng{ CounterHash(CounterHash(mnMasterSeed, _stream), _sub) };
+}
+
+CS380::Rng CS380::Random::NextEntityStream(void) noexcept
+{
+	return EntityStream(NextEntityId());
+}
+
+std::uint64_t CS380::Random::NextEntityId(void) noexcept
+{
+	return mnEntityCounter.fetch_add(1);
+}
+
+CS380::Rng CS380::Random::EntityStream(std::uint64_t _id) const noexcept
+{
+	return Stream(STREAM_CREATURE, _id);
+}
+
+void CS380::Random::ResetEntityStreams(void) noexcept
+{
+	mnEntityCounter = 0;
+}
+
+std::uint64_t CS380::Random::GetEntityCounter(void) const noexcept
+{
+	return mnEntityCounter;
+}
+
+void CS380::Random::SetEntityCounter(std::uint64_t _n) noexcept
+{
+	mnEntityCounter = _n;
+}
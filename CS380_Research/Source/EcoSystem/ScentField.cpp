@@ -0,0 +1,183 @@
+#include "EcoSystem/ScentField.h"
+#include "EcoSystem/Checkpoint.h"
+#include "EcoSystem/PathArena.h"
+#include "EcoSystem/ThreadPool.h"
+
+#include <algorithm>
+
+// rows of a layer per parallel job
+#define SCENT_BAND_ROWS 32
+
+// vectorized spread for the cells between a row's first and last, same operation order as Spread so both
+// paths produce identical results
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SCENT_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCENT_SIMD_WIDTH 4
+#endif
+
+namespace
+{
+	// one cell from itself and its 4 neighbours, scaled by what is kept after the fade
+	inline float Spread(float _self, float _left, float _right, float _up, float _down, float _keepSelf, float _k, float _keep) noexcept
+	{
+		const float v = (_keepSelf * _self + _k * ((_left + _right) + (_up + _down))) * _keep;
+		return v >= SCENT_FLOOR ? v : 0.f;
+	}
+
+#if defined(SCENT_SIMD_WIDTH)
+#if SCENT_SIMD_WIDTH == 8
+	using vfloat = __m256;
+	inline vfloat Load(const float* _p) noexcept { return _mm256_loadu_ps(_p); }
+	inline void Store(float* _p, vfloat _v) noexcept { _mm256_storeu_ps(_p, _v); }
+	inline vfloat Set1(float _v) noexcept { return _mm256_set1_ps(_v); }
+	inline vfloat Add(vfloat _a, vfloat _b) noexcept { return _mm256_add_ps(_a, _b); }
+	inline vfloat Mul(vfloat _a, vfloat _b) noexcept { return _mm256_mul_ps(_a, _b); }
+	inline vfloat KeepAtLeast(vfloat _v, vfloat _floor) noexcept { return _mm256_and_ps(_v, _mm256_cmp_ps(_v, _floor, _CMP_GE_OQ)); }
+#else
+	using vfloat = __m128;
+	inline vfloat Load(const float* _p) noexcept { return _mm_loadu_ps(_p); }
+	inline void Store(float* _p, vfloat _v) noexcept { _mm_storeu_ps(_p, _v); }
+	inline vfloat Set1(float _v) noexcept { return _mm_set1_ps(_v); }
+	inline vfloat Add(vfloat _a, vfloat _b) noexcept { return _mm_add_ps(_a, _b); }
+	inline vfloat Mul(vfloat _a, vfloat _b) noexcept { return _mm_mul_ps(_a, _b); }
+	inline vfloat KeepAtLeast(vfloat _v, vfloat _floor) noexcept { return _mm_and_ps(_v, _mm_cmpge_ps(_v, _floor)); }
+#endif
+#endif
+
+	// off the map's edge a cell sees itself, so the spread never loses scent over it
+	void SpreadRow(const float* _up, const float* _row, const float* _down, float* _out, unsigned _w, float _k, float _keep) noexcept
+	{
+		const float keepSelf = 1.f - 4.f * _k;
+		if (_w == 1)
+		{
+			_out[0] = Spread(_row[0], _row[0], _row[0], _up[0], _down[0], keepSelf, _k, _keep);
+			return;
+		}
+
+		_out[0] = Spread(_row[0], _row[0], _row[1], _up[0], _down[0], keepSelf, _k, _keep);
+		unsigned x = 1;
+#if defined(SCENT_SIMD_WIDTH)
+		const vfloat vKeepSelf = Set1(keepSelf);
+		const vfloat vK = Set1(_k);
+		const vfloat vKeep = Set1(_keep);
+		const vfloat vFloor = Set1(SCENT_FLOOR);
+		for (; x + SCENT_SIMD_WIDTH < _w; x += SCENT_SIMD_WIDTH)
+		{
+			const vfloat sides = Add(Load(_row + x - 1), Load(_row + x + 1));
+			const vfloat vert = Add(Load(_up + x), Load(_down + x));
+			const vfloat v = Mul(Add(Mul(vKeepSelf, Load(_row + x)), Mul(vK, Add(sides, vert))), vKeep);
+			Store(_out + x, KeepAtLeast(v, vFloor));
+		}
+#endif
+		for (; x + 1 < _w; ++x)
+			_out[x] = Spread(_row[x], _row[x - 1], _row[x + 1], _up[x], _down[x], keepSelf, _k, _keep);
+		_out[_w - 1] = Spread(_row[_w - 1], _row[_w - 2], _row[_w - 1], _up[_w - 1], _down[_w - 1], keepSelf, _k, _keep);
+	}
+}
+
+CS380::ScentField::ScentField(void) noexcept
+	: mpPool{ nullptr }, mnWidth{ 0 }, mnHeight{ 0 }, mnMask{ 0 }, mLayers(sizeof(unsigned) * 8), mNext{}
+{
+}
+
+void CS380::ScentField::SetThreadPool(ThreadPool* _pool) noexcept
+{
+	mpPool = _pool;
+}
+
+void CS380::ScentField::Reset(unsigned _w, unsigned _h) noexcept
+{
+	mnWidth = _w;
+	mnHeight = _h;
+	for (unsigned s = 0; s < mLayers.size(); ++s)
+		if (IsTracked(s))
+			mLayers[s].Resize(_w, _h, 0.f);
+}
+
+void CS380::ScentField::SetSpeciesMask(unsigned _mask) noexcept
+{
+	for (unsigned s = 0; s < mLayers.size(); ++s)
+	{
+		const bool on = (_mask >> s) & 1u;
+		if (!on)
+			Grid<float>{}.Swap(mLayers[s]);
+		else if (mLayers[s].GetWidth() != mnWidth || mLayers[s].GetHeight() != mnHeight)
+			mLayers[s].Resize(mnWidth, mnHeight, 0.f);
+	}
+	mnMask = _mask;
+	if (!mnMask)
+		Grid<float>{}.Swap(mNext);
+}
+
+void CS380::ScentField::Update(void) noexcept
+{
+	for (Grid<float>& layer : mLayers)
+		if (!layer.Empty())
+			UpdateLayer(layer);
+}
+
+void CS380::ScentField::UpdateLayer(Grid<float>& _layer) noexcept
+{
+	if (mNext.GetWidth() != mnWidth || mNext.GetHeight() != mnHeight)
+		mNext.Resize(mnWidth, mnHeight);
+
+	// every row reads the old layer and writes its own row of mNext, so the bands need no order
+	const float keep = 1.f - SCENT_DECAY;
+	auto band = [this, &_layer, keep](unsigned _i, unsigned)
+	{
+		const unsigned y0 = _i * SCENT_BAND_ROWS;
+		const unsigned y1 = std::min(y0 + SCENT_BAND_ROWS, mnHeight);
+		for (unsigned y = y0; y < y1; ++y)
+		{
+			const float* row = _layer.Row(y);
+			SpreadRow(y ? _layer.Row(y - 1) : row, row, y + 1 < mnHeight ? _layer.Row(y + 1) : row, mNext.Row(y), mnWidth, SCENT_DIFFUSION, keep);
+		}
+	};
+	const unsigned bands = (mnHeight + SCENT_BAND_ROWS - 1) / SCENT_BAND_ROWS;
+	if (mpPool && bands > 1)
+		mpPool->ParallelFor(bands, band);
+	else
+		for (unsigned i = 0; i < bands; ++i)
+			band(i, 0);
+	_layer.Swap(mNext);
+}
+
+CS380::GridPos CS380::ScentField::Climb(unsigned _species, const GridPos& _p) const noexcept
+{
+	const Grid<float>& layer = mLayers[_species];
+	GridPos best = _p;
+	float strongest = layer(_p.x, _p.y);
+	for (unsigned d = 0; d < 8; ++d)
+	{
+		const int x = _p.x + NeighbourDX[d];
+		const int y = _p.y + NeighbourDY[d];
+		if (layer.InBounds(x, y) && layer(x, y) > strongest)
+		{
+			strongest = layer(x, y);
+			best = GridPos{ x, y };
+		}
+	}
+	return strongest > 0.f ? best : GridPos{ -1, -1 };
+}
+
+void CS380::ScentField::Save(CheckpointWriter& _w) const
+{
+	_w.Pod(mnMask);
+	for (unsigned s = 0; s < mLayers.size(); ++s)
+		if (IsTracked(s))
+			_w.Plane(mLayers[s]);
+}
+
+bool CS380::ScentField::Load(CheckpointReader& _r, unsigned _w, unsigned _h)
+{
+	mnWidth = _w;
+	mnHeight = _h;
+	SetSpeciesMask(_r.Pod<unsigned>());
+	for (unsigned s = 0; s < mLayers.size() && !_r.Failed(); ++s)
+		if (IsTracked(s))
+			_r.Plane(mLayers[s], _w, _h);
+	return !_r.Failed();
+}
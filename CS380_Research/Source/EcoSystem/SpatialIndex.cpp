@@ -0,0 +1,130 @@
+#include "EcoSystem/SpatialIndex.h"
+
+CS380::SpatialIndex::SpatialIndex(void) noexcept
+	: mnBucketsX{ 0 }, mnBucketsY{ 0 }, mnSpecies{ 0 }, mBuckets{}, mWhere{}
+{
+}
+
+void CS380::SpatialIndex::Reset(unsigned _w, unsigned _h, unsigned _species) noexcept
+{
+	mnBucketsX = (_w + SPATIAL_BUCKET_SIZE - 1) >> SPATIAL_BUCKET_SHIFT;
+	mnBucketsY = (_h + SPATIAL_BUCKET_SIZE - 1) >> SPATIAL_BUCKET_SHIFT;
+	mnSpecies = _species;
+	mBuckets.assign(static_cast<std::size_t>(mnSpecies) * mnBucketsX * mnBucketsY, std::vector<Entry>{});
+	mWhere.assign(mnSpecies, std::vector<unsigned>{});
+}
+
+void CS380::SpatialIndex::Insert(const CreatureHandle& _h, const GridPos& _p) noexcept
+{
+	std::vector<unsigned>& where = mWhere[_h.GetSpecies()];
+	if (_h.GetSlot() >= where.size())
+		where.resize(_h.GetSlot() + 1);
+
+	std::vector<Entry>& bucket = Bucket(_h.GetSpecies(), _p);
+	where[_h.GetSlot()] = static_cast<unsigned>(bucket.size());
+	bucket.push_back(Entry{ _h, _p.x, _p.y });
+}
+
+void CS380::SpatialIndex::Move(const CreatureHandle& _h, const GridPos& _from, const GridPos& _to) noexcept
+{
+	// most steps stay inside the bucket
+	if ((_from.x >> SPATIAL_BUCKET_SHIFT) == (_to.x >> SPATIAL_BUCKET_SHIFT) &&
+		(_from.y >> SPATIAL_BUCKET_SHIFT) == (_to.y >> SPATIAL_BUCKET_SHIFT))
+	{
+		Entry& e = Bucket(_h.GetSpecies(), _from)[mWhere[_h.GetSpecies()][_h.GetSlot()]];
+		e.mnX = _to.x;
+		e.mnY = _to.y;
+		return;
+	}
+	Remove(_h, _from);
+	Insert(_h, _to);
+}
+
+void CS380::SpatialIndex::Remove(const CreatureHandle& _h, const GridPos& _p) noexcept
+{
+	std::vector<unsigned>& where = mWhere[_h.GetSpecies()];
+	std::vector<Entry>& bucket = Bucket(_h.GetSpecies(), _p);
+	const unsigned i = where[_h.GetSlot()];
+	if (i >= bucket.size() || bucket[i].mHandle != _h)
+		return;
+
+	bucket[i] = bucket.back();
+	where[bucket[i].mHandle.GetSlot()] = i;
+	bucket.pop_back();
+}
+
+unsigned CS380::SpatialIndex::QueryRadius(const GridPos& _p, float _radius, unsigned _speciesMask, SpatialHit* _out, unsigned _capacity) const noexcept
+{
+	if (!_capacity || _radius < 0.f)
+		return 0;
+
+	const int r = static_cast<int>(_radius);
+	const int r2 = static_cast<int>(_radius * _radius);
+	unsigned bx0, by0, bx1, by1;
+	if (!BucketRange(_p, r, bx0, by0, bx1, by1))
+		return 0;
+
+	unsigned n = 0;
+	for (unsigned s = 0; s < mnSpecies; ++s)
+	{
+		if (!(_speciesMask & (1u << s)))
+			continue;
+		for (unsigned by = by0; by <= by1; ++by)
+			for (unsigned bx = bx0; bx <= bx1; ++bx)
+				for (const Entry& e : Bucket(s, bx, by))
+				{
+					const int dx = e.mnX - _p.x;
+					const int dy = e.mnY - _p.y;
+					const int d = dx * dx + dy * dy;
+					if (d > r2)
+						continue;
+					if (n == _capacity && !Closer(d, e.mHandle, _out[n - 1].mnDistSq, _out[n - 1].mHandle))
+						continue;
+
+					// insertion into the sorted prefix, the farthest falls off once full
+					unsigned k = n < _capacity ? n++ : _capacity - 1;
+					while (k > 0 && Closer(d, e.mHandle, _out[k - 1].mnDistSq, _out[k - 1].mHandle))
+					{
+						_out[k] = _out[k - 1];
+						--k;
+					}
+					_out[k] = SpatialHit{ e.mHandle, e.mnX, e.mnY, d };
+				}
+	}
+	return n;
+}
+
+std::vector<CS380::SpatialIndex::Entry>& CS380::SpatialIndex::Bucket(unsigned _species, const GridPos& _p) noexcept
+{
+	const unsigned bx = static_cast<unsigned>(_p.x) >> SPATIAL_BUCKET_SHIFT;
+	const unsigned by = static_cast<unsigned>(_p.y) >> SPATIAL_BUCKET_SHIFT;
+	return mBuckets[(static_cast<std::size_t>(_species) * mnBucketsY + by) * mnBucketsX + bx];
+}
+
+const std::vector<CS380::SpatialIndex::Entry>& CS380::SpatialIndex::Bucket(unsigned _species, unsigned _bx, unsigned _by) const noexcept
+{
+	return mBuckets[(static_cast<std::size_t>(_species) * mnBucketsY + _by) * mnBucketsX + _bx];
+}
+
+bool CS380::SpatialIndex::BucketRange(const GridPos& _p, int _r, unsigned& _bx0, unsigned& _by0, unsigned& _bx1, unsigned& _by1) const noexcept
+{
+	const int maxX = static_cast<int>(mnBucketsX << SPATIAL_BUCKET_SHIFT) - 1;
+	const int maxY = static_cast<int>(mnBucketsY << SPATIAL_BUCKET_SHIFT) - 1;
+	const int x0 = _p.x - _r < 0 ? 0 : _p.x - _r;
+	const int y0 = _p.y - _r < 0 ? 0 : _p.y - _r;
+	const int x1 = _p.x + _r > maxX ? maxX : _p.x + _r;
+	const int y1 = _p.y + _r > maxY ? maxY : _p.y + _r;
+	if (x0 > x1 || y0 > y1)
+		return false;
+
+	_bx0 = static_cast<unsigned>(x0) >> SPATIAL_BUCKET_SHIFT;
+	_by0 = static_cast<unsigned>(y0) >> SPATIAL_BUCKET_SHIFT;
+	_bx1 = static_cast<unsigned>(x1) >> SPATIAL_BUCKET_SHIFT;
+	_by1 = static_cast<unsigned>(y1) >> SPATIAL_BUCKET_SHIFT;
+	return true;
+}
+
+bool CS380::SpatialIndex::Closer(int _d, const CreatureHandle& _h, int _rhsD, const CreatureHandle& _rhsH) noexcept
+{
+	return _d < _rhsD || (_d == _rhsD && _h.mnIndex < _rhsH.mnIndex);
+}
@@ -0,0 +1,288 @@
+#include "EcoSystem/Telemetry.h"
+
+#include <cstdint>
+#include <cstring>
+
+CS380::CsvTelemetrySink::CsvTelemetrySink(const std::string& _path) noexcept
+	: mPath{ _path }, mpFile{ nullptr }, mnColumns{ 0 }
+{
+}
+
+CS380::CsvTelemetrySink::~CsvTelemetrySink(void) noexcept
+{
+	Close();
+}
+
+bool CS380::CsvTelemetrySink::Open(const std::vector<std::string>& _columns) noexcept
+{
+	mpFile = std::fopen(mPath.c_str(), "w");
+	if (!mpFile)
+		return false;
+	mnColumns = static_cast<unsigned>(_columns.size());
+	bool ok = std::fputs("tick", mpFile) >= 0;
+	for (const auto& c : _columns)
+		ok &= std::fprintf(mpFile, ",%s", c.c_str()) >= 0;
+	ok &= std::fputc('\n', mpFile) != EOF;
+	if (!ok)
+		Close();
+	return ok;
+}
+
+bool CS380::CsvTelemetrySink::Write(const unsigned long long* _ticks, const float* _values, unsigned _rows) noexcept
+{
+	if (!mpFile)
+		return false;
+	bool ok = true;
+	for (unsigned r = 0; r < _rows; ++r)
+	{
+		ok &= std::fprintf(mpFile, "%llu", _ticks[r]) >= 0;
+		const float* row = _values + static_cast<std::size_t>(r) * mnColumns;
+		for (unsigned c = 0; c < mnColumns; ++c)
+			ok &= std::fprintf(mpFile, ",%g", row[c]) >= 0;
+		ok &= std::fputc('\n', mpFile) != EOF;
+	}
+	return ok;
+}
+
+bool CS380::CsvTelemetrySink::Close(void) noexcept
+{
+	const bool ok = !mpFile || !std::fclose(mpFile);
+	mpFile = nullptr;
+	return ok;
+}
+
+CS380::BinaryTelemetrySink::BinaryTelemetrySink(const std::string& _path) noexcept
+	: mPath{ _path }, mpFile{ nullptr }, mnColumns{ 0 }, mColumn{}
+{
+}
+
+CS380::BinaryTelemetrySink::~BinaryTelemetrySink(void) noexcept
+{
+	Close();
+}
+
+bool CS380::BinaryTelemetrySink::Open(const std::vector<std::string>& _columns) noexcept
+{
+	mpFile = std::fopen(mPath.c_str(), "wb");
+	if (!mpFile)
+		return false;
+	mnColumns = static_cast<unsigned>(_columns.size());
+
+	const std::uint32_t version = TELEMETRY_VERSION;
+	const std::uint32_t columns = mnColumns;
+	bool ok = std::fwrite(TELEMETRY_MAGIC, 1, 4, mpFile) == 4;
+	ok &= std::fwrite(&version, sizeof(version), 1, mpFile) == 1;
+	ok &= std::fwrite(&columns, sizeof(columns), 1, mpFile) == 1;
+	for (const auto& c : _columns)
+	{
+		const std::uint16_t len = static_cast<std::uint16_t>(c.size());
+		ok &= std::fwrite(&len, sizeof(len), 1, mpFile) == 1;
+		ok &= std::fwrite(c.data(), 1, len, mpFile) == len;
+	}
+	if (!ok)
+		Close();
+	return ok;
+}
+
+bool CS380::BinaryTelemetrySink::Write(const unsigned long long* _ticks, const float* _values, unsigned _rows) noexcept
+{
+	if (!mpFile)
+		return false;
+	if (!_rows)
+		return true;
+	const std::uint32_t rows = _rows;
+	bool ok = std::fwrite(&rows, sizeof(rows), 1, mpFile) == 1;
+	static_assert(sizeof(unsigned long long) == sizeof(std::uint64_t), "ticks are written as u64");
+	ok &= std::fwrite(_ticks, sizeof(std::uint64_t), _rows, mpFile) == _rows;
+
+	mColumn.resize(_rows);
+	for (unsigned c = 0; c < mnColumns; ++c)
+	{
+		for (unsigned r = 0; r < _rows; ++r)
+			mColumn[r] = _values[static_cast<std::size_t>(r) * mnColumns + c];
+		ok &= std::fwrite(mColumn.data(), sizeof(float), _rows, mpFile) == _rows;
+	}
+	return ok;
+}
+
+bool CS380::BinaryTelemetrySink::Close(void) noexcept
+{
+	const bool ok = !mpFile || !std::fclose(mpFile);
+	mpFile = nullptr;
+	return ok;
+}
+
+std::unique_ptr<CS380::TelemetrySink> CS380::MakeTelemetrySink(const std::string& _path)
+{
+	if (_path.size() >= 4 && !std::strcmp(_path.c_str() + _path.size() - 4, ".csv"))
+		return std::make_unique<CsvTelemetrySink>(_path);
+	return std::make_unique<BinaryTelemetrySink>(_path);
+}
+
+CS380::TelemetryStream::TelemetryStream(void) noexcept
+	: mpSink{}, mWriter{}, mMutex{}, mWake{}, mDrained{}, mPending{}, mFree{}, mpCurrent{}, mnColumns{ 0 }, mnDropped{ 0 }, mnWritten{ 0 },
+	mnFailed{ 0 }, mbBlocking{ false }, mbStop{ false }
+{
+}
+
+CS380::TelemetryStream::~TelemetryStream(void) noexcept
+{
+	Stop();
+}
+
+bool CS380::TelemetryStream::Start(std::unique_ptr<TelemetrySink> _sink, const std::vector<std::string>& _columns, bool _blocking)
+{
+	Stop();
+	if (!_sink || !_sink->Open(_columns))
+		return false;
+
+	mpSink = std::move(_sink);
+	mnColumns = static_cast<unsigned>(_columns.size());
+	mnDropped = 0;
+	mnWritten = 0;
+	mnFailed = 0;
+	mbBlocking = _blocking;
+	mbStop = false;
+	mpCurrent = TakeFree();
+	mWriter = std::thread{ &TelemetryStream::WriterLoop, this };
+	return true;
+}
+
+void CS380::TelemetryStream::Stop(void) noexcept
+{
+	if (!mWriter.joinable())
+		return;
+
+	if (mpCurrent && !mpCurrent->mTicks.empty())
+		Submit();
+	{
+		std::lock_guard<std::mutex> lock{ mMutex };
+		mbStop = true;
+	}
+	mWake.notify_one();
+	mWriter.join();
+
+	// nothing written is known to be on the disk when the flush fails
+	if (!mpSink->Close())
+	{
+		mnFailed += mnWritten;
+		mnWritten = 0;
+	}
+	mpSink.reset();
+	mpCurrent.reset();
+	mFree.clear();
+}
+
+bool CS380::TelemetryStream::IsRunning(void) const noexcept
+{
+	return mWriter.joinable();
+}
+
+void CS380::TelemetryStream::Push(unsigned long long _tick, const float* _values) noexcept
+{
+	if (!mpCurrent)
+		return;
+	mpCurrent->mTicks.push_back(_tick);
+	mpCurrent->mValues.insert(mpCurrent->mValues.end(), _values, _values + mnColumns);
+	if (mpCurrent->mTicks.size() == TELEMETRY_BLOCK_ROWS)
+		Submit();
+}
+
+unsigned CS380::TelemetryStream::GetColumnCount(void) const noexcept
+{
+	return mnColumns;
+}
+
+unsigned long long CS380::TelemetryStream::GetWrittenRows(void) const noexcept
+{
+	return mnWritten;
+}
+
+unsigned long long CS380::TelemetryStream::GetDroppedRows(void) const noexcept
+{
+	return mnDropped;
+}
+
+unsigned long long CS380::TelemetryStream::GetFailedRows(void) const noexcept
+{
+	return mnFailed;
+}
+
+void CS380::TelemetryStream::Submit(void) noexcept
+{
+	{
+		std::unique_lock<std::mutex> lock{ mMutex };
+		if (mbBlocking)
+			mDrained.wait(lock, [this] { return mPending.size() < TELEMETRY_MAX_PENDING; });
+		if (mPending.size() < TELEMETRY_MAX_PENDING)
+			mPending.push_back(std::move(mpCurrent));
+		else
+			mnDropped += mpCurrent->mTicks.size();
+	}
+	mWake.notify_one();
+
+	if (mpCurrent)
+	{
+		mpCurrent->mTicks.clear();
+		mpCurrent->mValues.clear();
+	}
+	else
+		mpCurrent = TakeFree();
+}
+
+std::unique_ptr<CS380::TelemetryStream::Block> CS380::TelemetryStream::TakeFree(void) noexcept
+{
+	std::unique_ptr<Block> b;
+	{
+		std::lock_guard<std::mutex> lock{ mMutex };
+		if (!mFree.empty())
+		{
+			b = std::move(mFree.back());
+			mFree.pop_back();
+		}
+	}
+	if (!b)
+	{
+		b = std::make_unique<Block>();
+		b->mTicks.reserve(TELEMETRY_BLOCK_ROWS);
+		b->mValues.reserve(static_cast<std::size_t>(TELEMETRY_BLOCK_ROWS) * mnColumns);
+	}
+	return b;
+}
+
+void CS380::TelemetryStream::WriterLoop(void) noexcept
+{
+	std::vector<std::unique_ptr<Block>> work;
+	for (;;)
+	{
+		bool stop;
+		{
+			std::unique_lock<std::mutex> lock{ mMutex };
+			mWake.wait(lock, [this] { return mbStop || !mPending.empty(); });
+			work.swap(mPending);
+			stop = mbStop;
+		}
+		mDrained.notify_one();
+
+		// the disk only ever sees the writer, the lock is not held while it writes
+		for (auto& b : work)
+		{
+			const unsigned rows = static_cast<unsigned>(b->mTicks.size());
+			if (mpSink->Write(b->mTicks.data(), b->mValues.data(), rows))
+				mnWritten += rows;
+			else
+				mnFailed += rows;
+			b->mTicks.clear();
+			b->mValues.clear();
+		}
+		{
+			std::lock_guard<std::mutex> lock{ mMutex };
+			for (auto& b : work)
+				mFree.push_back(std::move(b));
+		}
+		work.clear();
+
+		if (stop)
+			return;
+	}
+}
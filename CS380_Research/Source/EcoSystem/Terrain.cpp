@@ -1,21 +1,32 @@
 #include "EcoSystem/Terrain.h"
-#include "imgui.h"
-#include "imgui_internal.h"
-
-#include <queue>
-#include <random>
+#include "EcoSystem/Checkpoint.h"
+#include "EcoSystem/Color.h"
+#include "EcoSystem/PathArena.h"
+#include "EcoSystem/Profiler.h"
+#include "EcoSystem/ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <utility>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #define SQRT_2 1.41421356237f
 
-struct Comp
-{
-	template <typename T>
-	bool operator()(T* _a, T* _b)
-	{
-		return *_a < *_b;
-	}
-};
+// updates between the settles of a lazy tile whose cells still spill or grow
+#define LAZY_SPILL_INTERVAL 64u
+#define LAZY_NEVER 0xFFFFFFFFFFFFFFFFull
+
+#define NODE_UNSEEN 0xFFFFFFFFu
+#define NODE_CLOSED 0xFFFFFFFEu
+// a node's generation stamp is 29 bits wide
+#define NODE_GEN_LIMIT (1u << 29)
+
+// top bits of the pick hashes Init counts the cells under, the last bucket the initial grass takes from is sorted
+#define TERRAIN_INIT_BUCKET_BITS 12
 
 template <typename T>
 T Max(const T& _a, const T& _b)
@@ -46,6 +57,148 @@ float GetOctileCost(float x, float y)
 	return Max(x, y) + (SQRT_2 - 1)*Min(x, y);
 }
 
+namespace
+{
+	// an occupied cell in a checkpoint, y * width + x and the first creature on it
+	struct CellHead
+	{
+		unsigned mnCell;
+		CS380::CreatureHandle mHead;
+	};
+
+	// stateless per cell hash so tie breaking between equally low neighbours needs no shared rng
+	inline unsigned HashCell(std::uint64_t _seed, unsigned _x, unsigned _y, unsigned long long _n) noexcept
+	{
+		return static_cast<unsigned>(CS380::CounterHash(_seed ^ (static_cast<std::uint64_t>(_y) << 32 | _x), _n));
+	}
+
+	// [0, 1) off a counter hash, the same bits Rng::NextFloat takes
+	inline float HashFloat(std::uint64_t _key, std::uint64_t _counter) noexcept
+	{
+		return static_cast<float>(CS380::CounterHash(_key, _counter) >> 40) * (1.f / 16777216.f);
+	}
+
+	// [0, 1) value noise, a hashed value per whole point smoothly blended in between
+	float ValueNoise(std::uint64_t _key, float _x, float _y) noexcept
+	{
+		const float fx = floorf(_x);
+		const float fy = floorf(_y);
+		const std::uint32_t ix = static_cast<std::uint32_t>(static_cast<std::int32_t>(fx));
+		const std::uint32_t iy = static_cast<std::uint32_t>(static_cast<std::int32_t>(fy));
+		auto corner = [_key](std::uint32_t _cx, std::uint32_t _cy) { return HashFloat(_key, static_cast<std::uint64_t>(_cy) << 32 | _cx); };
+		float tx = _x - fx;
+		float ty = _y - fy;
+		tx = tx * tx * (3.f - 2.f * tx);
+		ty = ty * ty * (3.f - 2.f * ty);
+		const float top = corner(ix, iy) + (corner(ix + 1, iy) - corner(ix, iy)) * tx;
+		const float bottom = corner(ix, iy + 1) + (corner(ix + 1, iy + 1) - corner(ix, iy + 1)) * tx;
+		return top + (bottom - top) * ty;
+	}
+
+	static_assert(TERRAIN_TILE_SIZE == 64, "a tile row has to fit one awake word");
+
+	// index of the lowest set bit, _v is never 0
+	inline unsigned LowestBit(std::uint64_t _v) noexcept
+	{
+#if defined(_MSC_VER)
+		unsigned long i = 0;
+		_BitScanForward64(&i, _v);
+		return static_cast<unsigned>(i);
+#else
+		return static_cast<unsigned>(__builtin_ctzll(_v));
+#endif
+	}
+}
+
+// vectorized growth for blocks of cells that are not saturated, same operation order as UpdateCell
+// so both paths produce identical results
+#if defined(__AVX__)
+#include <immintrin.h>
+#define TERRAIN_SIMD_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TERRAIN_SIMD_WIDTH 4
+#endif
+
+#if defined(TERRAIN_SIMD_WIDTH)
+#define TERRAIN_SIMD_MASK ((std::uint64_t{ 1 } << TERRAIN_SIMD_WIDTH) - 1)
+#endif
+
+#if defined(TERRAIN_SIMD_WIDTH)
+namespace
+{
+	struct GrowthRow
+	{
+		float* mpFert;
+		const float* mpGrass;
+		float* mpGrassNext;
+		signed char* mpSpill;
+		const float* mpFertRate;
+		const float* mpGrassRate;
+		float* mpFertLo;
+		float mfFertHi;
+		float mfGrassHi;
+	};
+
+#if TERRAIN_SIMD_WIDTH == 8
+	using vfloat = __m256;
+	inline vfloat Load(const float* _p) noexcept { return _mm256_loadu_ps(_p); }
+	inline void Store(float* _p, vfloat _v) noexcept { _mm256_storeu_ps(_p, _v); }
+	inline vfloat Set1(float _v) noexcept { return _mm256_set1_ps(_v); }
+	inline vfloat Add(vfloat _a, vfloat _b) noexcept { return _mm256_add_ps(_a, _b); }
+	inline vfloat Sub(vfloat _a, vfloat _b) noexcept { return _mm256_sub_ps(_a, _b); }
+	inline vfloat Mul(vfloat _a, vfloat _b) noexcept { return _mm256_mul_ps(_a, _b); }
+	inline vfloat Div(vfloat _a, vfloat _b) noexcept { return _mm256_div_ps(_a, _b); }
+	inline vfloat VMin(vfloat _a, vfloat _b) noexcept { return _mm256_min_ps(_a, _b); }
+	inline vfloat VMax(vfloat _a, vfloat _b) noexcept { return _mm256_max_ps(_a, _b); }
+	inline bool AnyGreaterEqual(vfloat _a, vfloat _b) noexcept { return _mm256_movemask_ps(_mm256_cmp_ps(_a, _b, _CMP_GE_OQ)) != 0; }
+#else
+	using vfloat = __m128;
+	inline vfloat Load(const float* _p) noexcept { return _mm_loadu_ps(_p); }
+	inline void Store(float* _p, vfloat _v) noexcept { _mm_storeu_ps(_p, _v); }
+	inline vfloat Set1(float _v) noexcept { return _mm_set1_ps(_v); }
+	inline vfloat Add(vfloat _a, vfloat _b) noexcept { return _mm_add_ps(_a, _b); }
+	inline vfloat Sub(vfloat _a, vfloat _b) noexcept { return _mm_sub_ps(_a, _b); }
+	inline vfloat Mul(vfloat _a, vfloat _b) noexcept { return _mm_mul_ps(_a, _b); }
+	inline vfloat Div(vfloat _a, vfloat _b) noexcept { return _mm_div_ps(_a, _b); }
+	inline vfloat VMin(vfloat _a, vfloat _b) noexcept { return _mm_min_ps(_a, _b); }
+	inline vfloat VMax(vfloat _a, vfloat _b) noexcept { return _mm_max_ps(_a, _b); }
+	inline bool AnyGreaterEqual(vfloat _a, vfloat _b) noexcept { return _mm_movemask_ps(_mm_cmpge_ps(_a, _b)) != 0; }
+#endif
+
+	// Clamp(lo, hi, v) with the same argument order as the scalar helper
+	inline vfloat VClamp(vfloat _lo, vfloat _hi, vfloat _v) noexcept
+	{
+		return VMax(VMin(_v, _hi), _lo);
+	}
+
+	// returns false without touching anything if a cell in the block is saturated
+	bool GrowBlock(const GrowthRow& _r, unsigned _x, float _dt) noexcept
+	{
+		vfloat grass = Load(_r.mpGrass + _x);
+		vfloat grassHi = Set1(_r.mfGrassHi);
+		if (AnyGreaterEqual(grass, grassHi))
+			return false;
+
+		vfloat dt = Set1(_dt);
+		vfloat fertHi = Set1(_r.mfFertHi);
+		vfloat fert = Load(_r.mpFert + _x);
+		fert = VClamp(Load(_r.mpFertLo + _x), fertHi, Add(fert, Mul(Mul(Load(_r.mpFertRate + _x), dt), fertHi)));
+
+		vfloat rate = Mul(Mul(Load(_r.mpGrassRate + _x), dt), grassHi);
+		vfloat consumable = VMin(fert, rate);
+
+		Store(_r.mpGrassNext + _x, Add(grass, consumable));
+		for (unsigned i = 0; i < TERRAIN_SIMD_WIDTH; ++i)
+			_r.mpSpill[_x + i] = -1;
+		fert = VClamp(Set1(0.f), fertHi, Sub(fert, consumable));
+		Store(_r.mpFert + _x, fert);
+		Store(_r.mpFertLo + _x, Div(fert, fertHi));
+		return true;
+	}
+}
+#endif
+
 CS380::GridPos::GridPos(int _x, int _y) noexcept
 	: x{ _x }, y{ _y }
 {}
@@ -56,376 +209,1418 @@ bool CS380::GridPos::operator==(const GridPos& _rhs) const
 }
 
 CS380::Node::Node(void) noexcept
-	: pos{ 0,0 }, tcost{ 0 }, hcost{ 0 }, fcost{ 0.f }, mpPrev{ nullptr }
+	: mnX{ 0 }, mnY{ 0 }, tcost{ 0.f }, fcost{ 0.f }, mnGen{ 0 }, mnPrev{ 0 }, mnHeapIdx{ NODE_UNSEEN }
 {}
 
-CS380::Node::Node(const GridPos& _p, float _t, float _h) noexcept
-	: pos{ _p }, tcost{ _t }, hcost{ _h }, fcost{ 0.f }, mpPrev{ nullptr }
-{}
+CS380::Terrain::Terrain(unsigned _x, unsigned _y)
+	: mSpaceLayer{}, 
+	mGrassLayer{}, mFertilizerLayer{}, 
+	mGrassLayerRate{},
+	mfGrassLo{ 0.f }, mfGrassHi{ 0.f }, mFertilizerThreshLo{}, mfFertilizerHi{ 0.f },
+	mGrassNext{}, mSpillDir{}, mSpillAmount{}, mpPool{ nullptr }, mpRandom{ nullptr }, mpProfiler{ nullptr }, mpPaths{ nullptr }, mnUpdateCount{ 0 },
+	mnWidth{ _x }, mnHeight{ _y }, mnFrameX{ 0 }, mnFrameY{ 0 }, mnWorldWidth{ 0 }, mnWorldHeight{ 0 }, mfRateNoise{ 0.f }, mfRateNoiseScale{ TERRAIN_NOISE_SCALE },
+	mGrassRatio{}, mnHashSeed{ 0 }, mFlowFields{}, mScratch{}, mTileDirty{}, mnTilesX{ 0 }, mnTilesY{ 0 },
+	mAwake{}, mOverfull{}, mTileGrassChanged{}, mTileGrassDelta{}, mTileRatioDelta{}, mfGrassTotal{ 0.0 }, mfGrassRatioSum{ 0.0 }, mfLastDt{ 0.f },
+	mbLazy{ false }, mLastTick{}, mPendingSpill{}, mTileDue{}
+{
+	mScratch.resize(1);
+}
 
-bool CS380::Node::operator<(const Node& _rhs) const noexcept
+CS380::PathScratch::PathScratch(void) noexcept
+	: mNodes{}, mOpen{}, mnSearchGen{ 0 }
 {
-	return fcost > _rhs.fcost;
 }
 
-CS380::Terrain::Terrain(unsigned _x, unsigned _y)
-	: mnWidth{ _x }, mnHeight{ _y }, mSpaceLayer{}, 
-	mGrassLayer{}, mFertilizerLayer{}, 
-	mGrassLayerRate{},
-	mGrassThresh{}, mFertilizerThresh{}
+void CS380::PathScratch::Reset(unsigned _w, unsigned _h) noexcept
 {
+	// TouchNode fills in the position, chunks are only allocated under a search
+	mNodes.Resize(_w, _h, Node{});
+	mOpen.clear();
+	mnSearchGen = 0;
 }
 
 void CS380::Terrain::Init(float _iga, float _igl, float _igh, unsigned _w, unsigned _h, float _grl, float _grh, float _gm, float _fm, float _frl, float _frh) noexcept
 {
-	std::random_device rd;
-	std::mt19937 mt(rd());
-
 	mnWidth = _w;
 	mnHeight = _h;
 
-	// usage layers
-	mSpaceLayer.resize(mnHeight);
-	for (auto& sub : mSpaceLayer)
-		sub.resize(mnWidth, -1);
-
-	mGrassLayer.resize(mnHeight);
-	for (auto& sub : mGrassLayer)
-		sub.resize(mnWidth, 0.f);
-
-	mFertilizerLayer.resize(mnHeight);
-	for (auto& sub : mFertilizerLayer)
-		sub.resize(mnWidth, 0.f);
-
-	// growth rates
-	std::uniform_real_distribution<float> distR1(_grl, _grh);
-	std::uniform_real_distribution<float> distR2(_frl, _frh);
-	mGrassLayerRate.resize(mnHeight);
-	for (auto& sub : mGrassLayerRate)
-		sub.resize(mnWidth, 0.f);
-	for (auto& r : mGrassLayerRate)
-		for (auto& c : r)
-			c = distR1(mt);
-
-	mFertilizerRate.resize(mnHeight);
-	for (auto& sub : mFertilizerRate)
-		sub.resize(mnWidth, 0.f);
-	for (auto& r : mFertilizerRate)
-		for (auto& c : r)
-			c = distR2(mt);
-
-	// low and high limits
-	mGrassThresh.resize(mnHeight);
-	for (auto& sub : mGrassThresh)
-		sub.resize(mnWidth, std::make_pair(0.f, _gm));
-
-	mFertilizerThresh.resize(mnHeight);
-	for (auto& sub : mFertilizerThresh)
-		sub.resize(mnWidth, std::make_pair(0.f, _fm));
-
-	// normalize gradient towards centre of grid
-	std::uniform_real_distribution<float> dist{};
-	unsigned centreRow = mnHeight / 2;
-	unsigned centreCol = mnWidth / 2;
-	float maxD = sqrtf(static_cast<float>(centreRow*centreRow + centreCol * centreCol));
-	for (unsigned i = 0; i < mnHeight; ++i)
-	{
-		for (unsigned j = 0; j < mnWidth; ++j)
+	// the planes are only shaped here, the tile passes below write every cell of them. the space layer is
+	// chunked and allocates nothing up front
+	mSpaceLayer.Resize(mnWidth, mnHeight, CreatureHandle{});
+	for (Grid<float>* g : { &mGrassLayer, &mFertilizerLayer, &mGrassNext, &mSpillAmount, &mGrassLayerRate, &mFertilizerRate, &mFertilizerThreshLo })
+		g->Reshape(mnWidth, mnHeight);
+	mSpillDir.Reshape(mnWidth, mnHeight);
+	mGrassRatio.Resize(mnWidth, mnHeight);
+	mnUpdateCount = 0;
+
+	mnTilesX = (mnWidth + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	mnTilesY = (mnHeight + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	mTileDirty.assign(static_cast<std::size_t>(mnTilesX) * mnTilesY, DIRTY_ALL);
+	mTileGrassChanged.assign(static_cast<std::size_t>(mnTilesX) * mnTilesY, 0);
+	mTileGrassDelta.assign(static_cast<std::size_t>(mnTilesX) * mnTilesY, 0.0);
+	mTileRatioDelta.assign(static_cast<std::size_t>(mnTilesX) * mnTilesY, 0.0);
+	mOverfull.assign(static_cast<std::size_t>(mnTilesX) * mnTilesY * TERRAIN_TILE_SIZE, 0u);
+	WakeAll();
+
+	// low and high limits, only the fertilizer's normal ratio differs from cell to cell
+	mfGrassLo = 0.f;
+	mfGrassHi = _gm;
+	mfFertilizerHi = _fm;
+
+	// path finding, scratch node grids are sized on their first search
+	const std::size_t workers = mScratch.size();
+	mScratch.clear();
+	mScratch.resize(workers);
+	mFlowFields.Reset(mnWidth, mnHeight);
+	mnHashSeed = mpRandom->Stream(STREAM_TERRAIN_HASH)();
+
+	// every draw is a counter hash of the cell's index under a key per layer, so bands fill in any order on
+	// any thread and still come out the same
+	Rng rng = mpRandom->Stream(STREAM_TERRAIN_INIT);
+	const std::uint64_t grassRateKey = rng();
+	const std::uint64_t fertRateKey = rng();
+	const std::uint64_t grassNoiseKey = rng();
+	const std::uint64_t fertNoiseKey = rng();
+	const std::uint64_t pickKey = rng();
+	const std::uint64_t grassKey = rng();
+
+	// normalize gradient towards centre of grid, the whole world's when the map is a part of one
+	const bool framed = mnWorldWidth && mnWorldHeight;
+	const unsigned centreRow = (framed ? mnWorldHeight : mnHeight) / 2;
+	const unsigned centreCol = (framed ? mnWorldWidth : mnWidth) / 2;
+	const unsigned fx = framed ? mnFrameX : 0;
+	const unsigned fy = framed ? mnFrameY : 0;
+	const float maxD = sqrtf(static_cast<float>(centreRow*centreRow + centreCol * centreCol));
+
+	// the initial grass goes on the cells whose pick hashes are the lowest, the first of a random shuffle of
+	// every cell, so the count is exact and nothing is drawn twice however close _iga is to 1. the top bits
+	// bucket the hashes up and only the bucket the count ends in is sorted
+	const std::size_t cells = static_cast<std::size_t>(mnWidth) * mnHeight;
+	const std::size_t times = Min(static_cast<std::size_t>(_iga * static_cast<float>(cells)), cells);
+	const unsigned threads = mpPool ? mpPool->GetThreadCount() : 1u;
+	std::vector<unsigned> buckets(static_cast<std::size_t>(threads) << TERRAIN_INIT_BUCKET_BITS, 0u);
+
+	// bands of whole rows, a tile high so the pyramid's levels up to a tile's stay inside one. whole rows
+	// keep every plane streaming in order where square tiles would jump a page per row
+	const unsigned bands = mnTilesY;
+	auto forBands = [this, bands](auto&& _func)
+	{
+		auto band = [this, &_func](unsigned _i, unsigned _worker)
+		{
+			const unsigned y0 = _i * TERRAIN_TILE_SIZE;
+			_func(_i, y0, Min(y0 + TERRAIN_TILE_SIZE, mnHeight), _worker);
+		};
+		if (mpPool)
+			mpPool->ParallelFor(bands, band);
+		else
+			for (unsigned i = 0; i < bands; ++i)
+				band(i, 0);
+	};
+
+	const float noise = mfRateNoise;
+	const float noiseScale = mfRateNoiseScale;
+	forBands([&](unsigned, unsigned _y0, unsigned _y1, unsigned _worker)
+	{
+		unsigned* count = buckets.data() + (static_cast<std::size_t>(_worker) << TERRAIN_INIT_BUCKET_BITS);
+		for (unsigned i = _y0; i < _y1; ++i)
+		{
+			float* grassRate = mGrassLayerRate.Row(i);
+			float* fertRate = mFertilizerRate.Row(i);
+			float* threshLo = mFertilizerThreshLo.Row(i);
+			float* fert = mFertilizerLayer.Row(i);
+			// padding too, checkpoints store it
+			std::fill(mGrassNext.Row(i), mGrassNext.Row(i) + mGrassNext.GetStride(), 0.f);
+			std::fill(mSpillAmount.Row(i), mSpillAmount.Row(i) + mSpillAmount.GetStride(), 0.f);
+			std::fill(mSpillDir.Row(i), mSpillDir.Row(i) + mSpillDir.GetStride(), static_cast<signed char>(-1));
+			for (Grid<float>* g : { &mGrassLayer, &mGrassLayerRate, &mFertilizerRate, &mFertilizerThreshLo, &mFertilizerLayer })
+				std::fill(g->Row(i) + mnWidth, g->Row(i) + g->GetStride(), 0.f);
+			for (unsigned j = 0; j < mnWidth; ++j)
+			{
+				const std::uint64_t idx = static_cast<std::uint64_t>(i) * mnWidth + j;
+				float g = HashFloat(grassRateKey, idx);
+				float f = HashFloat(fertRateKey, idx);
+				if (noise > 0.f)
+				{
+					const float nx = static_cast<float>(fx + j) / noiseScale;
+					const float ny = static_cast<float>(fy + i) / noiseScale;
+					g = Lerp(g, ValueNoise(grassNoiseKey, nx, ny), noise);
+					f = Lerp(f, ValueNoise(fertNoiseKey, nx, ny), noise);
+				}
+				grassRate[j] = _grl + (_grh - _grl) * g;
+				fertRate[j] = _frl + (_frh - _frl) * f;
+
+				const unsigned wi = fy + i;
+				const unsigned wj = fx + j;
+				const float d = sqrtf(static_cast<float>((centreRow - wi)*(centreRow - wi) + (centreCol - wj)*(centreCol - wj)));
+				threshLo[j] = 1.f - d / maxD;
+				fert[j] = threshLo[j] * mfFertilizerHi;
+
+				++count[CounterHash(pickKey, idx) >> (64 - TERRAIN_INIT_BUCKET_BITS)];
+			}
+		}
+	});
+
+	// the bucket the count ends in, every cell of the ones below it gets grass
+	std::size_t below = 0;
+	unsigned cut = 0;
+	for (unsigned b = 0; b < (1u << TERRAIN_INIT_BUCKET_BITS) && times; ++b)
+	{
+		std::size_t n = 0;
+		for (unsigned t = 0; t < threads; ++t)
+			n += buckets[(static_cast<std::size_t>(t) << TERRAIN_INIT_BUCKET_BITS) + b];
+		if (below + n >= times)
+		{
+			cut = b;
+			break;
+		}
+		below += n;
+	}
+
+	const float grassRange = mfGrassHi - mfGrassLo;
+	Grid<float>& ratio = mGrassRatio.GetBase();
+	std::vector<std::vector<std::pair<std::uint64_t, std::uint64_t>>> edge(threads);
+	forBands([&](unsigned, unsigned _y0, unsigned _y1, unsigned _worker)
+	{
+		for (unsigned i = _y0; i < _y1; ++i)
+		{
+			float* grass = mGrassLayer.Row(i);
+			for (unsigned j = 0; j < mnWidth; ++j)
+			{
+				const std::uint64_t idx = static_cast<std::uint64_t>(i) * mnWidth + j;
+				const std::uint64_t pick = CounterHash(pickKey, idx);
+				const unsigned b = static_cast<unsigned>(pick >> (64 - TERRAIN_INIT_BUCKET_BITS));
+				grass[j] = b < cut ? (_igl + (_igh - _igl) * HashFloat(grassKey, idx)) * grassRange : 0.f;
+				if (b == cut && times)
+					edge[_worker].emplace_back(pick, idx);
+				ratio(j, i) = grass[j] / grassRange;
+			}
+		}
+	});
+
+	// lowest hash first, the index settles the (all but impossible) ties
+	std::vector<std::pair<std::uint64_t, std::uint64_t>> last;
+	for (auto& e : edge)
+		last.insert(last.end(), e.begin(), e.end());
+	const std::size_t need = times - below;
+	if (need && need < last.size())
+		std::nth_element(last.begin(), last.begin() + (need - 1), last.end());
+	for (std::size_t k = 0; k < need && k < last.size(); ++k)
+	{
+		const std::uint64_t idx = last[k].second;
+		const unsigned row = static_cast<unsigned>(idx / mnWidth);
+		const unsigned col = static_cast<unsigned>(idx - static_cast<std::uint64_t>(row) * mnWidth);
+		mGrassLayer(col, row) = (_igl + (_igh - _igl) * HashFloat(grassKey, idx)) * grassRange;
+		ratio(col, row) = mGrassLayer(col, row) / grassRange;
+	}
+
+	// a band's own levels of the pyramid side by side, the few above them after
+	constexpr unsigned tileLevels = 6;
+	static_assert(TERRAIN_TILE_SIZE == 1 << tileLevels, "a band is one cell high on its top level");
+	std::vector<double> bandGrass(bands, 0.0);
+	std::vector<double> bandRatio(bands, 0.0);
+	forBands([&](unsigned _i, unsigned _y0, unsigned _y1, unsigned)
+	{
+		mGrassRatio.RebuildRect(0, _y0, mnWidth, _y1, tileLevels);
+		for (unsigned i = _y0; i < _y1; ++i)
 		{
-			float d = sqrtf(static_cast<float>((centreRow - i)*(centreRow - i) + (centreCol - j)*(centreCol - j)));
-			mFertilizerThresh[i][j].first = 1.f - d / maxD;
-			mFertilizerLayer[i][j] = mFertilizerThresh[i][j].first * mFertilizerThresh[i][j].second;
+			const float* grass = mGrassLayer.Row(i);
+			for (unsigned j = 0; j < mnWidth; ++j)
+			{
+				bandGrass[_i] += grass[j];
+				bandRatio[_i] += grass[j] / mfGrassHi;
+			}
 		}
+	});
+	mGrassRatio.RebuildLevels(tileLevels + 1);
+	mfGrassTotal = 0.0;
+	mfGrassRatioSum = 0.0;
+	for (unsigned b = 0; b < bands; ++b)
+	{
+		mfGrassTotal += bandGrass[b];
+		mfGrassRatioSum += bandRatio[b];
+	}
+
+	// lazy state sized for the new world
+	if (mbLazy)
+	{
+		mbLazy = false;
+		SetLazy(true);
 	}
+}
 
-	// node style for path finding
-	mNodeLayer.resize(mnHeight);
-	for (int i = 0; i < static_cast<int>(mnHeight); ++i)
+void CS380::Terrain::Save(CheckpointWriter& _w) const
+{
+	_w.Pod(mnWidth);
+	_w.Pod(mnHeight);
+	_w.Pod(mnUpdateCount);
+	_w.Pod(mnHashSeed);
+	_w.Pod(mfLastDt);
+	_w.Pod(mfGrassTotal);
+	_w.Pod(mfGrassRatioSum);
+
+	_w.Pod(mfGrassLo);
+	_w.Pod(mfGrassHi);
+	_w.Pod(mfFertilizerHi);
+
+	for (const Grid<float>* g : { &mGrassLayer, &mFertilizerLayer, &mGrassLayerRate, &mFertilizerRate, &mFertilizerThreshLo,
+		&mGrassNext, &mSpillAmount })
+		_w.Plane(*g);
+	_w.Plane(mSpillDir);
+	_w.Vector(mAwake);
+	_w.Vector(mOverfull);
+
+	_w.Pod(mbLazy);
+	if (mbLazy)
 	{
-		mNodeLayer[i].resize(mnWidth, Node{});
-		for (int j = 0; j < static_cast<int>(mnWidth); ++j)
-			mNodeLayer[i][j] = Node{ GridPos{ j, i}, 0.f, 0.f };
+		_w.Plane(mLastTick);
+		_w.Plane(mPendingSpill);
+		_w.Vector(mTileDue);
 	}
 
-	std::uniform_real_distribution<float> distF(_igl, _igh);
-	std::uniform_int_distribution<unsigned> distI(0, mnWidth * mnHeight - 1);
+	// only the head of each occupied cell, the rest of a cell's list lives in the creatures' hot data
+	std::vector<CellHead> heads;
+	for (unsigned y = 0; y < mnHeight; ++y)
+		for (unsigned x = 0; x < mnWidth; ++x)
+			if (mSpaceLayer(x, y).IsValid())
+				heads.push_back(CellHead{ y * mnWidth + x, mSpaceLayer(x, y) });
+	_w.Vector(heads);
 
-	unsigned times = static_cast<unsigned>(_iga * static_cast<float>(mnWidth * mnHeight));
-	for (unsigned i = 0; i < times; ++i)
+	mFlowFields.Save(_w);
+}
+
+bool CS380::Terrain::Load(CheckpointReader& _r)
+{
+	const unsigned w = _r.Pod<unsigned>();
+	const unsigned h = _r.Pod<unsigned>();
+	if (_r.Failed() || !w || !h)
+		return false;
+
+	mnWidth = w;
+	mnHeight = h;
+	_r.Pod(mnUpdateCount);
+	_r.Pod(mnHashSeed);
+	_r.Pod(mfLastDt);
+	_r.Pod(mfGrassTotal);
+	_r.Pod(mfGrassRatioSum);
+
+	_r.Pod(mfGrassLo);
+	_r.Pod(mfGrassHi);
+	_r.Pod(mfFertilizerHi);
+
+	for (Grid<float>* g : { &mGrassLayer, &mFertilizerLayer, &mGrassLayerRate, &mFertilizerRate, &mFertilizerThreshLo,
+		&mGrassNext, &mSpillAmount })
+		_r.Plane(*g, w, h);
+	_r.Plane(mSpillDir, w, h);
+
+	mnTilesX = (mnWidth + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	mnTilesY = (mnHeight + TERRAIN_TILE_SIZE - 1) / TERRAIN_TILE_SIZE;
+	const std::size_t tiles = static_cast<std::size_t>(mnTilesX) * mnTilesY;
+	_r.Vector(mAwake);
+	_r.Vector(mOverfull);
+	if (mAwake.size() != tiles * TERRAIN_TILE_SIZE || mOverfull.size() != tiles * TERRAIN_TILE_SIZE)
+		_r.Fail();
+	mTileDirty.assign(tiles, DIRTY_ALL);
+	mTileGrassChanged.assign(tiles, 0);
+	mTileGrassDelta.assign(tiles, 0.0);
+	mTileRatioDelta.assign(tiles, 0.0);
+
+	_r.Pod(mbLazy);
+	if (mbLazy)
 	{
-		unsigned idx = distI(mt);
-		unsigned row = idx / mnWidth;
-		unsigned col = idx - (row * mnWidth);
-		if (mGrassLayer[row][col] > 0)
-			--i;
-		else
-			mGrassLayer[row][col] = distF(mt) * (mGrassThresh[row][col].second - mGrassThresh[row][col].first);
+		_r.Plane(mLastTick, w, h);
+		_r.Plane(mPendingSpill, w, h);
+		_r.Vector(mTileDue);
+		if (mTileDue.size() != tiles)
+			_r.Fail();
+	}
+	else
+	{
+		mLastTick = Grid<unsigned>{};
+		mPendingSpill = Grid<float>{};
+		mTileDue.clear();
+	}
+
+	std::vector<CellHead> heads;
+	_r.Vector(heads);
+	mSpaceLayer.Resize(mnWidth, mnHeight, CreatureHandle{});
+	for (const auto& c : heads)
+	{
+		if (c.mnCell >= mnWidth * mnHeight)
+		{
+			_r.Fail();
+			break;
+		}
+		mSpaceLayer.Touch(c.mnCell % mnWidth, c.mnCell / mnWidth) = c.mHead;
 	}
+
+	mFlowFields.Load(_r, mnWidth, mnHeight);
+	if (_r.Failed())
+		return false;
+
+	// the grass ratio is grass / (hi - lo) as Init and the updates keep it, eager or lazy
+	mGrassRatio.Resize(mnWidth, mnHeight);
+	Grid<float>& ratio = mGrassRatio.GetBase();
+	for (unsigned y = 0; y < mnHeight; ++y)
+		for (unsigned x = 0; x < mnWidth; ++x)
+			ratio(x, y) = mGrassLayer(x, y) / (mfGrassHi - mfGrassLo);
+	mGrassRatio.RebuildLevels();
+
+	const std::size_t workers = mScratch.size();
+	mScratch.clear();
+	mScratch.resize(workers);
+	return true;
 }
 
-const CS380::Map<int>& CS380::Terrain::GetSpaceLayer(void) const noexcept
+const CS380::ChunkedGrid<CS380::CreatureHandle>& CS380::Terrain::GetSpaceLayer(void) const noexcept
 {
 	return mSpaceLayer;
 }
 
-CS380::Map<int>& CS380::Terrain::GetSpaceLayer(void) noexcept
+CS380::ChunkedGrid<CS380::CreatureHandle>& CS380::Terrain::GetSpaceLayer(void) noexcept
 {
 	return mSpaceLayer;
 }
 
-const CS380::Map<float>& CS380::Terrain::GetGrassLayer(void) const noexcept
+const CS380::Grid<float>& CS380::Terrain::GetGrassLayer(void) const noexcept
 {
 	return mGrassLayer;
 }
 
-CS380::Map<float>& CS380::Terrain::GetGrassLayer(void) noexcept
+CS380::Grid<float>& CS380::Terrain::GetGrassLayer(void) noexcept
 {
 	return mGrassLayer;
 }
 
-const CS380::Map<float>& CS380::Terrain::GetFertilizerLayer(void) const noexcept
+const CS380::Grid<float>& CS380::Terrain::GetFertilizerLayer(void) const noexcept
 {
 	return mFertilizerLayer;
 }
 
-CS380::Map<float>& CS380::Terrain::GetFertilizerLayer(void) noexcept
+CS380::Grid<float>& CS380::Terrain::GetFertilizerLayer(void) noexcept
 {
 	return mFertilizerLayer;
 }
 
-const CS380::Map<float>& CS380::Terrain::GetGrassLayerRate(void) const noexcept
+const CS380::Grid<float>& CS380::Terrain::GetGrassLayerRate(void) const noexcept
 {
 	return mGrassLayerRate;
 }
 
-CS380::Map<float>& CS380::Terrain::GetGrassLayerRate(void) noexcept
+CS380::Grid<float>& CS380::Terrain::GetGrassLayerRate(void) noexcept
 {
 	return mGrassLayerRate;
 }
 
-const CS380::Map<std::pair<float, float>>& CS380::Terrain::GetGrassLayerThresh(void) const noexcept
+float CS380::Terrain::GetGrassThreshLo(void) const noexcept
+{
+	return mfGrassLo;
+}
+
+float CS380::Terrain::GetGrassThreshHi(void) const noexcept
+{
+	return mfGrassHi;
+}
+
+const CS380::Grid<float>& CS380::Terrain::GetFertilizerThreshLo(void) const noexcept
+{
+	return mFertilizerThreshLo;
+}
+
+float CS380::Terrain::GetFertilizerThreshHi(void) const noexcept
+{
+	return mfFertilizerHi;
+}
+
+void CS380::Terrain::SetWorldFrame(unsigned _x, unsigned _y, unsigned _w, unsigned _h) noexcept
+{
+	mnFrameX = _x;
+	mnFrameY = _y;
+	mnWorldWidth = _w;
+	mnWorldHeight = _h;
+}
+
+void CS380::Terrain::SetRateNoise(float _mix, float _scale) noexcept
+{
+	mfRateNoise = Clamp(0.f, 1.f, _mix);
+	mfRateNoiseScale = Max(_scale, 1.f);
+}
+
+void CS380::Terrain::SetThreadPool(ThreadPool* _pool) noexcept
 {
-	return mGrassThresh;
+	mpPool = _pool;
 }
 
-CS380::Map<std::pair<float, float>>& CS380::Terrain::GetGrassLayerThresh(void) noexcept
+void CS380::Terrain::SetRandom(const Random* _random) noexcept
 {
-	return mGrassThresh;
+	mpRandom = _random;
 }
 
-const CS380::Map<std::pair<float, float>>& CS380::Terrain::GetFertilizerLayerThresh(void) const noexcept
+void CS380::Terrain::SetProfiler(Profiler* _profiler) noexcept
 {
-	return mFertilizerThresh;
+	mpProfiler = _profiler;
 }
 
-CS380::Map<std::pair<float, float>>& CS380::Terrain::GetFertilizerLayerThresh(void) noexcept
+void CS380::Terrain::SetPathArena(PathArena* _paths) noexcept
 {
-	return mFertilizerThresh;
+	mpPaths = _paths;
 }
 
 void CS380::Terrain::Update(float _dt) noexcept
 {
-	for (unsigned short y = 0; y < mnHeight; ++y)
+	// growth reads mGrassLayer and writes mGrassNext, spill lands in the gather pass,
+	// so no tile ever writes a cell another tile reads
+	const unsigned tilesX = mnTilesX;
+	const unsigned tiles = mnTilesX * mnTilesY;
+	if (_dt != mfLastDt)
 	{
-		for (unsigned short x = 0; x < mnWidth; ++x)
+		if (mbLazy)
+			SettleAll();
+		else
+			WakeAll();
+		mfLastDt = _dt;
+	}
+
+	if (mbLazy)
+	{
+		// nothing is swept, cells catch up when read and tiles only settle when their spill is due. a tile is
+		// only dirty once settled or edited, so the map shows a growing tile as of its last settle
+		++mnUpdateCount;
+		for (unsigned i = 0; i < tiles; ++i)
+			if (mTileDue[i] <= mnUpdateCount)
+				mTileDue[i] = SettleTile(i % tilesX, i / tilesX) ? mnUpdateCount + LAZY_SPILL_INTERVAL : LAZY_NEVER;
+		return;
+	}
+
+	if (mpPool)
+	{
+		mpPool->ParallelFor(tiles, [this, tilesX, _dt](unsigned _i, unsigned) { UpdateTile(_i % tilesX, _i / tilesX, _dt); });
+		mpPool->ParallelFor(tiles, [this, tilesX](unsigned _i, unsigned) { GatherTile(_i % tilesX, _i / tilesX); });
+	}
+	else
+	{
+		for (unsigned i = 0; i < tiles; ++i)
+			UpdateTile(i % tilesX, i / tilesX, _dt);
+		for (unsigned i = 0; i < tiles; ++i)
+			GatherTile(i % tilesX, i / tilesX);
+	}
+
+	mGrassLayer.Swap(mGrassNext);
+	// max is exact, rebuilding under the tiles that moved gives the same levels as a full rebuild
+	for (unsigned i = 0; i < tiles; ++i)
+	{
+		if (!mTileGrassChanged[i])
+			continue;
+		mfGrassTotal += mTileGrassDelta[i];
+		mfGrassRatioSum += mTileRatioDelta[i];
+		const unsigned x0 = (i % tilesX) * TERRAIN_TILE_SIZE;
+		const unsigned y0 = (i / tilesX) * TERRAIN_TILE_SIZE;
+		mGrassRatio.RebuildRect(x0, y0, Min(x0 + TERRAIN_TILE_SIZE, mnWidth), Min(y0 + TERRAIN_TILE_SIZE, mnHeight));
+	}
+	++mnUpdateCount;
+}
+
+void CS380::Terrain::UpdateTile(unsigned _tx, unsigned _ty, float _dt) noexcept
+{
+	const unsigned x0 = _tx * TERRAIN_TILE_SIZE;
+	const unsigned y0 = _ty * TERRAIN_TILE_SIZE;
+	const unsigned x1 = Min(x0 + TERRAIN_TILE_SIZE, mnWidth);
+	const unsigned y1 = Min(y0 + TERRAIN_TILE_SIZE, mnHeight);
+	const std::size_t word = GetAwakeWord(x0, y0);
+	bool awakeTile = false;
+
+	for (unsigned y = y0; y < y1; ++y)
+	{
+		std::uint64_t& awake = mAwake[word + (y - y0)];
+		std::uint64_t& over = mOverfull[word + (y - y0)];
+		if (!awake)
+			continue;
+		awakeTile = true;
+
+		unsigned x = x0;
+#if defined(TERRAIN_SIMD_WIDTH)
+		GrowthRow row{ mFertilizerLayer.Row(y), mGrassLayer.Row(y), mGrassNext.Row(y), mSpillDir.Row(y),
+					   mFertilizerRate.Row(y), mGrassLayerRate.Row(y),
+					   mFertilizerThreshLo.Row(y), mfFertilizerHi, mfGrassHi };
+		for (; x + TERRAIN_SIMD_WIDTH <= x1; x += TERRAIN_SIMD_WIDTH)
 		{
-			mFertilizerLayer[y][x] = Clamp(mFertilizerThresh[y][x].first, mFertilizerThresh[y][x].second, mFertilizerLayer[y][x] + (mFertilizerRate[y][x] * _dt * mFertilizerThresh[y][x].second));
+			const std::uint64_t bits = awake >> (x - x0) & TERRAIN_SIMD_MASK;
+			// growing cells never sleep, so a block with a sleeper in it has a saturated cell for the scalar path
+			// anyway, as do blocks GrowBlock turns down for the spill
+			if (bits == TERRAIN_SIMD_MASK && GrowBlock(row, x, _dt))
+				continue;
+			for (unsigned i = 0; i < TERRAIN_SIMD_WIDTH; ++i)
+				if (bits >> i & 1u)
+					StepCell(x + i, y, _dt, awake, over);
+		}
+		if (x == x1)
+			continue;
+#endif
+		for (std::uint64_t bits = awake >> (x - x0); bits; bits &= bits - 1)
+			StepCell(x + LowestBit(bits), y, _dt, awake, over);
+	}
+
+	// fertilizer drifts in every awake cell, checking each one would cost as much as drawing it
+	if (awakeTile)
+		mTileDirty[_ty * mnTilesX + _tx] |= DIRTY_FERTILIZER;
+}
+
+void CS380::Terrain::StepCell(unsigned _x, unsigned _y, float _dt, std::uint64_t& _awake, std::uint64_t& _over) noexcept
+{
+	if (UpdateCell(_x, _y, _dt))
+		return;
+
+	const std::uint64_t bit = std::uint64_t{ 1 } << (_x % TERRAIN_TILE_SIZE);
+	_awake &= ~bit;
+	if (mGrassLayer(_x, _y) > mfGrassHi)
+		_over |= bit;
+	else
+		_over &= ~bit;
+}
+
+bool CS380::Terrain::UpdateCell(unsigned _x, unsigned _y, float _dt) noexcept
+{
+	float& fert = mFertilizerLayer(_x, _y);
+	float& fertLo = mFertilizerThreshLo(_x, _y);
+	const float fertHi = mfFertilizerHi;
+	const float grassHi = mfGrassHi;
+	const float grass = mGrassLayer(_x, _y);
+	const float fertWas = fert;
+	const float fertLoWas = fertLo;
+
+	fert = Clamp(fertLo, fertHi, fert + (mFertilizerRate(_x, _y) * _dt * fertHi));
+
+	float rate = mGrassLayerRate(_x, _y) * _dt * grassHi;
+	float consumableValue = Min(fert, rate);
+	mGrassNext(_x, _y) = grass;
+	mSpillDir(_x, _y) = -1;
+	// growing cells always move, fertilizer never runs dry while its rate is above 0
+	bool moving = true;
+	// birthed out by neighbours
+	if (grass >= grassHi)
+	{
+		int d = GetLowestGrass(_x, _y);
+		if (d < 0)
+			return fert != fertWas;
+		consumableValue /= 8.f;
+		// a neighbour already at its limit gets clamped straight back by the gather, so the spill is dropped
+		const unsigned nx = static_cast<unsigned>(static_cast<int>(_x) + NeighbourDX[d]);
+		const unsigned ny = static_cast<unsigned>(static_cast<int>(_y) + NeighbourDY[d]);
+		moving = mGrassLayer(nx, ny) != mfGrassHi;
+		if (moving)
+		{
+			mSpillDir(_x, _y) = static_cast<signed char>(d);
+			mSpillAmount(_x, _y) = consumableValue;
+		}
+	}
+	// normal rates
+	else
+	{
+		mGrassNext(_x, _y) += consumableValue;
+	}
+	fert = Clamp(0.f, fertHi, fert - consumableValue);
+	fertLo = fert / fertHi;
+	// the lowest neighbour only leaves its limit by being eaten, which wakes this cell again
+	return moving || fert != fertWas || fertLo != fertLoWas;
+}
 
-			float rate = mGrassLayerRate[y][x] * _dt * mGrassThresh[y][x].second;
-			float consumableValue = Min(mFertilizerLayer[y][x], rate);
-			// birthed out by neighbours
-			if (mGrassLayer[y][x] >= mGrassThresh[y][x].second)
+void CS380::Terrain::GatherTile(unsigned _tx, unsigned _ty) noexcept
+{
+	const unsigned x0 = _tx * TERRAIN_TILE_SIZE;
+	const unsigned y0 = _ty * TERRAIN_TILE_SIZE;
+	const unsigned y1 = Min(y0 + TERRAIN_TILE_SIZE, mnHeight);
+
+	Grid<float>& ratio = mGrassRatio.GetBase();
+	const std::size_t word = GetAwakeWord(x0, y0);
+	bool changed = false;
+	double grassDelta = 0.0;
+	double ratioDelta = 0.0;
+	for (unsigned y = y0; y < y1; ++y)
+	{
+		std::uint64_t& awake = mAwake[word + (y - y0)];
+		std::uint64_t& over = mOverfull[word + (y - y0)];
+		// a sleeper at its limit takes any spill without moving
+		for (std::uint64_t bits = awake | over; bits; bits &= bits - 1)
+		{
+			const unsigned bit = LowestBit(bits);
+			const unsigned x = x0 + bit;
+			// fixed neighbour order keeps the clamped sum independent of tiling. the cell gathers from neighbour
+			// (x - dx, y - dy) when that neighbour spilled in direction d
+			float v = mGrassNext(x, y);
+			for (int d = 0; d < 8; ++d)
 			{
-				auto p = GetLowestGrass({ x,y });
-				if (p.x < 0 || p.y < 0)
-					continue;
-				consumableValue /= 8.f;
-				mGrassLayer[p.y][p.x] = Clamp(0.f, mGrassThresh[p.y][p.x].second, mGrassLayer[p.y][p.x] + consumableValue);
+				int sx = static_cast<int>(x) - NeighbourDX[d];
+				int sy = static_cast<int>(y) - NeighbourDY[d];
+				if (mSpillDir.InBounds(sx, sy) && mSpillDir(sx, sy) == d)
+					v = Clamp(0.f, mfGrassHi, v + mSpillAmount(sx, sy));
 			}
-			// normal rates
-			else
+			mGrassNext(x, y) = v;
+			ratio(x, y) = v / (mfGrassHi - mfGrassLo);
+			if (v == mGrassLayer(x, y))
+				continue;
+			changed = true;
+			const float delta = v - mGrassLayer(x, y);
+			grassDelta += delta;
+			ratioDelta += delta / mfGrassHi;
+			// a clamped sleeper is not at rest any more, and its other buffer still holds the old value
+			const std::uint64_t mask = std::uint64_t{ 1 } << bit;
+			if (over & mask)
 			{
-				mGrassLayer[y][x] += consumableValue;
+				over &= ~mask;
+				awake |= mask;
 			}
-			mFertilizerLayer[y][x] = Clamp(0.f, mFertilizerThresh[y][x].second, mFertilizerLayer[y][x] - consumableValue);
-			mFertilizerThresh[y][x].first = mFertilizerLayer[y][x] / mFertilizerThresh[y][x].second;
+		}
+	}
+	mTileGrassChanged[_ty * mnTilesX + _tx] = changed;
+	mTileGrassDelta[_ty * mnTilesX + _tx] = grassDelta;
+	mTileRatioDelta[_ty * mnTilesX + _tx] = ratioDelta;
+	if (changed)
+		mTileDirty[_ty * mnTilesX + _tx] |= DIRTY_GRASS;
+}
+
+double CS380::Terrain::GetGrassTotal(void) const noexcept
+{
+	return mfGrassTotal;
+}
 
+double CS380::Terrain::GetGrassRatioSum(void) const noexcept
+{
+	return mfGrassRatioSum;
+}
+
+void CS380::Terrain::RecountGrass(void) noexcept
+{
+	mfGrassTotal = 0.0;
+	mfGrassRatioSum = 0.0;
+	for (unsigned y = 0; y < mnHeight; ++y)
+	{
+		const float* grass = mGrassLayer.Row(y);
+		for (unsigned x = 0; x < mnWidth; ++x)
+		{
+			mfGrassTotal += grass[x];
+			mfGrassRatioSum += grass[x] / mfGrassHi;
 		}
 	}
 }
 
 float CS380::Terrain::ConsumeGrass(unsigned _x, unsigned _y, float _val) noexcept
 {
-	if (_x > mnWidth || _y > mnHeight)
+	if (_x >= mnWidth || _y >= mnHeight)
 		return 0;
 
-	float v = Min(_val * (mGrassThresh[_y][_x].second - mGrassThresh[_y][_x].first), mGrassLayer[_y][_x]);
-	float result = Clamp(mGrassThresh[_y][_x].first, mGrassThresh[_y][_x].second, mGrassLayer[_y][_x] - v);
-	v = mGrassLayer[_y][_x] - result;
-	mGrassLayer[_y][_x] = result;
+	Settle(_x, _y);
+	float v = Min(_val * (mfGrassHi - mfGrassLo), mGrassLayer(_x, _y));
+	float result = Clamp(mfGrassLo, mfGrassHi, mGrassLayer(_x, _y) - v);
+	v = mGrassLayer(_x, _y) - result;
+	mGrassLayer(_x, _y) = result;
+	mfGrassTotal -= v;
+	mfGrassRatioSum -= v / mfGrassHi;
+	MarkDirty(_x, _y, DIRTY_GRASS);
+	if (mbLazy)
+	{
+		// the neighbours may spill into it now
+		ScheduleAround(_x, _y);
+		return v;
+	}
+
+	mGrassRatio.Set(_x, _y, result / (mfGrassHi - mfGrassLo));
+	// the neighbours may spill into it now
+	WakeAround(_x, _y);
 	return v;
 }
 
+void CS380::Terrain::AddFertilizer(unsigned _x, unsigned _y, float _v) noexcept
+{
+	Settle(_x, _y);
+	mFertilizerLayer(_x, _y) += _v;
+	MarkDirty(_x, _y, DIRTY_FERTILIZER);
+	Wake(_x, _y);
+}
+
+void CS380::Terrain::SetCell(unsigned _x, unsigned _y, float _grass, float _fert, float _fertLo) noexcept
+{
+	if (_x >= mnWidth || _y >= mnHeight)
+		return;
+
+	Settle(_x, _y);
+	const float v = _grass - mGrassLayer(_x, _y);
+	mGrassLayer(_x, _y) = _grass;
+	mFertilizerLayer(_x, _y) = _fert;
+	mFertilizerThreshLo(_x, _y) = _fertLo;
+	mfGrassTotal += v;
+	mfGrassRatioSum += v / mfGrassHi;
+	MarkDirty(_x, _y, DIRTY_GRASS | DIRTY_FERTILIZER);
+	if (mbLazy)
+	{
+		ScheduleAround(_x, _y);
+		return;
+	}
+
+	mGrassRatio.Set(_x, _y, _grass / (mfGrassHi - mfGrassLo));
+	WakeAround(_x, _y);
+}
+
+void CS380::Terrain::Wake(unsigned _x, unsigned _y) noexcept
+{
+	mAwake[GetAwakeWord(_x, _y)] |= std::uint64_t{ 1 } << (_x % TERRAIN_TILE_SIZE);
+}
+
+unsigned long long CS380::Terrain::GetAwakeCells(void) const noexcept
+{
+	// lazy mode sweeps no cell
+	if (mbLazy)
+		return 0;
+	unsigned long long n = 0;
+	for (std::uint64_t w : mAwake)
+		for (; w; w &= w - 1)
+			++n;
+	return n;
+}
+
+std::size_t CS380::Terrain::GetAwakeWord(unsigned _x, unsigned _y) const noexcept
+{
+	return (static_cast<std::size_t>(_y / TERRAIN_TILE_SIZE) * mnTilesX + _x / TERRAIN_TILE_SIZE) * TERRAIN_TILE_SIZE + _y % TERRAIN_TILE_SIZE;
+}
+
+void CS380::Terrain::WakeAround(unsigned _x, unsigned _y) noexcept
+{
+	for (int j = -1; j < 2; ++j)
+		for (int i = -1; i < 2; ++i)
+			if (mGrassLayer.InBounds(static_cast<int>(_x) + i, static_cast<int>(_y) + j))
+				Wake(_x + i, _y + j);
+}
+
+void CS380::Terrain::WakeAll(void) noexcept
+{
+	// every cell of every tile, edge tiles only get the bits of cells that exist
+	mAwake.assign(static_cast<std::size_t>(mnTilesX) * mnTilesY * TERRAIN_TILE_SIZE, 0u);
+	for (unsigned ty = 0; ty < mnTilesY; ++ty)
+	{
+		for (unsigned tx = 0; tx < mnTilesX; ++tx)
+		{
+			const unsigned w = Min<unsigned>(TERRAIN_TILE_SIZE, mnWidth - tx * TERRAIN_TILE_SIZE);
+			const unsigned h = Min<unsigned>(TERRAIN_TILE_SIZE, mnHeight - ty * TERRAIN_TILE_SIZE);
+			const std::uint64_t row = w == TERRAIN_TILE_SIZE ? ~std::uint64_t{ 0 } : (std::uint64_t{ 1 } << w) - 1;
+			const std::size_t word = GetAwakeWord(tx * TERRAIN_TILE_SIZE, ty * TERRAIN_TILE_SIZE);
+			for (unsigned r = 0; r < h; ++r)
+				mAwake[word + r] = row;
+		}
+	}
+}
+
 unsigned int CS380::Terrain::GetGrassColor(unsigned _x, unsigned _y) const noexcept
 {
-	float r = mGrassLayer[_y][_x] / (mGrassThresh[_y][_x].second - mGrassThresh[_y][_x].first);
-	return ImGui::GetColorU32(Lerp(ImVec4{ 0.f, 0.3f, 0.f, 0.5f }, 
-								   ImVec4{ 0.f, 0.9f, 0.f, 0.8f }, r));
+	return GrassColor(GetGrass(_x, _y) / (mfGrassHi - mfGrassLo));
 }
 
-std::vector<CS380::GridPos> CS380::Terrain::GetShortestPath(const GridPos& _src, const GridPos& _dest) noexcept
+void CS380::Terrain::SetLazy(bool _b) noexcept
 {
-	for (auto& row : mNodeLayer)
+	if (_b == mbLazy)
+		return;
+
+	if (_b)
 	{
-		for (auto& col : row)
+		mLastTick.Resize(mnWidth, mnHeight, static_cast<unsigned>(mnUpdateCount));
+		mPendingSpill.Resize(mnWidth, mnHeight, 0.f);
+		// first settles staggered so they do not all land on the same update
+		mTileDue.resize(static_cast<std::size_t>(mnTilesX) * mnTilesY);
+		for (std::size_t i = 0; i < mTileDue.size(); ++i)
+			mTileDue[i] = mnUpdateCount + 1 + i % LAZY_SPILL_INTERVAL;
+		mbLazy = true;
+		return;
+	}
+
+	SettleAll();
+	mbLazy = false;
+	mLastTick = Grid<unsigned>{};
+	mPendingSpill = Grid<float>{};
+	mTileDue.clear();
+
+	// the eager update picks up from the settled layers, every cell awake
+	Grid<float>& ratio = mGrassRatio.GetBase();
+	for (unsigned y = 0; y < mnHeight; ++y)
+		for (unsigned x = 0; x < mnWidth; ++x)
+			ratio(x, y) = mGrassLayer(x, y) / (mfGrassHi - mfGrassLo);
+	mGrassRatio.RebuildLevels();
+	RecountGrass();
+	WakeAll();
+}
+
+bool CS380::Terrain::IsLazy(void) const noexcept
+{
+	return mbLazy;
+}
+
+float CS380::Terrain::GetGrass(unsigned _x, unsigned _y) const noexcept
+{
+	return mbLazy ? Project(_x, _y).mfGrass : mGrassLayer(_x, _y);
+}
+
+float CS380::Terrain::GetFertilizer(unsigned _x, unsigned _y) const noexcept
+{
+	return mbLazy ? Project(_x, _y).mfFert : mFertilizerLayer(_x, _y);
+}
+
+float CS380::Terrain::GetFertilizerRatio(unsigned _x, unsigned _y) const noexcept
+{
+	return mbLazy ? Project(_x, _y).mfFert / mfFertilizerHi : mFertilizerThreshLo(_x, _y);
+}
+
+CS380::Terrain::LazyCell CS380::Terrain::Project(unsigned _x, unsigned _y) const noexcept
+{
+	// one UpdateCell takes u = min(hi, fert + regen), a growing cell turns min(u, rate) of it into grass and a
+	// saturated one spills an eighth of that and only loses the eighth. the ratio floor UpdateCell also clamps
+	// to never binds while the fertilizer limit is at least 1. so the ticks since the last touch split into a
+	// handful of pieces that each have a closed form: the rate covered, fertilizer used up, or in a saturated
+	// cell fertilizer settling geometrically towards 7 * regen
+	double ticks = static_cast<double>(static_cast<unsigned>(mnUpdateCount) - mLastTick(_x, _y));
+	const double fertHi = mfFertilizerHi;
+	const double grassHi = mfGrassHi;
+	const double regen = static_cast<double>(mFertilizerRate(_x, _y) * mfLastDt) * fertHi;
+	const double rate = static_cast<double>(mGrassLayerRate(_x, _y) * mfLastDt) * grassHi;
+	double fert = mFertilizerLayer(_x, _y);
+	double grass = mGrassLayer(_x, _y);
+	double spill = 0.0;
+
+	while (ticks > 0.0)
+	{
+		const bool saturated = grass >= grassHi;
+		const double u = Min(fertHi, fert + regen);
+		double n = ticks;
+		if (u >= rate)
 		{
-			col.fcost = col.hcost = col.tcost = std::numeric_limits<float>::infinity();
-			col.mpPrev = nullptr;
+			// the full rate every tick, fert moves by e a tick after the first until it hits its cap
+			// or stops covering the rate
+			const double loss = saturated ? rate / 8.0 : rate;
+			const double e = regen - loss;
+			if (e < 0.0)
+				n = Min(n, std::floor((u - rate) / -e) + 1.0);
+			if (!saturated)
+				n = Min(n, std::ceil((grassHi - grass) / rate));
+			n = Max(1.0, n);
+			fert = u - loss + (n - 1.0) * e;
+			if (e >= 0.0)
+				fert = Min(fert, fertHi - loss);
+			if (saturated)
+				spill += n * loss;
+			else
+				grass += n * rate;
 		}
+		else if (!saturated)
+		{
+			// the grass takes all there is, once fert is gone only the regen is left each tick
+			if (fert > 0.0)
+				n = 1.0;
+			else if (regen > 0.0)
+				n = Max(1.0, Min(n, std::ceil((grassHi - grass) / regen)));
+			grass += n * u;
+			fert = 0.0;
+		}
+		else
+		{
+			// f' = 7 / 8 (f + regen), an eighth of u spilled. once 8 * regen is over the rate fert climbs until
+			// it covers the rate again
+			const double q = 7.0 / 8.0;
+			const double rest = 7.0 * regen;
+			if (8.0 * regen > rate)
+				n = Max(1.0, Min(n, std::ceil(std::log((8.0 * regen - rate) / (rest - fert)) / std::log(q))));
+			const double qn = std::pow(q, n);
+			spill += n * regen + (fert - rest) * (1.0 - qn);
+			fert = rest + qn * (fert - rest);
+		}
+		ticks -= n;
 	}
-	
-	std::vector<CS380::GridPos> result;
-	std::priority_queue<Node*, std::vector<Node*>, Comp> q;
-	for (auto & n : GetNeighbours(_src, _dest, 0.f, nullptr))
-		q.push(n);
 
-	while (!q.empty())
+	const float pending = mPendingSpill(_x, _y);
+	float g = static_cast<float>(grass);
+	if (pending > 0.f)
+		g = Clamp(0.f, static_cast<float>(grassHi), g + pending);
+	return LazyCell{ g, static_cast<float>(Max(0.0, fert)), static_cast<float>(spill) };
+}
+
+void CS380::Terrain::Settle(unsigned _x, unsigned _y) noexcept
+{
+	if (!mbLazy)
+		return;
+
+	unsigned& last = mLastTick(_x, _y);
+	const unsigned now = static_cast<unsigned>(mnUpdateCount);
+	if (last == now && mPendingSpill(_x, _y) == 0.f)
+		return;
+
+	const LazyCell c = Project(_x, _y);
+	const float v = c.mfGrass - mGrassLayer(_x, _y);
+	mfGrassTotal += v;
+	mfGrassRatioSum += v / mfGrassHi;
+	mGrassLayer(_x, _y) = c.mfGrass;
+	mFertilizerLayer(_x, _y) = c.mfFert;
+	mFertilizerThreshLo(_x, _y) = c.mfFert / mfFertilizerHi;
+	mPendingSpill(_x, _y) = 0.f;
+	last = now;
+	MarkDirty(_x, _y, DIRTY_GRASS | DIRTY_FERTILIZER);
+
+	// the whole spill of the ticks since the last touch lands on whoever is lowest now
+	if (c.mfSpill > 0.f)
 	{
-		Node * cur = q.top();
-		q.pop();
+		const int d = GetLowestGrass(_x, _y);
+		if (d >= 0)
+			mPendingSpill(_x + NeighbourDX[d], _y + NeighbourDY[d]) += c.mfSpill;
+	}
+}
 
-		if (q.size() > 1000)
-			__debugbreak();
-		if (cur->pos == _dest)
+bool CS380::Terrain::SettleTile(unsigned _tx, unsigned _ty) noexcept
+{
+	const unsigned x0 = _tx * TERRAIN_TILE_SIZE;
+	const unsigned y0 = _ty * TERRAIN_TILE_SIZE;
+	const unsigned x1 = Min(x0 + TERRAIN_TILE_SIZE, mnWidth);
+	const unsigned y1 = Min(y0 + TERRAIN_TILE_SIZE, mnHeight);
+
+	// at rest is saturated with the lowest neighbour saturated too, the same spill the eager update drops
+	bool moving = false;
+	for (unsigned y = y0; y < y1; ++y)
+	{
+		for (unsigned x = x0; x < x1; ++x)
 		{
-			Node * p = cur->mpPrev;
-			result.insert(result.begin(), cur->pos);
-			while (p)
+			Settle(x, y);
+			if (moving || mGrassLayer(x, y) < mfGrassHi)
 			{
-				result.insert(result.begin(), p->pos);
-				p = p->mpPrev;
+				moving = true;
+				continue;
 			}
-			break;
+			const int d = GetLowestGrass(x, y);
+			if (d < 0)
+				continue;
+			const unsigned nx = x + NeighbourDX[d];
+			const unsigned ny = y + NeighbourDY[d];
+			moving = GetGrass(nx, ny) < mfGrassHi;
 		}
-
-		for (auto& n : GetNeighbours(cur->pos, _dest, cur->tcost, cur))
-			q.push(n);
 	}
-	return result;
+	return moving;
 }
 
-CS380::GridPos CS380::Terrain::GetBestGrassPos(const GridPos& _src, float _limit, float _minAlpha) noexcept
+void CS380::Terrain::ScheduleAround(unsigned _x, unsigned _y) noexcept
 {
-	for (auto& row : mNodeLayer)
+	const unsigned tx0 = (_x ? _x - 1 : 0) / TERRAIN_TILE_SIZE;
+	const unsigned ty0 = (_y ? _y - 1 : 0) / TERRAIN_TILE_SIZE;
+	const unsigned tx1 = Min(_x + 1, mnWidth - 1) / TERRAIN_TILE_SIZE;
+	const unsigned ty1 = Min(_y + 1, mnHeight - 1) / TERRAIN_TILE_SIZE;
+	for (unsigned ty = ty0; ty <= ty1; ++ty)
 	{
-		for (auto& col : row)
+		for (unsigned tx = tx0; tx <= tx1; ++tx)
 		{
-			col.fcost = col.hcost = col.tcost = std::numeric_limits<float>::infinity();
-			col.mpPrev = nullptr;
+			unsigned long long& due = mTileDue[ty * mnTilesX + tx];
+			due = Min(due, mnUpdateCount + LAZY_SPILL_INTERVAL);
 		}
 	}
+}
+
+void CS380::Terrain::SettleAll(void) noexcept
+{
+	// the second pass folds in spill handed to cells the first one had already settled
+	for (unsigned pass = 0; pass < 2; ++pass)
+		for (unsigned y = 0; y < mnHeight; ++y)
+			for (unsigned x = 0; x < mnWidth; ++x)
+				Settle(x, y);
+}
+
+unsigned int CS380::Terrain::GrassColor(float _ratio) noexcept
+{
+	return PackColor(0.f, Lerp(0.3f, 0.9f, _ratio), 0.f, Lerp(0.5f, 0.8f, _ratio));
+}
+
+void CS380::Terrain::MarkDirty(unsigned _x, unsigned _y, unsigned char _bits) noexcept
+{
+	mTileDirty[(_y / TERRAIN_TILE_SIZE) * mnTilesX + _x / TERRAIN_TILE_SIZE] |= _bits;
+}
+
+unsigned char CS380::Terrain::GetTileDirty(unsigned _tx, unsigned _ty) const noexcept
+{
+	return mTileDirty[_ty * mnTilesX + _tx];
+}
+
+void CS380::Terrain::ClearDirty(void) noexcept
+{
+	std::fill(mTileDirty.begin(), mTileDirty.end(), static_cast<unsigned char>(0));
+}
+
+unsigned CS380::Terrain::GetTilesX(void) const noexcept
+{
+	return mnTilesX;
+}
+
+unsigned CS380::Terrain::GetTilesY(void) const noexcept
+{
+	return mnTilesY;
+}
+
+bool CS380::Terrain::GetShortestPath(const GridPos& _src, const GridPos& _dest, PathCursor& _out, PathMode _mode, unsigned* _nodes) noexcept
+{
+	NotePathRequest(_src, _dest);
+	return PeekShortestPath(_src, _dest, _out, _mode, _nodes);
+}
+
+void CS380::Terrain::NotePathRequest(const GridPos& _src, const GridPos& _dest) noexcept
+{
+	if (!mGrassLayer.InBounds(_src.x, _src.y) || !mGrassLayer.InBounds(_dest.x, _dest.y) || _src == _dest)
+		return;
+	mFlowFields.NoteRequest(_src, _dest);
+}
+
+void CS380::Terrain::ReserveSearchWorkers(unsigned _n) noexcept
+{
+	if (mScratch.size() < _n)
+		mScratch.resize(_n);
+}
 
-	unsigned& w = mnWidth;
-	unsigned& h = mnHeight;
-	auto getNeigh = [w, h](const GridPos& _src, Map<Node>& _mapLay, float _curT)
+bool CS380::Terrain::PeekShortestPath(const GridPos& _src, const GridPos& _dest, PathCursor& _out, PathMode _mode, unsigned* _nodes) noexcept
+{
+	if (_nodes)
+		*_nodes = 0;
+	if (!mGrassLayer.InBounds(_src.x, _src.y) || !mGrassLayer.InBounds(_dest.x, _dest.y) || _src == _dest)
+		return false;
+	if (_mode == PATH_AUTO)
+		_mode = GetOctileCost(static_cast<float>(abs(_dest.x - _src.x)), static_cast<float>(abs(_dest.y - _src.y))) > TERRAIN_LONG_PATH ? PATH_LONG : PATH_LOCAL;
+	if (_mode == PATH_LONG)
+		return LongPath(_src, _dest, _out);
+	if (mFlowFields.PeekPath(_src, _dest, *mpPaths, _out))
+	{
+		ECO_PROFILE_COUNT(mpProfiler, COUNTER_FLOW_FIELD_HITS, 1);
+		return true;
+	}
+
+	PathScratch& s = mScratch[ThreadPool::GetCurrentWorker()];
+	if (s.mNodes.GetWidth() != mnWidth || s.mNodes.GetHeight() != mnHeight)
+		s.Reset(mnWidth, mnHeight);
+
+	s.BeginSearch();
+	Node* start = s.TouchNode(_src.x, _src.y);
+	start->tcost = 0.f;
+	start->fcost = GetOctileCost(static_cast<float>(abs(_dest.x - _src.x)), static_cast<float>(abs(_dest.y - _src.y)));
+	s.PushOpen(start);
+	unsigned expanded = 0;
+	unsigned pushes = 1;
+	bool found = false;
+
+	// neighbour order rotates per search so equal cost routes do not always bend the same way, keyed on the query
+	// itself so the route does not depend on which worker ran it or what it searched before
+	const unsigned rot = HashCell(mnHashSeed, _src.x, _src.y, mnUpdateCount << 32 | (static_cast<unsigned>(_dest.y) * mnWidth + _dest.x)) & 7;
+	while (!s.mOpen.empty())
 	{
-		std::vector<CS380::Node*> result;
-		for (int j = -1; j < 2; ++j)
+		Node * cur = s.PopOpen();
+		++expanded;
+		if (cur->mnX == _dest.x && cur->mnY == _dest.y)
 		{
-			for (int i = -1; i < 2; ++i)
+			// the route is turned around in place so it can be written front to back, each node on it ends up
+			// holding the step that leaves it. the source is not part of it
+			unsigned steps = 0;
+			unsigned dir = cur->mnPrev;
+			for (Node* p = cur; p != start; ++steps)
+			{
+				Node* prev = s.TouchNode(p->mnX - NeighbourDX[dir], p->mnY - NeighbourDY[dir]);
+				const unsigned back = prev->mnPrev;
+				prev->mnPrev = dir;
+				dir = back;
+				p = prev;
+			}
+			PathCursor path = mpPaths->Allocate(_src, steps);
+			if (path.mnLeft)
 			{
-				if (static_cast<unsigned>(_src.x + i) >= w || static_cast<unsigned>(_src.y + j) >= h)
-					continue;
+				PathWriter w{ *mpPaths, path };
+				int x = _src.x;
+				int y = _src.y;
+				for (unsigned i = 0; i < steps; ++i)
+				{
+					const unsigned d = s.TouchNode(x, y)->mnPrev;
+					w.Push(d);
+					x += NeighbourDX[d];
+					y += NeighbourDY[d];
+				}
+				_out = path;
+				found = true;
+			}
+			break;
+		}
+
+		for (unsigned k = 0; k < 8; ++k)
+		{
+			const int d = static_cast<int>((rot + k) & 7);
+			Node* n = s.TouchNode(cur->mnX + NeighbourDX[d], cur->mnY + NeighbourDY[d]);
+			if (!n || n->mnHeapIdx == NODE_CLOSED)
+				continue;
 
-				if (_mapLay[_src.y + j][_src.x + i].fcost <= ((!i || !j) ? _curT + 1 : _curT + SQRT_2))
-					continue;
+			float t = cur->tcost + ((NeighbourDX[d] && NeighbourDY[d]) ? SQRT_2 : 1.f);
+			if (t >= n->tcost)
+				continue;
 
-				_mapLay[_src.y + j][_src.x + i].hcost = 0.f;
-				_mapLay[_src.y + j][_src.x + i].fcost =
-					_mapLay[_src.y + j][_src.x + i].tcost =
-					(!i || !j) ? _curT + 1 : _curT + SQRT_2;
-				result.push_back(&_mapLay[_src.y + j][_src.x + i]);
+			n->tcost = t;
+			n->fcost = t + GetOctileCost(static_cast<float>(abs(_dest.x - n->mnX)), static_cast<float>(abs(_dest.y - n->mnY)));
+			// neighbour codes are the arena's direction codes
+			n->mnPrev = static_cast<unsigned>(d);
+			if (n->mnHeapIdx == NODE_UNSEEN)
+			{
+				s.PushOpen(n);
+				++pushes;
 			}
+			else
+				s.SiftUp(n->mnHeapIdx);
 		}
-		std::random_device rd;
-		std::mt19937 g(rd());
-		std::shuffle(result.begin(), result.end(), g);
-		return result;
-	};
+	}
+	if (_nodes)
+		*_nodes = expanded;
+	ECO_PROFILE_COUNT(mpProfiler, COUNTER_SEARCHES, 1);
+	ECO_PROFILE_COUNT(mpProfiler, COUNTER_NODES_EXPANDED, expanded);
+	ECO_PROFILE_COUNT(mpProfiler, COUNTER_HEAP_PUSHES, pushes);
+	return found;
+}
+
+bool CS380::Terrain::LongPath(const GridPos& _src, const GridPos& _dest, PathCursor& _out) noexcept
+{
+	// bresenham along the longer axis: a step along it every time, the diagonals spread evenly over them. that is
+	// the fewest steps and the fewest diagonals any route between the two cells can have
+	const int dx = _dest.x - _src.x;
+	const int dy = _dest.y - _src.y;
+	const int sx = dx < 0 ? -1 : 1;
+	const int sy = dy < 0 ? -1 : 1;
+	const bool xMajor = abs(dx) >= abs(dy);
+	const unsigned major = static_cast<unsigned>(xMajor ? abs(dx) : abs(dy));
+	const unsigned minor = static_cast<unsigned>(xMajor ? abs(dy) : abs(dx));
+
+	PathCursor path = mpPaths->Allocate(_src, major);
+	if (!path.mnLeft)
+		return false;
+
+	const unsigned straight = xMajor ? PathDir(sx, 0) : PathDir(0, sy);
+	const unsigned diagonal = PathDir(sx, sy);
+	PathWriter w{ *mpPaths, path };
+	long long err = 0;
+	for (unsigned i = 0; i < major; ++i)
+	{
+		err += minor;
+		if (err * 2 >= static_cast<long long>(major))
+		{
+			err -= major;
+			w.Push(diagonal);
+		}
+		else
+			w.Push(straight);
+	}
+	_out = path;
+	ECO_PROFILE_COUNT(mpProfiler, COUNTER_LONG_ROUTES, 1);
+	return true;
+}
 
-	std::vector<CS380::GridPos> result;
-	std::priority_queue<Node*, std::vector<Node*>, Comp> q;
-	for (auto & n : getNeigh(_src, mNodeLayer, 0.f))
-		q.push(n);
+struct CS380::Terrain::BestGrassQuery
+{
+	GridPos mSrc;
+	float mfLimitSq;
+	float mfMinAlpha;
+	float mfBest;
+	GridPos mBest;
+	unsigned mnTies;
+};
 
-	while (!q.empty())
+CS380::GridPos CS380::Terrain::GetBestGrassPos(const GridPos& _src, float _limit, float _minAlpha) const noexcept
+{
+	if (!mGrassLayer.InBounds(_src.x, _src.y))
+		return GridPos{ -1,-1 };
+
+	// a non positive limit only ever sees the source cell
+	BestGrassQuery q{ _src, _limit > 0.f ? _limit * _limit : -1.f, _minAlpha, -std::numeric_limits<float>::infinity(), GridPos{ -1, -1 }, 0 };
+	if (!mbLazy)
 	{
-		Node * cur = q.top();
-		q.pop();
+		SearchBestGrass(mGrassRatio.GetLevelCount() - 1, 0, 0, q);
+		return q.mBest;
+	}
 
-		// if regrowth more than half, then consider it a grass patch
-		if (mGrassLayer[cur->pos.y][cur->pos.x] / (mGrassThresh[cur->pos.y][cur->pos.x].second - mGrassThresh[cur->pos.y][cur->pos.x].first) > _minAlpha)
-			result.push_back(cur->pos);
+	// the pyramid only knows what cells held when they were last touched, so lazy mode works out every cell in
+	// reach instead. same reach and tie rule as the pyramid search, ties are met in another order
+	const int reach = _limit > 0.f ? static_cast<int>(std::ceil(_limit)) : 0;
+	for (int y = Max(0, _src.y - reach); y <= Min(static_cast<int>(mnHeight) - 1, _src.y + reach); ++y)
+	{
+		for (int x = Max(0, _src.x - reach); x <= Min(static_cast<int>(mnWidth) - 1, _src.x + reach); ++x)
+		{
+			const int dx = Max(0, abs(x - _src.x) - 1);
+			const int dy = Max(0, abs(y - _src.y) - 1);
+			if ((x != _src.x || y != _src.y) && static_cast<float>(dx * dx + dy * dy) >= q.mfLimitSq)
+				continue;
 
-		if (static_cast<float>(sqrt((cur->pos.x - _src.x)*(cur->pos.x - _src.x) + (cur->pos.y - _src.y)*(cur->pos.y - _src.y))) < _limit)
-			for (auto& n : getNeigh(cur->pos, mNodeLayer, cur->fcost))
-				q.push(n);
+			const float m = GetGrass(x, y) / (mfGrassHi - mfGrassLo);
+			if (m <= q.mfMinAlpha || m < q.mfBest)
+				continue;
+			if (m > q.mfBest)
+			{
+				q.mfBest = m;
+				q.mBest = GridPos{ x, y };
+				q.mnTies = 1;
+			}
+			else if (HashCell(mnHashSeed, static_cast<unsigned>(x), static_cast<unsigned>(y),
+				mnUpdateCount << 32 | (static_cast<unsigned>(_src.y) * mnWidth + _src.x)) % ++q.mnTies == 0)
+				q.mBest = GridPos{ x, y };
+		}
 	}
+	return q.mBest;
+}
 
-	std::random_device rd;
-	std::mt19937 g(rd());
-	std::shuffle(result.begin(), result.end(), g);
-	if (result.size())
+void CS380::Terrain::SearchBestGrass(unsigned _level, unsigned _bx, unsigned _by, BestGrassQuery& _q) const noexcept
+{
+	const float m = mGrassRatio.GetLevel(_level)(_bx, _by);
+	// if regrowth more than alpha, then consider it a grass patch
+	if (m <= _q.mfMinAlpha || m < _q.mfBest)
+		return;
+
+	// reach matches the old sense flood: cells within _limit of the source plus the ring one step past them
+	const int x0 = static_cast<int>(_bx << _level);
+	const int y0 = static_cast<int>(_by << _level);
+	const int x1 = x0 + (1 << _level) - 1;
+	const int y1 = y0 + (1 << _level) - 1;
+	const int dx = Max(0, Max(x0 - _q.mSrc.x, _q.mSrc.x - x1) - 1);
+	const int dy = Max(0, Max(y0 - _q.mSrc.y, _q.mSrc.y - y1) - 1);
+	const bool hasSrc = _q.mSrc.x >= x0 && _q.mSrc.x <= x1 && _q.mSrc.y >= y0 && _q.mSrc.y <= y1;
+	if (!hasSrc && static_cast<float>(dx * dx + dy * dy) >= _q.mfLimitSq)
+		return;
+
+	if (!_level)
 	{
-		unsigned highestId = 0;
-		float highestV = mGrassLayer[result[0].y][result[0].x] / (mGrassThresh[result[0].y][result[0].x].second - mGrassThresh[result[0].y][result[0].x].first);
-		for (unsigned i = 1; i < result.size(); ++i)
+		if (m > _q.mfBest)
 		{
-			float v = mGrassLayer[result[i].y][result[i].x] / (mGrassThresh[result[i].y][result[i].x].second - mGrassThresh[result[i].y][result[i].x].first);
-			if (v > highestV)
-				highestId = i;
+			_q.mfBest = m;
+			_q.mBest = GridPos{ x0, y0 };
+			_q.mnTies = 1;
 		}
-		return result[highestId];
+		// reservoir pick so every equally good cell is as likely
+		else if (HashCell(mnHashSeed, static_cast<unsigned>(x0), static_cast<unsigned>(y0),
+			mnUpdateCount << 32 | (static_cast<unsigned>(_q.mSrc.y) * mnWidth + _q.mSrc.x)) % ++_q.mnTies == 0)
+			_q.mBest = GridPos{ x0, y0 };
+		return;
 	}
-	return GridPos{ -1,-1 };
+
+	// richest child first so the rest prune sooner
+	const Grid<float>& below = mGrassRatio.GetLevel(_level - 1);
+	unsigned cx[4];
+	unsigned cy[4];
+	unsigned count = 0;
+	for (unsigned j = _by * 2; j < _by * 2 + 2 && j < below.GetHeight(); ++j)
+		for (unsigned i = _bx * 2; i < _bx * 2 + 2 && i < below.GetWidth(); ++i)
+		{
+			unsigned k = count++;
+			for (; k > 0 && below(cx[k - 1], cy[k - 1]) < below(i, j); --k)
+			{
+				cx[k] = cx[k - 1];
+				cy[k] = cy[k - 1];
+			}
+			cx[k] = i;
+			cy[k] = j;
+		}
+
+	for (unsigned k = 0; k < count; ++k)
+		SearchBestGrass(_level - 1, cx[k], cy[k], _q);
 }
 
-std::vector<CS380::Node*> CS380::Terrain::GetNeighbours(const GridPos& _src, const GridPos& _dest, float _curT, Node * _prev) noexcept
+CS380::GridPos CS380::Terrain::GetNextStep(const GridPos& _src, const GridPos& _dest) noexcept
 {
-	std::vector<CS380::Node*> result;
-	result.reserve(8);
-	for (int j = -1; j < 2; ++j)
+	GridPos next{ -1, -1 };
+	if (mFlowFields.GetNextStep(_src, _dest, next))
+		return next;
+	// the request is already counted
+	PathCursor path{};
+	if (!PeekShortestPath(_src, _dest, path))
+		return next;
+	const unsigned d = mpPaths->Peek(path);
+	mpPaths->Release(path);
+	return GridPos{ _src.x + NeighbourDX[d], _src.y + NeighbourDY[d] };
+}
+
+const CS380::FlowFieldCache& CS380::Terrain::GetFlowFields(void) const noexcept
+{
+	return mFlowFields;
+}
+
+void CS380::PathScratch::BeginSearch(void) noexcept
+{
+	mOpen.clear();
+	// stamps wrapped, the one time a full clear is needed
+	if (++mnSearchGen == NODE_GEN_LIMIT)
 	{
-		for (int i = -1; i < 2; ++i)
+		mNodes.ForEachChunk([](Node* _n, unsigned _count)
 		{
-			if (!j && !i)
-				continue;
-			if (static_cast<unsigned>(_src.x + i) >= mnWidth || 
-				static_cast<unsigned>(_src.y + j) >= mnHeight)
-				continue;
+			for (unsigned i = 0; i < _count; ++i)
+				_n[i].mnGen = 0;
+		});
+		mnSearchGen = 1;
+	}
+}
 
-			float x = static_cast<float>(abs(_dest.x - (_src.x + i)));
-			float y = static_cast<float>(abs(_dest.y - (_src.y + j)));
+CS380::Node* CS380::PathScratch::TouchNode(int _x, int _y) noexcept
+{
+	if (!mNodes.InBounds(_x, _y))
+		return nullptr;
 
-			float h = GetOctileCost(x, y);
-			if (mNodeLayer[_src.y + j][_src.x + i].fcost <= h + ((!i || !j) ? _curT + 1 : _curT + SQRT_2))
-				continue;
+	Node& n = mNodes.Touch(static_cast<unsigned>(_x), static_cast<unsigned>(_y));
+	if (n.mnGen != mnSearchGen)
+	{
+		n.mnX = static_cast<std::uint16_t>(_x);
+		n.mnY = static_cast<std::uint16_t>(_y);
+		n.mnGen = mnSearchGen;
+		n.tcost = n.fcost = std::numeric_limits<float>::infinity();
+		n.mnPrev = 0;
+		n.mnHeapIdx = NODE_UNSEEN;
+	}
+	return &n;
+}
+
+void CS380::PathScratch::PushOpen(Node* _n) noexcept
+{
+	_n->mnHeapIdx = static_cast<unsigned>(mOpen.size());
+	mOpen.push_back(_n);
+	SiftUp(_n->mnHeapIdx);
+}
 
-			if (_prev && _prev->mpPrev == &mNodeLayer[_src.y + j][_src.x + i])
-				__debugbreak(); //cyclic
+CS380::Node* CS380::PathScratch::PopOpen(void) noexcept
+{
+	Node* top = mOpen.front();
+	mOpen.front() = mOpen.back();
+	mOpen.front()->mnHeapIdx = 0;
+	mOpen.pop_back();
+	if (!mOpen.empty())
+		SiftDown(0);
+	top->mnHeapIdx = NODE_CLOSED;
+	return top;
+}
 
-			mNodeLayer[_src.y + j][_src.x + i].hcost = h;
-			mNodeLayer[_src.y + j][_src.x + i].tcost = (!i || !j) ? _curT + 1 : _curT + SQRT_2;
-			mNodeLayer[_src.y + j][_src.x + i].fcost = mNodeLayer[_src.y + j][_src.x + i].hcost + mNodeLayer[_src.y + j][_src.x + i].tcost;
-			mNodeLayer[_src.y + j][_src.x + i].mpPrev = _prev;
+void CS380::PathScratch::SiftUp(unsigned _i) noexcept
+{
+	Node* n = mOpen[_i];
+	while (_i)
+	{
+		unsigned parent = (_i - 1) / 2;
+		if (!(n->fcost < mOpen[parent]->fcost))
+			break;
+		mOpen[_i] = mOpen[parent];
+		mOpen[_i]->mnHeapIdx = _i;
+		_i = parent;
+	}
+	mOpen[_i] = n;
+	n->mnHeapIdx = _i;
+}
 
-			result.push_back(&mNodeLayer[_src.y + j][_src.x + i]);
-		}
+void CS380::PathScratch::SiftDown(unsigned _i) noexcept
+{
+	const unsigned size = static_cast<unsigned>(mOpen.size());
+	Node* n = mOpen[_i];
+	for (;;)
+	{
+		unsigned child = 2 * _i + 1;
+		if (child >= size)
+			break;
+		if (child + 1 < size && mOpen[child + 1]->fcost < mOpen[child]->fcost)
+			++child;
+		if (!(mOpen[child]->fcost < n->fcost))
+			break;
+		mOpen[_i] = mOpen[child];
+		mOpen[_i]->mnHeapIdx = _i;
+		_i = child;
 	}
-	std::random_device rd;
-	std::mt19937 g(rd());
-	std::shuffle(result.begin(), result.end(), g);
-	return result;
+	mOpen[_i] = n;
+	n->mnHeapIdx = _i;
 }
 
 CS380::GridPos CS380::Terrain::GetEmptyNeighbour(const GridPos& _src) noexcept
@@ -441,54 +1636,38 @@ CS380::GridPos CS380::Terrain::GetEmptyNeighbour(const GridPos& _src) noexcept
 				static_cast<unsigned>(_src.y + j) >= mnHeight)
 				continue;
 
-			if (mSpaceLayer[_src.y + j][_src.x + i] == -1)
+			if (!mSpaceLayer(_src.x + i, _src.y + j).IsValid())
 				return GridPos{  _src.x + i, _src.y + j };
 		}
 	}
 	return GridPos{ -1, -1 };
 }
 
-CS380::GridPos CS380::Terrain::GetLowestGrass(const GridPos& _src) noexcept
+int CS380::Terrain::GetLowestGrass(unsigned _x, unsigned _y) const noexcept
 {
-	// Random in 8 direction
-	std::vector<std::pair<int, int>> neighbourCells = { {-1, 1}, {0, 1}, {1, 1}, 
-														{-1, 0},		 {1, 0},
-														{-1, -1},{0, -1},{1,-1}
-													};
-	std::random_device rd; // obtain a random number from hardware
-	std::mt19937 eng(rd()); // seed the generator
+	ECO_PROFILE_SCOPE(mpProfiler, ZONE_LOWEST_GRASS);
+	// 8 directions from a hashed start so ties do not always break the same way
+	const unsigned start = HashCell(mnHashSeed, _x, _y, mnUpdateCount) & 7;
 
-	CS380::GridPos lowest{ -1, -1 };
+	int lowest = -1;
 	float lowestV = std::numeric_limits<float>::max();
-	while (!neighbourCells.empty())
-	{	
-		std::uniform_int_distribution<> distr(0,static_cast<int>(neighbourCells.size())-1); // define the range
-
-		const int randIdx = distr(eng);
+	for (unsigned i = 0; i < 8; ++i)
+	{
+		const int d = static_cast<int>((start + i) & 7);
+		const int nx = static_cast<int>(_x) + NeighbourDX[d];
+		const int ny = static_cast<int>(_y) + NeighbourDY[d];
 
-		CS380::GridPos newPos{ 0, 0 };
-		newPos = GridPos{ static_cast<int>(_src.x) + neighbourCells[randIdx].first, static_cast<int>(_src.y) + neighbourCells[randIdx].second };
-		
 		// out of range
-		if (static_cast<unsigned>(newPos.x) >= mnWidth ||
-			static_cast<unsigned>(newPos.y) >= mnHeight)
-		{
-			neighbourCells.erase(neighbourCells.begin() + randIdx);
+		if (!mGrassLayer.InBounds(nx, ny))
 			continue;
-		}
 
-		if (mGrassLayer[newPos.y][newPos.x] < lowestV)
+		const float v = mbLazy ? GetGrass(nx, ny) : mGrassLayer(nx, ny);
+		if (v < lowestV)
 		{
-			lowestV = mGrassLayer[newPos.y][newPos.x];
-			lowest.x = newPos.x;
-			lowest.y = newPos.y;
+			lowestV = v;
+			lowest = d;
 		}
-		neighbourCells.erase(neighbourCells.begin() + randIdx);
 	}
 
 	return lowest;
 }
-
-
-
-
@@ -0,0 +1,111 @@
+#include "EcoSystem/ThreadPool.h"
+
+namespace
+{
+	thread_local unsigned gCurrentWorker = 0;
+}
+
+CS380::ThreadPool::ThreadPool(unsigned _threads) noexcept
+	: mWorkers{}, mMutex{}, mWake{}, mDone{}, mpJob{ nullptr }, mnCount{ 0 }, mnNext{ 0 }, mnBusy{ 0 }, mnGeneration{ 0 }, mbStop{ false }
+{
+	Resize(_threads);
+}
+
+CS380::ThreadPool::~ThreadPool(void) noexcept
+{
+	Stop();
+}
+
+void CS380::ThreadPool::Resize(unsigned _threads) noexcept
+{
+	if (!_threads)
+		_threads = std::thread::hardware_concurrency();
+	if (!_threads)
+		_threads = 1;
+	if (_threads == GetThreadCount())
+		return;
+
+	Stop();
+	mbStop = false;
+	// worker 0 is whoever calls ParallelFor
+	for (unsigned i = 1; i < _threads; ++i)
+		mWorkers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+unsigned CS380::ThreadPool::GetThreadCount(void) const noexcept
+{
+	return static_cast<unsigned>(mWorkers.size()) + 1;
+}
+
+void CS380::ThreadPool::ParallelFor(unsigned _count, const std::function<void(unsigned, unsigned)>& _func) noexcept
+{
+	if (!_count)
+		return;
+	if (mWorkers.empty() || _count == 1)
+	{
+		for (unsigned i = 0; i < _count; ++i)
+			_func(i, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{ mMutex };
+		mpJob = &_func;
+		mnCount = _count;
+		mnNext.store(0, std::memory_order_relaxed);
+		mnBusy = static_cast<unsigned>(mWorkers.size());
+		++mnGeneration;
+	}
+	mWake.notify_all();
+
+	RunJob(0);
+
+	std::unique_lock<std::mutex> lock{ mMutex };
+	mDone.wait(lock, [this] { return mnBusy == 0; });
+	mpJob = nullptr;
+}
+
+unsigned CS380::ThreadPool::GetCurrentWorker(void) noexcept
+{
+	return gCurrentWorker;
+}
+
+void CS380::ThreadPool::WorkerLoop(unsigned _worker) noexcept
+{
+	gCurrentWorker = _worker;
+	unsigned long long seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock{ mMutex };
+			mWake.wait(lock, [this, seen] { return mbStop || mnGeneration != seen; });
+			if (mbStop)
+				return;
+			seen = mnGeneration;
+		}
+
+		RunJob(_worker);
+
+		std::lock_guard<std::mutex> lock{ mMutex };
+		if (--mnBusy == 0)
+			mDone.notify_one();
+	}
+}
+
+void CS380::ThreadPool::RunJob(unsigned _worker) noexcept
+{
+	for (unsigned i = mnNext.fetch_add(1, std::memory_order_relaxed); i < mnCount; i = mnNext.fetch_add(1, std::memory_order_relaxed))
+		(*mpJob)(i, _worker);
+}
+
+void CS380::ThreadPool::Stop(void) noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{ mMutex };
+		mbStop = true;
+	}
+	mWake.notify_all();
+	for (auto& t : mWorkers)
+		t.join();
+	mWorkers.clear();
+}
@@ -2,8 +2,8 @@
 #include "EcoSystem/EcoSystem.h"
 #include "imgui.h"
 
-CS380::LogTool::LogTool(bool _opened) noexcept
-	: Tools{ "Logging", _opened }
+CS380::LogTool::LogTool(EcoSystem& _eco, bool _opened) noexcept
+	: Tools{ _eco, "Logging", _opened }
 {
 }
 
@@ -13,35 +13,38 @@ CS380::LogTool::~LogTool(void) noexcept
 
 void CS380::LogTool::Render(void) noexcept
 {
-	auto& eco = EcoSystem::GetInst();
-	auto& logs = eco.GetLogs();
+	const WorldSnapshot& view = mEco.GetView();
+	auto& logs = view.mLogs;
 	ImGui::Begin(mName.c_str(), &mbOpened);
-	std::vector<float> res;
+	// the logs are ring buffers, plotted straight off their storage from the oldest sample on
 	for (unsigned i = 0; i < logs.size(); ++i)
 	{
-		res.resize(logs[i].size(), 0);
-		for (unsigned j = 0; j < res.size(); ++j)
-			res[j] = logs[i][j];
+		const float* data = logs[i].Data();
+		const int size = static_cast<int>(logs[i].GetSize());
+		const int offset = static_cast<int>(logs[i].GetOffset());
 
 		switch (i)
 		{
 		case 0:
-			ImGui::PlotHistogram("Average Speed", res.data(), static_cast<int>(res.size()), 0, NULL, 0.0f, 2.f, ImVec2(0, 30));
+			ImGui::PlotHistogram("Average Speed", data, size, offset, NULL, 0.0f, 2.f, ImVec2(0, 30));
 			break;
 		case 1:
-			ImGui::PlotHistogram("Average Size", res.data(), static_cast<int>(res.size()), 0, NULL, 0.0f, 2.f, ImVec2(0, 30));
+			ImGui::PlotHistogram("Average Size", data, size, offset, NULL, 0.0f, 2.f, ImVec2(0, 30));
 			break;
 		case 2:
-			ImGui::PlotHistogram("Average Sense", res.data(), static_cast<int>(res.size()), 0, NULL, 0.0f, 2.f, ImVec2(0, 30));
+			ImGui::PlotHistogram("Average Sense", data, size, offset, NULL, 0.0f, 2.f, ImVec2(0, 30));
 			break;
 		case 3:
-			ImGui::PlotHistogram("Creature Population", res.data(), static_cast<int>(res.size()), 0, NULL, 0.0f, static_cast<float>(eco.mnPeakPops), ImVec2(0, 80));
+			ImGui::PlotHistogram("Creature Population", data, size, offset, NULL, 0.0f, static_cast<float>(view.mnPeakPops), ImVec2(0, 80));
 			break;
 		case 4:
-			ImGui::PlotHistogram("Grass Density", res.data(), static_cast<int>(res.size()), 0, NULL, 0.0f, static_cast<float>(eco.GetWidth() * eco.GetHeight()), ImVec2(0, 80));
+			ImGui::PlotHistogram("Grass Density", data, size, offset, NULL, 0.0f, static_cast<float>(view.mnWidth * view.mnHeight), ImVec2(0, 80));
 			break;
 		}
 	}
+	// a gap in the streamed history would go unnoticed otherwise
+	if (view.mbTelemetry || view.mnTelemetryLost)
+		ImGui::Text("Telemetry: %llu rows written, %llu lost", view.mnTelemetryWritten, view.mnTelemetryLost);
 	ImGui::End();
 }
 
@@ -0,0 +1,128 @@
+#include "EcoSystem/Tools/ProfilerTool.h"
+#include "Data/EcoData.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <initializer_list>
+
+namespace
+{
+	ImU32 ZoneColor(CS380::ProfileZone _zone)
+	{
+		return ImColor::HSV(static_cast<float>(_zone) / CS380::ZONE_COUNT, 0.55f, 0.75f);
+	}
+}
+
+CS380::ProfilerTool::ProfilerTool(EcoSystem& _eco, bool _opened) noexcept
+	: Tools{ _eco, "Profiler", _opened }, mbRecording{ false }, mnFrameBack{ 0 }, mPlot{}
+{
+}
+
+CS380::ProfilerTool::~ProfilerTool(void) noexcept
+{
+}
+
+void CS380::ProfilerTool::Render(void) noexcept
+{
+	const RingBuffer<ProfileFrame>& history = mEco.GetView().mProfile;
+	ImGui::Begin(mName.c_str(), &mbOpened);
+
+	if (ImGui::Checkbox("Record", &mbRecording))
+	{
+		UiCommand cmd{};
+		cmd.meType = UiCommand::UI_SET;
+		cmd.meParam = UiCommand::PARAM_PROFILE;
+		cmd.mfValue = mbRecording ? 1.f : 0.f;
+		mEco.PushCommand(cmd);
+	}
+	if (history.Empty())
+	{
+		ImGui::TextDisabled(ECO_PROFILING ? "nothing recorded yet" : "built with ECO_NO_PROFILE");
+		ImGui::End();
+		return;
+	}
+
+	// frame graphs, milliseconds per tick from the oldest kept tick on
+	const unsigned n = history.GetSize();
+	mPlot.resize(n);
+	static constexpr ProfileZone plotted[] = { ZONE_TICK, ZONE_TERRAIN, ZONE_CREATURES, ZONE_CLEANUP, ZONE_LOGS, ZONE_PUBLISH,
+		ZONE_SHORTEST_PATH, ZONE_BEST_GRASS, ZONE_EMPTY_NEIGHBOUR, ZONE_LOWEST_GRASS };
+	for (ProfileZone z : plotted)
+	{
+		float peak = 0.f;
+		for (unsigned i = 0; i < n; ++i)
+		{
+			mPlot[i] = static_cast<float>(history[i].mZoneSeconds[z] * 1000.0);
+			peak = std::max(peak, mPlot[i]);
+		}
+		char overlay[32];
+		snprintf(overlay, sizeof(overlay), "%.3f ms", mPlot[n - 1]);
+		ImGui::PlotLines(Profiler::GetZoneName(z), mPlot.data(), static_cast<int>(n), 0, overlay, 0.f, std::max(peak, 0.001f), ImVec2(0, z == ZONE_TICK ? 60.f : 30.f));
+	}
+
+	ImGui::Separator();
+	mnFrameBack = std::min(mnFrameBack, static_cast<int>(n) - 1);
+	ImGui::SliderInt("Ticks back", &mnFrameBack, 0, static_cast<int>(n) - 1);
+	const ProfileFrame& f = history[n - 1 - mnFrameBack];
+	ImGui::Text("tick %llu", f.mnTick);
+
+	// flame graph of the tick, the phases under it and the calls timed inside them. with several workers the
+	// calls add up over every worker, they are squeezed into their phase when they come to more than it took
+	ImDrawList* draw = ImGui::GetWindowDrawList();
+	const ImVec2 origin = ImGui::GetCursorScreenPos();
+	const float width = std::max(ImGui::GetContentRegionAvail().x, 1.f);
+	const float row = ImGui::GetTextLineHeightWithSpacing();
+	const double total = std::max(f.mZoneSeconds[ZONE_TICK], 1e-9);
+	auto bar = [&](unsigned _level, double _from, double _seconds, ProfileZone _zone)
+	{
+		const ImVec2 a{ origin.x + static_cast<float>(_from / total) * width, origin.y + _level * row };
+		const ImVec2 b{ origin.x + static_cast<float>((_from + _seconds) / total) * width, a.y + row - 1.f };
+		if (b.x - a.x < 1.f)
+			return;
+		draw->AddRectFilled(a, b, ZoneColor(_zone));
+		draw->PushClipRect(a, b, true);
+		draw->AddText(ImVec2{ a.x + 2.f, a.y }, IM_COL32_WHITE, Profiler::GetZoneName(_zone));
+		draw->PopClipRect();
+		if (ImGui::IsMouseHoveringRect(a, b))
+			ImGui::SetTooltip("%s\n%.3f ms over %u calls", Profiler::GetZoneName(_zone), _seconds * 1000.0, f.mZoneCalls[_zone]);
+	};
+	auto children = [&](unsigned _level, double _from, ProfileZone _parent, std::initializer_list<ProfileZone> _zones)
+	{
+		double sum = 0.0;
+		for (ProfileZone z : _zones)
+			sum += f.mZoneSeconds[z];
+		const double scale = sum > f.mZoneSeconds[_parent] ? f.mZoneSeconds[_parent] / sum : 1.0;
+		for (ProfileZone z : _zones)
+		{
+			bar(_level, _from, f.mZoneSeconds[z] * scale, z);
+			_from += f.mZoneSeconds[z] * scale;
+		}
+	};
+
+	bar(0, 0.0, f.mZoneSeconds[ZONE_TICK], ZONE_TICK);
+	double at = 0.0;
+	for (ProfileZone z : { ZONE_TERRAIN, ZONE_CREATURES, ZONE_CLEANUP, ZONE_LOGS })
+	{
+		bar(1, at, f.mZoneSeconds[z], z);
+		if (z == ZONE_TERRAIN)
+			children(2, at, z, { ZONE_LOWEST_GRASS });
+		else if (z == ZONE_CREATURES)
+			children(2, at, z, { ZONE_SHORTEST_PATH, ZONE_BEST_GRASS, ZONE_EMPTY_NEIGHBOUR });
+		at += f.mZoneSeconds[z];
+	}
+	ImGui::Dummy(ImVec2{ width, row * 3.f });
+
+	ImGui::Separator();
+	const unsigned long long searches = f.mCounters[COUNTER_SEARCHES];
+	const double perSearch = searches ? 1.0 / static_cast<double>(searches) : 0.0;
+	ImGui::Text("searches %llu, flow field hits %llu, long routes %llu", searches, f.mCounters[COUNTER_FLOW_FIELD_HITS], f.mCounters[COUNTER_LONG_ROUTES]);
+	ImGui::Text("nodes expanded %.1f / search, heap pushes %.1f / search",
+		f.mCounters[COUNTER_NODES_EXPANDED] * perSearch, f.mCounters[COUNTER_HEAP_PUSHES] * perSearch);
+	ImGui::Text("spawns %llu, deaths %llu", f.mCounters[COUNTER_SPAWNS], f.mCounters[COUNTER_DEATHS]);
+	for (unsigned s = 0; s < Data::SpeciesNames.size(); ++s)
+		ImGui::Text("%s paths %u", Data::SpeciesNames[s], f.mPaths[s]);
+
+	ImGui::End();
+}
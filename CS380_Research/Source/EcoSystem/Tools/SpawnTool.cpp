@@ -3,16 +3,9 @@
 #include "imgui.h"
 #include "imgui_internal.h"
 
-#include <random>
-
-namespace CS380
-{
-	extern EvolutionData EvolutionChart[EVOLUTION_CHART_COUNT];
-}
-
-CS380::SpawnTool::SpawnTool(bool _opened) noexcept
-	: Tools{ "SpawnTool", _opened }, mnSpawnX{ 0 }, mnSpawnY{ 0 }, mnCurrSelection{ 0 },
-	mfCurSize{ 1.f }, mfCurSpeed{ 1.f }, mfCurSense{ 1.f }, mnSpawnCount{ 1 }
+CS380::SpawnTool::SpawnTool(EcoSystem& _eco, bool _opened) noexcept
+	: Tools{ _eco, "SpawnTool", _opened }, mnSpawnX{ 0 }, mnSpawnY{ 0 }, mnCurrSelection{ 0 }, mnSpawnCount{ 1 },
+	mnBatchCount{ 0 }, mfFillPercent{ 10.f }, mfCurSize{ 1.f }, mfCurSpeed{ 1.f }, mfCurSense{ 1.f }
 {
 }
 
@@ -22,57 +15,55 @@ CS380::SpawnTool::~SpawnTool(void) noexcept
 
 void CS380::SpawnTool::Render(void) noexcept
 {
-	EcoSystem& eco = EcoSystem::GetInst();
+	EcoSystem& eco = mEco;
+	const WorldSnapshot& view = eco.GetView();
 	ImGui::Begin(mName.c_str(), &mbOpened);
 	ImGui::Combo("Creatures", &mnCurrSelection, Spawnables, CREATURE_COUNT);
 	ImGui::DragFloat("Size ", &mfCurSize, 0.1f, 1.f, MAX_CREATURE_SIZE);
 	ImGui::DragFloat("Speed ", &mfCurSpeed, 0.1f, 1.f, MAX_CREATURE_SPEED);
 	ImGui::DragFloat("Sense ", &mfCurSense, 0.1f, 1.f, MAX_CREATURE_SENSE);
+
+	// spawns run on the sim thread, which checks the cell again in case it filled up since this snapshot
+	UiCommand cmd{};
+	cmd.mnIndex = mnCurrSelection;
+	cmd.mfSize = mfCurSize;
+	cmd.mfSpeed = mfCurSpeed;
+	cmd.mfSense = mfCurSense;
 	if (ImGui::CollapsingHeader("Singular"))
 	{
 		ImGui::DragInt("X ", &mnSpawnX, 1.f, 0, eco.GetWidth() - 1);
 		ImGui::DragInt("Y ", &mnSpawnY, 1.f, 0, eco.GetHeight() - 1);
-		unsigned short x = static_cast<unsigned short>(mnSpawnX);
-		unsigned short y = static_cast<unsigned short>(mnSpawnY);
-		if (ImGui::ButtonEx("Spawn", ImVec2{ 80, 30 }, (eco.GetGridVal(x, y) == -1 ? 0 : ImGuiButtonFlags_Disabled)))
+		const unsigned x = static_cast<unsigned>(mnSpawnX);
+		const unsigned y = static_cast<unsigned>(mnSpawnY);
+		const bool free = x < view.mnWidth && y < view.mnHeight && !view.mOccupants(x, y).mHead.IsValid();
+		if (ImGui::ButtonEx("Spawn", ImVec2{ 80, 30 }, (free ? 0 : ImGuiButtonFlags_Disabled)))
 		{
-			Data::VisitSpawnTuple(
-				Data::SpawnVisitor{ x, y, EvolutionChart[mnCurrSelection], Traits{ mfCurSize, mfCurSpeed, mfCurSense } }
-			, mnCurrSelection);
+			cmd.meType = UiCommand::UI_SPAWN;
+			cmd.mnX = x;
+			cmd.mnY = y;
+			eco.PushCommand(cmd);
 		}
 		eco.HighlightGrid(x, y, ImGui::GetColorU32({ 1.f,0.f,0.f,0.5f }));
 	}
 	
 	if (ImGui::CollapsingHeader("Multiple"))
 	{
-		ImGui::DragInt("Count ", &mnSpawnCount, 1.f, 1, 100);
+		// cells are sampled from the free ones, a crowded map gets as many as still fit
+		ImGui::DragInt("Count ", &mnSpawnCount, 1.f, 1, 1000000);
 		if (ImGui::ButtonEx("Batch Spawn", ImVec2{ 80, 30 }))
 		{
-			std::random_device rd;
-			std::mt19937 mt(rd());
-			for (int i = 0; i < mnSpawnCount; ++i)
-			{
-				std::uniform_int_distribution<unsigned short> distX(0, static_cast<unsigned short>(EcoSystem::GetInst().GetWidth()) - 1);
-				std::uniform_int_distribution<unsigned short> distY(0, static_cast<unsigned short>(EcoSystem::GetInst().GetHeight()) - 1);
-				unsigned short x = distX(mt);
-				unsigned short y = distY(mt);
-				int failsafe = 10000;
-				while (eco.GetGridVal(x, y) != -1)
-				{
-					x = distX(mt);
-					y = distY(mt);
-					failsafe--;
-					if (failsafe < 0)
-						break;
-				}
-				if (failsafe > 0)
-				{
-					auto a = EvolutionChart[mnCurrSelection];
-					Data::VisitSpawnTuple(
-						Data::SpawnVisitor{ x, y, EvolutionChart[mnCurrSelection], Traits{ mfCurSize, mfCurSpeed, mfCurSense } }
-					, mnCurrSelection);
-				}
-			}
+			cmd.meType = UiCommand::UI_SPAWN_RANDOM;
+			cmd.mnCount = static_cast<unsigned>(mnSpawnCount < 0 ? 0 : mnSpawnCount);
+			cmd.mnSeed = mnBatchCount++;
+			eco.PushCommand(cmd);
+		}
+		ImGui::DragFloat("Fill % ", &mfFillPercent, 0.1f, 0.f, 100.f, "%.1f");
+		if (ImGui::ButtonEx("Fill", ImVec2{ 80, 30 }))
+		{
+			cmd.meType = UiCommand::UI_SPAWN_RANDOM;
+			cmd.mfValue = mfFillPercent / 100.f;
+			cmd.mnSeed = mnBatchCount++;
+			eco.PushCommand(cmd);
 		}
 	}
 
@@ -1,7 +1,7 @@
 #include "EcoSystem/Tools/Tools.h"
 
-CS380::Tools::Tools(std::string _name, bool _opened) noexcept
-	: mName{ _name }, mbOpened{ _opened }
+CS380::Tools::Tools(EcoSystem& _eco, std::string _name, bool _opened) noexcept
+	: mEco{ _eco }, mbOpened{ _opened }, mName{ _name }
 {
 
 }
@@ -4,8 +4,93 @@
 #include "imgui.h"
 #include "imgui_internal.h"
 
-CS380::ViewTool::ViewTool(bool _open) noexcept
-	: Tools{ "View Tool", _open }, mnCurrSelection{ -1 }
+#include <cctype>
+#include <cstdio>
+
+namespace
+{
+	constexpr float indent = 10.f;
+
+	// case insensitive, an empty needle matches everything
+	bool Contains(const char* _hay, const char* _needle) noexcept
+	{
+		if (!*_needle)
+			return true;
+		for (; *_hay; ++_hay)
+		{
+			const char* h = _hay;
+			const char* n = _needle;
+			while (*h && *n && std::tolower(static_cast<unsigned char>(*h)) == std::tolower(static_cast<unsigned char>(*n)))
+				++h, ++n;
+			if (!*n)
+				return true;
+		}
+		return false;
+	}
+
+	void CreatureDetails(const CS380::CreatureView& c)
+	{
+		ImGui::Text("General");
+		ImGui::Indent(indent);
+		ImGui::Text("UID  : %016llX", static_cast<unsigned long long>(c.mnID));
+		ImGui::Text("Name : %s", CS380::Data::SpeciesNames[c.mHandle.GetSpecies()]);
+		ImGui::Text("Pos  : %d, %d", c.mnX, c.mnY);
+		ImGui::Text("Mass : %f / %f", c.mfEnergy, c.mfMaxEnergy);
+		ImGui::Unindent(indent);
+		ImGui::Text("Traits");
+		ImGui::Indent(indent);
+		ImGui::Text("Size : %f", c.mfSize);
+		ImGui::Text("Speed: %f", c.mfSpeed);
+		ImGui::Text("Sense: %f", c.mfSense);
+		ImGui::Unindent(indent);
+		ImGui::Text("Evolution");
+		ImGui::Indent(indent);
+		ImGui::Text("Rep. : %f", c.mfRepChance);
+		ImGui::Text("Mut. : %f", c.mfMutChance);
+		ImGui::Unindent(indent);
+	}
+
+	// rate and thresholds other than the fertilizer's lo are fixed once the terrain is made, so they are read
+	// off the terrain itself
+	void CellDetails(const CS380::WorldSnapshot& view, const CS380::Terrain& terrain, unsigned x, unsigned y)
+	{
+		ImGui::Text("Pos x,y: %u, %u", x, y);
+		ImGui::Text("Grass");
+		ImGui::Indent(indent);
+		ImGui::Text("Val    : %f", view.mGrass(x, y));
+		ImGui::Text("Rate   : %f", terrain.GetGrassLayerRate()(x, y));
+		ImGui::Text("Thresh : %f / %f", terrain.GetGrassThreshLo(), terrain.GetGrassThreshHi());
+		ImGui::Unindent(indent);
+		ImGui::Text("Fertilizer");
+		ImGui::Indent(indent);
+		ImGui::Text("Val    : %f", view.mFertilizer(x, y));
+		ImGui::Text("Thresh : %f / %f", view.mFertilizerLo(x, y), terrain.GetFertilizerThreshHi());
+		ImGui::Unindent(indent);
+		if (!view.mScent.Empty())
+		{
+			ImGui::Text("Scent");
+			ImGui::Indent(indent);
+			ImGui::Text("Val    : %f", view.mScent(x, y));
+			ImGui::Unindent(indent);
+		}
+		ImGui::Text("Occupancy");
+		ImGui::Indent(indent);
+		const CS380::CellOccupants& o = view.mOccupants(x, y);
+		if (o.mHead.IsValid())
+		{
+			ImGui::Text("Handle : species %u slot %u gen %u", o.mHead.GetSpecies(), o.mHead.GetSlot(), o.mHead.mnGen);
+			ImGui::Text("Crowd  : %u", o.mnCrowd);
+		}
+		else
+			ImGui::Text("Handle : none");
+		ImGui::Unindent(indent);
+	}
+}
+
+CS380::ViewTool::ViewTool(EcoSystem& _eco, bool _open) noexcept
+	: Tools{ _eco, "View Tool", _open }, mCurrSelection{}, mFiltered{}, mSearch{},
+	mnSpeciesMask{ ~0u }, mTraitMin{ 0.f, 0.f, 0.f }, mTraitMax{ 100.f, 100.f, 100.f }, mfEnergyMin{ 0.f }, mfEnergyMax{ 1.f },
+	mbPick{ false }, mPinned{ -1, -1 }
 {
 }
 
@@ -14,84 +99,164 @@ CS380::ViewTool::~ViewTool(void) noexcept
 
 void CS380::ViewTool::Render(void) noexcept
 {
-	const auto& cs = EcoSystem::GetInst().GetAllCreatures();
-	static float constexpr indent = 10.f;
 	ImGui::Begin(mName.c_str(), &mbOpened);
-	ImGui::BeginColumns("View", 2);
 
-	for (unsigned i = 0; i < cs.size(); ++i)
+	// everything shown comes off the published snapshot. the selection is a handle, so it simply goes away once
+	// the creature is no longer in one
+	const WorldSnapshot& view = mEco.GetView();
+	for (const CreatureView& c : view.mCreatures)
 	{
-		ImGui::TextDisabled("%d) %s", i, cs[i]->GetUniqueID().c_str());
-		if (ImGui::IsItemHovered())
+		if (c.mHandle == mCurrSelection)
 		{
-			unsigned x, y;
-			cs[i]->GetGridPosition(x, y);
-			EcoSystem::GetInst().HighlightGrid(x, y, ImGui::GetColorU32(ImVec4{ 1.f,1.f,1.f,1.f }));
+			mEco.HighlightGrid(static_cast<unsigned>(c.mnX), static_cast<unsigned>(c.mnY), ImGui::GetColorU32(ImVec4{ 1.f,1.f,0.f,1.f }));
+			break;
+		}
+	}
 
-			ImGui::BeginTooltip();
-			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
-			ImGui::Text("General");
-			ImGui::Indent(indent);
-			ImGui::Text("UID  : %s", cs[i]->GetUniqueID().c_str());
-			ImGui::Text("Name : %s", cs[i]->GetName().c_str());
-			ImGui::Text("Mass : %f / %f", cs[i]->GetEnergy().first, cs[i]->GetEnergy().second);
-			ImGui::Unindent(indent);
-			ImGui::Text("Traits");
-			ImGui::Indent(indent);
-			ImGui::Text("Size : %f", cs[i]->GetSize());
-			ImGui::Text("Speed: %f", cs[i]->GetSpeed());
-			ImGui::Text("Sense: %f", cs[i]->GetSense());
-			ImGui::Unindent(indent);
-			ImGui::Text("Evolution");
-			ImGui::Indent(indent);
-			ImGui::Text("Rep. : %f", cs[i]->GetRepChance());
-			ImGui::Text("Mut. : %f", cs[i]->GetMutChance());
-			ImGui::Unindent(indent);
+	RenderFilter();
+	ImGui::BeginColumns("View", 2);
+	RenderCreatures();
+	ImGui::NextColumn();
+	RenderCells();
+	ImGui::EndColumns();
+	ImGui::End();
+}
 
-			ImGui::PopTextWrapPos();
-			ImGui::EndTooltip();
+void CS380::ViewTool::RenderFilter(void) noexcept
+{
+	if (!ImGui::CollapsingHeader("Filter"))
+		return;
+
+	ImGui::InputText("Search", mSearch, sizeof(mSearch));
+	for (unsigned s = 0; s < Data::SpeciesNames.size(); ++s)
+	{
+		if (s)
+			ImGui::SameLine();
+		bool on = (mnSpeciesMask >> s) & 1u;
+		if (ImGui::Checkbox(Data::SpeciesNames[s], &on))
+			mnSpeciesMask = on ? mnSpeciesMask | (1u << s) : mnSpeciesMask & ~(1u << s);
+	}
+	static const char* const traits[] = { "Size", "Speed", "Sense" };
+	for (unsigned t = 0; t < 3; ++t)
+		ImGui::DragFloatRange2(traits[t], &mTraitMin[t], &mTraitMax[t], 0.01f, 0.f, 100.f, "Min: %.2f", "Max: %.2f");
+	ImGui::DragFloatRange2("Energy", &mfEnergyMin, &mfEnergyMax, 0.005f, 0.f, 1.f, "Min: %.2f", "Max: %.2f");
+	if (ImGui::Button("Reset"))
+	{
+		mSearch[0] = '\0';
+		mnSpeciesMask = ~0u;
+		for (unsigned t = 0; t < 3; ++t)
+		{
+			mTraitMin[t] = 0.f;
+			mTraitMax[t] = 100.f;
 		}
+		mfEnergyMin = 0.f;
+		mfEnergyMax = 1.f;
 	}
+}
 
-	ImGui::NextColumn();
+void CS380::ViewTool::Refilter(void)
+{
+	const WorldSnapshot& view = mEco.GetView();
+	mFiltered.clear();
+	char text[64];
+	for (unsigned i = 0; i < view.mCreatures.size(); ++i)
+	{
+		const CreatureView& c = view.mCreatures[i];
+		if (!((mnSpeciesMask >> c.mHandle.GetSpecies()) & 1u))
+			continue;
+		const float traits[3] = { c.mfSize, c.mfSpeed, c.mfSense };
+		bool pass = true;
+		for (unsigned t = 0; t < 3 && pass; ++t)
+			pass = traits[t] >= mTraitMin[t] && traits[t] <= mTraitMax[t];
+		const float energy = c.mfMaxEnergy > 0.f ? c.mfEnergy / c.mfMaxEnergy : 0.f;
+		if (!pass || energy < mfEnergyMin || energy > mfEnergyMax)
+			continue;
+		if (mSearch[0])
+		{
+			snprintf(text, sizeof(text), "%s %016llX", Data::SpeciesNames[c.mHandle.GetSpecies()], static_cast<unsigned long long>(c.mnID));
+			if (!Contains(text, mSearch))
+				continue;
+		}
+		mFiltered.push_back(i);
+	}
+}
+
+void CS380::ViewTool::RenderCreatures(void) noexcept
+{
+	const WorldSnapshot& view = mEco.GetView();
+	Refilter();
+	ImGui::Text("%u of %u creatures", static_cast<unsigned>(mFiltered.size()), static_cast<unsigned>(view.mCreatures.size()));
 
-	const auto& terrain = EcoSystem::GetInst().GetTerrain();
-	const auto& grid = terrain.GetGrassLayer();
-	for (unsigned y = 0; y < grid.size(); ++y)
+	// only the rows in view submit widgets, a list of any length costs a screenful
+	ImGui::BeginChild("Creatures");
+	ImGuiListClipper clipper{ static_cast<int>(mFiltered.size()), ImGui::GetTextLineHeightWithSpacing() };
+	while (clipper.Step())
 	{
-		for (unsigned x = 0; x < grid[y].size(); ++x)
+		for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; ++r)
 		{
-			ImGui::TextDisabled("Grid [%d][%d]", x, y);
+			const unsigned i = mFiltered[r];
+			const CreatureView& c = view.mCreatures[i];
+			if (c.mHandle == mCurrSelection)
+				ImGui::Text("%u) %016llX", i, static_cast<unsigned long long>(c.mnID));
+			else
+				ImGui::TextDisabled("%u) %016llX", i, static_cast<unsigned long long>(c.mnID));
+			if (ImGui::IsItemClicked())
+				mCurrSelection = c.mHandle == mCurrSelection ? CreatureHandle{} : c.mHandle;
 			if (ImGui::IsItemHovered())
 			{
-				EcoSystem::GetInst().HighlightGrid(x, y, ImGui::GetColorU32(ImVec4{ 1.f,1.f,1.f,1.f }));
+				mEco.HighlightGrid(static_cast<unsigned>(c.mnX), static_cast<unsigned>(c.mnY), ImGui::GetColorU32(ImVec4{ 1.f,1.f,1.f,1.f }));
 
 				ImGui::BeginTooltip();
 				ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
-				ImGui::Text("Pos x,y: %d, %d", x, y);
-				ImGui::Text("Grass");
-				ImGui::Indent(indent);
-				ImGui::Text("Val    : %f", terrain.GetGrassLayer()[y][x]);
-				ImGui::Text("Rate   : %f", terrain.GetGrassLayerRate()[y][x]);
-				ImGui::Text("Thresh : %f / %f", terrain.GetGrassLayerThresh()[y][x].first, terrain.GetGrassLayerThresh()[y][x].second);
-				ImGui::Unindent(indent);
-				ImGui::Text("Fertilizer");
-				ImGui::Indent(indent);
-				ImGui::Text("Val    : %f", terrain.GetFertilizerLayer()[y][x]);
-				ImGui::Text("Thresh : %f / %f", terrain.GetFertilizerLayerThresh()[y][x].first, terrain.GetFertilizerLayerThresh()[y][x].second);
-				ImGui::Unindent(indent);
-				ImGui::Text("Occupancy");
-				ImGui::Indent(indent);
-				ImGui::Text("Indx   : %d", terrain.GetSpaceLayer()[y][x]);
-				ImGui::Unindent(indent);
-
+				CreatureDetails(c);
 				ImGui::PopTextWrapPos();
 				ImGui::EndTooltip();
 			}
 		}
 	}
-
-	ImGui::EndColumns();
-	ImGui::End();
+	ImGui::EndChild();
 }
 
+void CS380::ViewTool::RenderCells(void) noexcept
+{
+	const WorldSnapshot& view = mEco.GetView();
+	const Terrain& terrain = mEco.GetTerrain();
+
+	ImGui::Checkbox("Pick on map", &mbPick);
+	ImGui::InputInt2("Cell", mPinned);
+
+	// the cell under the mouse straight off the map transform, nothing is listed
+	if (mbPick)
+	{
+		const GridPos p = mEco.GetHoveredCell();
+		if (p.x >= 0 && static_cast<unsigned>(p.x) < view.mnWidth && static_cast<unsigned>(p.y) < view.mnHeight)
+		{
+			mEco.HighlightGrid(static_cast<unsigned>(p.x), static_cast<unsigned>(p.y), ImGui::GetColorU32(ImVec4{ 1.f,1.f,1.f,1.f }));
+			ImGui::BeginTooltip();
+			ImGui::PushTextWrapPos(ImGui::GetFontSize() * 35.0f);
+			CellDetails(view, terrain, static_cast<unsigned>(p.x), static_cast<unsigned>(p.y));
+			ImGui::PopTextWrapPos();
+			ImGui::EndTooltip();
+
+			if (ImGui::IsMouseClicked(0))
+			{
+				mPinned[0] = p.x;
+				mPinned[1] = p.y;
+			}
+		}
+	}
+
+	if (mPinned[0] < 0 || mPinned[1] < 0 || static_cast<unsigned>(mPinned[0]) >= view.mnWidth || static_cast<unsigned>(mPinned[1]) >= view.mnHeight)
+	{
+		ImGui::TextDisabled(mbPick ? "click a cell on the map" : "no cell picked");
+		return;
+	}
+
+	const unsigned x = static_cast<unsigned>(mPinned[0]);
+	const unsigned y = static_cast<unsigned>(mPinned[1]);
+	mEco.HighlightGrid(x, y, ImGui::GetColorU32(ImVec4{ 0.f,1.f,1.f,1.f }));
+	CellDetails(view, terrain, x, y);
+	const CreatureHandle head = view.mOccupants(x, y).mHead;
+	if (head.IsValid() && ImGui::Button("Select occupant"))
+		mCurrSelection = head;
+}
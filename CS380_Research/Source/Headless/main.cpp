@@ -0,0 +1,497 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#include <string>
+#include <vector>
+
+#include "EcoSystem/EcoSystem.h"
+#include "Data/EcoData.h"
+#include "EcoSystem/Domain.h"
+#include "EcoSystem/Ensemble.h"
+#include "EcoSystem/Random.h"
+
+// Headless batch runner, links only the simulation core (no GLFW / ImGui)
+// every tick is FIXED_DT, so a run is independent of how fast the machine is
+//
+// usage: CS380_Headless [options]
+//   --width N --height N      world size (default 64 x 64)
+//   --ticks N                 ticks to simulate (default 10000)
+//   --rabbits N --foxes N     initial population, randomly placed (default 20 / 0)
+//   --fill F                  rabbits on fraction F of the cells still free after --rabbits and --foxes (default 0)
+//   --grass-a F               initial grass coverage 0-1
+//   --rate-noise F            blend the growth rates 0-1 towards smooth patches instead of per cell noise (default 0)
+//   --report N                print a status line every N ticks (0 = only at the end)
+//   --threads N               worker threads for the terrain and parallel creature passes (0 = all hardware threads)
+//   --seed N                  master seed, the same seed and options replay the same run
+//   --batched 0|1             batched creature metabolism pass (default 0)
+//   --parallel 0|1            creature phase on every worker with deferred world changes (default 0)
+//   --lazy-terrain 0|1        cells grow in closed form when read instead of every tick (default 0)
+//   --scent 0|1               rabbits leave a scent the foxes follow instead of searching for them (default 0)
+//   --path-budget N           search nodes the queued path requests may expand per tick, 0 = no limit (default 65536)
+//   --telemetry PATH          stream every log sample to PATH, csv for a .csv path and columnar binary otherwise.
+//                             the run waits on the disk rather than drop a sample and fails if any did not make it
+//   --load PATH               carry on from a checkpoint instead of a new world, --seed then branches it off
+//   --save PATH               checkpoint the run to PATH once the ticks are done
+//   --ensemble N              N independent worlds instead of one, seeded --seed, --seed + 1, ... and run --threads
+//                             at a time with a single worker each. prints one line per world
+//   --sweep NAME LO HI        spread NAME evenly from LO to HI over the ensemble, may be given several times.
+//                             grass-a, grass-rate-lo, grass-rate-hi, mutation-epsilon, replication-thresh,
+//                             replicate-chance or mutation-chance, the last three on chart entry --sweep-chart
+//   --sweep-chart N           evolution chart entry the chart sweeps change (default 0)
+//   --trace PATH              profile every tick and write the timed calls and counters to PATH as Chrome trace
+//                             json (chrome://tracing, Perfetto)
+//   --distributed 0|1         one world cut up between every process of an MPI launch (mpirun -n N), each ticking
+//                             its own part. needs a build with ECO_WITH_MPI to run on more than one. the creature
+//                             counts are split by area and only the first process prints, no --load, --save,
+//                             --ensemble, --telemetry or --trace
+
+namespace
+{
+	struct Sweep
+	{
+		std::string mName;
+		float mfLo;
+		float mfHi;
+	};
+
+	struct HeadlessConfig
+	{
+		unsigned mnWidth = 64;
+		unsigned mnHeight = 64;
+		unsigned mnTicks = 10000;
+		unsigned mnRabbits = 20;
+		unsigned mnFoxes = 0;
+		float mfFill = 0.f;
+		unsigned mnReport = 1000;
+		unsigned mnThreads = 0;
+		unsigned long long mnSeed = 0;
+		bool mbSeeded = false;
+		bool mbBatched = false;
+		bool mbParallel = false;
+		bool mbLazyTerrain = false;
+		// a loaded run keeps the checkpoint's mode unless told otherwise
+		bool mbLazyTerrainSet = false;
+		bool mbScent = false;
+		bool mbScentSet = false;
+		unsigned mnPathBudget = DEFAULT_PATH_BUDGET;
+		float mfGrassA = 0.1f;
+		float mfRateNoise = 0.f;
+		const char* mpTelemetry = nullptr;
+		const char* mpLoad = nullptr;
+		const char* mpSave = nullptr;
+		const char* mpTrace = nullptr;
+		unsigned mnEnsemble = 0;
+		bool mbDistributed = false;
+		unsigned mnSweepChart = 0;
+		std::vector<Sweep> mSweeps;
+	};
+
+	const char* const SweepNames[] = {
+		"grass-a", "grass-rate-lo", "grass-rate-hi", "mutation-epsilon", "replication-thresh", "replicate-chance", "mutation-chance"
+	};
+
+	unsigned ScentMask(const HeadlessConfig& _cfg) noexcept
+	{
+		return _cfg.mbScent ? 1u << CS380::Data::SpeciesOf<CS380::Rabbit>() : 0u;
+	}
+
+	void PrintUsage(void)
+	{
+		printf("usage: CS380_Headless [--width N] [--height N] [--ticks N]\n"
+			   "                      [--rabbits N] [--foxes N] [--fill F] [--grass-a F] [--rate-noise F]\n"
+			   "                      [--report N] [--threads N] [--seed N] [--batched 0|1]\n"
+			   "                      [--parallel 0|1] [--lazy-terrain 0|1] [--path-budget N]\n"
+			   "                      [--scent 0|1] [--telemetry PATH]\n"
+			   "                      [--load PATH] [--save PATH]\n"
+			   "                      [--ensemble N] [--sweep NAME LO HI]... [--sweep-chart N]\n"
+			   "                      [--trace PATH] [--distributed 0|1]\n");
+	}
+
+	bool ParseArgs(int argc, char** argv, HeadlessConfig& _cfg)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			const char* arg = argv[i];
+			if (!strcmp(arg, "--help") || !strcmp(arg, "-h"))
+				return false;
+			if (i + 1 >= argc)
+			{
+				fprintf(stderr, "missing value for %s\n", arg);
+				return false;
+			}
+			if (!strcmp(arg, "--sweep"))
+			{
+				if (i + 3 >= argc)
+				{
+					fprintf(stderr, "--sweep takes NAME LO HI\n");
+					return false;
+				}
+				Sweep sw{ argv[i + 1], static_cast<float>(atof(argv[i + 2])), static_cast<float>(atof(argv[i + 3])) };
+				if (std::none_of(std::begin(SweepNames), std::end(SweepNames), [&sw](const char* _n) { return sw.mName == _n; }))
+				{
+					fprintf(stderr, "unknown sweep %s\n", argv[i + 1]);
+					return false;
+				}
+				_cfg.mSweeps.push_back(sw);
+				i += 3;
+				continue;
+			}
+			const char* val = argv[++i];
+
+			if (!strcmp(arg, "--width"))
+				_cfg.mnWidth = static_cast<unsigned>(atoi(val));
+			else if (!strcmp(arg, "--height"))
+				_cfg.mnHeight = static_cast<unsigned>(atoi(val));
+			else if (!strcmp(arg, "--ticks"))
+				_cfg.mnTicks = static_cast<unsigned>(atoi(val));
+			else if (!strcmp(arg, "--rabbits"))
+				_cfg.mnRabbits = static_cast<unsigned>(atoi(val));
+			else if (!strcmp(arg, "--foxes"))
+				_cfg.mnFoxes = static_cast<unsigned>(atoi(val));
+			else if (!strcmp(arg, "--fill"))
+				_cfg.mfFill = static_cast<float>(atof(val));
+			else if (!strcmp(arg, "--grass-a"))
+				_cfg.mfGrassA = static_cast<float>(atof(val));
+			else if (!strcmp(arg, "--rate-noise"))
+				_cfg.mfRateNoise = static_cast<float>(atof(val));
+			else if (!strcmp(arg, "--report"))
+				_cfg.mnReport = static_cast<unsigned>(atoi(val));
+			else if (!strcmp(arg, "--threads"))
+				_cfg.mnThreads = static_cast<unsigned>(atoi(val));
+			else if (!strcmp(arg, "--seed"))
+			{
+				_cfg.mnSeed = strtoull(val, nullptr, 10);
+				_cfg.mbSeeded = true;
+			}
+			else if (!strcmp(arg, "--batched"))
+				_cfg.mbBatched = atoi(val) != 0;
+			else if (!strcmp(arg, "--parallel"))
+				_cfg.mbParallel = atoi(val) != 0;
+			else if (!strcmp(arg, "--path-budget"))
+				_cfg.mnPathBudget = static_cast<unsigned>(atoi(val));
+			else if (!strcmp(arg, "--lazy-terrain"))
+			{
+				_cfg.mbLazyTerrain = atoi(val) != 0;
+				_cfg.mbLazyTerrainSet = true;
+			}
+			else if (!strcmp(arg, "--scent"))
+			{
+				_cfg.mbScent = atoi(val) != 0;
+				_cfg.mbScentSet = true;
+			}
+			else if (!strcmp(arg, "--telemetry"))
+				_cfg.mpTelemetry = val;
+			else if (!strcmp(arg, "--load"))
+				_cfg.mpLoad = val;
+			else if (!strcmp(arg, "--save"))
+				_cfg.mpSave = val;
+			else if (!strcmp(arg, "--trace"))
+				_cfg.mpTrace = val;
+			else if (!strcmp(arg, "--ensemble"))
+				_cfg.mnEnsemble = static_cast<unsigned>(atoi(val));
+			else if (!strcmp(arg, "--distributed"))
+				_cfg.mbDistributed = atoi(val) != 0;
+			else if (!strcmp(arg, "--sweep-chart"))
+				_cfg.mnSweepChart = static_cast<unsigned>(atoi(val));
+			else
+			{
+				fprintf(stderr, "unknown option %s\n", arg);
+				return false;
+			}
+		}
+		if (!_cfg.mSweeps.empty() && !_cfg.mnEnsemble)
+		{
+			fprintf(stderr, "--sweep needs --ensemble\n");
+			return false;
+		}
+		if (_cfg.mnEnsemble && (_cfg.mpLoad || _cfg.mpSave || _cfg.mpTelemetry || _cfg.mpTrace))
+		{
+			fprintf(stderr, "--ensemble runs new worlds only, without --load, --save, --telemetry or --trace\n");
+			return false;
+		}
+		if (_cfg.mbDistributed && (_cfg.mnEnsemble || _cfg.mpLoad || _cfg.mpSave || _cfg.mpTelemetry || _cfg.mpTrace))
+		{
+			fprintf(stderr, "--distributed runs one new world only, without --ensemble, --load, --save, --telemetry or --trace\n");
+			return false;
+		}
+		return _cfg.mnWidth > 0 && _cfg.mnHeight > 0 && _cfg.mnSweepChart < EVOLUTION_CHART_COUNT;
+	}
+
+	// counts are the whole world's under a domain, every process has to get here for them to add up. every column is
+	// read as of the world's tick, not off the last log sample. _ticks are the ones run by this process in _elapsed,
+	// fewer than the world's after a --load
+	void PrintStatus(CS380::EcoSystem& _eco, unsigned _ticks, double _elapsed, const CS380::Domain* _domain = nullptr)
+	{
+		// creatures, awake cells, grass, then the trait sums
+		double counts[3 + CS380::TRAIT_COUNT] = { 0.0, static_cast<double>(_eco.GetTerrain().GetAwakeCells()), _eco.GetOwnedGrassRatioSum() };
+		double* const traits = counts + 3;
+		for (unsigned s = 0; s < CS380::Data::SpeciesNames.size(); ++s)
+		{
+			const CS380::SpeciesStats& st = _eco.GetPool(s).GetStats();
+			counts[0] += st.mnCount;
+			for (unsigned i = 0; i < CS380::TRAIT_COUNT; ++i)
+				traits[i] += st.mTraits[i].mfSum;
+		}
+		if (_domain)
+		{
+			_domain->Sum(counts, static_cast<unsigned>(std::size(counts)));
+			if (CS380::Domain::GetProcessRank())
+				return;
+		}
+		const double n = counts[0] ? counts[0] : 1.0;
+		printf("tick %llu  creatures %u  grass %.2f  avg speed %.3f  size %.3f  sense %.3f  awake cells %llu  (%.1f ticks/s)\n",
+			_eco.GetTickCount(), static_cast<unsigned>(counts[0]), counts[2],
+			traits[CS380::TRAIT_SPEED] / n, traits[CS380::TRAIT_SIZE] / n, traits[CS380::TRAIT_SENSE] / n,
+			static_cast<unsigned long long>(counts[1]), _elapsed > 0.0 ? _ticks / _elapsed : 0.0);
+	}
+
+	void ApplySweep(CS380::EnsembleMember& _m, const Sweep& _sweep, float _v, unsigned _chart)
+	{
+		CS380::EvolutionData& evo = _m.mEvolution[_chart];
+		if (_sweep.mName == "grass-a")
+			_m.mfGrassA = _v;
+		else if (_sweep.mName == "grass-rate-lo")
+			_m.mfGrassRateLo = _v;
+		else if (_sweep.mName == "grass-rate-hi")
+			_m.mfGrassRateHi = _v;
+		else if (_sweep.mName == "mutation-epsilon")
+			_m.mfMutationEpsilon = _v;
+		else if (_sweep.mName == "replication-thresh")
+			evo.mfReplicationThresh = _v;
+		else if (_sweep.mName == "replicate-chance")
+			evo.mfReplicateChance = _v;
+		else if (_sweep.mName == "mutation-chance")
+			evo.mfMutationChance = _v;
+	}
+
+	// one world per member, all in this process. every member gets the single run options, the sweeps and its own seed
+	int RunEnsemble(const HeadlessConfig& _cfg)
+	{
+		const unsigned long long base = _cfg.mbSeeded ? _cfg.mnSeed : CS380::Random{}.GetMasterSeed();
+		const unsigned n = _cfg.mnEnsemble;
+
+		CS380::Ensemble ensemble{ _cfg.mnThreads };
+		for (unsigned i = 0; i < n; ++i)
+		{
+			CS380::EnsembleMember m;
+			m.mnSeed = base + i;
+			m.mnTicks = _cfg.mnTicks;
+			m.mnWidth = _cfg.mnWidth;
+			m.mnHeight = _cfg.mnHeight;
+			m.mPopulation = { _cfg.mnRabbits, _cfg.mnFoxes };
+			m.mFill = { _cfg.mfFill };
+			m.mfGrassA = _cfg.mfGrassA;
+			m.mfRateNoise = _cfg.mfRateNoise;
+			m.mEvolution.assign(CS380::DefaultEvolutionChart, CS380::DefaultEvolutionChart + EVOLUTION_CHART_COUNT);
+			m.mbBatched = _cfg.mbBatched;
+			m.mbLazyTerrain = _cfg.mbLazyTerrain;
+			m.mnScentMask = ScentMask(_cfg);
+			m.mnPathBudget = _cfg.mnPathBudget;
+			const float t = n > 1 ? static_cast<float>(i) / (n - 1) : 0.f;
+			for (const Sweep& sw : _cfg.mSweeps)
+				ApplySweep(m, sw, sw.mfLo + (sw.mfHi - sw.mfLo) * t, _cfg.mnSweepChart);
+			ensemble.Add(m);
+		}
+		printf("ensemble of %u  seeds %llu - %llu\n", n, base, base + n - 1);
+
+		auto start = std::chrono::steady_clock::now();
+		ensemble.Run([&](unsigned _i, const CS380::EnsembleResult& _r)
+		{
+			printf("world %u  seed %llu", _i, static_cast<unsigned long long>(_r.mnSeed));
+			const float t = n > 1 ? static_cast<float>(_i) / (n - 1) : 0.f;
+			for (const Sweep& sw : _cfg.mSweeps)
+				printf("  %s %g", sw.mName.c_str(), sw.mfLo + (sw.mfHi - sw.mfLo) * t);
+			printf("  tick %llu  creatures %u  peak %u  grass %.2f", _r.mnTicks, _r.mnCreatures, _r.mnPeakPops, _r.mfGrassDensity);
+			for (unsigned s = 0; s < _r.mSpecies.size(); ++s)
+			{
+				const CS380::SpeciesStats& st = _r.mSpecies[s];
+				printf("  %s %u (speed %.3f size %.3f sense %.3f)", CS380::Data::SpeciesNames[s], st.mnCount,
+					st.mTraits[CS380::TRAIT_SPEED].GetMean(st.mnCount), st.mTraits[CS380::TRAIT_SIZE].GetMean(st.mnCount),
+					st.mTraits[CS380::TRAIT_SENSE].GetMean(st.mnCount));
+			}
+			printf("  (%.1f ticks/s)\n", _r.mfSeconds > 0.0 ? _r.mnTicks / _r.mfSeconds : 0.0);
+			fflush(stdout);
+		});
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		printf("%u worlds in %.2f s  (%.1f world ticks/s)\n", n, elapsed, elapsed > 0.0 ? static_cast<double>(n) * _cfg.mnTicks / elapsed : 0.0);
+		return 0;
+	}
+
+	// this process's part of one world, the rest are ticked by the other processes of the launch in lock step
+	int RunDistributed(const HeadlessConfig& _cfg)
+	{
+		CS380::Domain domain{ _cfg.mnWidth, _cfg.mnHeight };
+		const bool first = CS380::Domain::GetProcessRank() == 0;
+		if (!domain.GetOwnedWidth() || !domain.GetOwnedHeight())
+		{
+			if (first)
+				fprintf(stderr, "a %u x %u world does not split between %u processes\n", _cfg.mnWidth, _cfg.mnHeight, CS380::Domain::GetProcessCount());
+			return 1;
+		}
+
+		CS380::EcoSystem eco{};
+		eco.SetWorkerCount(_cfg.mnThreads);
+		eco.SetBatchedUpdate(_cfg.mbBatched);
+		eco.SetParallelUpdate(_cfg.mbParallel);
+		eco.SetPathBudget(_cfg.mnPathBudget);
+		if (_cfg.mbSeeded)
+			eco.GetRandom().SetMasterSeed(_cfg.mnSeed);
+		if (first)
+			printf("seed %llu  %u processes\n", static_cast<unsigned long long>(eco.GetRandom().GetMasterSeed()), CS380::Domain::GetProcessCount());
+
+		eco.SetLazyTerrain(_cfg.mbLazyTerrain);
+		eco.SetScentSpecies(ScentMask(_cfg));
+		domain.Attach(eco);
+		eco.SetRateNoise(_cfg.mfRateNoise);
+		eco.SetGrassParams(_cfg.mfGrassA, 0.025f, 1.0f, 0.0001f, 0.05f, 300.f);
+		eco.Begin();
+		domain.Begin();
+
+		eco.Populate(0, domain.Share(_cfg.mnRabbits));
+		eco.Populate(1, domain.Share(_cfg.mnFoxes));
+		if (_cfg.mfFill > 0.f)
+			eco.PopulateFill(0, _cfg.mfFill);
+
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned t = 1; t <= _cfg.mnTicks; ++t)
+		{
+			eco.Tick();
+			domain.Exchange();
+
+			if (_cfg.mnReport && t % _cfg.mnReport == 0)
+				PrintStatus(eco, t, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), &domain);
+		}
+		// the last tick was just printed when the ticks are a whole number of reports
+		if (!_cfg.mnReport || _cfg.mnTicks % _cfg.mnReport)
+			PrintStatus(eco, _cfg.mnTicks, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(), &domain);
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	HeadlessConfig cfg;
+	if (!ParseArgs(argc, argv, cfg))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	if (cfg.mnEnsemble)
+		return RunEnsemble(cfg);
+	if (cfg.mbDistributed)
+	{
+		if (!CS380::Domain::InitProcesses(&argc, &argv))
+		{
+			fprintf(stderr, "could not start the processes\n");
+			return 1;
+		}
+		const int rc = RunDistributed(cfg);
+		CS380::Domain::FinishProcesses();
+		return rc;
+	}
+
+	CS380::EcoSystem eco{};
+	eco.SetWorkerCount(cfg.mnThreads);
+	eco.SetBatchedUpdate(cfg.mbBatched);
+	eco.SetParallelUpdate(cfg.mbParallel);
+	eco.SetPathBudget(cfg.mnPathBudget);
+	if (cfg.mpLoad)
+	{
+		if (!eco.LoadCheckpoint(cfg.mpLoad))
+		{
+			fprintf(stderr, "could not load %s\n", cfg.mpLoad);
+			return 1;
+		}
+		// same world, new randomness for whatever is spawned from here on
+		if (cfg.mbSeeded)
+		{
+			const unsigned long long entities = eco.GetRandom().GetEntityCounter();
+			eco.GetRandom().SetMasterSeed(cfg.mnSeed);
+			eco.GetRandom().SetEntityCounter(entities);
+		}
+		if (cfg.mbLazyTerrainSet)
+			eco.SetLazyTerrain(cfg.mbLazyTerrain);
+		if (cfg.mbScentSet)
+			eco.SetScentSpecies(ScentMask(cfg));
+		printf("seed %llu  loaded %s at tick %llu\n", static_cast<unsigned long long>(eco.GetRandom().GetMasterSeed()), cfg.mpLoad, eco.GetTickCount());
+	}
+	else
+	{
+		if (cfg.mbSeeded)
+			eco.GetRandom().SetMasterSeed(cfg.mnSeed);
+		printf("seed %llu\n", static_cast<unsigned long long>(eco.GetRandom().GetMasterSeed()));
+
+		eco.SetLazyTerrain(cfg.mbLazyTerrain);
+		eco.SetScentSpecies(ScentMask(cfg));
+		eco.SetWorldSize(cfg.mnWidth, cfg.mnHeight);
+		eco.SetRateNoise(cfg.mfRateNoise);
+		eco.SetGrassParams(cfg.mfGrassA, 0.025f, 1.0f, 0.0001f, 0.05f, 300.f);
+		eco.Begin();
+
+		eco.Populate(0, cfg.mnRabbits);
+		eco.Populate(1, cfg.mnFoxes);
+		if (cfg.mfFill > 0.f)
+			eco.PopulateFill(0, cfg.mfFill);
+	}
+
+	// a batch run would rather wait on the disk than have a gap in its history
+	if (cfg.mpTelemetry && !eco.OpenTelemetry(cfg.mpTelemetry, true))
+	{
+		fprintf(stderr, "could not open %s\n", cfg.mpTelemetry);
+		return 1;
+	}
+	if (cfg.mpTrace)
+	{
+		if (!ECO_PROFILING)
+			fprintf(stderr, "built with ECO_NO_PROFILE, %s will only hold the trace header\n", cfg.mpTrace);
+		eco.GetProfiler().SetEnabled(true);
+		eco.GetProfiler().BeginTrace();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	for (unsigned t = 1; t <= cfg.mnTicks; ++t)
+	{
+		eco.Tick();
+
+		if (cfg.mnReport && t % cfg.mnReport == 0)
+			PrintStatus(eco, t, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	// the last tick was just printed when the ticks are a whole number of reports
+	if (!cfg.mnReport || cfg.mnTicks % cfg.mnReport)
+		PrintStatus(eco, cfg.mnTicks, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	eco.CloseTelemetry();
+	if (cfg.mpTelemetry)
+	{
+		const CS380::TelemetryStream& telemetry = eco.GetTelemetry();
+		const unsigned long long lost = telemetry.GetDroppedRows() + telemetry.GetFailedRows();
+		printf("telemetry %llu rows  %llu lost\n", telemetry.GetWrittenRows(), lost);
+		if (lost)
+		{
+			fprintf(stderr, "could not write all of %s\n", cfg.mpTelemetry);
+			return 1;
+		}
+	}
+
+	if (cfg.mpTrace && !eco.GetProfiler().EndTrace(cfg.mpTrace))
+	{
+		fprintf(stderr, "could not write %s\n", cfg.mpTrace);
+		return 1;
+	}
+
+	if (cfg.mpSave)
+	{
+		eco.SaveCheckpoint(cfg.mpSave);
+		if (!eco.FinishCheckpoint())
+		{
+			fprintf(stderr, "could not save %s\n", cfg.mpSave);
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -56,7 +56,7 @@ int main(int, char**)
 
 	ImVec4 clear_color = ImVec4(0.f, 0.f, 0.f, 1.00f);
 
-	CS380::EcoSystem& eco = CS380::EcoSystem::GetInst();
+	CS380::EcoSystem eco{};
 	eco.Init();
 
 	// Main loop
@@ -90,6 +90,7 @@ int main(int, char**)
 	}
 
 	// Cleanup
+	eco.Shutdown();
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();